@@ -64,6 +64,8 @@ static void boot_start_lmb(bootm_headers_t *images)
 	ulong		mem_start;
 	phys_size_t	mem_size;
 
+	/* Drop anything left over from an earlier boot attempt */
+	lmb_uninit(&images->lmb);
 	lmb_init(&images->lmb);
 
 	mem_start = getenv_bootm_low();
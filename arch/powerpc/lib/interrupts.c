@@ -9,6 +9,7 @@
 
 #include <common.h>
 #include <irq_func.h>
+#include <trace.h>
 #include <asm/processor.h>
 #include <watchdog.h>
 #ifdef CONFIG_LED_STATUS
@@ -69,6 +70,27 @@ int interrupt_init(void)
 
 static volatile ulong timestamp = 0;
 
+#ifdef CONFIG_PROFILE
+static uint profile_ticks;	/* decrementer ticks per sample, 0 if off */
+static uint profile_count;
+
+int arch_profile_start(uint hz)
+{
+	/* Samples are taken from the CONFIG_SYS_HZ decrementer interrupt */
+	if (!hz || hz > CONFIG_SYS_HZ)
+		return -EINVAL;
+	profile_count = 0;
+	profile_ticks = CONFIG_SYS_HZ / hz;
+
+	return 0;
+}
+
+void arch_profile_stop(void)
+{
+	profile_ticks = 0;
+}
+#endif
+
 void timer_interrupt(struct pt_regs *regs)
 {
 	/* call cpu specific function from $(CPU)/interrupts.c */
@@ -87,6 +109,19 @@ void timer_interrupt(struct pt_regs *regs)
 #ifdef CONFIG_LED_STATUS
 	status_led_tick(timestamp);
 #endif /* CONFIG_LED_STATUS */
+
+#ifdef CONFIG_PROFILE
+	/*
+	 * Only the interrupted PC is recorded: its caller cannot be found
+	 * reliably, since the link register may not be saved yet
+	 */
+	if (profile_ticks && ++profile_count >= profile_ticks) {
+		void *pc = (void *)regs->nip;
+
+		profile_count = 0;
+		profile_record(&pc, 1);
+	}
+#endif
 }
 
 ulong get_timer (ulong base)
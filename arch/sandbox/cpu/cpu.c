@@ -12,10 +12,12 @@
 #include <linux/delay.h>
 #include <linux/libfdt.h>
 #include <os.h>
+#include <trace.h>
 #include <asm/io.h>
 #include <asm/malloc.h>
 #include <asm/setjmp.h>
 #include <asm/state.h>
+#include <asm/test.h>
 #include <dm/root.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -23,6 +25,24 @@ DECLARE_GLOBAL_DATA_PTR;
 /* Enable access to PCI memory with map_sysmem() */
 static bool enable_pci_map;
 
+/* Number of register regions which emulators can watch for writes */
+#define SANDBOX_MMIO_COUNT	4
+
+/**
+ * struct sandbox_mmio - emulated registers whose writes go to an emulator
+ *
+ * @dev:	Emulator device, or NULL if this entry is free
+ * @base:	Start of the register memory
+ * @size:	Size of the register memory in bytes
+ * @write:	Function to call after each write
+ */
+static struct sandbox_mmio {
+	struct udevice *dev;
+	void *base;
+	ulong size;
+	sandbox_mmio_write_t write;
+} sandbox_mmio[SANDBOX_MMIO_COUNT];
+
 #ifdef CONFIG_PCI
 /* Last device that was mapped into memory, and length of mapping */
 static struct udevice *map_dev;
@@ -251,9 +271,10 @@ unsigned int sandbox_read(const void *addr, enum sandboxio_size_t size)
 	return 0;
 }
 
-void sandbox_write(void *addr, unsigned int val, enum sandboxio_size_t size)
+void sandbox_write(void *addr, u64 val, enum sandboxio_size_t size)
 {
 	struct sandbox_state *state = state_get_current();
+	struct sandbox_mmio *mmio;
 
 	if (!state->allow_memio)
 		return;
@@ -272,6 +293,45 @@ void sandbox_write(void *addr, unsigned int val, enum sandboxio_size_t size)
 		*(u64 *)addr = val;
 		break;
 	}
+
+	for (mmio = sandbox_mmio; mmio != sandbox_mmio + SANDBOX_MMIO_COUNT;
+	     mmio++) {
+		if (mmio->dev && addr >= mmio->base &&
+		    addr < mmio->base + mmio->size) {
+			mmio->write(mmio->dev, addr - mmio->base, val);
+			break;
+		}
+	}
+}
+
+int sandbox_mmio_add(struct udevice *dev, void *base, ulong size,
+		     sandbox_mmio_write_t write)
+{
+	struct sandbox_mmio *mmio;
+
+	for (mmio = sandbox_mmio; mmio != sandbox_mmio + SANDBOX_MMIO_COUNT;
+	     mmio++) {
+		if (!mmio->dev) {
+			mmio->dev = dev;
+			mmio->base = base;
+			mmio->size = size;
+			mmio->write = write;
+			return 0;
+		}
+	}
+
+	return -ENOSPC;
+}
+
+void sandbox_mmio_remove(struct udevice *dev)
+{
+	struct sandbox_mmio *mmio;
+
+	for (mmio = sandbox_mmio; mmio != sandbox_mmio + SANDBOX_MMIO_COUNT;
+	     mmio++) {
+		if (mmio->dev == dev)
+			mmio->dev = NULL;
+	}
 }
 
 void sandbox_set_enable_memio(bool enable)
@@ -344,3 +404,15 @@ ulong timer_get_boot_us(void)
 
 	return (count - base_count) / 1000;
 }
+
+#ifdef CONFIG_PROFILE
+int arch_profile_start(uint hz)
+{
+	return os_profile_start(hz, profile_record);
+}
+
+void arch_profile_stop(void)
+{
+	os_profile_stop();
+}
+#endif
@@ -3,8 +3,11 @@
  * Copyright (c) 2011 The Chromium OS Authors.
  */
 
+#define _GNU_SOURCE
+
 #include <dirent.h>
 #include <errno.h>
+#include <execinfo.h>
 #include <fcntl.h>
 #include <getopt.h>
 #include <setjmp.h>
@@ -15,6 +18,7 @@
 #include <string.h>
 #include <termios.h>
 #include <time.h>
+#include <ucontext.h>
 #include <unistd.h>
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -814,3 +818,87 @@ void *os_find_text_base(void)
 
 	return base;
 }
+
+/* Number of stack frames to collect, including those in the signal handler */
+#define OS_PROFILE_FRAMES	32
+
+static void (*os_profile_func)(void *const pcs[], int depth);
+
+static void *os_ucontext_pc(ucontext_t *uc)
+{
+#if defined(__x86_64__)
+	return (void *)uc->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+	return (void *)uc->uc_mcontext.gregs[REG_EIP];
+#elif defined(__aarch64__)
+	return (void *)uc->uc_mcontext.pc;
+#else
+	return NULL;
+#endif
+}
+
+static void os_sigprof_handler(int sig, siginfo_t *info, void *context)
+{
+	void *frames[OS_PROFILE_FRAMES];
+	void *pc = os_ucontext_pc(context);
+	int count, i;
+
+	if (!pc)
+		return;
+
+	/*
+	 * The unwinder steps through the signal frame, so the interrupted PC
+	 * appears in the list followed by its callers. If it cannot be found,
+	 * just record the PC on its own.
+	 */
+	count = backtrace(frames, OS_PROFILE_FRAMES);
+	for (i = 0; i < count && frames[i] != pc; i++)
+		;
+	if (i == count) {
+		frames[0] = pc;
+		i = 0;
+		count = 1;
+	}
+	os_profile_func(frames + i, count - i);
+}
+
+int os_profile_start(unsigned int hz,
+		     void (*func)(void *const pcs[], int depth))
+{
+	struct itimerval timer;
+	struct sigaction act;
+	void *frames[1];
+
+	if (!hz || hz > 1000000)
+		return -EINVAL;
+
+	/* backtrace() may load libgcc on first use, so get that done now */
+	backtrace(frames, 1);
+
+	os_profile_func = func;
+	memset(&act, '\0', sizeof(act));
+	act.sa_sigaction = os_sigprof_handler;
+	act.sa_flags = SA_SIGINFO | SA_RESTART;
+	sigemptyset(&act.sa_mask);
+	if (sigaction(SIGPROF, &act, NULL))
+		return -errno;
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL))
+		return -errno;
+
+	return 0;
+}
+
+void os_profile_stop(void)
+{
+	struct itimerval timer;
+
+	memset(&timer, '\0', sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+
+	/* The default action for SIGPROF is to terminate, so ignore stragglers */
+	signal(SIGPROF, SIG_IGN);
+}
@@ -4,14 +4,20 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <dm.h>
+#include <fdt_support.h>
 #include <hang.h>
+#include <image.h>
 #include <init.h>
 #include <log.h>
+#include <mapmem.h>
 #include <os.h>
 #include <spl.h>
+#include <u-boot/crc.h>
 #include <asm/spl.h>
 #include <asm/state.h>
+#include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -29,12 +35,172 @@ u32 spl_boot_device(void)
 	return BOOT_DEVICE_BOARD;
 }
 
+/**
+ * spl_board_load_os() - Load an OS image for falcon mode
+ *
+ * The image is a legacy image holding a host executable, such as U-Boot
+ * itself, since that is the only thing sandbox can run.
+ *
+ * @spl_image: Place to put the image details
+ * @fname: Filename of the image on the host
+ * @return 0 if OK, -ve on error
+ */
+static int spl_board_load_os(struct spl_image_info *spl_image,
+			     const char *fname)
+{
+	struct image_header header;
+	void *buf;
+	int ret;
+	int fd;
+
+	/* Opening the file stands in for bringing up the boot media */
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_MEDIA, "spl_media");
+	fd = os_open(fname, OS_O_RDONLY);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_MEDIA);
+	if (fd < 0) {
+		printf("(OS image '%s' not found)\n", fname);
+		return -ENOENT;
+	}
+
+	ret = -EIO;
+	if (os_read(fd, &header, sizeof(header)) != sizeof(header))
+		goto err;
+	spl_image->flags |= SPL_COPY_PAYLOAD_ONLY;
+	ret = spl_parse_image_header(spl_image, &header);
+	if (ret)
+		goto err;
+	if (spl_image->os != IH_OS_LINUX) {
+		ret = -EPROTONOSUPPORT;
+		goto err;
+	}
+	buf = map_sysmem(spl_image->load_addr, spl_image->size);
+	if (os_read(fd, buf, spl_image->size) != spl_image->size)
+		ret = -EIO;
+	unmap_sysmem(buf);
+err:
+	os_close(fd);
+
+	return log_msg_ret("Load OS", ret);
+}
+
+/* Sandbox RAM address for loading images, leaving room for a FIT before it */
+#define SANDBOX_SPL_LOAD_BUF	SZ_16M
+
+struct image_header *spl_get_load_buffer(ssize_t offset, size_t size)
+{
+	return map_sysmem(SANDBOX_SPL_LOAD_BUF + offset, size);
+}
+
+/**
+ * spl_board_fit_read() - Read sectors from a FIT held in a host file
+ *
+ * The file is treated like a disk, so reading past its end gives zeroes.
+ */
+static ulong spl_board_fit_read(struct spl_load_info *load, ulong sector,
+				ulong count, void *buf)
+{
+	int fd = *(int *)load->priv;
+	ulong size = count * load->bl_len;
+	ssize_t len;
+
+	if (os_lseek(fd, sector * load->bl_len, OS_SEEK_SET) < 0)
+		return 0;
+	len = os_read(fd, buf, size);
+	if (len < 0)
+		return 0;
+	memset(buf + len, '\0', size - len);
+
+	return count;
+}
+
+/* Show where an image was loaded along with its checksum, for tests */
+static void spl_board_show_image(const char *name, ulong addr, ulong size)
+{
+	printf("FIT image %s: addr %lx size %lx crc32 %08x\n", name, addr, size,
+	       crc32(0, map_sysmem(addr, size), size));
+}
+
+/**
+ * spl_board_load_fit() - Load a FIT and show where its images ended up
+ *
+ * This lets tests check how SPL loads FITs from a block device. The images
+ * are not run, since sandbox cannot run them; SPL goes on to start U-Boot as
+ * usual.
+ *
+ * @spl_image: Place to put the image details
+ * @fname: Filename of the FIT on the host
+ * @return 0 if OK, -ve on error
+ */
+static int spl_board_load_fit(struct spl_image_info *spl_image,
+			      const char *fname)
+{
+	struct image_header *header;
+	struct spl_load_info load;
+	const void *fdt;
+	int node, subnode;
+	int ret;
+	int fd;
+
+	fd = os_open(fname, OS_O_RDONLY);
+	if (fd < 0) {
+		printf("(FIT '%s' not found)\n", fname);
+		return -ENOENT;
+	}
+	memset(&load, '\0', sizeof(load));
+	load.priv = &fd;
+	load.bl_len = 512;
+	load.read = spl_board_fit_read;
+
+	header = spl_get_load_buffer(-sizeof(*header), load.bl_len);
+	ret = -EIO;
+	if (spl_board_fit_read(&load, 0, 1, header) != 1)
+		goto err;
+	ret = -EPROTONOSUPPORT;
+	if (image_get_magic(header) != FDT_MAGIC)
+		goto err;
+	ret = spl_load_simple_fit(spl_image, &load, 0, header);
+	if (ret)
+		goto err;
+
+	spl_board_show_image("firmware", spl_image->load_addr, spl_image->size);
+
+	/* The loadables are recorded in the U-Boot devicetree */
+	fdt = spl_image->fdt_addr;
+	node = fdt ? fdt_path_offset(fdt, "/fit-images") : -FDT_ERR_NOTFOUND;
+	if (node >= 0) {
+		fdt_for_each_subnode(subnode, fdt, node) {
+			u32 addr, size;
+
+			addr = fdt_getprop_u32_default_node(fdt, subnode, 0,
+							    "load-addr", 0);
+			size = fdt_getprop_u32_default_node(fdt, subnode, 0,
+							    "size", 0);
+			spl_board_show_image(fdt_get_name(fdt, subnode, NULL),
+					     addr, size);
+		}
+	}
+err:
+	os_close(fd);
+
+	return log_msg_ret("Load FIT", ret);
+}
+
 static int spl_board_load_image(struct spl_image_info *spl_image,
 				struct spl_boot_device *bootdev)
 {
+	struct sandbox_state *state = state_get_current();
 	char fname[256];
 	int ret;
 
+	if (IS_ENABLED(CONFIG_SPL_OS_BOOT) && !spl_start_uboot())
+		return spl_board_load_os(spl_image, state->spl_os);
+
+	if (state->spl_fit) {
+		ret = spl_board_load_fit(spl_image, state->spl_fit);
+		if (ret)
+			return ret;
+	}
+
 	ret = os_find_u_boot(fname, sizeof(fname));
 	if (ret) {
 		printf("(%s not found, error %d)\n", fname, ret);
@@ -82,6 +248,26 @@ void __noreturn jump_to_image_no_args(struct spl_image_info *spl_image)
 	hang();
 }
 
+#ifdef CONFIG_SPL_OS_BOOT
+int spl_start_uboot(void)
+{
+	struct sandbox_state *state = state_get_current();
+
+	/* Boot the OS only if one was given with --spl_os */
+	return !state->spl_os;
+}
+
+void __noreturn jump_to_image_linux(struct spl_image_info *spl_image)
+{
+	void *buf = map_sysmem(spl_image->load_addr, spl_image->size);
+	int ret;
+
+	ret = os_jump_to_image(buf, spl_image->size);
+	printf("Cannot run OS image (err=%d)\n", ret);
+	hang();
+}
+#endif
+
 int handoff_arch_save(struct spl_handoff *ho)
 {
 	ho->arch.magic = TEST_HANDOFF_MAGIC;
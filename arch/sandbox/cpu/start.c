@@ -374,6 +374,24 @@ static int sandbox_cmdline_cb_show_of_platdata(struct sandbox_state *state,
 }
 SANDBOX_CMDLINE_OPT(show_of_platdata, 0, "Show of-platdata in SPL");
 
+static int sandbox_cmdline_cb_spl_os(struct sandbox_state *state,
+				     const char *arg)
+{
+	state->spl_os = arg;
+
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(spl_os, 1, "Boot this OS image from SPL (falcon mode)");
+
+static int sandbox_cmdline_cb_spl_fit(struct sandbox_state *state,
+				      const char *arg)
+{
+	state->spl_fit = arg;
+
+	return 0;
+}
+SANDBOX_CMDLINE_OPT(spl_fit, 1, "Load this FIT in SPL and show its images");
+
 static void setup_ram_buf(struct sandbox_state *state)
 {
 	/* Zero the RAM buffer if we didn't read it, to keep valgrind happy */
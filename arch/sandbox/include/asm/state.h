@@ -91,6 +91,8 @@ struct sandbox_state {
 	bool show_test_output;		/* Don't suppress stdout in tests */
 	int default_log_level;		/* Default log level for sandbox */
 	bool show_of_platdata;		/* Show of-platdata in SPL */
+	const char *spl_os;		/* OS image for SPL to boot (falcon) */
+	const char *spl_fit;		/* FIT for SPL to load and report */
 	bool ram_buf_read;		/* true if we read the RAM buffer */
 
 	/* Pointer to information for each SPI bus/cs */
@@ -15,6 +15,7 @@
 #define SANDBOX_PCI_SWAP_CASE_EMUL_ID	0x5678
 #define SANDBOX_PCI_PMC_EMUL_ID		0x5677
 #define SANDBOX_PCI_P2SB_EMUL_ID	0x5676
+#define SANDBOX_PCI_NVME_EMUL_ID	0x5675
 #define SANDBOX_PCI_CLASS_CODE		PCI_CLASS_CODE_COMM
 #define SANDBOX_PCI_CLASS_SUB_CODE	PCI_CLASS_SUB_CODE_COMM_SERIAL
 
@@ -108,6 +109,15 @@ long sandbox_i2c_rtc_get_set_base_time(struct udevice *dev, long base_time);
 
 int sandbox_usb_keyb_add_string(struct udevice *dev, const char *str);
 
+/**
+ * sandbox_usb_flash_get_max_read() - get the largest read seen by a stick
+ *
+ * @dev:		USB flash-stick emulator
+ * @return largest number of blocks requested by one read command since the
+ *	emulator was probed
+ */
+int sandbox_usb_flash_get_max_read(struct udevice *dev);
+
 /**
  * sandbox_osd_get_mem() - get the internal memory of a sandbox OSD
  *
@@ -139,6 +149,16 @@ int sandbox_pwm_get_config(struct udevice *dev, uint channel, uint *period_nsp,
  */
 void sandbox_sf_set_block_protect(struct udevice *dev, int bp_mask);
 
+/**
+ * sandbox_mmc_get_stop_stats() - Read back how multi-block reads were ended
+ *
+ * @dev: MMC controller device
+ * @sbc_countp: Returns the number of reads set up with CMD23 (SET_BLOCK_COUNT)
+ * @stop_countp: Returns the number of reads ended with CMD12 (STOP_TRANSMISSION)
+ */
+void sandbox_mmc_get_stop_stats(struct udevice *dev, uint *sbc_countp,
+				uint *stop_countp);
+
 /**
  * sandbox_get_codec_params() - Read back codec parameters
  *
@@ -244,4 +264,75 @@ uint sandbox_pci_read_bar(u32 barval, int type, uint size);
  */
 void sandbox_set_enable_memio(bool enable);
 
+struct udevice;
+
+/**
+ * typedef sandbox_mmio_write_t - Handle a write to emulated registers
+ *
+ * @dev: Emulator device
+ * @offset: Offset of the register written, from the base of the region
+ * @val: Value written
+ */
+typedef void (*sandbox_mmio_write_t)(struct udevice *dev, ulong offset,
+				     u64 val);
+
+/**
+ * sandbox_mmio_add() - Tell an emulator about writes to its registers
+ *
+ * Emulators hand out memory for a device's registers with map_physmem(), and
+ * writel() etc. just store to that memory. An emulator which must act on a
+ * write, e.g. to a doorbell register, can register the memory here. This only
+ * works while readl/writel() are enabled with sandbox_set_enable_memio().
+ *
+ * @dev: Emulator device
+ * @base: Start of the register memory
+ * @size: Size of the register memory in bytes
+ * @write: Function to call after each write to the memory
+ * @return 0 if OK, -ENOSPC if too many regions are registered
+ */
+int sandbox_mmio_add(struct udevice *dev, void *base, ulong size,
+		     sandbox_mmio_write_t write);
+
+/**
+ * sandbox_mmio_remove() - Stop telling an emulator about writes
+ *
+ * @dev: Emulator device, as passed to sandbox_mmio_add()
+ */
+void sandbox_mmio_remove(struct udevice *dev);
+
+/**
+ * sandbox_nvme_emul_set_fail_lba() - Make I/O to a block fail
+ *
+ * @emul: NVMe emulator device
+ * @lba: Block number; any read or write command which includes it completes
+ *	with an error. Use -1ULL to stop failing
+ */
+void sandbox_nvme_emul_set_fail_lba(struct udevice *emul, u64 lba);
+
+/**
+ * sandbox_nvme_emul_get_max_batch() - Get the largest batch of I/O commands
+ *
+ * @emul: NVMe emulator device
+ * @return largest number of I/O commands submitted with a single doorbell
+ *	write since the emulator was probed
+ */
+uint sandbox_nvme_emul_get_max_batch(struct udevice *emul);
+
+/**
+ * sandbox_serial_set_tx_room() - Set how many characters the uart accepts
+ *
+ * Once this many characters have been written, the sandbox uart reports that
+ * its transmit FIFO is full until this is called again.
+ *
+ * @room: Number of characters to accept, or -1 for no limit
+ */
+void sandbox_serial_set_tx_room(int room);
+
+/**
+ * sandbox_serial_get_tx_count() - Get the number of characters written
+ *
+ * @return number of characters the sandbox uart has accepted so far
+ */
+uint sandbox_serial_get_tx_count(void);
+
 #endif
@@ -10,6 +10,7 @@
 #include <common.h>
 #include <bootstage.h>
 #include <command.h>
+#include <console.h>
 #include <hang.h>
 #include <log.h>
 #include <dm/device.h>
@@ -42,6 +43,9 @@ void bootm_announce_and_cleanup(void)
 	bootstage_report();
 #endif
 
+	/* zboot does not go through bootm, so flush here as well */
+	console_flush();
+
 	/*
 	 * Call remove function of all devices with a removal flag set.
 	 * This may be useful for last-stage operations, like cancelling
@@ -9,6 +9,7 @@
  */
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <net.h>
 
 #ifdef CONFIG_CMD_GO
@@ -37,7 +38,9 @@ static int do_go(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 	 * pass address parameter as argv[0] (aka command name),
 	 * and all remaining args
 	 */
+	console_defer_suspend(true);
 	rc = do_go_exec ((void *)addr, argc - 1, argv + 1);
+	console_defer_suspend(false);
 	if (rc != 0) rcode = 1;
 
 	printf ("## Application terminated, rc = 0x%lX\n", rc);
@@ -6,6 +6,10 @@
 #include <common.h>
 #include <bootstage.h>
 #include <command.h>
+#include <env.h>
+#include <malloc.h>
+#include <mapmem.h>
+#include <os.h>
 
 static int do_bootstage_report(struct cmd_tbl *cmdtp, int flag, int argc,
 			       char *const argv[])
@@ -59,10 +63,63 @@ static int do_bootstage_stash(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#ifdef CONFIG_BOOTSTAGE_TRACE
+static int do_bootstage_export(struct cmd_tbl *cmdtp, int flag, int argc,
+			       char *const argv[])
+{
+	ulong base, size;
+	char *buf;
+	int len;
+
+	if (argc < 2)
+		return CMD_RET_USAGE;
+	len = bootstage_export(NULL, 0);
+#ifdef CONFIG_SANDBOX
+	if (!strcmp(argv[1], "-f")) {
+		int ret;
+
+		if (argc != 3)
+			return CMD_RET_USAGE;
+		buf = malloc(len + 1);
+		if (!buf) {
+			printf("Out of memory\n");
+			return CMD_RET_FAILURE;
+		}
+		bootstage_export(buf, len + 1);
+		ret = os_write_file(argv[2], buf, len);
+		free(buf);
+		if (ret) {
+			printf("Cannot write '%s' (err=%d)\n", argv[2], ret);
+			return CMD_RET_FAILURE;
+		}
+
+		return 0;
+	}
+#endif
+	if (get_base_size(argc, argv, &base, &size))
+		return CMD_RET_USAGE;
+	if (argc < 3)
+		size = len + 1;
+	if (len >= size) {
+		printf("Trace needs %#x bytes\n", len + 1);
+		return CMD_RET_FAILURE;
+	}
+	buf = map_sysmem(base, size);
+	bootstage_export(buf, size);
+	unmap_sysmem(buf);
+	env_set_hex("filesize", len);
+
+	return 0;
+}
+#endif
+
 static struct cmd_tbl cmd_bootstage_sub[] = {
 	U_BOOT_CMD_MKENT(report, 2, 1, do_bootstage_report, "", ""),
 	U_BOOT_CMD_MKENT(stash, 4, 0, do_bootstage_stash, "", ""),
 	U_BOOT_CMD_MKENT(unstash, 4, 0, do_bootstage_stash, "", ""),
+#ifdef CONFIG_BOOTSTAGE_TRACE
+	U_BOOT_CMD_MKENT(export, 4, 0, do_bootstage_export, "", ""),
+#endif
 };
 
 /*
@@ -93,4 +150,10 @@ U_BOOT_CMD(bootstage, 4, 1, do_boostage,
 	"report                      - Print a report\n"
 	"stash [<start> [<size>]]    - Stash data into memory\n"
 	"unstash [<start> [<size>]]  - Unstash data from memory"
+#ifdef CONFIG_BOOTSTAGE_TRACE
+	"\nexport <start> [<size>]     - Write a Chrome trace-event file to memory"
+#ifdef CONFIG_SANDBOX
+	"\nexport -f <filename>        - Write a Chrome trace-event file to the host"
+#endif
+#endif
 );
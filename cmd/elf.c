@@ -6,6 +6,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <cpu_func.h>
 #include <elf.h>
 #include <env.h>
@@ -78,7 +79,9 @@ int do_bootelf(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 	 * pass address parameter as argv[0] (aka command name),
 	 * and all remaining args
 	 */
+	console_defer_suspend(true);
 	rc = do_bootelf_exec((void *)addr, argc, argv);
+	console_defer_suspend(false);
 	if (rc != 0)
 		rcode = 1;
 
@@ -276,6 +279,7 @@ int do_bootvx(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 
 	printf("## Starting vxWorks at 0x%08lx ...\n", addr);
 
+	console_defer_suspend(true);
 	dcache_disable();
 #if defined(CONFIG_ARM64) && defined(CONFIG_ARMV8_PSCI)
 	armv8_setup_psci();
@@ -289,6 +293,7 @@ int do_bootvx(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 	((void (*)(int))addr)(0);
 #endif
 
+	console_defer_suspend(false);
 	puts("## vxWorks terminated\n");
 
 	return 1;
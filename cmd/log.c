@@ -103,6 +103,20 @@ static int do_log_rec(struct cmd_tbl *cmdtp, int flag, int argc,
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(LOG_BINARY)
+static int do_log_dump(struct cmd_tbl *cmdtp, int flag, int argc,
+		       char *const argv[])
+{
+	int count = 0;
+
+	if (argc > 1)
+		count = simple_strtoul(argv[1], NULL, 10);
+	log_binary_dump(count);
+
+	return 0;
+}
+#endif
+
 static struct cmd_tbl log_sub[] = {
 	U_BOOT_CMD_MKENT(level, CONFIG_SYS_MAXARGS, 1, do_log_level, "", ""),
 #ifdef CONFIG_LOG_TEST
@@ -110,6 +124,9 @@ static struct cmd_tbl log_sub[] = {
 #endif
 	U_BOOT_CMD_MKENT(format, CONFIG_SYS_MAXARGS, 1, do_log_format, "", ""),
 	U_BOOT_CMD_MKENT(rec, CONFIG_SYS_MAXARGS, 1, do_log_rec, "", ""),
+#if CONFIG_IS_ENABLED(LOG_BINARY)
+	U_BOOT_CMD_MKENT(dump, 2, 1, do_log_dump, "", ""),
+#endif
 };
 
 static int do_log(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
@@ -142,6 +159,10 @@ static char log_help_text[] =
 	"\tor 'default', or 'all' for all\n"
 	"log rec <category> <level> <file> <line> <func> <message> - "
 		"output a log record"
+#if CONFIG_IS_ENABLED(LOG_BINARY)
+	"\nlog dump [<count>] - show the last <count> (or all) records held "
+		"in memory"
+#endif
 	;
 #endif
 
@@ -0,0 +1,43 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Show malloc() heap usage
+ */
+
+#include <common.h>
+#include <command.h>
+#include <malloc.h>
+#include <mapmem.h>
+
+static int do_malloc_stats(struct cmd_tbl *cmdtp, int flag, int argc,
+			   char *const argv[])
+{
+	struct malloc_slab_stats stats;
+	ulong pages = 0, bytes = 0;
+	int i;
+
+	printf("heap:   %08lx, size %#lx\n",
+	       (ulong)map_to_sysmem((void *)mem_malloc_start),
+	       mem_malloc_end - mem_malloc_start);
+	printf("top:    %#lx bytes taken from the heap so far\n",
+	       mem_malloc_brk - mem_malloc_start);
+
+	if (malloc_slab_get_stats(0, &stats))
+		return CMD_RET_SUCCESS;
+
+	printf("\n size  pages    objs    used      allocs\n");
+	for (i = 0; !malloc_slab_get_stats(i, &stats); i++) {
+		printf("%5lu %6lu %7lu %7lu %11lu\n", stats.size, stats.pages,
+		       stats.objs, stats.used, stats.allocs);
+		pages += stats.pages;
+		bytes += stats.pages * stats.page_size;
+	}
+	printf("slab pages: %lu (%lu bytes)\n", pages, bytes);
+
+	return CMD_RET_SUCCESS;
+}
+
+static char malloc_help_text[] =
+	"stats - show heap usage and the slab size classes";
+
+U_BOOT_CMD_WITH_SUBCMDS(malloc, "malloc() heap information", malloc_help_text,
+			U_BOOT_SUBCMD_MKENT(stats, 1, 1, do_malloc_stats));
@@ -25,6 +25,7 @@
 
 #include <common.h>
 #include <cli.h>
+#include <cli_hush.h>
 #include <command.h>
 #include <console.h>
 #include <env.h>
@@ -262,6 +263,8 @@ static int _do_env_set(int flag, int argc, char *const argv[], int env_flag)
 	}
 
 	env_id++;
+	if (CONFIG_IS_ENABLED(HUSH_PARSE_CACHE))
+		parse_cache_invalidate(name);
 
 	/* Delete only ? */
 	if (argc < 3 || argv[2] == NULL) {
@@ -1239,6 +1242,27 @@ static int print_env_info(void)
 	return CMD_RET_SUCCESS;
 }
 
+/*
+ * print_env_stats - print environment hash table statistics
+ */
+static void print_env_stats(void)
+{
+	struct hsearch_stats stats;
+
+	hstats_r(&env_htab, &stats);
+	printf("env_entries = %u (%u deleted)\n", stats.filled,
+	       stats.deleted);
+	printf("env_table_size = %u\n", stats.size);
+	if (stats.size)
+		printf("env_load_factor = %u%%\n",
+		       stats.filled * 100 / stats.size);
+	if (stats.filled)
+		printf("env_probe_len = %u.%02u avg, %u max\n",
+		       stats.probe_total / stats.filled,
+		       stats.probe_total * 100 / stats.filled % 100,
+		       stats.probe_max);
+}
+
 #define ENV_INFO_IS_DEFAULT	BIT(0) /* default environment bit mask */
 #define ENV_INFO_IS_PERSISTED	BIT(1) /* environment persistence bit mask */
 
@@ -1246,6 +1270,7 @@ static int print_env_info(void)
  * env info - display environment information
  * env info [-d] - evaluate whether default environment is used
  * env info [-p] - evaluate whether environment can be persisted
+ * env info [-s] - display hash table statistics
  *      Add [-q] - quiet mode, use only for command result, for test by example:
  *                 test env info -p -d -q
  */
@@ -1255,6 +1280,7 @@ static int do_env_info(struct cmd_tbl *cmdtp, int flag,
 	int eval_flags = 0;
 	int eval_results = 0;
 	bool quiet = false;
+	bool stats = false;
 #if defined(CONFIG_CMD_SAVEENV) && defined(ENV_IS_IN_DEVICE)
 	enum env_location loc;
 #endif
@@ -1278,12 +1304,19 @@ static int do_env_info(struct cmd_tbl *cmdtp, int flag,
 			case 'q':
 				quiet = true;
 				break;
+			case 's':
+				stats = true;
+				break;
 			default:
 				return CMD_RET_USAGE;
 			}
 		}
 	}
 
+	/* display hash table statistics */
+	if (stats)
+		print_env_stats();
+
 	/* evaluate whether default environment is used */
 	if (eval_flags & ENV_INFO_IS_DEFAULT) {
 		if (gd->flags & GD_FLG_ENV_DEFAULT) {
@@ -1456,6 +1489,7 @@ static char env_help_text[] =
 	"      \"-d\": default environment is used\n"
 	"      \"-p\": environment can be persisted\n"
 	"      \"-q\": quiet output\n"
+	"env info -s - display hash table statistics\n"
 #endif
 	"env print [-a | name ...] - print environment\n"
 #if defined(CONFIG_CMD_NVEDIT_EFI)
@@ -7,6 +7,7 @@
 #include <common.h>
 #include <bootm.h>
 #include <bootstage.h>
+#include <console.h>
 #include <cpu_func.h>
 #include <efi_loader.h>
 #include <env.h>
@@ -610,9 +611,14 @@ __weak void board_preboot_os(void)
 int boot_selected_os(int argc, char *const argv[], int state,
 		     bootm_headers_t *images, boot_os_fn *boot_fn)
 {
+	/* Pass on the log records; failing to do so should not stop boot */
+	log_binary_to_bloblist();
 	arch_preboot_os();
 	board_preboot_os();
+	/* Anything still queued when the OS starts would be lost */
+	console_defer_suspend(true);
 	boot_fn(state, argc, argv, images);
+	console_defer_suspend(false);
 
 	/* Stand-alone may return when 'autostart' is 'no' */
 	if (images->os.type == IH_TYPE_STANDALONE ||
@@ -23,6 +23,10 @@ DECLARE_GLOBAL_DATA_PTR;
 
 enum {
 	RECORD_COUNT = CONFIG_VAL(BOOTSTAGE_RECORD_COUNT),
+#ifdef ENABLE_BOOTSTAGE_TRACE
+	SPAN_COUNT = CONFIG_BOOTSTAGE_TRACE_COUNT,
+#endif
+	SPAN_NAME_LEN = 22,
 };
 
 struct bootstage_record {
@@ -33,10 +37,27 @@ struct bootstage_record {
 	enum bootstage_id id;
 };
 
+/*
+ * A span of time between two points, e.g. a device probe. The name is held
+ * inline so that it survives relocation and the device being unbound.
+ */
+struct bootstage_span {
+	uint32_t start_us;
+	uint32_t end_us;
+	u8 cat;			/* enum bootstage_span_cat */
+	bool open;		/* true if bootstage_span_end() is not called yet */
+	char name[SPAN_NAME_LEN];
+};
+
 struct bootstage_data {
 	uint rec_count;
 	uint next_id;
 	struct bootstage_record record[RECORD_COUNT];
+#ifdef ENABLE_BOOTSTAGE_TRACE
+	uint span_count;
+	uint span_dropped;	/* Number of spans which did not fit */
+	struct bootstage_span span[SPAN_COUNT];
+#endif
 };
 
 enum {
@@ -189,6 +210,101 @@ ulong bootstage_mark_code(const char *file, const char *func, int linenum)
 	return bootstage_mark_name(BOOTSTAGE_ID_ALLOC, str);
 }
 
+/**
+ * Get a record name as a printable string
+ *
+ * @param buf	Buffer to put name if needed
+ * @param len	Length of buffer
+ * @param rec	Boot stage record to get the name from
+ * @return pointer to name, either from the record or pointing to buf.
+ */
+static const char *get_record_name(char *buf, int len,
+				   const struct bootstage_record *rec)
+{
+	if (rec->name)
+		return rec->name;
+	else if (rec->id >= BOOTSTAGE_ID_USER)
+		snprintf(buf, len, "user_%d", rec->id - BOOTSTAGE_ID_USER);
+	else
+		snprintf(buf, len, "id=%d", rec->id);
+
+	return buf;
+}
+
+#ifdef ENABLE_BOOTSTAGE_TRACE
+static const char *const span_cat_name[BOOTSTAGE_SPAN_CAT_COUNT] = {
+	"stage",
+	"probe",
+	"cmd",
+};
+
+int bootstage_span_start(const char *name, enum bootstage_span_cat cat)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (!data)
+		return -ENOSYS;
+	if (data->span_count == SPAN_COUNT) {
+		data->span_dropped++;
+		return -ENOSPC;
+	}
+	span = &data->span[data->span_count];
+	strlcpy(span->name, name ? name : "", sizeof(span->name));
+	span->cat = cat;
+	span->open = true;
+	span->end_us = 0;
+	span->start_us = timer_get_boot_us();
+
+	return data->span_count++;
+}
+
+void bootstage_span_end(int idx)
+{
+	struct bootstage_data *data = gd->bootstage;
+	struct bootstage_span *span;
+
+	if (!data || idx < 0 || idx >= data->span_count)
+		return;
+	span = &data->span[idx];
+	span->end_us = timer_get_boot_us();
+	span->open = false;
+}
+
+/**
+ * end_stage_span() - End the stage span for a record
+ *
+ * This closes the most recent open span started by bootstage_start() for the
+ * record, if any
+ *
+ * @data: Bootstage data
+ * @rec: Record being accumulated
+ */
+static void end_stage_span(struct bootstage_data *data,
+			   const struct bootstage_record *rec)
+{
+	const char *name;
+	char buf[20];
+	int i;
+
+	name = get_record_name(buf, sizeof(buf), rec);
+	for (i = data->span_count - 1; i >= 0; i--) {
+		struct bootstage_span *span = &data->span[i];
+
+		if (span->open && span->cat == BOOTSTAGE_SPAN_STAGE &&
+		    !strncmp(span->name, name, sizeof(span->name) - 1)) {
+			bootstage_span_end(i);
+			break;
+		}
+	}
+}
+#else
+static void end_stage_span(struct bootstage_data *data,
+			   const struct bootstage_record *rec)
+{
+}
+#endif /* ENABLE_BOOTSTAGE_TRACE */
+
 uint32_t bootstage_start(enum bootstage_id id, const char *name)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -196,8 +312,12 @@ uint32_t bootstage_start(enum bootstage_id id, const char *name)
 	ulong start_us = timer_get_boot_us();
 
 	if (rec) {
+		char buf[20];
+
 		rec->start_us = start_us;
 		rec->name = name;
+		bootstage_span_start(get_record_name(buf, sizeof(buf), rec),
+				     BOOTSTAGE_SPAN_STAGE);
 	}
 
 	return start_us;
@@ -213,31 +333,11 @@ uint32_t bootstage_accum(enum bootstage_id id)
 		return 0;
 	duration = (uint32_t)timer_get_boot_us() - rec->start_us;
 	rec->time_us += duration;
+	end_stage_span(data, rec);
 
 	return duration;
 }
 
-/**
- * Get a record name as a printable string
- *
- * @param buf	Buffer to put name if needed
- * @param len	Length of buffer
- * @param rec	Boot stage record to get the name from
- * @return pointer to name, either from the record or pointing to buf.
- */
-static const char *get_record_name(char *buf, int len,
-				   const struct bootstage_record *rec)
-{
-	if (rec->name)
-		return rec->name;
-	else if (rec->id >= BOOTSTAGE_ID_USER)
-		snprintf(buf, len, "user_%d", rec->id - BOOTSTAGE_ID_USER);
-	else
-		snprintf(buf, len, "id=%d", rec->id);
-
-	return buf;
-}
-
 static uint32_t print_time_record(struct bootstage_record *rec, uint32_t prev)
 {
 	char buf[20];
@@ -326,6 +426,58 @@ int bootstage_fdt_add_report(void)
 }
 #endif
 
+#ifdef ENABLE_BOOTSTAGE_TRACE
+enum {
+	SPAN_BUCKETS	= 6,	/* <10us, <100us, ... <100ms, >=100ms */
+};
+
+/**
+ * report_spans() - Print a histogram of span durations for each category
+ *
+ * @data: Bootstage data
+ */
+static void report_spans(struct bootstage_data *data)
+{
+	static const char *const bucket_name[SPAN_BUCKETS] = {
+		"<10us", "<100us", "<1ms", "<10ms", "<100ms", ">=100ms",
+	};
+	uint count[BOOTSTAGE_SPAN_CAT_COUNT][SPAN_BUCKETS] = {};
+	ulong total[BOOTSTAGE_SPAN_CAT_COUNT] = {};
+	uint32_t now = timer_get_boot_us();
+	int i, j;
+
+	for (i = 0; i < data->span_count; i++) {
+		struct bootstage_span *span = &data->span[i];
+		uint32_t dur, limit;
+
+		dur = (span->open ? now : span->end_us) - span->start_us;
+		for (j = 0, limit = 10; j < SPAN_BUCKETS - 1 && dur >= limit;
+		     j++)
+			limit *= 10;
+		count[span->cat][j]++;
+		total[span->cat] += dur;
+	}
+
+	printf("\nSpans (%d recorded, %d dropped):\n", data->span_count,
+	       data->span_dropped);
+	printf("%-8s", "Category");
+	for (j = 0; j < SPAN_BUCKETS; j++)
+		printf("%8s", bucket_name[j]);
+	printf("%11s\n", "Total");
+	for (i = 0; i < BOOTSTAGE_SPAN_CAT_COUNT; i++) {
+		printf("%-8s", span_cat_name[i]);
+		for (j = 0; j < SPAN_BUCKETS; j++)
+			printf("%8u", count[i][j]);
+		print_grouped_ull(total[i], BOOTSTAGE_DIGITS);
+		printf("\n");
+	}
+}
+#else
+static void report_spans(struct bootstage_data *data)
+{
+}
+#endif
+
 void bootstage_report(void)
 {
 	struct bootstage_data *data = gd->bootstage;
@@ -356,6 +508,7 @@ void bootstage_report(void)
 		if (rec->start_us)
 			prev = print_time_record(rec, -1);
 	}
+	report_spans(data);
 }
 
 /**
@@ -501,6 +654,93 @@ int bootstage_unstash(const void *base, int size)
 	return 0;
 }
 
+#ifdef ENABLE_BOOTSTAGE_TRACE
+/**
+ * Append formatted output to a memory buffer
+ *
+ * This works like append_data() but uses a printf()-style format string
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param fmt	printf() format string
+ */
+static void append_printf(char **ptrp, char *end, const char *fmt, ...)
+{
+	va_list args;
+	char *ptr = *ptrp;
+
+	va_start(args, fmt);
+	*ptrp += vsnprintf(ptr, ptr < end ? end - ptr : 0, fmt, args);
+	va_end(args);
+}
+
+/**
+ * Append a quoted JSON string to a memory buffer
+ *
+ * @param ptrp	Pointer to buffer, updated by this function
+ * @param end	Pointer to end of buffer
+ * @param str	String to write
+ */
+static void append_json_str(char **ptrp, char *end, const char *str)
+{
+	append_data(ptrp, end, "\"", 1);
+	for (; *str; str++) {
+		if (*str == '"' || *str == '\\')
+			append_printf(ptrp, end, "\\%c", *str);
+		else if ((uchar)*str < ' ')
+			append_printf(ptrp, end, "\\u%04x", *str);
+		else
+			append_data(ptrp, end, str, 1);
+	}
+	append_data(ptrp, end, "\"", 1);
+}
+
+int bootstage_export(char *buf, int size)
+{
+	const struct bootstage_data *data = gd->bootstage;
+	const struct bootstage_record *rec;
+	const struct bootstage_span *span;
+	char *ptr = buf, *end = buf + size;
+	uint32_t now = timer_get_boot_us();
+	const char *sep = "";
+	char name[20];
+	int i;
+
+	append_printf(&ptr, end, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for (rec = data->record, i = 0; i < data->rec_count; i++, rec++) {
+		if (rec->start_us ||
+		    (rec->id != BOOTSTAGE_ID_AWAKE && !rec->time_us))
+			continue;
+		append_printf(&ptr, end, "%s\n{\"name\":", sep);
+		append_json_str(&ptr, end,
+				get_record_name(name, sizeof(name), rec));
+		append_printf(&ptr, end,
+			      ",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%lu,\"pid\":0,\"tid\":0}",
+			      rec->time_us);
+		sep = ",";
+	}
+	for (span = data->span, i = 0; i < data->span_count; i++, span++) {
+		uint32_t dur;
+
+		dur = (span->open ? now : span->end_us) - span->start_us;
+		append_printf(&ptr, end, "%s\n{\"name\":", sep);
+		append_json_str(&ptr, end, span->name);
+		append_printf(&ptr, end,
+			      ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%u,\"dur\":%u,\"pid\":0,\"tid\":0}",
+			      span_cat_name[span->cat], span->start_us, dur);
+		sep = ",";
+	}
+	append_printf(&ptr, end, "\n],\"otherData\":{\"spans_dropped\":%u}}\n",
+		      data->span_dropped);
+
+	/* Add a terminator if there is space */
+	if (ptr < end)
+		*ptr = '\0';
+
+	return ptr - buf;
+}
+#endif /* ENABLE_BOOTSTAGE_TRACE */
+
 int bootstage_get_size(void)
 {
 	struct bootstage_data *data = gd->bootstage;
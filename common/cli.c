@@ -145,8 +145,12 @@ int do_run(struct cmd_tbl *cmdtp, int flag, int argc, char *const argv[])
 			return 1;
 		}
 
-		if (run_command(arg, flag | CMD_FLAG_ENV) != 0)
+		if (CONFIG_IS_ENABLED(HUSH_PARSE_CACHE)) {
+			if (parse_cached_string_outer(argv[i], arg))
+				return 1;
+		} else if (run_command(arg, flag | CMD_FLAG_ENV) != 0) {
 			return 1;
+		}
 	}
 	return 0;
 }
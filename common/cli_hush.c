@@ -84,6 +84,7 @@
 #include <cli.h>
 #include <cli_hush.h>
 #include <command.h>        /* find_cmd */
+#include <u-boot/crc.h>
 #ifndef CONFIG_SYS_PROMPT_HUSH_PS2
 #define CONFIG_SYS_PROMPT_HUSH_PS2	"> "
 #endif
@@ -1541,6 +1542,7 @@ static int run_pipe_real(struct pipe *pi)
 	struct child_prog *child;
 	struct built_in_command *x;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1553,6 +1555,7 @@ static int run_pipe_real(struct pipe *pi)
 	int flag = do_repeat ? CMD_FLAG_REPEAT : 0;
 	struct child_prog *child;
 	char *p;
+	int sp;
 # if __GNUC__
 	/* Avoid longjmp clobbering */
 	(void) &i;
@@ -1619,6 +1622,11 @@ static int run_pipe_real(struct pipe *pi)
 			}
 			return EXIT_SUCCESS;   /* don't worry about errors in set_local_var() yet */
 		}
+		/*
+		 * Count substitutions locally rather than in child->sp, since
+		 * the pipe may be run again from the parse cache
+		 */
+		sp = child->sp;
 		for (i = 0; is_assignment(child->argv[i]); i++) {
 			p = insert_var_value(child->argv[i]);
 #ifndef __U_BOOT__
@@ -1627,11 +1635,11 @@ static int run_pipe_real(struct pipe *pi)
 			set_local_var(p, 0);
 #endif
 			if (p != child->argv[i]) {
-				child->sp--;
+				sp--;
 				free(p);
 			}
 		}
-		if (child->sp) {
+		if (sp) {
 			char * str = NULL;
 
 			str = make_string(child->argv + i,
@@ -1764,6 +1772,7 @@ static int run_list_real(struct pipe *pi)
 	char *save_name = NULL;
 	char **list = NULL;
 	char **save_list = NULL;
+	struct pipe *save_pipe = NULL;
 	struct pipe *rpipe;
 	int flag_rep = 0;
 #ifndef __U_BOOT__
@@ -1803,7 +1812,8 @@ static int run_list_real(struct pipe *pi)
 				/* check Ctrl-C */
 				ctrlc();
 				if ((had_ctrlc())) {
-					return 1;
+					rcode = 1;
+					break;
 				}
 #endif
 				flag_restore = 0;
@@ -1832,6 +1842,7 @@ static int run_list_real(struct pipe *pi)
 				list = make_list_in(pi->next->progs->argv,
 					pi->progs->argv[0]);
 				save_list = list;
+				save_pipe = pi;
 				save_name = pi->progs->argv[0];
 				pi->progs->argv[0] = NULL;
 				flag_rep = 1;
@@ -1902,7 +1913,8 @@ static int run_list_real(struct pipe *pi)
 #else
 		if (rcode < -1) {
 			last_return_code = -rcode - 2;
-			return -2;	/* exit */
+			rcode = -2;	/* exit */
+			break;
 		}
 		last_return_code=(rcode == 0) ? 0 : 1;
 #endif
@@ -1922,6 +1934,17 @@ static int run_list_real(struct pipe *pi)
 		checkjobs(NULL);
 #endif
 	}
+	/*
+	 * If we left a "for" loop early, put back the variable name so that
+	 * the pipe list is intact in case it is run again
+	 */
+	if (list) {
+		free(save_pipe->progs->argv[0]);
+		while (*list)
+			free(*list++);
+		free(save_list);
+		save_pipe->progs->argv[0] = save_name;
+	}
 	return rcode;
 }
 
@@ -3283,6 +3306,190 @@ int parse_string_outer(const char *s, int flag)
 #endif
 }
 
+#ifdef CONFIG_HUSH_PARSE_CACHE
+/*
+ * Scripts run from the environment with 'run' are kept here after parsing,
+ * so that running them again (e.g. in a loop over boot devices) does not
+ * parse them again. Entries are keyed by the variable name and checked
+ * against a hash of the text, so a stale entry is never run.
+ */
+struct parse_cache {
+	char *name;		/* name of the variable, NULL if entry unused */
+	char *text;		/* script text which was parsed */
+	u32 hash;		/* crc32 of text */
+	struct pipe *list;	/* parsed script */
+	ulong last_used;	/* value of parse_cache_tick when last run */
+	bool busy;		/* script is running */
+	bool stale;		/* free the entry when the script finishes */
+};
+
+static struct parse_cache parse_cache[CONFIG_HUSH_PARSE_CACHE_ENTRIES];
+static ulong parse_cache_tick;
+
+static void parse_cache_free(struct parse_cache *pc)
+{
+	free(pc->name);
+	free(pc->text);
+	free_pipe_list(pc->list, 0);
+	memset(pc, '\0', sizeof(*pc));
+}
+
+void parse_cache_invalidate(const char *name)
+{
+	struct parse_cache *pc;
+
+	for (pc = parse_cache; pc != parse_cache + ARRAY_SIZE(parse_cache);
+	     pc++) {
+		if (!pc->name || strcmp(pc->name, name))
+			continue;
+		if (pc->busy)
+			pc->stale = true;
+		else
+			parse_cache_free(pc);
+	}
+}
+
+static struct parse_cache *parse_cache_lookup(const char *name)
+{
+	struct parse_cache *pc;
+
+	for (pc = parse_cache; pc != parse_cache + ARRAY_SIZE(parse_cache);
+	     pc++) {
+		if (pc->name && !pc->stale && !strcmp(pc->name, name))
+			return pc;
+	}
+
+	return NULL;
+}
+
+/* Add a parsed script, evicting the least recently used one if needed */
+static struct parse_cache *parse_cache_add(const char *name, const char *text,
+					   u32 hash, struct pipe *list)
+{
+	struct parse_cache *pc, *victim = NULL;
+
+	for (pc = parse_cache; pc != parse_cache + ARRAY_SIZE(parse_cache);
+	     pc++) {
+		if (pc->busy)
+			continue;
+		if (!pc->name) {
+			victim = pc;
+			break;
+		}
+		if (!victim || pc->last_used < victim->last_used)
+			victim = pc;
+	}
+	if (!victim)
+		return NULL;
+	if (victim->name)
+		parse_cache_free(victim);
+	victim->name = strdup(name);
+	victim->text = strdup(text);
+	if (!victim->name || !victim->text) {
+		free(victim->name);
+		free(victim->text);
+		memset(victim, '\0', sizeof(*victim));
+		return NULL;
+	}
+	victim->hash = hash;
+	victim->list = list;
+
+	return victim;
+}
+
+/* Parse a script into a pipe list, without running it */
+static struct pipe *parse_string_list(const char *s, int flag)
+{
+	struct in_str input;
+	struct p_context ctx;
+	o_string temp = NULL_O_STRING;
+	char *p;
+	int rcode;
+
+	/* Add a newline at the end, as parse_string_outer() does */
+	p = xmalloc(strlen(s) + 2);
+	strcpy(p, s);
+	s = strchr(s, '\n');
+	if (!s || s[1])
+		strcat(p, "\n");
+	setup_string_in_str(&input, p);
+
+	ctx.type = flag;
+	initialize_context(&ctx);
+	update_ifs_map();
+	rcode = parse_stream(&temp, &ctx, &input,
+			     flag & FLAG_CONT_ON_NEWLINE ? -1 : '\n');
+	free(p);
+	if (rcode != 1 && ctx.old_flag == 0) {
+		done_word(&temp, &ctx);
+		done_pipe(&ctx, PIPE_SEQ);
+		b_free(&temp);
+		return ctx.list_head;
+	}
+
+	flag_repeat = 0;
+	if (ctx.old_flag != 0) {
+		syntax();
+		free(ctx.stack);
+	}
+	b_free(&temp);
+	free_pipe_list(ctx.list_head, 0);
+
+	return NULL;
+}
+
+int parse_cached_string_outer(const char *name, const char *s)
+{
+	const int flag = FLAG_PARSE_SEMICOLON | FLAG_EXIT_FROM_LOOP |
+		FLAG_CONT_ON_NEWLINE;
+	struct parse_cache *pc;
+	struct pipe *list;
+	u32 hash;
+	int code;
+
+	if (!s)
+		return 1;
+	if (!*s)
+		return 0;
+	hash = crc32(0, (const uchar *)s, strlen(s));
+	pc = parse_cache_lookup(name);
+	if (pc && (pc->hash != hash || strcmp(pc->text, s))) {
+		parse_cache_invalidate(name);
+		pc = NULL;
+	}
+
+	/* A script which runs itself gets a private copy */
+	if (pc && pc->busy)
+		return parse_string_outer(s, flag);
+
+	if (!pc) {
+		list = parse_string_list(s, flag);
+		if (!list)
+			return 1;
+		pc = parse_cache_add(name, s, hash, list);
+		if (!pc) {
+			/* No room, so run it once and throw it away */
+			code = run_list(list);
+			goto done;
+		}
+	}
+
+	pc->busy = true;
+	pc->last_used = ++parse_cache_tick;
+	code = run_list_real(pc->list);
+	pc->busy = false;
+	if (pc->stale)
+		parse_cache_free(pc);
+done:
+	if (code == -2)		/* exit */
+		code = 0;
+	else if (code == -1)
+		flag_repeat = 0;
+
+	return code != 0;
+}
+#endif /* CONFIG_HUSH_PARSE_CACHE */
+
 #ifndef __U_BOOT__
 static int parse_file_outer(FILE *f)
 #else
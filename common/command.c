@@ -9,13 +9,17 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <compiler.h>
 #include <command.h>
 #include <console.h>
 #include <env.h>
 #include <log.h>
+#include <malloc.h>
 #include <linux/ctype.h>
 
+DECLARE_GLOBAL_DATA_PTR;
+
 /*
  * Use puts() instead of printf() to avoid printf buffer overflow
  * for long help messages
@@ -120,10 +124,116 @@ struct cmd_tbl *find_cmd_tbl(const char *cmd, struct cmd_tbl *table,
 	return NULL;	/* not found or ambiguous command */
 }
 
+#ifdef CONFIG_CMDLINE
+/*
+ * find_cmd() looks commands up through an index of the command table sorted
+ * by name, so that each lookup is a binary search rather than a walk of the
+ * whole table. It is built on first use, once U-Boot has relocated and
+ * malloc() is available, so the entries do not move after that. Before then,
+ * and for other tables such as sub-commands, find_cmd_tbl() is used.
+ */
+static struct cmd_tbl **cmd_index;
+static int cmd_index_len;
+
+/*
+ * Compare the first len characters of cmd with a command name, where a
+ * prefix of the name sorts before the name
+ */
+static int cmd_name_cmp(const char *cmd, int len, const char *name)
+{
+	int ret;
+
+	ret = strncmp(cmd, name, len);
+	if (ret)
+		return ret;
+
+	return name[len] ? -1 : 0;
+}
+
+/* Set up cmd_index, returning true if it can be used */
+static bool cmd_index_ready(struct cmd_tbl *table, int table_len)
+{
+	struct cmd_tbl *cmdtp;
+
+	if (cmd_index)
+		return true;
+	if (!(gd->flags & GD_FLG_RELOC))
+		return false;
+	cmd_index = malloc(table_len * sizeof(*cmd_index));
+	if (!cmd_index)
+		return false;
+
+	/* Insertion sort, keeping commands of the same name in table order */
+	for (cmdtp = table; cmdtp != table + table_len; cmdtp++) {
+		int lo = 0, hi = cmd_index_len;
+
+		while (lo < hi) {
+			int mid = lo + (hi - lo) / 2;
+
+			if (strcmp(cmd_index[mid]->name, cmdtp->name) <= 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+		memmove(&cmd_index[lo + 1], &cmd_index[lo],
+			(cmd_index_len - lo) * sizeof(*cmd_index));
+		cmd_index[lo] = cmdtp;
+		cmd_index_len++;
+	}
+
+	return true;
+}
+
+/* Same as find_cmd_tbl() but using cmd_index */
+static struct cmd_tbl *find_cmd_index(const char *cmd)
+{
+	struct cmd_tbl *cmdtp;
+	const char *p;
+	int len, lo, hi;
+
+	if (!cmd)
+		return NULL;
+	len = ((p = strchr(cmd, '.')) == NULL) ? strlen(cmd) : (p - cmd);
+
+	/* Find the first command which does not sort before cmd */
+	lo = 0;
+	hi = cmd_index_len;
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+
+		if (cmd_name_cmp(cmd, len, cmd_index[mid]->name) > 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	if (lo == cmd_index_len)
+		return NULL;
+
+	/* A full match sorts before all commands which it abbreviates */
+	cmdtp = cmd_index[lo];
+	if (strncmp(cmd, cmdtp->name, len))
+		return NULL;
+	if (!cmdtp->name[len])
+		return cmdtp;
+
+	/* An abbreviation must match exactly one command */
+	if (lo + 1 < cmd_index_len &&
+	    !strncmp(cmd, cmd_index[lo + 1]->name, len))
+		return NULL;
+
+	return cmdtp;
+}
+#endif /* CONFIG_CMDLINE */
+
 struct cmd_tbl *find_cmd(const char *cmd)
 {
 	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
 	const int len = ll_entry_count(struct cmd_tbl, cmd);
+
+#ifdef CONFIG_CMDLINE
+	if (cmd_index_ready(start, len))
+		return find_cmd_index(cmd);
+#endif
 	return find_cmd_tbl(cmd, start, len);
 }
 
@@ -489,8 +599,6 @@ int cmd_get_data_size(char* arg, int default_size)
 #endif
 
 #if defined(CONFIG_NEEDS_MANUAL_RELOC)
-DECLARE_GLOBAL_DATA_PTR;
-
 void fixup_cmdtable(struct cmd_tbl *cmdtp, int size)
 {
 	int	i;
@@ -577,8 +685,11 @@ static int cmd_call(struct cmd_tbl *cmdtp, int flag, int argc,
 		    char *const argv[], int *repeatable)
 {
 	int result;
+	int span;
 
+	span = bootstage_span_start(cmdtp->name, BOOTSTAGE_SPAN_CMD);
 	result = cmdtp->cmd_rep(cmdtp, flag, argc, argv, repeatable);
+	bootstage_span_end(span);
 	if (result)
 		debug("Command failed, result=%d\n", result);
 	return result;
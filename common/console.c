@@ -11,8 +11,10 @@
 #include <env.h>
 #include <stdarg.h>
 #include <iomux.h>
+#include <log.h>
 #include <malloc.h>
 #include <mapmem.h>
+#include <membuff.h>
 #include <os.h>
 #include <serial.h>
 #include <stdio_dev.h>
@@ -43,7 +45,7 @@ static int on_console(const char *name, const char *value, enum env_op op,
 	switch (op) {
 	case env_op_create:
 	case env_op_overwrite:
-
+		console_flush();
 #if CONFIG_IS_ENABLED(CONSOLE_MUX)
 		if (iomux_doenv(console, value))
 			return 1;
@@ -254,6 +256,7 @@ static void console_puts_select(int file, bool serial_only, const char *s)
 
 void console_puts_select_stderr(bool serial_only, const char *s)
 {
+	console_flush();
 	console_puts_select(stderr, serial_only, s);
 }
 
@@ -310,6 +313,156 @@ static inline void console_doenv(int file, struct stdio_dev *dev)
 #endif
 #endif /* CONIFIG_IS_ENABLED(CONSOLE_MUX) */
 
+#if CONFIG_IS_ENABLED(CONSOLE_DEFER)
+/** Deferred console output ************************************************/
+
+static struct membuff defer_buf;
+static bool defer_disabled;	/* set by the 'consoledefer' variable */
+static bool defer_suspended;	/* handing over to an OS or application */
+static bool defer_busy;		/* writing out the buffer, don't recurse */
+
+static int on_consoledefer(const char *name, const char *value,
+			   enum env_op op, int flags)
+{
+	bool disable = value && *value && strchr("nN0fF", *value);
+
+	if (disable && !defer_disabled)
+		console_flush();
+	defer_disabled = disable;
+
+	return 0;
+}
+U_BOOT_ENV_CALLBACK(consoledefer, on_consoledefer);
+
+static void console_defer_init(void)
+{
+	if (!defer_buf.start &&
+	    membuff_new(&defer_buf, CONFIG_CONSOLE_DEFER_SIZE))
+		log_warning("Cannot allocate deferred console buffer\n");
+}
+
+/**
+ * console_stdout_devs() - Get the list of devices used for stdout
+ *
+ * @devsp: Returns a pointer to the device list
+ * @return number of devices in the list
+ */
+static int console_stdout_devs(struct stdio_dev ***devsp)
+{
+#if CONFIG_IS_ENABLED(CONSOLE_MUX)
+	*devsp = console_devices[stdout];
+
+	return cd_count[stdout];
+#else
+	*devsp = &stdio_devices[stdout];
+
+	return stdio_devices[stdout] ? 1 : 0;
+#endif
+}
+
+/**
+ * console_defer_write() - Write out buffered console output
+ *
+ * If @wait is false, the first serial device on stdout sets the pace: only
+ * as many characters as it accepts without waiting are taken from the
+ * buffer, and the same characters are then sent to the other devices.
+ *
+ * @wait: true to write out everything, false to stop as soon as the serial
+ *	device would block
+ */
+static void console_defer_write(bool wait)
+{
+	struct stdio_dev **devs, *pacer = NULL;
+	int count, i;
+
+	if (defer_busy || !defer_buf.start)
+		return;
+	defer_busy = true;
+
+	count = console_stdout_devs(&devs);
+	for (i = 0; !wait && i < count; i++) {
+		if ((devs[i]->flags & DEV_FLAGS_DM) &&
+		    console_dev_is_serial(devs[i])) {
+			pacer = devs[i];
+			break;
+		}
+	}
+
+	for (;;) {
+		char buf[64], *data;
+		int len, done;
+
+		len = membuff_getraw(&defer_buf, sizeof(buf) - 1, false, &data);
+		if (!len)
+			break;
+		memcpy(buf, data, len);
+		done = pacer ? serial_try_puts(pacer->priv, buf, len) : len;
+		buf[done] = '\0';
+		for (i = 0; done && i < count; i++) {
+			if (devs[i] != pacer && devs[i]->puts)
+				devs[i]->puts(devs[i], buf);
+		}
+		membuff_getraw(&defer_buf, done, true, &data);
+		if (done < len)
+			break;
+	}
+
+	defer_busy = false;
+}
+
+/**
+ * console_defer_puts() - Queue output for stdout
+ *
+ * @s: Characters to queue (must not include a nul character)
+ * @len: Number of characters
+ * @return true if the output was queued, false if it must be written directly
+ */
+static bool console_defer_puts(const char *s, int len)
+{
+	if (!defer_buf.start || defer_disabled || defer_suspended ||
+	    defer_busy)
+		return false;
+
+	while (len) {
+		int done = membuff_put(&defer_buf, s, len);
+
+		s += done;
+		len -= done;
+		if (len)
+			console_defer_write(true);
+	}
+	console_defer_write(false);
+
+	return true;
+}
+
+static void console_drain(void)
+{
+	console_defer_write(false);
+}
+
+void console_flush(void)
+{
+	console_defer_write(true);
+}
+
+void console_defer_suspend(bool suspend)
+{
+	if (suspend)
+		console_flush();
+	defer_suspended = suspend;
+}
+#else
+static inline void console_defer_init(void) {}
+
+static inline bool console_defer_puts(const char *s, int len)
+{
+	return false;
+}
+
+static inline void console_drain(void) {}
+#endif /* CONFIG_IS_ENABLED(CONSOLE_DEFER) */
+
 /** U-Boot INITIAL CONSOLE-NOT COMPATIBLE FUNCTIONS *************************/
 
 int serial_printf(const char *fmt, ...)
@@ -338,6 +491,7 @@ int fgetc(int file)
 		 */
 		for (;;) {
 			WATCHDOG_RESET();
+			console_drain();
 #if CONFIG_IS_ENABLED(CONSOLE_MUX)
 			/*
 			 * Upper layer may have already called tstc() so
@@ -365,22 +519,32 @@ int fgetc(int file)
 
 int ftstc(int file)
 {
-	if (file < MAX_FILES)
+	if (file < MAX_FILES) {
+		console_drain();
 		return console_tstc(file);
+	}
 
 	return -1;
 }
 
 void fputc(int file, const char c)
 {
-	if (file < MAX_FILES)
+	if (file < MAX_FILES) {
+		if (file == stdout && c && console_defer_puts(&c, 1))
+			return;
+		console_flush();
 		console_putc(file, c);
+	}
 }
 
 void fputs(int file, const char *s)
 {
-	if (file < MAX_FILES)
+	if (file < MAX_FILES) {
+		if (file == stdout && console_defer_puts(s, strlen(s)))
+			return;
+		console_flush();
 		console_puts(file, s);
+	}
 }
 
 int fprintf(int file, const char *fmt, ...)
@@ -661,6 +825,7 @@ static int ctrlc_disabled = 0;	/* see disable_ctrl() */
 static int ctrlc_was_pressed = 0;
 int ctrlc(void)
 {
+	console_drain();
 	if (!ctrlc_disabled && gd->have_console) {
 		if (tstc()) {
 			switch (getc()) {
@@ -927,6 +1092,7 @@ done:
 	}
 #endif /* CONFIG_SYS_CONSOLE_ENV_OVERWRITE */
 
+	console_defer_init();
 	gd->flags |= GD_FLG_DEVINIT;	/* device initialization completed */
 
 #if 0
@@ -1010,6 +1176,7 @@ int console_init_r(void)
 		env_set(stdio_names[i], stdio_devices[i]->name);
 	}
 
+	console_defer_init();
 	gd->flags |= GD_FLG_DEVINIT;	/* device initialization completed */
 
 #if 0
@@ -7,6 +7,9 @@
 
 #include <malloc.h>
 #include <asm/io.h>
+#include <linux/bitops.h>
+#include <linux/errno.h>
+#include <linux/list.h>
 
 #ifdef DEBUG
 #if __STD_C
@@ -604,8 +607,222 @@ void *sbrk(ptrdiff_t increment)
 	return (void *)old;
 }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+/*
+ * Size-class front end for small allocations
+ *
+ * Requests of up to SLAB_MAX_SIZE bytes are served from 4KiB slab pages,
+ * each holding objects of a single size class on a free list. The pages
+ * themselves come from dlmalloc. A bitmap with one bit per page of the
+ * malloc() area tells free() whether a pointer lies in a slab page, so
+ * no per-object header is needed.
+ */
+
+#define SLAB_PAGE_SHIFT		12
+#define SLAB_PAGE_SIZE		(1UL << SLAB_PAGE_SHIFT)
+#define SLAB_MAX_SIZE		512
+#define SLAB_GRANULE		16
+
+/**
+ * struct slab_page - header at the start of each slab page
+ *
+ * @link:	entry in the partial list of the class, empty if full
+ * @free:	first free object, each free object points to the next one
+ * @inuse:	number of objects allocated from this page
+ * @class:	index into slab_classes[]
+ */
+struct slab_page {
+	struct list_head link;
+	void *free;
+	unsigned short inuse;
+	unsigned short class;
+};
+
+#define SLAB_HDR_SIZE	ALIGN(sizeof(struct slab_page), SLAB_GRANULE)
+
+/**
+ * struct slab_class - a size class
+ *
+ * @partial:	pages with at least one free object
+ * @stats:	usage statistics
+ */
+struct slab_class {
+	struct list_head partial;
+	struct malloc_slab_stats stats;
+};
+
+static const unsigned short slab_sizes[] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512
+};
+
+static struct slab_class slab_classes[ARRAY_SIZE(slab_sizes)];
+static unsigned char slab_index[SLAB_MAX_SIZE / SLAB_GRANULE + 1];
+static unsigned long *slab_map;
+static ulong slab_base;
+static ulong slab_npages;
+static ulong slab_page_bytes;	/* heap bytes held by slab pages */
+static ulong slab_used_bytes;	/* bytes in allocated slab objects */
+
+static ulong slab_map_size(ulong size)
+{
+	ulong pages = (size >> SLAB_PAGE_SHIFT) + 2;
+
+	return ALIGN(BITS_TO_LONGS(pages) * sizeof(long), MALLOC_ALIGNMENT);
+}
+
+static void slab_init(void *map, ulong start, ulong end)
+{
+	int i, c;
+
+	slab_map = map;
+	slab_base = start & ~(SLAB_PAGE_SIZE - 1);
+	slab_npages = (end - slab_base + SLAB_PAGE_SIZE - 1) >> SLAB_PAGE_SHIFT;
+	memset(slab_map, '\0', BITS_TO_LONGS(slab_npages) * sizeof(long));
+	slab_page_bytes = 0;
+	slab_used_bytes = 0;
+
+	for (c = 0, i = 0; i < ARRAY_SIZE(slab_index); i++) {
+		while (i * SLAB_GRANULE > slab_sizes[c])
+			c++;
+		slab_index[i] = c;
+	}
+	for (c = 0; c < ARRAY_SIZE(slab_classes); c++) {
+		INIT_LIST_HEAD(&slab_classes[c].partial);
+		memset(&slab_classes[c].stats, '\0',
+		       sizeof(slab_classes[c].stats));
+		slab_classes[c].stats.size = slab_sizes[c];
+	}
+}
+
+/* Return the slab page holding @mem, or NULL if it is not a slab object */
+static struct slab_page *slab_page_of(Void_t *mem)
+{
+	ulong page = ((ulong)mem - slab_base) >> SLAB_PAGE_SHIFT;
+
+	if (!slab_map || (ulong)mem < slab_base || page >= slab_npages)
+		return NULL;
+	if (!(slab_map[page / BITS_PER_LONG] & (1UL << (page % BITS_PER_LONG))))
+		return NULL;
+
+	return (struct slab_page *)((ulong)mem & ~(SLAB_PAGE_SIZE - 1));
+}
+
+static void slab_map_set(struct slab_page *page, bool set)
+{
+	ulong bit = ((ulong)page - slab_base) >> SLAB_PAGE_SHIFT;
+	ulong mask = 1UL << (bit % BITS_PER_LONG);
+
+	if (set)
+		slab_map[bit / BITS_PER_LONG] |= mask;
+	else
+		slab_map[bit / BITS_PER_LONG] &= ~mask;
+}
+
+static struct slab_page *slab_grow(int class)
+{
+	struct slab_class *cls = &slab_classes[class];
+	ulong size = cls->stats.size;
+	struct slab_page *page;
+	char *obj, *end;
+
+	page = mEMALIGn(SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+	if (!page)
+		return NULL;
+
+	page->class = class;
+	page->inuse = 0;
+	page->free = NULL;
+	end = (char *)page + SLAB_PAGE_SIZE - size;
+	for (obj = end; obj >= (char *)page + SLAB_HDR_SIZE; obj -= size) {
+		*(void **)obj = page->free;
+		page->free = obj;
+	}
+	list_add(&page->link, &cls->partial);
+	slab_map_set(page, true);
+
+	cls->stats.pages++;
+	cls->stats.objs += (SLAB_PAGE_SIZE - SLAB_HDR_SIZE) / size;
+	slab_page_bytes += chunksize(mem2chunk(page));
+
+	return page;
+}
+
+static Void_t *slab_alloc(size_t bytes)
+{
+	int class = slab_index[(bytes + SLAB_GRANULE - 1) / SLAB_GRANULE];
+	struct slab_class *cls = &slab_classes[class];
+	struct slab_page *page;
+	void *obj;
+
+	if (list_empty(&cls->partial)) {
+		page = slab_grow(class);
+		if (!page)
+			return NULL;
+	} else {
+		page = list_first_entry(&cls->partial, struct slab_page, link);
+	}
+
+	obj = page->free;
+	page->free = *(void **)obj;
+	page->inuse++;
+	if (!page->free)
+		list_del_init(&page->link);
+
+	cls->stats.used++;
+	cls->stats.allocs++;
+	slab_used_bytes += cls->stats.size;
+
+	return obj;
+}
+
+static void slab_free(struct slab_page *page, Void_t *mem)
+{
+	struct slab_class *cls = &slab_classes[page->class];
+
+	if (!page->free)
+		list_add(&page->link, &cls->partial);
+	*(void **)mem = page->free;
+	page->free = mem;
+	page->inuse--;
+
+	cls->stats.used--;
+	slab_used_bytes -= cls->stats.size;
+
+	/* Keep one page per class to avoid thrashing, release the others */
+	if (!page->inuse && !list_is_singular(&cls->partial)) {
+		list_del(&page->link);
+		slab_map_set(page, false);
+		cls->stats.pages--;
+		cls->stats.objs -= (SLAB_PAGE_SIZE - SLAB_HDR_SIZE) /
+				   cls->stats.size;
+		slab_page_bytes -= chunksize(mem2chunk(page));
+		fREe(page);
+	}
+}
+
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats)
+{
+	if (class < 0 || class >= ARRAY_SIZE(slab_classes))
+		return -ENOENT;
+	*stats = slab_classes[class].stats;
+	stats->page_size = SLAB_PAGE_SIZE;
+
+	return 0;
+}
+#else
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats)
+{
+	return -ENOSYS;
+}
+#endif /* SYS_MALLOC_SLAB */
+
 void mem_malloc_init(ulong start, ulong size)
 {
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	/* The slab page bitmap lives at the top of the area */
+	size -= slab_map_size(size);
+	slab_init((void *)(start + size), start, start + size);
+#endif
 	mem_malloc_start = start;
 	mem_malloc_end = start + size;
 	mem_malloc_brk = start;
@@ -1270,9 +1487,9 @@ static void malloc_extend_top(nb) INTERNAL_SIZE_T nb;
 */
 
 #if __STD_C
-Void_t* mALLOc(size_t bytes)
+static Void_t* mALLOc_chunk(size_t bytes)
 #else
-Void_t* mALLOc(bytes) size_t bytes;
+static Void_t* mALLOc_chunk(bytes) size_t bytes;
 #endif
 {
   mchunkptr victim;                  /* inspected/selected chunk */
@@ -1516,6 +1733,24 @@ Void_t* mALLOc(bytes) size_t bytes;
 
 }
 
+#if __STD_C
+Void_t* mALLOc(size_t bytes)
+#else
+Void_t* mALLOc(bytes) size_t bytes;
+#endif
+{
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (bytes <= SLAB_MAX_SIZE && slab_map &&
+	    (gd->flags & GD_FLG_FULL_MALLOC_INIT)) {
+		Void_t *mem = slab_alloc(bytes);
+
+		if (mem)
+			return mem;
+	}
+#endif
+
+	return mALLOc_chunk(bytes);
+}
 
 
 
@@ -1557,6 +1792,9 @@ void fREe(mem) Void_t* mem;
   mchunkptr bck;       /* misc temp for linking */
   mchunkptr fwd;       /* misc temp for linking */
   int       islr;      /* track whether merging with last_remainder */
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  struct slab_page *slab; /* slab page holding mem */
+#endif
 
 #if CONFIG_VAL(SYS_MALLOC_F_LEN)
 	/* free() is a no-op - all the memory will be freed on relocation */
@@ -1567,6 +1805,14 @@ void fREe(mem) Void_t* mem;
   if (mem == NULL)                              /* free(0) has no effect */
     return;
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	slab = slab_page_of(mem);
+	if (slab) {
+		slab_free(slab, mem);
+		return;
+	}
+#endif
+
   p = mem2chunk(mem);
   hd = p->size;
 
@@ -1705,6 +1951,9 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
   mchunkptr bck;              /* misc temp for linking */
   mchunkptr fwd;              /* misc temp for linking */
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  struct slab_page *slab;     /* slab page holding oldmem */
+#endif
 
 #ifdef REALLOC_ZERO_BYTES_FREES
   if (!bytes) {
@@ -1725,6 +1974,22 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 	}
 #endif
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	slab = slab_page_of(oldmem);
+	if (slab) {
+		size_t size = slab_classes[slab->class].stats.size;
+
+		if (bytes <= size)
+			return oldmem;
+		newmem = mALLOc(bytes);
+		if (!newmem)
+			return NULL;
+		memcpy(newmem, oldmem, size);
+		slab_free(slab, oldmem);
+		return newmem;
+	}
+#endif
+
   newp    = oldp    = mem2chunk(oldmem);
   newsize = oldsize = chunksize(oldp);
 
@@ -1741,7 +2006,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
     /* Note the extra SIZE_SZ overhead. */
     if(oldsize - SIZE_SZ >= nb) return oldmem; /* do nothing */
     /* Must alloc, copy, free. */
-    newmem = mALLOc(bytes);
+    newmem = mALLOc_chunk(bytes);
     if (!newmem)
 	return NULL; /* propagate failure */
     MALLOC_COPY(newmem, oldmem, oldsize - 2*SIZE_SZ);
@@ -1844,7 +2109,7 @@ Void_t* rEALLOc(oldmem, bytes) Void_t* oldmem; size_t bytes;
 
     /* Must allocate */
 
-    newmem = mALLOc (bytes);
+    newmem = mALLOc_chunk(bytes);
 
     if (newmem == NULL)  /* propagate failure */
       return NULL;
@@ -1944,7 +2209,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
   /* Call malloc with worst case padding to hit alignment. */
 
   nb = request2size(bytes);
-  m  = (char*)(mALLOc(nb + alignment + MINSIZE));
+  m  = (char*)(mALLOc_chunk(nb + alignment + MINSIZE));
 
   /*
   * The attempt to over-allocate (with a size large enough to guarantee the
@@ -1960,7 +2225,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
      * Use bytes not nb, since mALLOc internally calls request2size too, and
      * each call increases the size to allocate, to account for the header.
      */
-    m  = (char*)(mALLOc(bytes));
+    m  = (char*)(mALLOc_chunk(bytes));
     /* Aligned -> return it */
     if ((((unsigned long)(m)) % alignment) == 0)
       return m;
@@ -1971,7 +2236,7 @@ Void_t* mEMALIGn(alignment, bytes) size_t alignment; size_t bytes;
     fREe(m);
     /* Add in extra bytes to match misalignment of unexpanded allocation */
     extra = alignment - (((unsigned long)(m)) % alignment);
-    m  = (char*)(mALLOc(bytes + extra));
+    m  = (char*)(mALLOc_chunk(bytes + extra));
     /*
      * m might not be the same as before. Validate that the previous value of
      * extra still works for the current value of m.
@@ -2125,6 +2390,12 @@ Void_t* cALLOc(n, elem_size) size_t n; size_t elem_size;
 		memset(mem, 0, sz);
 		return mem;
 	}
+#endif
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+	if (slab_page_of(mem)) {
+		memset(mem, 0, sz);
+		return mem;
+	}
 #endif
     p = mem2chunk(mem);
 
@@ -2273,6 +2544,10 @@ size_t malloc_usable_size(mem) Void_t* mem;
   mchunkptr p;
   if (mem == NULL)
     return 0;
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  if (slab_page_of(mem))
+    return slab_classes[slab_page_of(mem)->class].stats.size;
+#endif
   else
   {
     p = mem2chunk(mem);
@@ -2321,6 +2596,11 @@ static void malloc_update_mallinfo()
     }
   }
 
+#if CONFIG_IS_ENABLED(SYS_MALLOC_SLAB)
+  /* Only count the objects handed out from slab pages as in use */
+  avail += slab_page_bytes - slab_used_bytes;
+#endif
+
   current_mallinfo.ordblks = navail;
   current_mallinfo.uordblks = sbrked_mem - avail;
   current_mallinfo.fordblks = avail;
@@ -159,7 +159,8 @@ static bool log_passes_filters(struct log_device *ldev, struct log_rec *rec)
 
 	/* If there are no filters, filter on the default log level */
 	if (list_empty(&ldev->filter_head)) {
-		if (rec->level > gd->default_log_level)
+		if (rec->level > gd->default_log_level &&
+		    !(ldev->drv->flags & LOGDF_ALL))
 			return false;
 		return true;
 	}
@@ -183,18 +184,31 @@ static bool log_passes_filters(struct log_device *ldev, struct log_rec *rec)
  * log_dispatch() - Send a log record to all log devices for processing
  *
  * The log record is sent to each log device in turn, skipping those which have
- * filters which block the record
+ * filters which block the record. The message is formatted the first time a
+ * device which needs it accepts the record, so records which only go to
+ * LOGDF_RAW devices are never formatted.
  *
  * @rec: Log record to dispatch
+ * @buf: Buffer to hold the formatted message
+ * @size: Size of @buf in bytes
  * @return 0 (meaning success)
  */
-static int log_dispatch(struct log_rec *rec)
+static int log_dispatch(struct log_rec *rec, char *buf, int size)
 {
 	struct log_device *ldev;
 
 	list_for_each_entry(ldev, &gd->log_head, sibling_node) {
-		if (log_passes_filters(ldev, rec))
-			ldev->drv->emit(ldev, rec);
+		if (!log_passes_filters(ldev, rec))
+			continue;
+		if (!rec->msg && !(ldev->drv->flags & LOGDF_RAW)) {
+			va_list args;
+
+			va_copy(args, *rec->args);
+			vsnprintf(buf, size, rec->fmt, args);
+			va_end(args);
+			rec->msg = buf;
+		}
+		ldev->drv->emit(ldev, rec);
 	}
 
 	return 0;
@@ -207,21 +221,22 @@ int _log(enum log_category_t cat, enum log_level_t level, const char *file,
 	struct log_rec rec;
 	va_list args;
 
+	if (!gd || !(gd->flags & GD_FLG_LOG_READY)) {
+		if (gd)
+			gd->log_drop_count++;
+		return -ENOSYS;
+	}
 	rec.cat = cat;
 	rec.level = level;
 	rec.file = file;
 	rec.line = line;
 	rec.func = func;
+	rec.msg = NULL;
+	rec.fmt = fmt;
+	rec.args = &args;
 	va_start(args, fmt);
-	vsnprintf(buf, sizeof(buf), fmt, args);
+	log_dispatch(&rec, buf, sizeof(buf));
 	va_end(args);
-	rec.msg = buf;
-	if (!gd || !(gd->flags & GD_FLG_LOG_READY)) {
-		if (gd)
-			gd->log_drop_count++;
-		return -ENOSYS;
-	}
-	log_dispatch(&rec);
 
 	return 0;
 }
@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Log to a ring buffer in memory, formatting records only when they are read
+ *
+ * Records hold the raw printf() arguments, so logging costs a few copies
+ * rather than a vsnprintf() and a trip through the console. Messages are
+ * only formatted by 'log dump' or when the log is passed on in the bloblist.
+ */
+
+#include <common.h>
+#include <bloblist.h>
+#include <log.h>
+#include <time.h>
+#include <linux/ctype.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+enum {
+	LOGB_MAX_REC	= 512,	/* Maximum size of a record, with header */
+	LOGB_MAX_NAME	= 64,	/* Maximum length of a file/function name */
+	LOGB_MAX_SPEC	= 32,	/* Maximum length of a single conversion */
+};
+
+/* Type of an argument packed into a record */
+enum logb_arg_t {
+	LOGB_INT,
+	LOGB_LONG,
+	LOGB_LLONG,
+	LOGB_PTR,
+	LOGB_STR,
+	LOGB_BAD,	/* Cannot be packed, e.g. %pM which reads memory */
+};
+
+enum logb_flags {
+	LOGBF_TEXT	= 1 << 0,	/* Format string is the final message */
+};
+
+/**
+ * struct logb_hdr - header of a record in the ring
+ *
+ * This is followed by the nul-terminated file name, function name and format
+ * string, then the packed arguments
+ *
+ * @size: Size of the record in bytes, including this header
+ * @cat: Category of the record
+ * @level: Level of the record
+ * @flags: Flags for the record (enum logb_flags)
+ * @line: Line number where the record was generated
+ * @time_us: Time when the record was generated
+ */
+struct logb_hdr {
+	u16 size;
+	u16 cat;
+	u8 level;
+	u8 flags;
+	u32 line;
+	u64 time_us;
+};
+
+/**
+ * struct logb_ring - ring buffer holding the records
+ *
+ * Records are stored back-to-back and may wrap around the end of the buffer.
+ * When there is no room for a new record, the oldest ones are dropped.
+ *
+ * @head: Offset of the oldest record
+ * @used: Number of bytes in use
+ * @count: Number of records held
+ * @dropped: Number of records dropped to make room for newer ones
+ */
+struct logb_ring {
+	int head;
+	int used;
+	ulong count;
+	ulong dropped;
+};
+
+static char logb_buf[CONFIG_LOG_BINARY_SIZE];
+static struct logb_ring ring;
+
+static void logb_read(int offset, void *data, int size)
+{
+	int first = min(size, CONFIG_LOG_BINARY_SIZE - offset);
+
+	memcpy(data, logb_buf + offset, first);
+	memcpy(data + first, logb_buf, size - first);
+}
+
+static void logb_write(int offset, const void *data, int size)
+{
+	int first = min(size, CONFIG_LOG_BINARY_SIZE - offset);
+
+	memcpy(logb_buf + offset, data, first);
+	memcpy(logb_buf, data + first, size - first);
+}
+
+static void logb_push(const void *rec, int size)
+{
+	while (CONFIG_LOG_BINARY_SIZE - ring.used < size) {
+		u16 old;
+
+		logb_read(ring.head, &old, sizeof(old));
+		ring.head = (ring.head + old) % CONFIG_LOG_BINARY_SIZE;
+		ring.used -= old;
+		ring.count--;
+		ring.dropped++;
+	}
+	logb_write((ring.head + ring.used) % CONFIG_LOG_BINARY_SIZE, rec, size);
+	ring.used += size;
+	ring.count++;
+}
+
+/**
+ * logb_next_spec() - Find the next conversion in a format string
+ *
+ * This follows the conversions supported by vsprintf(), including the single
+ * h/l/L/z/Z/t qualifier and 'll'.
+ *
+ * @fmt: Format string to search
+ * @specp: Returns a pointer to the '%' starting the conversion
+ * @typep: Returns the type of the argument which the conversion consumes
+ * @starsp: Returns the number of int arguments ('*') which come first
+ * @return pointer to the character after the conversion, or NULL if there are
+ *	no more conversions
+ */
+static const char *logb_next_spec(const char *fmt, const char **specp,
+				  enum logb_arg_t *typep, int *starsp)
+{
+	const char *p = fmt;
+	int qualifier = 0;
+
+	while ((p = strchr(p, '%')) && p[1] == '%')
+		p += 2;
+	if (!p)
+		return NULL;
+	*specp = p++;
+
+	*starsp = 0;
+	while (*p && strchr("-+ #0", *p))
+		p++;
+	if (*p == '*') {
+		(*starsp)++;
+		p++;
+	}
+	while (isdigit(*p))
+		p++;
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			(*starsp)++;
+			p++;
+		}
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p && strchr("hlLZzt", *p)) {
+		qualifier = *p++;
+		if (qualifier == 'l' && *p == 'l') {
+			qualifier = 'L';
+			p++;
+		}
+	}
+
+	switch (*p) {
+	case 'c':
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+		if (qualifier == 'L')
+			*typep = LOGB_LLONG;
+		else if (qualifier && strchr("lZzt", qualifier))
+			*typep = LOGB_LONG;
+		else
+			*typep = LOGB_INT;
+		break;
+	case 's':
+		*typep = qualifier ? LOGB_BAD : LOGB_STR;
+		break;
+	case 'p':
+		*typep = isalnum(p[1]) ? LOGB_BAD : LOGB_PTR;
+		break;
+	default:
+		*typep = LOGB_BAD;
+		break;
+	}
+
+	return *p ? p + 1 : p;
+}
+
+/**
+ * logb_pack() - Pack the arguments for a format string into a record
+ *
+ * @out: Place to put the arguments
+ * @end: End of the space available at @out
+ * @fmt: Format string
+ * @args: Arguments for @fmt
+ * @return number of bytes used, -ENOSPC if there was not enough space, or
+ *	-EINVAL if @fmt has a conversion which cannot be packed
+ */
+static int logb_pack(char *out, char *end, const char *fmt, va_list args)
+{
+	enum logb_arg_t type;
+	const char *spec;
+	char *p = out;
+	int stars;
+
+	while ((fmt = logb_next_spec(fmt, &spec, &type, &stars))) {
+		union {
+			int i;
+			long l;
+			long long ll;
+			void *ptr;
+		} val;
+		const char *str;
+		int size;
+
+		for (; stars; stars--) {
+			val.i = va_arg(args, int);
+			if (end - p < sizeof(int))
+				return -ENOSPC;
+			memcpy(p, &val.i, sizeof(int));
+			p += sizeof(int);
+		}
+		switch (type) {
+		case LOGB_INT:
+			val.i = va_arg(args, int);
+			size = sizeof(int);
+			break;
+		case LOGB_LONG:
+			val.l = va_arg(args, long);
+			size = sizeof(long);
+			break;
+		case LOGB_LLONG:
+			val.ll = va_arg(args, long long);
+			size = sizeof(long long);
+			break;
+		case LOGB_PTR:
+			val.ptr = va_arg(args, void *);
+			size = sizeof(void *);
+			break;
+		case LOGB_STR:
+			str = va_arg(args, const char *);
+			if (!str)
+				str = "<NULL>";
+			size = strnlen(str, end - p);
+			if (size == end - p)
+				return -ENOSPC;
+			memcpy(p, str, size + 1);
+			p += size + 1;
+			continue;
+		default:
+			return -EINVAL;
+		}
+		if (end - p < size)
+			return -ENOSPC;
+		memcpy(p, &val, size);
+		p += size;
+	}
+
+	return p - out;
+}
+
+/* Copy literal text from a format string, handling %% */
+static int logb_put_text(char *buf, int size, const char *fmt,
+			 const char *end)
+{
+	int len = 0;
+
+	while (fmt < end && len < size - 1) {
+		if (*fmt == '%' && fmt[1] == '%')
+			fmt++;
+		buf[len++] = *fmt++;
+	}
+	buf[len] = '\0';
+
+	return len;
+}
+
+/**
+ * logb_format() - Format a message from a format string and packed arguments
+ *
+ * @buf: Place to put the message
+ * @size: Size of @buf in bytes
+ * @fmt: Format string
+ * @args: Packed arguments, as written by logb_pack()
+ * @end: End of the packed arguments
+ * @return length of the message
+ */
+static int logb_format(char *buf, int size, const char *fmt, const char *args,
+		       const char *end)
+{
+	enum logb_arg_t type;
+	const char *spec, *next;
+	int len = 0, stars;
+
+	while ((next = logb_next_spec(fmt, &spec, &type, &stars))) {
+		union {
+			int i;
+			long l;
+			long long ll;
+			void *ptr;
+		} val;
+		char conv[LOGB_MAX_SPEC];
+		const char *s;
+		int pos = 0;
+
+		len += logb_put_text(buf + len, size - len, fmt, spec);
+		fmt = next;
+
+		/* Put the '*' values straight into the conversion */
+		for (s = spec; s < next && pos < sizeof(conv) - 12; s++) {
+			if (*s != '*') {
+				conv[pos++] = *s;
+				continue;
+			}
+			if (end - args < sizeof(int))
+				return len;
+			memcpy(&val.i, args, sizeof(int));
+			args += sizeof(int);
+			if (val.i >= 0)
+				pos += scnprintf(conv + pos, sizeof(conv) - pos,
+						 "%d", val.i);
+			else if (conv[pos - 1] == '.')
+				pos--;	/* negative precision is ignored */
+			else
+				pos += scnprintf(conv + pos, sizeof(conv) - pos,
+						 "%d", val.i);
+		}
+		conv[pos] = '\0';
+
+		switch (type) {
+		case LOGB_INT:
+			if (end - args < sizeof(int))
+				return len;
+			memcpy(&val.i, args, sizeof(int));
+			len += scnprintf(buf + len, size - len, conv, val.i);
+			args += sizeof(int);
+			break;
+		case LOGB_LONG:
+			if (end - args < sizeof(long))
+				return len;
+			memcpy(&val.l, args, sizeof(long));
+			len += scnprintf(buf + len, size - len, conv, val.l);
+			args += sizeof(long);
+			break;
+		case LOGB_LLONG:
+			if (end - args < sizeof(long long))
+				return len;
+			memcpy(&val.ll, args, sizeof(long long));
+			len += scnprintf(buf + len, size - len, conv, val.ll);
+			args += sizeof(long long);
+			break;
+		case LOGB_PTR:
+			if (end - args < sizeof(void *))
+				return len;
+			memcpy(&val.ptr, args, sizeof(void *));
+			len += scnprintf(buf + len, size - len, conv, val.ptr);
+			args += sizeof(void *);
+			break;
+		case LOGB_STR:
+			if (!memchr(args, '\0', end - args))
+				return len;
+			len += scnprintf(buf + len, size - len, conv, args);
+			args += strlen(args) + 1;
+			break;
+		default:
+			return len;
+		}
+	}
+	len += logb_put_text(buf + len, size - len, fmt, fmt + strlen(fmt));
+
+	return len;
+}
+
+/* Copy a string into a record, truncating it to LOGB_MAX_NAME */
+static char *logb_put_name(char *p, const char *name)
+{
+	int len;
+
+	if (!name)
+		name = "";
+	len = strnlen(name, LOGB_MAX_NAME - 1);
+
+	memcpy(p, name, len);
+	p[len] = '\0';
+
+	return p + len + 1;
+}
+
+static int log_binary_emit(struct log_device *ldev, struct log_rec *rec)
+{
+	char buf[LOGB_MAX_REC] __aligned(8);
+	struct logb_hdr *hdr = (struct logb_hdr *)buf;
+	char *end = buf + sizeof(buf);
+	char *p, *fmt;
+	va_list args;
+	int len, ret;
+
+	/* The ring is in BSS, which cannot be used before relocation */
+	if (!(gd->flags & GD_FLG_RELOC))
+		return 0;
+
+	hdr->cat = rec->cat;
+	hdr->level = rec->level;
+	hdr->flags = 0;
+	hdr->line = rec->line;
+	hdr->time_us = timer_get_us();
+	p = logb_put_name(buf + sizeof(*hdr), rec->file);
+	fmt = logb_put_name(p, rec->func);
+
+	len = strlen(rec->fmt) + 1;
+	ret = -ENOSPC;
+	if (len < end - fmt) {
+		memcpy(fmt, rec->fmt, len);
+		va_copy(args, *rec->args);
+		ret = logb_pack(fmt + len, end, rec->fmt, args);
+		va_end(args);
+	}
+	if (ret >= 0) {
+		p = fmt + len + ret;
+	} else {
+		/* Store the formatted message instead */
+		va_copy(args, *rec->args);
+		vsnprintf(fmt, end - fmt, rec->fmt, args);
+		va_end(args);
+		hdr->flags |= LOGBF_TEXT;
+		p = fmt + strlen(fmt) + 1;
+	}
+	hdr->size = p - buf;
+	logb_push(buf, hdr->size);
+
+	return 0;
+}
+
+/**
+ * logb_show() - Format one record as a line of text
+ *
+ * @hdr: Record to format
+ * @buf: Place to put the text
+ * @size: Size of @buf in bytes
+ * @return length of the text
+ */
+static int logb_show(struct logb_hdr *hdr, char *buf, int size)
+{
+	const char *file, *func, *fmt, *end = (char *)hdr + hdr->size;
+	int log_fmt = gd->log_fmt;
+	int len;
+
+	file = (char *)(hdr + 1);
+	func = file + strlen(file) + 1;
+	fmt = func + strlen(func) + 1;
+
+	len = scnprintf(buf, size, "[%5llu.%06llu] ", hdr->time_us / 1000000,
+			hdr->time_us % 1000000);
+	if (log_fmt & BIT(LOGF_LEVEL))
+		len += scnprintf(buf + len, size - len, "%s.",
+				 log_get_level_name(hdr->level));
+	if (log_fmt & BIT(LOGF_CAT))
+		len += scnprintf(buf + len, size - len, "%s,",
+				 log_get_cat_name(hdr->cat));
+	if (log_fmt & BIT(LOGF_FILE))
+		len += scnprintf(buf + len, size - len, "%s:", file);
+	if (log_fmt & BIT(LOGF_LINE))
+		len += scnprintf(buf + len, size - len, "%u-", hdr->line);
+	if (log_fmt & BIT(LOGF_FUNC))
+		len += scnprintf(buf + len, size - len, "%s()", func);
+	if (log_fmt & BIT(LOGF_MSG)) {
+		if (log_fmt != BIT(LOGF_MSG))
+			len += scnprintf(buf + len, size - len, " ");
+		if (hdr->flags & LOGBF_TEXT)
+			len += scnprintf(buf + len, size - len, "%s", fmt);
+		else
+			len += logb_format(buf + len, size - len, fmt,
+					   fmt + strlen(fmt) + 1, end);
+	}
+	if (!len || buf[len - 1] != '\n')
+		len += scnprintf(buf + len, size - len, "\n");
+
+	return len;
+}
+
+/**
+ * logb_walk() - Format records, oldest first
+ *
+ * @skip: Number of (oldest) records to skip
+ * @show: true to write each record to the console
+ * @out: Place to put the text of all records, or NULL
+ * @size: Size of @out in bytes
+ * @return total length of the text
+ */
+static int logb_walk(ulong skip, bool show, char *out, int size)
+{
+	char rec[LOGB_MAX_REC] __aligned(8);
+	struct logb_hdr *hdr = (struct logb_hdr *)rec;
+	char line[CONFIG_SYS_CBSIZE + 80];
+	int offset = ring.head, left = ring.used;
+	int total = 0;
+
+	while (left > 0) {
+		int len;
+
+		logb_read(offset, rec, sizeof(*hdr));
+		logb_read(offset, rec, hdr->size);
+		offset = (offset + hdr->size) % CONFIG_LOG_BINARY_SIZE;
+		left -= hdr->size;
+		if (skip) {
+			skip--;
+			continue;
+		}
+
+		len = logb_show(hdr, line, sizeof(line));
+		if (show)
+			puts(line);
+		if (out && total + len < size)
+			memcpy(out + total, line, len + 1);
+		total += len;
+	}
+
+	return total;
+}
+
+void log_binary_dump(int count)
+{
+	if (count > 0 && count < ring.count) {
+		logb_walk(ring.count - count, true, NULL, 0);
+		return;
+	}
+	logb_walk(0, true, NULL, 0);
+	if (ring.dropped)
+		printf("(%lu older records dropped)\n", ring.dropped);
+}
+
+#if CONFIG_IS_ENABLED(BLOBLIST)
+int log_binary_to_bloblist(void)
+{
+	char *blob;
+	int len;
+
+	len = logb_walk(0, false, NULL, 0);
+	blob = bloblist_add(BLOBLISTT_LOG, len + 1);
+	if (!blob)
+		return log_msg_ret("blob", -ENOSPC);
+	*blob = '\0';
+	logb_walk(0, false, blob, len + 1);
+
+	return 0;
+}
+#endif
+
+LOG_DRIVER(binary) = {
+	.name	= "binary",
+	.flags	= LOGDF_RAW | LOGDF_ALL,
+	.emit	= log_binary_emit,
+};
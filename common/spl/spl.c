@@ -520,7 +520,9 @@ static int spl_load_image(struct spl_image_info *spl_image,
 	bootdev.boot_device = loader->boot_device;
 	bootdev.boot_device_name = NULL;
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_READ, "spl_read");
 	ret = loader->load_image(spl_image, &bootdev);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_READ);
 #ifdef CONFIG_SPL_LEGACY_IMAGE_CRC_CHECK
 	if (!ret && spl_image->dcrc_length) {
 		/* check data crc */
@@ -584,6 +586,29 @@ void board_init_f(ulong dummy)
 }
 #endif
 
+/**
+ * spl_finish_bootstage() - Record the end of SPL and pass on the timings
+ *
+ * This must be called just before jumping to the next phase, which picks up
+ * the stashed records, if enabled.
+ */
+static void spl_finish_bootstage(void)
+{
+	void *stash;
+	int ret;
+
+	bootstage_mark_name(spl_phase() == PHASE_TPL ? BOOTSTAGE_ID_END_TPL :
+			    BOOTSTAGE_ID_END_SPL, "end " SPL_TPL_NAME);
+	if (IS_ENABLED(CONFIG_BOOTSTAGE_STASH)) {
+		stash = map_sysmem(CONFIG_BOOTSTAGE_STASH_ADDR,
+				   CONFIG_BOOTSTAGE_STASH_SIZE);
+		ret = bootstage_stash(stash, CONFIG_BOOTSTAGE_STASH_SIZE);
+		if (ret)
+			debug("Failed to stash bootstage: err=%d\n", ret);
+		unmap_sysmem(stash);
+	}
+}
+
 void board_init_r(gd_t *dummy1, ulong dummy2)
 {
 	u32 spl_boot_list[] = {
@@ -662,7 +687,9 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 		hang();
 	}
 
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIXUP, "spl_fixup");
 	spl_perform_fixups(&spl_image);
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_FIXUP);
 	if (CONFIG_IS_ENABLED(HANDOFF)) {
 		ret = write_spl_handoff();
 		if (ret)
@@ -707,9 +734,14 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	case IH_OS_LINUX:
 		debug("Jumping to Linux\n");
 #if defined(CONFIG_SYS_SPL_ARGS_ADDR)
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_FIXUP, "spl_fixup");
 		spl_fixup_fdt((void *)CONFIG_SYS_SPL_ARGS_ADDR);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_FIXUP);
 #endif
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_JUMP, "spl_jump");
 		spl_board_prepare_for_linux();
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_JUMP);
+		spl_finish_bootstage();
 		jump_to_image_linux(&spl_image);
 #endif
 	default:
@@ -719,17 +751,12 @@ void board_init_r(gd_t *dummy1, ulong dummy2)
 	debug("SPL malloc() used 0x%lx bytes (%ld KB)\n", gd->malloc_ptr,
 	      gd->malloc_ptr / 1024);
 #endif
-	bootstage_mark_name(spl_phase() == PHASE_TPL ? BOOTSTAGE_ID_END_TPL :
-			    BOOTSTAGE_ID_END_SPL, "end " SPL_TPL_NAME);
-#ifdef CONFIG_BOOTSTAGE_STASH
-	ret = bootstage_stash((void *)CONFIG_BOOTSTAGE_STASH_ADDR,
-			      CONFIG_BOOTSTAGE_STASH_SIZE);
-	if (ret)
-		debug("Failed to stash bootstage: err=%d\n", ret);
-#endif
 
 	debug("loaded - jumping to U-Boot...\n");
+	bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_JUMP, "spl_jump");
 	spl_board_prepare_for_boot();
+	bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_JUMP);
+	spl_finish_bootstage();
 	jump_to_image_no_args(&spl_image);
 }
 
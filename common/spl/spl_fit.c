@@ -11,10 +11,15 @@
 #include <gzip.h>
 #include <image.h>
 #include <log.h>
+#include <lz4.h>
 #include <malloc.h>
+#include <mapmem.h>
+#include <memalign.h>
 #include <spl.h>
 #include <asm/cache.h>
 #include <linux/libfdt.h>
+#include <linux/sizes.h>
+#include <u-boot/zstd.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -26,6 +31,52 @@ DECLARE_GLOBAL_DATA_PTR;
 #define CONFIG_SYS_BOOTM_LEN	(64 << 20)
 #endif
 
+/* Maximum number of images which are considered when planning reads */
+#define SPL_FIT_MAX_READS	8
+
+/* Largest gap between two images which is read, rather than skipped */
+#define SPL_FIT_MAX_GAP		4096
+
+enum spl_fit_read_flags {
+	SPL_FIT_READ_LAST	= 1 << 0,	/* Do not merge the next image */
+	SPL_FIT_READ_DONE	= 1 << 1,	/* Data is at @read_addr */
+};
+
+/**
+ * struct spl_fit_read - a planned read of an image with external data
+ *
+ * @node:	Offset of the image node in the FIT
+ * @offset:	Offset of the image data from the start of the FIT, in bytes
+ * @size:	Size of the image data in bytes
+ * @load_addr:	Address the image is expected to be loaded to
+ * @read_addr:	For an image which is read along with an earlier one, the
+ *		address at which its data lands
+ * @group:	Number of following images which are read along with this one
+ * @flags:	Flags for this image (enum spl_fit_read_flags)
+ */
+struct spl_fit_read {
+	int node;
+	ulong offset;
+	ulong size;
+	ulong load_addr;
+	ulong read_addr;
+	int group;
+	uint flags;
+};
+
+/**
+ * struct spl_fit_plan - reads planned for the images in a FIT
+ *
+ * The images are listed in the order in which they are loaded
+ *
+ * @read:	Information about each image
+ * @count:	Number of images in @read
+ */
+struct spl_fit_plan {
+	struct spl_fit_read read[SPL_FIT_MAX_READS];
+	int count;
+};
+
 __weak void board_spl_fit_post_load(ulong load_addr, size_t length)
 {
 }
@@ -219,6 +270,465 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
 	return (data_size + info->bl_len - 1) / info->bl_len;
 }
 
+/* Get the number of bytes written to memory when reading an image's data */
+static ulong get_aligned_read_bytes(struct spl_load_info *info, ulong size,
+				    ulong offset)
+{
+	ulong count = get_aligned_image_size(info, size, offset);
+
+	return info->filename ? count : count * info->bl_len;
+}
+
+/**
+ * spl_fit_plan_add() - Add an image to the list of planned reads
+ *
+ * Only uncompressed images with external data and a known load address can
+ * be read along with other images. If the image is not suitable, the previous
+ * image is marked so that nothing after it is read early, since that could
+ * overwrite this image or be overwritten by it.
+ *
+ * @plan:	Plan to update
+ * @fit:	Pointer to the FIT
+ * @node:	Offset of the image node in the FIT
+ * @base_offset: Offset of the data area from the beginning of the FIT
+ * @load_addr:	Address to load to if the image has no 'load' property, or
+ *		FDT_ERROR if none
+ * @return the new entry, or NULL if the image was not added
+ */
+static struct spl_fit_read *spl_fit_plan_add(struct spl_fit_plan *plan,
+					     const void *fit, int node,
+					     ulong base_offset, ulong load_addr)
+{
+	struct spl_fit_read *rd;
+	uint8_t comp = IH_COMP_NONE;
+	int offset, len;
+
+	if (plan->count == SPL_FIT_MAX_READS) {
+		plan->read[plan->count - 1].flags |= SPL_FIT_READ_LAST;
+		return NULL;
+	}
+	rd = &plan->read[plan->count];
+	if (fit_image_get_load(fit, node, &rd->load_addr))
+		rd->load_addr = load_addr;
+	fit_image_get_comp(fit, node, &comp);
+	if (fit_image_get_data_position(fit, node, &offset)) {
+		if (fit_image_get_data_offset(fit, node, &offset))
+			offset = -1;
+		else
+			offset += base_offset;
+	}
+
+	if (rd->load_addr == FDT_ERROR || comp != IH_COMP_NONE || offset < 0 ||
+	    fit_image_get_data_size(fit, node, &len)) {
+		if (plan->count)
+			plan->read[plan->count - 1].flags |= SPL_FIT_READ_LAST;
+		return NULL;
+	}
+	rd->node = node;
+	rd->offset = offset;
+	rd->size = len;
+	rd->read_addr = 0;
+	rd->group = 0;
+	rd->flags = 0;
+	plan->count++;
+
+	return rd;
+}
+
+/**
+ * spl_fit_plan_reads() - Work out which images can be read together
+ *
+ * Images which are next to each other in the FIT, or separated by a small
+ * gap, are read with a single call to info->read(), into the place where
+ * the first one is read. This saves the overhead of setting up each read.
+ *
+ * Each image is then moved to its load address as usual. This is only done
+ * if the combined read does not write to any memory outside the areas the
+ * separate reads would have used and moving an image to its load address
+ * cannot overwrite the data of the following image.
+ *
+ * @info:	Information about the device to load data from
+ * @plan:	Plan to update
+ */
+static void spl_fit_plan_reads(struct spl_load_info *info,
+			       struct spl_fit_plan *plan)
+{
+	ulong align_len = ARCH_DMA_MINALIGN - 1;
+	int i, j;
+
+	for (i = 0; i < plan->count; i = j) {
+		struct spl_fit_read *lead = &plan->read[i];
+		ulong lead_ptr = (lead->load_addr + align_len) & ~align_len;
+		ulong start = lead->offset -
+			get_aligned_image_overhead(info, lead->offset);
+		ulong used_end;
+
+		used_end = lead_ptr + get_aligned_read_bytes(info, lead->size,
+							     lead->offset);
+		for (j = i + 1; j < plan->count; j++) {
+			struct spl_fit_read *prev = &plan->read[j - 1];
+			struct spl_fit_read *rd = &plan->read[j];
+			ulong prev_end = prev->offset + prev->size;
+			ulong ptr = (rd->load_addr + align_len) & ~align_len;
+			ulong land = lead_ptr + rd->offset - start;
+			ulong end;
+
+			if ((prev->flags & SPL_FIT_READ_LAST) ||
+			    rd->offset < prev_end ||
+			    rd->offset - prev_end > SPL_FIT_MAX_GAP ||
+			    prev->load_addr + prev->size > land ||
+			    ptr < lead_ptr || ptr > used_end)
+				break;
+			used_end = max(used_end, ptr +
+				       get_aligned_read_bytes(info, rd->size,
+							      rd->offset));
+			end = lead_ptr + get_aligned_read_bytes(info,
+						rd->offset + rd->size - start,
+						start);
+			if (end > used_end)
+				break;
+			rd->read_addr = land;
+		}
+		lead->group = j - i - 1;
+		if (lead->group)
+			debug("%s: %d images in one read\n", __func__,
+			      lead->group + 1);
+	}
+}
+
+/**
+ * spl_fit_plan_find() - Find the planned read for an image
+ *
+ * @plan:	Plan to search, or NULL if none
+ * @node:	Offset of the image node in the FIT
+ * @load_addr:	Address the image is to be loaded to
+ * @return the planned read, or NULL if the image was not planned, or is
+ *	being loaded to a different address than planned
+ */
+static struct spl_fit_read *spl_fit_plan_find(struct spl_fit_plan *plan,
+					      int node, ulong load_addr)
+{
+	int i;
+
+	if (!plan)
+		return NULL;
+	for (i = 0; i < plan->count; i++) {
+		struct spl_fit_read *rd = &plan->read[i];
+
+		if (rd->node == node)
+			return rd->load_addr == load_addr ? rd : NULL;
+	}
+
+	return NULL;
+}
+
+/**
+ * spl_fit_decomp_supported() - Check if SPL can decompress an image
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @return true if images of this type are decompressed when loaded
+ */
+static bool spl_fit_decomp_supported(int comp)
+{
+	return (IS_ENABLED(CONFIG_SPL_GZIP) && comp == IH_COMP_GZIP) ||
+	       (IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4) ||
+	       (IS_ENABLED(CONFIG_SPL_ZSTD) && comp == IH_COMP_ZSTD);
+}
+
+/**
+ * spl_fit_stream_supported() - Check if an image can be decompressed as read
+ *
+ * Streaming means that the compressed data never exists in memory as a whole,
+ * so it cannot be used when the hashes (which cover the compressed data) must
+ * be checked, or when the board wants to process the data first.
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @return true if the image can be decompressed while it is being read
+ */
+static bool spl_fit_stream_supported(int comp)
+{
+	return ((IS_ENABLED(CONFIG_SPL_ZSTD) && comp == IH_COMP_ZSTD) ||
+		(IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4)) &&
+		!IS_ENABLED(CONFIG_SPL_FIT_SIGNATURE) &&
+		!IS_ENABLED(CONFIG_SPL_FIT_IMAGE_POST_PROCESS);
+}
+
+/**
+ * struct spl_fit_stream - compressed data on its way from the media
+ *
+ * Data is read in chunks as large as the buffer allows. The unused tail of
+ * the buffer is moved down before each read, such that new data is always
+ * read to an aligned address.
+ *
+ * @info:	Media to read from, or NULL if all the data is in @buf already
+ * @sector:	Next sector to read (or byte offset, for a FS read)
+ * @skip:	Number of bytes at the start of the first read to discard
+ * @left:	Number of bytes of compressed data still on the media
+ * @buf:	Buffer holding the data
+ * @size:	Size of @buf in bytes
+ * @pos:	Offset in @buf of the next byte to decompress
+ * @end:	Offset in @buf of the end of the data read so far
+ */
+struct spl_fit_stream {
+	struct spl_load_info *info;
+	ulong sector;
+	ulong skip;
+	ulong left;
+	u8 *buf;
+	ulong size;
+	ulong pos;
+	ulong end;
+};
+
+/* Get the unit in which data is read, so that the buffer stays aligned */
+static ulong spl_fit_stream_unit(struct spl_load_info *info)
+{
+	return info->filename ? ARCH_DMA_MINALIGN : info->bl_len;
+}
+
+/**
+ * spl_fit_stream_fill() - Make sure that some data is available in the buffer
+ *
+ * @s:		Stream to fill
+ * @need:	Number of bytes needed, starting at s->pos
+ * @return 0 if OK, -E2BIG if the buffer is too small, -EIO on read error or
+ *	if the data is truncated
+ */
+static int spl_fit_stream_fill(struct spl_fit_stream *s, ulong need)
+{
+	struct spl_load_info *info = s->info;
+	ulong unit, avail, pad, count, nr, bytes, got;
+
+	if (s->end - s->pos >= need)
+		return 0;
+	if (!info || !s->left)
+		return -EIO;
+
+	unit = spl_fit_stream_unit(info);
+	avail = s->end - s->pos;
+	pad = ALIGN(avail, unit) - avail;
+	if (pad + need + s->skip > s->size)
+		return -E2BIG;
+	memmove(s->buf + pad, s->buf + s->pos, avail);
+	s->pos = pad;
+	s->end = pad + avail;
+
+	while (s->end - s->pos < need) {
+		nr = min((s->size - s->end) / unit,
+			 DIV_ROUND_UP(s->skip + s->left, unit));
+		if (info->filename) {
+			/* A FS read must not go past the end of the file */
+			count = min(nr * unit, s->skip + s->left);
+			bytes = count;
+		} else {
+			count = nr;
+			bytes = nr * unit;
+		}
+		if (info->read(info, s->sector, count, s->buf + s->end) !=
+		    count)
+			return -EIO;
+		s->sector += count;
+
+		/* The last read may include data which follows the image */
+		got = min(bytes - s->skip, s->left);
+		s->pos += s->skip;
+		s->end += s->skip + got;
+		s->left -= got;
+		s->skip = 0;
+		if (s->end - s->pos < need && !s->left)
+			return -EIO;
+	}
+
+	return 0;
+}
+
+/**
+ * spl_fit_zstd() - Decompress zstd data into its final place
+ *
+ * This uses the bufferless API, which decompresses each block straight to the
+ * destination. This needs the output to be contiguous, but avoids allocating
+ * a window buffer and copying the data out of it.
+ *
+ * @s:		Stream holding the compressed data
+ * @dst:	Place to put the decompressed data
+ * @sizep:	Size of @dst, updated to the decompressed size on success
+ * @return 0 if OK, -ENOMEM if out of memory, other -ve on error
+ */
+static int spl_fit_zstd(struct spl_fit_stream *s, void *dst, ulong *sizep)
+{
+	ulong out = 0, need;
+	ZSTD_DCtx *dctx;
+	size_t ret;
+	int err = 0;
+
+	dctx = zstd_get_dctx();
+	if (!dctx)
+		return -ENOMEM;
+
+	ZSTD_decompressBegin(dctx);
+	while (1) {
+		need = ZSTD_nextSrcSizeToDecompress(dctx);
+		if (!need) {
+			/* End of frame; there may be another */
+			if (s->end == s->pos && !(s->info && s->left))
+				break;
+			ZSTD_decompressBegin(dctx);
+			continue;
+		}
+		err = spl_fit_stream_fill(s, need);
+		if (err)
+			break;
+		ret = ZSTD_decompressContinue(dctx, dst + out, *sizep - out,
+					      s->buf + s->pos, need);
+		if (ZSTD_isError(ret)) {
+			debug("%s: zstd error %d\n", __func__,
+			      ZSTD_getErrorCode(ret));
+			err = -EIO;
+			break;
+		}
+		s->pos += need;
+		out += ret;
+	}
+	*sizep = out;
+	zstd_put_dctx(dctx);
+
+	return err;
+}
+
+/* Amount of LZ4 data to read at once */
+#define SPL_FIT_LZ4_CHUNK	SZ_64K
+
+/**
+ * spl_fit_lz4() - Decompress an LZ4 frame into its final place
+ *
+ * Each chunk read from the media is passed to the frame decoder, which
+ * decompresses the blocks within it straight to the destination. A block
+ * which straddles two chunks is copied into a buffer of the block size, so
+ * this is only done for frames with blocks no larger than a chunk ('lz4 -B4').
+ * Frames with larger blocks, such as the 4MB default, are left to the caller.
+ *
+ * @s:		Stream holding the compressed data
+ * @dst:	Place to put the decompressed data
+ * @sizep:	Size of @dst, updated to the decompressed size on success
+ * @return 0 if OK, -E2BIG if the blocks are larger than a chunk, -ENOMEM if
+ *	out of memory, other -ve on error
+ */
+static int spl_fit_lz4(struct spl_fit_stream *s, void *dst, ulong *sizep)
+{
+	struct lz4f_stream ls;
+	size_t len;
+	int ret;
+
+	ret = spl_fit_stream_fill(s, LZ4F_HEADER_START);
+	if (ret)
+		return ret;
+	ret = lz4f_block_max(s->buf + s->pos);
+	if (ret < 0)
+		return ret;
+	if (ret > SPL_FIT_LZ4_CHUNK)
+		return -E2BIG;
+
+	lz4f_stream_init(&ls, dst, *sizep);
+	do {
+		ret = spl_fit_stream_fill(s, 1);
+		if (ret)
+			break;
+		len = s->end - s->pos;
+		ret = lz4f_stream_decode(&ls, s->buf + s->pos, &len);
+		s->pos += len;
+	} while (!ret);
+	lz4f_stream_end(&ls);
+	if (ret < 0) {
+		debug("%s: lz4 error %d\n", __func__, ret);
+		return ret;
+	}
+	*sizep = ls.out;
+
+	return 0;
+}
+
+/**
+ * spl_fit_stream_image() - Read and decompress an image a chunk at a time
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @info:	Media to read from
+ * @sector:	Start sector of the FIT on the media
+ * @offset:	Offset of the compressed data from the start of the FIT
+ * @len:	Size of the compressed data in bytes
+ * @dst:	Place to put the decompressed data
+ * @sizep:	Size of @dst, updated to the decompressed size on success
+ * @return 0 if OK, -ve on error
+ */
+static int spl_fit_stream_image(int comp, struct spl_load_info *info,
+				ulong sector, int offset, ulong len, void *dst,
+				ulong *sizep)
+{
+	bool lz4 = IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4;
+	struct spl_fit_stream s;
+	ulong unit;
+	int ret;
+
+	unit = spl_fit_stream_unit(info);
+	memset(&s, '\0', sizeof(s));
+	s.info = info;
+	s.sector = sector + get_aligned_image_offset(info, offset);
+	s.skip = get_aligned_image_overhead(info, offset);
+	s.left = len;
+	s.size = (lz4 ? SPL_FIT_LZ4_CHUNK : ZSTD_BLOCKSIZE_ABSOLUTEMAX) +
+		3 * unit;
+	s.buf = malloc_cache_aligned(s.size);
+	if (!s.buf)
+		return -ENOMEM;
+	if (lz4)
+		ret = spl_fit_lz4(&s, dst, sizep);
+	else
+		ret = spl_fit_zstd(&s, dst, sizep);
+	free(s.buf);
+
+	return ret;
+}
+
+/**
+ * spl_fit_decomp() - Decompress an image which is in memory
+ *
+ * @comp:	Compression type (IH_COMP_...)
+ * @src:	Compressed data
+ * @len:	Size of the compressed data in bytes
+ * @dst:	Place to put the decompressed data
+ * @sizep:	Size of @dst, updated to the decompressed size on success
+ * @return 0 if OK, -ve on error
+ */
+static int spl_fit_decomp(int comp, void *src, ulong len, void *dst,
+			  ulong *sizep)
+{
+	if (IS_ENABLED(CONFIG_SPL_GZIP) && comp == IH_COMP_GZIP) {
+		ulong size = len;
+
+		if (gunzip(dst, *sizep, src, &size))
+			return -EIO;
+		*sizep = size;
+	} else if (IS_ENABLED(CONFIG_SPL_LZ4) && comp == IH_COMP_LZ4) {
+		size_t size = *sizep;
+
+		if (ulz4fn(src, len, dst, &size))
+			return -EIO;
+		*sizep = size;
+	} else if (IS_ENABLED(CONFIG_SPL_ZSTD) && comp == IH_COMP_ZSTD) {
+		struct spl_fit_stream s;
+
+		memset(&s, '\0', sizeof(s));
+		s.buf = src;
+		s.size = len;
+		s.end = len;
+
+		return spl_fit_zstd(&s, dst, sizep);
+	} else {
+		return -ENOSYS;
+	}
+
+	return 0;
+}
+
 /**
  * spl_load_fit_image(): load the image described in a certain FIT node
  * @info:	points to information about the device to load data from
@@ -233,12 +743,14 @@ static int get_aligned_image_size(struct spl_load_info *info, int data_size,
  *		If the FIT node does not contain a "load" (address) property,
  *		the image gets loaded to the address pointed to by the
  *		load_addr member in this struct.
+ * @plan:	planned reads, from spl_fit_plan_reads(), or NULL if none
  *
  * Return:	0 on success or a negative error number.
  */
 static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			      void *fit, ulong base_offset, int node,
-			      struct spl_image_info *image_info)
+			      struct spl_image_info *image_info,
+			      struct spl_fit_plan *plan)
 {
 	int offset;
 	size_t length;
@@ -252,6 +764,7 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	uint8_t image_comp = -1, type = -1;
 	const void *data;
 	bool external_data = false;
+	int ret;
 
 	if (IS_ENABLED(CONFIG_SPL_FPGA_SUPPORT) ||
 	    (IS_ENABLED(CONFIG_SPL_OS_BOOT) && IS_ENABLED(CONFIG_SPL_GZIP))) {
@@ -261,7 +774,8 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 			debug("%s ", genimg_get_type_name(type));
 	}
 
-	if (IS_ENABLED(CONFIG_SPL_GZIP)) {
+	if (IS_ENABLED(CONFIG_SPL_GZIP) || IS_ENABLED(CONFIG_SPL_LZ4) ||
+	    IS_ENABLED(CONFIG_SPL_ZSTD)) {
 		fit_image_get_comp(fit, node, &image_comp);
 		debug("%s ", genimg_get_comp_name(image_comp));
 	}
@@ -277,24 +791,76 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	}
 
 	if (external_data) {
+		struct spl_fit_read *rd;
+		ulong read_len;
+		void *buf;
+		int i;
+
 		/* External data */
 		if (fit_image_get_data_size(fit, node, &len))
 			return -ENOENT;
 
-		load_ptr = (load_addr + align_len) & ~align_len;
-		length = len;
-
-		overhead = get_aligned_image_overhead(info, offset);
-		nr_sectors = get_aligned_image_size(info, length, offset);
+		if (spl_fit_stream_supported(image_comp)) {
+			size = CONFIG_SYS_BOOTM_LEN;
+			ret = spl_fit_stream_image(image_comp, info, sector,
+						   offset, len,
+						   map_sysmem(load_addr, size),
+						   &size);
+			if (!ret) {
+				debug("External data: streamed to %lx, size=%x->%lx\n",
+				      load_addr, len, size);
+				length = size;
+				goto done;
+			}
 
-		if (info->read(info,
-			       sector + get_aligned_image_offset(info, offset),
-			       nr_sectors, (void *)load_ptr) != nr_sectors)
-			return -EIO;
+			/* Without the memory to stream it, read it all first */
+			if (ret != -E2BIG && ret != -ENOMEM) {
+				printf("Uncompressing error %d\n", ret);
+				return ret;
+			}
+			debug("External data: cannot stream (err=%d)\n", ret);
+		}
 
-		debug("External data: dst=%lx, offset=%x, size=%lx\n",
-		      load_ptr, offset, (unsigned long)length);
-		src = (void *)load_ptr + overhead;
+		/*
+		 * Compressed data is staged elsewhere, since decompressing it
+		 * to the load address would overwrite it as it is being read
+		 */
+		if (spl_fit_decomp_supported(image_comp))
+			load_ptr = (CONFIG_SYS_LOAD_ADDR + align_len) &
+				~align_len;
+		else
+			load_ptr = (load_addr + align_len) & ~align_len;
+		length = len;
+		rd = spl_fit_plan_find(plan, node, load_addr);
+
+		if (rd && (rd->flags & SPL_FIT_READ_DONE)) {
+			debug("External data: already read to %lx, size=%lx\n",
+			      rd->read_addr, (unsigned long)length);
+			src = map_sysmem(rd->read_addr, length);
+		} else {
+			/* Also read any following images planned with this */
+			read_len = length;
+			if (rd && rd->group)
+				read_len = rd[rd->group].offset +
+					rd[rd->group].size - offset;
+
+			overhead = get_aligned_image_overhead(info, offset);
+			nr_sectors = get_aligned_image_size(info, read_len,
+							    offset);
+			buf = map_sysmem(load_ptr, overhead + read_len);
+
+			if (info->read(info,
+				       sector + get_aligned_image_offset(info,
+									 offset),
+				       nr_sectors, buf) != nr_sectors)
+				return -EIO;
+			for (i = 1; rd && i <= rd->group; i++)
+				rd[i].flags |= SPL_FIT_READ_DONE;
+
+			debug("External data: dst=%lx, offset=%x, size=%lx\n",
+			      load_ptr, offset, read_len);
+			src = buf + overhead;
+		}
 	} else {
 		/* Embedded data */
 		if (fit_image_get_data(fit, node, &data, &length)) {
@@ -319,18 +885,21 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 	board_fit_image_post_process(&src, &length);
 #endif
 
-	if (IS_ENABLED(CONFIG_SPL_GZIP) && image_comp == IH_COMP_GZIP) {
-		size = length;
-		if (gunzip((void *)load_addr, CONFIG_SYS_BOOTM_LEN,
-			   src, &size)) {
-			puts("Uncompressing error\n");
-			return -EIO;
+	if (spl_fit_decomp_supported(image_comp)) {
+		size = CONFIG_SYS_BOOTM_LEN;
+		ret = spl_fit_decomp(image_comp, src, length,
+				     map_sysmem(load_addr, size), &size);
+		if (ret) {
+			printf("Uncompressing error %d\n", ret);
+			return ret;
 		}
 		length = size;
 	} else {
-		memcpy((void *)load_addr, src, length);
+		/* The data may have been read just above the load address */
+		memmove(map_sysmem(load_addr, length), src, length);
 	}
 
+done:
 	if (image_info) {
 		image_info->load_addr = load_addr;
 		image_info->size = length;
@@ -342,7 +911,8 @@ static int spl_load_fit_image(struct spl_load_info *info, ulong sector,
 
 static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 			      struct spl_load_info *info, ulong sector,
-			      void *fit, int images, ulong base_offset)
+			      void *fit, int images, ulong base_offset,
+			      struct spl_fit_plan *plan)
 {
 	struct spl_image_info image_info;
 	int node, ret = 0, index = 0;
@@ -366,19 +936,20 @@ static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 		 * the U-Boot device tree instead.
 		 */
 		if (gd->fdt_blob)
-			memcpy((void *)image_info.load_addr, gd->fdt_blob,
-			       fdt_totalsize(gd->fdt_blob));
+			memcpy(map_sysmem(image_info.load_addr,
+					  fdt_totalsize(gd->fdt_blob)),
+			       gd->fdt_blob, fdt_totalsize(gd->fdt_blob));
 		else
 			return node;
 	} else {
 		ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-					 &image_info);
+					 &image_info, plan);
 		if (ret < 0)
 			return ret;
 	}
 
 	/* Make the load-address of the FDT available for the SPL framework */
-	spl_image->fdt_addr = (void *)image_info.load_addr;
+	spl_image->fdt_addr = map_sysmem(image_info.load_addr, 0);
 #if !CONFIG_IS_ENABLED(FIT_IMAGE_TINY)
 	if (CONFIG_IS_ENABLED(LOAD_FIT_APPLY_OVERLAY)) {
 		void *tmpbuffer = NULL;
@@ -407,9 +978,9 @@ static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 					debug("%s: unable to allocate space for overlays\n",
 					      __func__);
 			}
-			image_info.load_addr = (ulong)tmpbuffer;
+			image_info.load_addr = map_to_sysmem(tmpbuffer);
 			ret = spl_load_fit_image(info, sector, fit, base_offset,
-						 node, &image_info);
+						 node, &image_info, NULL);
 			if (ret < 0)
 				break;
 
@@ -420,7 +991,7 @@ static int spl_fit_append_fdt(struct spl_image_info *spl_image,
 				break;
 
 			ret = fdt_overlay_apply_verbose(spl_image->fdt_addr,
-							(void *)image_info.load_addr);
+							map_sysmem(image_info.load_addr, 0));
 			if (ret) {
 				pr_err("failed to apply DT overlay %s\n",
 				       fit_get_name(fit, node, NULL));
@@ -475,6 +1046,69 @@ static int spl_fit_image_get_os(const void *fit, int noffset, uint8_t *os)
 #endif
 }
 
+/**
+ * spl_fit_plan() - Plan the reads for the images which SPL loads
+ *
+ * This lists the firmware image, its device tree if it is U-Boot, and the
+ * loadables, in the order in which spl_load_simple_fit() loads them, then
+ * works out which of them can be read together.
+ *
+ * @info:	Information about the device to load data from
+ * @plan:	Returns the planned reads
+ * @fit:	Pointer to the FIT
+ * @images:	Offset of the /images node
+ * @base_offset: Offset of the data area from the beginning of the FIT
+ * @firmware:	Offset of the firmware image node
+ * @index:	Index of the first loadable to load
+ * @spl_image:	Information about the image being loaded
+ */
+static void spl_fit_plan(struct spl_load_info *info, struct spl_fit_plan *plan,
+			 const void *fit, int images, ulong base_offset,
+			 int firmware, int index,
+			 struct spl_image_info *spl_image)
+{
+	struct spl_fit_read *rd;
+	uint8_t os = IH_OS_INVALID;
+	int node;
+
+	rd = spl_fit_plan_add(plan, fit, firmware, base_offset,
+			      spl_image->load_addr);
+	if (!rd)
+		return;
+
+	/* Work out the OS in the same way as spl_load_simple_fit() */
+	if (spl_fit_image_get_os(fit, firmware, &os) &&
+	    !IS_ENABLED(CONFIG_SPL_OS_BOOT))
+		os = IH_OS_U_BOOT;
+	if (os == IH_OS_U_BOOT) {
+		/*
+		 * The device tree is placed after U-Boot. It grows once it is
+		 * loaded, so nothing can be read along with it.
+		 */
+		node = spl_fit_get_image_node(fit, images, FIT_FDT_PROP, 0);
+		if (node >= 0)
+			spl_fit_plan_add(plan, fit, node, base_offset,
+					 ALIGN(rd->load_addr + rd->size, 8));
+		plan->read[plan->count - 1].flags |= SPL_FIT_READ_LAST;
+	}
+
+	for (; ; index++) {
+		node = spl_fit_get_image_node(fit, images, "loadables", index);
+		if (node < 0)
+			break;
+		if (node == firmware)
+			continue;
+		rd = spl_fit_plan_add(plan, fit, node, base_offset, FDT_ERROR);
+
+		/* A device tree is placed after a U-Boot loadable */
+		if (rd && !spl_fit_image_get_os(fit, node, &os) &&
+		    os == IH_OS_U_BOOT)
+			rd->flags |= SPL_FIT_READ_LAST;
+	}
+
+	spl_fit_plan_reads(info, plan);
+}
+
 /*
  * Weak default function to allow customizing SPL fit loading for load-only
  * use cases by allowing to skip the parsing/processing of the FIT contents
@@ -497,6 +1131,9 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	int base_offset, hsize, align_len = ARCH_DMA_MINALIGN - 1;
 	int index = 0;
 	int firmware_node;
+	struct spl_fit_plan plan;
+
+	plan.count = 0;
 
 	/*
 	 * For FIT with external data, figure out where the external images
@@ -551,7 +1188,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	if (node >= 0) {
 		/* Load the image and set up the spl_image structure */
 		ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-					 spl_image);
+					 spl_image, NULL);
 		if (ret) {
 			printf("%s: Cannot load the FPGA: %i\n", __func__, ret);
 			return ret;
@@ -601,9 +1238,13 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 		return -1;
 	}
 
+	if (CONFIG_IS_ENABLED(LOAD_FIT_COALESCE))
+		spl_fit_plan(info, &plan, fit, images, base_offset, node,
+			     index, spl_image);
+
 	/* Load the image and set up the spl_image structure */
 	ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-				 spl_image);
+				 spl_image, &plan);
 	if (ret)
 		return ret;
 
@@ -624,7 +1265,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 	 */
 	if (spl_image->os == IH_OS_U_BOOT) {
 		ret = spl_fit_append_fdt(spl_image, info, sector, fit,
-					 images, base_offset);
+					 images, base_offset, &plan);
 		if (!IS_ENABLED(CONFIG_OF_EMBED) && ret < 0)
 			return ret;
 	}
@@ -647,7 +1288,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 			continue;
 
 		ret = spl_load_fit_image(info, sector, fit, base_offset, node,
-					 &image_info);
+					 &image_info, &plan);
 		if (ret < 0)
 			continue;
 
@@ -656,7 +1297,7 @@ int spl_load_simple_fit(struct spl_image_info *spl_image,
 
 		if (os_type == IH_OS_U_BOOT) {
 			spl_fit_append_fdt(&image_info, info, sector,
-					   fit, images, base_offset);
+					   fit, images, base_offset, &plan);
 			spl_image->fdt_addr = image_info.fdt_addr;
 		}
 
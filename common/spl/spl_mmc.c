@@ -6,6 +6,7 @@
  * Aneesh V <aneesh@ti.com>
  */
 #include <common.h>
+#include <bootstage.h>
 #include <dm.h>
 #include <log.h>
 #include <part.h>
@@ -337,11 +338,13 @@ int spl_mmc_load(struct spl_image_info *spl_image,
 
 	/* Perform peripheral init only once */
 	if (!mmc) {
+		bootstage_start(BOOTSTAGE_ID_ACCUM_SPL_MEDIA, "spl_media");
 		err = spl_mmc_find_device(&mmc, bootdev->boot_device);
 		if (err)
 			return err;
 
 		err = mmc_init(mmc);
+		bootstage_accum(BOOTSTAGE_ID_ACCUM_SPL_MEDIA);
 		if (err) {
 			mmc = NULL;
 #ifdef CONFIG_SPL_LIBCOMMON_SUPPORT
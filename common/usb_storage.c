@@ -958,9 +958,22 @@ static void usb_stor_set_max_xfer_blk(struct usb_device *udev,
 	 * Windows 7 limiting transfers to 128 sectors for both USB2 and USB3
 	 * and Apple Mac OS X 10.11 limiting transfers to 256 sectors for USB2
 	 * and 2048 for USB3 devices.
+	 *
+	 * SuperSpeed devices are recent enough not to carry the IDE legacy,
+	 * so follow Linux and Mac OS X and allow them 2048 sectors (1 MiB)
+	 * per command. On xHCI such a transfer is queued as a single chain
+	 * of 64 KiB TRBs, which keeps the per-command CBW/CSW overhead from
+	 * dominating the throughput of USB 3 sticks.
+	 *
+	 * This only raises the command size for the Bulk-Only transport. UAS
+	 * (which needs bulk streams) is not supported, and host controllers
+	 * without scatter-gather chains still cap the size below.
 	 */
 	unsigned short blk = 240;
 
+	if (udev->speed >= USB_SPEED_SUPER)
+		blk = 2048;
+
 #if CONFIG_IS_ENABLED(DM_USB)
 	size_t size;
 	int ret;
@@ -9,6 +9,7 @@
 #include <dm.h>
 #include <log.h>
 #include <malloc.h>
+#include <memalign.h>
 #include <part.h>
 #include <dm/device-internal.h>
 #include <dm/lists.h>
@@ -432,6 +433,43 @@ int blk_get_device(int if_type, int devnum, struct udevice **devp)
 	return device_probe(*devp);
 }
 
+/*
+ * Read into a buffer which is not suitably aligned for DMA.
+ *
+ * Rather than bouncing the whole transfer, read all but the last block
+ * straight into the caller's buffer, starting at the first aligned address
+ * within it, then slide the data down into place. Since the shift is less
+ * than one block this never writes past the end of the buffer. Only the
+ * last block needs to go through a bounce buffer.
+ */
+static ulong blk_read_unaligned(struct blk_desc *block_dev, lbaint_t start,
+				lbaint_t blkcnt, void *buffer)
+{
+	struct udevice *dev = block_dev->bdev;
+	const struct blk_ops *ops = blk_get_ops(dev);
+	ulong blksz = block_dev->blksz;
+	void *bulk = PTR_ALIGN(buffer, ARCH_DMA_MINALIGN);
+	ulong blks_read = 0;
+
+	if (blkcnt > 1) {
+		blks_read = ops->read(dev, start, blkcnt - 1, bulk);
+		if (blks_read)
+			memmove(buffer, bulk, blks_read * blksz);
+		if (blks_read != blkcnt - 1)
+			return blks_read;
+	}
+
+	{
+		ALLOC_CACHE_ALIGN_BUFFER(u8, tail, blksz);
+
+		if (ops->read(dev, start + blks_read, 1, tail) != 1)
+			return blks_read;
+		memcpy(buffer + blks_read * blksz, tail, blksz);
+	}
+
+	return blkcnt;
+}
+
 unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 			lbaint_t blkcnt, void *buffer)
 {
@@ -445,7 +483,12 @@ unsigned long blk_dread(struct blk_desc *block_dev, lbaint_t start,
 	if (blkcache_read(block_dev->if_type, block_dev->devnum,
 			  start, blkcnt, block_dev->blksz, buffer))
 		return blkcnt;
-	blks_read = ops->read(dev, start, blkcnt, buffer);
+	if (((ulong)buffer & (ARCH_DMA_MINALIGN - 1)) &&
+	    block_dev->blksz >= ARCH_DMA_MINALIGN)
+		blks_read = blk_read_unaligned(block_dev, start, blkcnt,
+					       buffer);
+	else
+		blks_read = ops->read(dev, start, blkcnt, buffer);
 	if (blks_read == blkcnt)
 		blkcache_fill(block_dev->if_type, block_dev->devnum,
 			      start, blkcnt, block_dev->blksz, buffer);
@@ -9,6 +9,7 @@
  */
 
 #include <common.h>
+#include <bootstage.h>
 #include <cpu_func.h>
 #include <log.h>
 #include <asm/io.h>
@@ -402,7 +403,7 @@ fail:
 	return ret;
 }
 
-int device_probe(struct udevice *dev)
+static int device_do_probe(struct udevice *dev)
 {
 	const struct driver *drv;
 	int ret;
@@ -512,6 +513,22 @@ fail:
 	return ret;
 }
 
+int device_probe(struct udevice *dev)
+{
+	int span;
+	int ret;
+
+	if (!CONFIG_IS_ENABLED(BOOTSTAGE_TRACE) || !dev ||
+	    (dev->flags & DM_FLAG_ACTIVATED))
+		return device_do_probe(dev);
+
+	span = bootstage_span_start(dev->name, BOOTSTAGE_SPAN_PROBE);
+	ret = device_do_probe(dev);
+	bootstage_span_end(span);
+
+	return ret;
+}
+
 void *dev_get_platdata(const struct udevice *dev)
 {
 	if (!dev) {
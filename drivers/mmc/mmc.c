@@ -373,11 +373,41 @@ int mmc_send_tuning(struct mmc *mmc, u32 opcode, int *cmd_error)
 }
 #endif
 
+/**
+ * mmc_can_cmd23() - Check whether multi-block transfers can be pre-defined
+ *
+ * With CMD23 (SET_BLOCK_COUNT) sent ahead of a multi-block read the card ends
+ * the transfer by itself, which saves the CMD12 round trip (and the busy wait
+ * on its R1b response) for each chunk.
+ *
+ * @mmc:	MMC device
+ * @return true if both the host and the card support CMD23
+ */
+static bool mmc_can_cmd23(struct mmc *mmc)
+{
+	if (!(mmc->host_caps & MMC_CAP_CMD23) || mmc_host_is_spi(mmc))
+		return false;
+
+	if (IS_SD(mmc))
+		return mmc->scr[0] & SD_SCR_CMD23_SUPPORT;
+
+	return mmc->version >= MMC_VERSION_3;
+}
+
 static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 			   lbaint_t blkcnt)
 {
 	struct mmc_cmd cmd;
 	struct mmc_data data;
+	bool sbc = blkcnt > 1 && mmc_can_cmd23(mmc);
+
+	if (sbc) {
+		cmd.cmdidx = MMC_CMD_SET_BLOCK_COUNT;
+		cmd.cmdarg = blkcnt;
+		cmd.resp_type = MMC_RSP_R1;
+		if (mmc_send_cmd(mmc, &cmd, NULL))
+			return 0;
+	}
 
 	if (blkcnt > 1)
 		cmd.cmdidx = MMC_CMD_READ_MULTIPLE_BLOCK;
@@ -399,7 +429,7 @@ static int mmc_read_blocks(struct mmc *mmc, void *dst, lbaint_t start,
 	if (mmc_send_cmd(mmc, &cmd, &data))
 		return 0;
 
-	if (blkcnt > 1) {
+	if (blkcnt > 1 && !sbc) {
 		cmd.cmdidx = MMC_CMD_STOP_TRANSMISSION;
 		cmd.cmdarg = 0;
 		cmd.resp_type = MMC_RSP_R1b;
@@ -468,6 +498,8 @@ ulong mmc_bread(struct blk_desc *block_dev, lbaint_t start, lbaint_t blkcnt,
 	}
 
 	b_max = mmc_get_b_max(mmc, dst, blkcnt);
+	if (IS_MMC(mmc) && mmc_can_cmd23(mmc))
+		b_max = min_t(uint, b_max, MMC_SET_BLOCK_COUNT_MAX);
 
 	do {
 		cur = (blocks_todo > b_max) ? b_max : blocks_todo;
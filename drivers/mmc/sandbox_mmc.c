@@ -12,20 +12,38 @@
 #include <mmc.h>
 #include <asm/test.h>
 
+/**
+ * struct sandbox_mmc_plat - Sandbox MMC state
+ *
+ * @cfg: MMC configuration
+ * @mmc: MMC device
+ * @sbc: Block count set by the last CMD23, or 0 if none is pending
+ * @open_ended: true if a multi-block read is waiting for CMD12
+ * @sbc_count: Number of multi-block reads set up with CMD23
+ * @stop_count: Number of multi-block reads ended with CMD12
+ */
 struct sandbox_mmc_plat {
 	struct mmc_config cfg;
 	struct mmc mmc;
+	uint sbc;
+	bool open_ended;
+	uint sbc_count;
+	uint stop_count;
 };
 
 /**
  * sandbox_mmc_send_cmd() - Emulate SD commands
  *
  * This emulate an SD card version 2. Single-block reads result in zero data.
- * Multiple-block reads return a test string.
+ * Multiple-block reads return a test string. The card supports CMD23, after
+ * which a multiple-block read must be for the number of blocks given and ends
+ * without CMD12.
  */
 static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 				struct mmc_data *data)
 {
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
 	switch (cmd->cmdidx) {
 	case MMC_CMD_ALL_SEND_CID:
 		memset(cmd->response, '\0', sizeof(cmd->response));
@@ -61,10 +79,26 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case MMC_CMD_READ_SINGLE_BLOCK:
 		memset(data->dest, '\0', data->blocksize);
 		break;
+	case MMC_CMD_SET_BLOCK_COUNT:
+		plat->sbc = cmd->cmdarg;
+		break;
 	case MMC_CMD_READ_MULTIPLE_BLOCK:
+		if (plat->sbc) {
+			if (data->blocks != plat->sbc)
+				return -EIO;
+			plat->sbc = 0;
+			plat->sbc_count++;
+		} else {
+			plat->open_ended = true;
+		}
 		strcpy(data->dest, "this is a test");
 		break;
 	case MMC_CMD_STOP_TRANSMISSION:
+		/* Only an open-ended transfer needs stopping */
+		if (!plat->open_ended)
+			return -EIO;
+		plat->open_ended = false;
+		plat->stop_count++;
 		break;
 	case SD_CMD_APP_SEND_OP_COND:
 		cmd->response[0] = OCR_BUSY | OCR_HCS;
@@ -79,7 +113,8 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	case SD_CMD_APP_SEND_SCR: {
 		u32 *scr = (u32 *)data->dest;
 
-		scr[0] = cpu_to_be32(2 << 24 | 1 << 15);  /* SD version 3 */
+		/* SD version 3, supports CMD23 */
+		scr[0] = cpu_to_be32(2 << 24 | 1 << 15 | SD_SCR_CMD23_SUPPORT);
 		break;
 	}
 	default:
@@ -90,6 +125,15 @@ static int sandbox_mmc_send_cmd(struct udevice *dev, struct mmc_cmd *cmd,
 	return 0;
 }
 
+void sandbox_mmc_get_stop_stats(struct udevice *dev, uint *sbc_countp,
+				uint *stop_countp)
+{
+	struct sandbox_mmc_plat *plat = dev_get_platdata(dev);
+
+	*sbc_countp = plat->sbc_count;
+	*stop_countp = plat->stop_count;
+}
+
 static int sandbox_mmc_set_ios(struct udevice *dev)
 {
 	return 0;
@@ -119,7 +163,8 @@ int sandbox_mmc_bind(struct udevice *dev)
 	struct mmc_config *cfg = &plat->cfg;
 
 	cfg->name = dev->name;
-	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT;
+	cfg->host_caps = MMC_MODE_HS_52MHz | MMC_MODE_HS | MMC_MODE_8BIT |
+			 MMC_CAP_CMD23;
 	cfg->voltages = MMC_VDD_165_195 | MMC_VDD_32_33 | MMC_VDD_33_34;
 	cfg->f_min = 1000000;
 	cfg->f_max = 52000000;
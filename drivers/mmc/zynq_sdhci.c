@@ -235,6 +235,9 @@ static int arasan_sdhci_probe(struct udevice *dev)
 #ifdef CONFIG_ZYNQ_HISPD_BROKEN
 	host->quirks |= SDHCI_QUIRK_BROKEN_HISPD_MODE;
 #endif
+	/* CMD23 is untested on real hardware, so let boards opt in */
+	if (dev_read_bool(dev, "u-boot,cmd23"))
+		host->host_caps |= MMC_CAP_CMD23;
 
 	plat->cfg.f_max = CONFIG_ZYNQ_SDHCI_MAX_FREQ;
 
@@ -59,9 +59,58 @@ static const char *sandbox_sf_state_name(enum sandbox_sf_state state)
 #define STAT_BP_SHIFT	2
 #define STAT_BP_MASK	(7 << STAT_BP_SHIFT)
 
-/* Assume all SPI flashes have 3 byte addresses since they do atm */
+/* Number of address bytes used by all but the 4-byte opcodes */
 #define SF_ADDR_LEN	3
 
+/**
+ * struct sandbox_sf_read_op - Describes a read opcode we understand
+ *
+ * Bus widths do not matter to the emulator since data is always transferred
+ * a byte at a time. What does matter is how many bytes follow the opcode
+ * before the data: all fast reads use 8 dummy clock cycles on the address
+ * lines, so an x-4-4 read has four dummy bytes where an x-1-1 read has one.
+ *
+ * @opcode: Opcode byte
+ * @addr_len: Number of address bytes
+ * @dummy: Number of dummy bytes after the address
+ */
+struct sandbox_sf_read_op {
+	u8 opcode;
+	u8 addr_len;
+	u8 dummy;
+};
+
+static const struct sandbox_sf_read_op sandbox_sf_read_ops[] = {
+	{ SPINOR_OP_READ,		3, 0 },
+	{ SPINOR_OP_READ_FAST,		3, 1 },
+	{ SPINOR_OP_READ_1_1_2,		3, 1 },
+	{ SPINOR_OP_READ_1_2_2,		3, 2 },
+	{ SPINOR_OP_READ_1_1_4,		3, 1 },
+	{ SPINOR_OP_READ_1_4_4,		3, 4 },
+	{ SPINOR_OP_READ_1_1_8,		3, 1 },
+	{ SPINOR_OP_READ_1_8_8,		3, 8 },
+	{ SPINOR_OP_READ_4B,		4, 0 },
+	{ SPINOR_OP_READ_FAST_4B,	4, 1 },
+	{ SPINOR_OP_READ_1_1_2_4B,	4, 1 },
+	{ SPINOR_OP_READ_1_2_2_4B,	4, 2 },
+	{ SPINOR_OP_READ_1_1_4_4B,	4, 1 },
+	{ SPINOR_OP_READ_1_4_4_4B,	4, 4 },
+	{ SPINOR_OP_READ_1_1_8_4B,	4, 1 },
+	{ SPINOR_OP_READ_1_8_8_4B,	4, 8 },
+};
+
+static const struct sandbox_sf_read_op *sandbox_sf_find_read_op(uint cmd)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(sandbox_sf_read_ops); i++) {
+		if (sandbox_sf_read_ops[i].opcode == cmd)
+			return &sandbox_sf_read_ops[i];
+	}
+
+	return NULL;
+}
+
 #define IDCODE_LEN 3
 
 /* Used to quickly bulk erase backing store */
@@ -86,8 +135,8 @@ struct sandbox_spi_flash {
 	uint erase_size;
 	/* Current position in the flash; used when reading/writing/etc... */
 	uint off;
-	/* How many address bytes we've consumed */
-	uint addr_bytes, pad_addr_bytes;
+	/* How many address bytes we've consumed, and how many we expect */
+	uint addr_bytes, addr_len, pad_addr_bytes;
 	/* The current flash status (see STAT_XXX defines above) */
 	u16 status;
 	/* Data describing the flash we're emulating */
@@ -235,20 +284,30 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 				  u8 *tx)
 {
 	enum sandbox_sf_state oldstate = sbsf->state;
+	const struct sandbox_sf_read_op *read_op;
 
 	/* We need to output a byte for the cmd byte we just ate */
 	if (tx)
 		sandbox_spi_tristate(tx, 1);
 
 	sbsf->cmd = rx[0];
+	sbsf->addr_len = SF_ADDR_LEN;
+	read_op = sandbox_sf_find_read_op(sbsf->cmd);
+	if (read_op) {
+		sbsf->addr_len = read_op->addr_len;
+		sbsf->pad_addr_bytes = read_op->dummy;
+		sbsf->state = SF_ADDR;
+		goto out;
+	}
+
 	switch (sbsf->cmd) {
 	case SPINOR_OP_RDID:
 		sbsf->state = SF_ID;
 		sbsf->cmd = SF_ID;
 		break;
-	case SPINOR_OP_READ_FAST:
-		sbsf->pad_addr_bytes = 1;
-	case SPINOR_OP_READ:
+	case SPINOR_OP_PP_4B:
+		sbsf->addr_len = 4;
+		/* fall through */
 	case SPINOR_OP_PP:
 		sbsf->state = SF_ADDR;
 		break;
@@ -289,6 +348,7 @@ static int sandbox_sf_process_cmd(struct sandbox_spi_flash *sbsf, const u8 *rx,
 	}
 	}
 
+out:
 	if (oldstate != sbsf->state)
 		log_content(" cmd: transition to %s state\n",
 			    sandbox_sf_state_name(sbsf->state));
@@ -360,7 +420,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 			log_content(" addr: bytes:%u rx:%02x ",
 				    sbsf->addr_bytes, rx[pos]);
 
-			if (sbsf->addr_bytes++ < SF_ADDR_LEN)
+			if (sbsf->addr_bytes++ < sbsf->addr_len)
 				sbsf->off = (sbsf->off << 8) | rx[pos];
 			log_content("addr:%06x\n", sbsf->off);
 
@@ -370,7 +430,7 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 
 			/* See if we're done processing */
 			if (sbsf->addr_bytes <
-					SF_ADDR_LEN + sbsf->pad_addr_bytes)
+					sbsf->addr_len + sbsf->pad_addr_bytes)
 				break;
 
 			/* Next state! */
@@ -378,15 +438,12 @@ static int sandbox_sf_xfer(struct udevice *dev, unsigned int bitlen,
 				puts("sandbox_sf: os_lseek() failed");
 				return -EIO;
 			}
-			switch (sbsf->cmd) {
-			case SPINOR_OP_READ_FAST:
-			case SPINOR_OP_READ:
+			if (sandbox_sf_find_read_op(sbsf->cmd)) {
 				sbsf->state = SF_READ;
-				break;
-			case SPINOR_OP_PP:
+			} else if (sbsf->cmd == SPINOR_OP_PP ||
+				   sbsf->cmd == SPINOR_OP_PP_4B) {
 				sbsf->state = SF_WRITE;
-				break;
-			default:
+			} else {
 				/* assume erase state ... */
 				sbsf->state = SF_ERASE;
 				goto case_sf_erase;
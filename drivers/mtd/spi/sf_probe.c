@@ -45,8 +45,11 @@ static int spi_flash_probe_slave(struct spi_flash *flash)
 	if (ret)
 		goto err_read_id;
 
-	if (CONFIG_IS_ENABLED(SPI_FLASH_MTD))
+	if (CONFIG_IS_ENABLED(SPI_FLASH_MTD)) {
 		ret = spi_flash_mtd_register(flash);
+		if (ret)
+			spi_nor_remove(flash);
+	}
 
 err_read_id:
 	spi_release_bus(spi);
@@ -86,6 +89,7 @@ void spi_flash_free(struct spi_flash *flash)
 	if (CONFIG_IS_ENABLED(SPI_FLASH_MTD))
 		spi_flash_mtd_unregister();
 
+	spi_nor_remove(flash);
 	spi_free_slave(flash->spi);
 	free(flash);
 }
@@ -143,10 +147,12 @@ int spi_flash_std_probe(struct udevice *dev)
 
 static int spi_flash_std_remove(struct udevice *dev)
 {
+	struct spi_flash *flash = dev_get_uclass_priv(dev);
+
 	if (CONFIG_IS_ENABLED(SPI_FLASH_MTD))
 		spi_flash_mtd_unregister();
 
-	return 0;
+	return spi_nor_remove(flash);
 }
 
 static const struct dm_spi_flash_ops spi_flash_std_ops = {
@@ -73,6 +73,42 @@ static int spi_nor_write_reg(struct spi_nor *nor, u8 opcode, u8 *buf, int len)
 	return spi_nor_read_write_reg(nor, &op, buf);
 }
 
+static void spi_nor_setup_read_op(struct spi_nor *nor, struct spi_mem_op *op)
+{
+	/* get transfer protocols. */
+	op->cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
+	op->addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
+	op->dummy.buswidth = op->addr.buswidth;
+	op->data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+
+	/* convert the dummy cycles to the number of bytes */
+	op->dummy.nbytes = (nor->read_dummy * op->dummy.buswidth) / 8;
+}
+
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+static ssize_t spi_nor_dirmap_read_data(struct spi_nor *nor, loff_t from,
+					size_t len, u_char *buf)
+{
+	size_t remaining = len;
+	ssize_t ret;
+
+	while (remaining) {
+		ret = spi_mem_dirmap_read(nor->dirmap.rdesc, from, remaining,
+					  buf);
+		if (ret < 0)
+			return ret;
+		if (!ret)
+			return -EIO;
+
+		from += ret;
+		remaining -= ret;
+		buf += ret;
+	}
+
+	return len;
+}
+#endif
+
 static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 				 u_char *buf)
 {
@@ -84,14 +120,12 @@ static ssize_t spi_nor_read_data(struct spi_nor *nor, loff_t from, size_t len,
 	size_t remaining = len;
 	int ret;
 
-	/* get transfer protocols. */
-	op.cmd.buswidth = spi_nor_get_protocol_inst_nbits(nor->read_proto);
-	op.addr.buswidth = spi_nor_get_protocol_addr_nbits(nor->read_proto);
-	op.dummy.buswidth = op.addr.buswidth;
-	op.data.buswidth = spi_nor_get_protocol_data_nbits(nor->read_proto);
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+	if (nor->dirmap.rdesc)
+		return spi_nor_dirmap_read_data(nor, from, len, buf);
+#endif
 
-	/* convert the dummy cycles to the number of bytes */
-	op.dummy.nbytes = (nor->read_dummy * op.dummy.buswidth) / 8;
+	spi_nor_setup_read_op(nor, &op);
 
 	while (remaining) {
 		op.data.nbytes = remaining < UINT_MAX ? remaining : UINT_MAX;
@@ -2477,6 +2511,55 @@ static int spi_nor_init(struct spi_nor *nor)
 	return 0;
 }
 
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+/*
+ * Describe the selected (fast) read operation to the controller once, so that
+ * reads can be handed to it whole instead of being issued as a string of
+ * spi_mem_exec_op() calls bounded by the controller's maximum read size.
+ */
+static int spi_nor_create_read_dirmap(struct spi_nor *nor)
+{
+	struct spi_mem_dirmap_info info = {
+		.op_tmpl = SPI_MEM_OP(SPI_MEM_OP_CMD(nor->read_opcode, 1),
+				      SPI_MEM_OP_ADDR(nor->addr_width, 0, 1),
+				      SPI_MEM_OP_DUMMY(nor->read_dummy, 1),
+				      SPI_MEM_OP_DATA_IN(0, NULL, 1)),
+		.offset = 0,
+		.length = nor->mtd.size,
+	};
+	struct spi_mem_dirmap_desc *desc;
+
+	/* Reads beyond 16MiB need a bank switch, which a mapping can't do */
+	if (nor->addr_width == 3 && nor->mtd.size > SZ_16M)
+		return 0;
+
+	spi_nor_setup_read_op(nor, &info.op_tmpl);
+
+	desc = spi_mem_dirmap_create(nor->spi, &info);
+	if (IS_ERR(desc))
+		return PTR_ERR(desc);
+
+	nor->dirmap.rdesc = desc;
+
+	return 0;
+}
+
+int spi_nor_remove(struct spi_nor *nor)
+{
+	if (nor->dirmap.rdesc) {
+		spi_mem_dirmap_destroy(nor->dirmap.rdesc);
+		nor->dirmap.rdesc = NULL;
+	}
+
+	return 0;
+}
+#else
+static inline int spi_nor_create_read_dirmap(struct spi_nor *nor)
+{
+	return 0;
+}
+#endif
+
 int spi_nor_scan(struct spi_nor *nor)
 {
 	struct spi_nor_flash_parameter params;
@@ -2632,6 +2715,10 @@ int spi_nor_scan(struct spi_nor *nor)
 	nor->erase_size = mtd->erasesize;
 	nor->sector_size = mtd->erasesize;
 
+	ret = spi_nor_create_read_dirmap(nor);
+	if (ret)
+		return ret;
+
 #ifndef CONFIG_SPL_BUILD
 	printf("SF: Detected %s with page size ", nor->name);
 	print_size(nor->page_size, ", erase size ");
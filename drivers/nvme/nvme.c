@@ -18,13 +18,12 @@
 #include <linux/compat.h>
 #include "nvme.h"
 
-#define NVME_Q_DEPTH		2
+#define NVME_Q_DEPTH		8
 #define NVME_AQ_DEPTH		2
 #define NVME_SQ_SIZE(depth)	(depth * sizeof(struct nvme_command))
 #define NVME_CQ_SIZE(depth)	(depth * sizeof(struct nvme_completion))
 #define ADMIN_TIMEOUT		60
 #define IO_TIMEOUT		30
-#define MAX_PRP_POOL		512
 
 enum nvme_queue_id {
 	NVME_ADMIN_Q,
@@ -71,16 +70,30 @@ static int nvme_wait_ready(struct nvme_dev *dev, bool enabled)
 	return -ETIME;
 }
 
-static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
+/**
+ * nvme_setup_prps() - build the PRP entries for one I/O command
+ *
+ * Each I/O queue slot owns a pre-allocated, page-aligned PRP list large
+ * enough for the largest transfer the controller accepts, so commands in
+ * flight at the same time never share a list and nothing is allocated on
+ * the I/O path.
+ *
+ * @dev:	NVMe device
+ * @slot:	I/O queue slot the command is submitted in
+ * @prp2:	Returns the value of the command's PRP2 field
+ * @total_len:	Length of the transfer in bytes
+ * @dma_addr:	Start address of the transfer
+ * @return 0 if OK, -EINVAL if the transfer does not fit in the PRP list
+ */
+static int nvme_setup_prps(struct nvme_dev *dev, int slot, u64 *prp2,
 			   int total_len, u64 dma_addr)
 {
 	u32 page_size = dev->page_size;
 	int offset = dma_addr & (page_size - 1);
-	u64 *prp_pool;
+	u64 *prp_list, *prp_page;
 	int length = total_len;
 	int i, nprps;
 	u32 prps_per_page = (page_size >> 3) - 1;
-	u32 num_pages;
 
 	length -= (page_size - offset);
 
@@ -98,39 +111,28 @@ static int nvme_setup_prps(struct nvme_dev *dev, u64 *prp2,
 	}
 
 	nprps = DIV_ROUND_UP(length, page_size);
-	num_pages = DIV_ROUND_UP(nprps, prps_per_page);
-
-	if (nprps > dev->prp_entry_num) {
-		free(dev->prp_pool);
-		/*
-		 * Always increase in increments of pages.  It doesn't waste
-		 * much memory and reduces the number of allocations.
-		 */
-		dev->prp_pool = memalign(page_size, num_pages * page_size);
-		if (!dev->prp_pool) {
-			printf("Error: malloc prp_pool fail\n");
-			return -ENOMEM;
-		}
-		dev->prp_entry_num = prps_per_page * num_pages;
-	}
+	if (nprps > dev->prp_pages * prps_per_page)
+		return -EINVAL;
 
-	prp_pool = dev->prp_pool;
+	prp_list = dev->prp_pool + slot * dev->prp_pages * (page_size >> 3);
+	prp_page = prp_list;
 	i = 0;
 	while (nprps) {
-		if (i == ((page_size >> 3) - 1)) {
-			*(prp_pool + i) = cpu_to_le64((ulong)prp_pool +
-					page_size);
+		/* The last entry of a full page chains to the next page */
+		if (i == prps_per_page && nprps > 1) {
+			prp_page[i] = cpu_to_le64((ulong)(prp_page +
+							  (page_size >> 3)));
 			i = 0;
-			prp_pool += page_size;
+			prp_page += page_size >> 3;
 		}
-		*(prp_pool + i++) = cpu_to_le64(dma_addr);
+		prp_page[i++] = cpu_to_le64(dma_addr);
 		dma_addr += page_size;
 		nprps--;
 	}
-	*prp2 = (ulong)dev->prp_pool;
+	*prp2 = (ulong)prp_list;
 
-	flush_dcache_range((ulong)dev->prp_pool, (ulong)dev->prp_pool +
-			   dev->prp_entry_num * sizeof(u64));
+	flush_dcache_range((ulong)prp_list,
+			   ALIGN((ulong)(prp_page + i), ARCH_DMA_MINALIGN));
 
 	return 0;
 }
@@ -153,12 +155,15 @@ static u16 nvme_read_completion_status(struct nvme_queue *nvmeq, u16 index)
 }
 
 /**
- * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ * nvme_queue_cmd() - copy a command into a queue without ringing the doorbell
+ *
+ * The caller must make sure the queue has room for the command and must call
+ * nvme_ring_sq_doorbell() once it has queued everything it wants to send.
  *
  * @nvmeq:	The queue to use
  * @cmd:	The command to send
  */
-static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+static void nvme_queue_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 {
 	u16 tail = nvmeq->sq_tail;
 
@@ -168,10 +173,81 @@ static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
 
 	if (++tail == nvmeq->q_depth)
 		tail = 0;
-	writel(tail, nvmeq->q_db);
 	nvmeq->sq_tail = tail;
 }
 
+static void nvme_ring_sq_doorbell(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->sq_tail, nvmeq->q_db);
+}
+
+/**
+ * nvme_submit_cmd() - copy a command into a queue and ring the doorbell
+ *
+ * @nvmeq:	The queue to use
+ * @cmd:	The command to send
+ */
+static void nvme_submit_cmd(struct nvme_queue *nvmeq, struct nvme_command *cmd)
+{
+	nvme_queue_cmd(nvmeq, cmd);
+	nvme_ring_sq_doorbell(nvmeq);
+}
+
+/**
+ * nvme_reap_cmd() - wait for the next completion on a queue
+ *
+ * This consumes one completion queue entry but leaves the completion queue
+ * head doorbell alone, so that a batch of completions can be acknowledged
+ * with a single nvme_ring_cq_doorbell().
+ *
+ * @nvmeq:	The queue to use
+ * @cmd_id:	Returns the ID of the completed command
+ * @timeout_us:	Time to wait for a completion in microseconds, or 0 to check
+ *		without waiting
+ * @return 0 if the command succeeded, -EIO if it failed, -ETIMEDOUT if no
+ *	command completed in time
+ */
+static int nvme_reap_cmd(struct nvme_queue *nvmeq, u16 *cmd_id,
+			 ulong timeout_us)
+{
+	u16 head = nvmeq->cq_head;
+	u16 phase = nvmeq->cq_phase;
+	ulong start_time;
+	u16 status;
+
+	start_time = timer_get_us();
+	for (;;) {
+		status = nvme_read_completion_status(nvmeq, head);
+		if ((status & 0x01) == phase)
+			break;
+		if ((timer_get_us() - start_time) >= timeout_us)
+			return -ETIMEDOUT;
+	}
+
+	*cmd_id = le16_to_cpu(readw(&nvmeq->cqes[head].command_id));
+	nvmeq->sq_head = le16_to_cpu(readw(&nvmeq->cqes[head].sq_head));
+
+	if (++head == nvmeq->q_depth) {
+		head = 0;
+		phase = !phase;
+	}
+	nvmeq->cq_head = head;
+	nvmeq->cq_phase = phase;
+
+	status >>= 1;
+	if (status) {
+		printf("ERROR: status = %x, cmd_id = %d\n", status, *cmd_id);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static void nvme_ring_cq_doorbell(struct nvme_queue *nvmeq)
+{
+	writel(nvmeq->cq_head, nvmeq->q_db + nvmeq->dev->db_stride);
+}
+
 static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 				struct nvme_command *cmd,
 				u32 *result, unsigned timeout)
@@ -180,7 +256,7 @@ static int nvme_submit_sync_cmd(struct nvme_queue *nvmeq,
 	u16 phase = nvmeq->cq_phase;
 	u16 status;
 	ulong start_time;
-	ulong timeout_us = timeout * 100000;
+	ulong timeout_us = timeout * 1000000;
 
 	cmd->common.command_id = nvme_get_cmd_id();
 	nvme_submit_cmd(nvmeq, cmd);
@@ -590,6 +666,32 @@ static int nvme_setup_io_queues(struct nvme_dev *dev)
 	return 0;
 }
 
+/**
+ * nvme_reset_ctrl() - reset the controller and set up its queues again
+ *
+ * Disabling the controller aborts every command it has not completed, so
+ * afterwards nothing refers to the host's buffers or PRP lists any more and
+ * the queue slots can safely be used again.
+ *
+ * @dev:	NVMe device
+ * @return 0 if OK, -ve on error
+ */
+static int nvme_reset_ctrl(struct nvme_dev *dev)
+{
+	int ret;
+
+	dev->online_queues = 0;
+	ret = nvme_configure_admin_queue(dev);
+	if (ret)
+		return ret;
+
+	ret = nvme_setup_io_queues(dev);
+	if (ret)
+		return ret;
+
+	return dev->online_queues == NVME_Q_NUM ? 0 : -EIO;
+}
+
 static int nvme_get_info_from_identify(struct nvme_dev *dev)
 {
 	struct nvme_id_ctrl *ctrl;
@@ -718,59 +820,118 @@ static ulong nvme_blk_rw(struct udevice *udev, lbaint_t blknr,
 {
 	struct nvme_ns *ns = dev_get_priv(udev);
 	struct nvme_dev *dev = ns->dev;
+	struct nvme_queue *nvmeq = dev->queues[NVME_IO_Q];
 	struct nvme_command c;
 	struct blk_desc *desc = dev_get_uclass_platdata(udev);
-	int status;
+	u64 slot_lba[NVME_Q_DEPTH];
+	ulong timeout_us = IO_TIMEOUT * 1000000;
+	int nslots = nvmeq->q_depth - 1;
+	uint busy = 0, reaped;
+	int slot, ret;
 	u64 prp2;
 	u64 total_len = blkcnt << desc->log2blksz;
-	u64 temp_len = total_len;
+	void *buf = buffer;
+	u16 cmd_id;
 
 	u64 slba = blknr;
+	u64 failed_lba = blknr + blkcnt;
 	u16 lbas = 1 << (dev->max_transfer_shift - ns->lba_shift);
 	u64 total_lbas = blkcnt;
 
 	flush_dcache_range((unsigned long)buffer,
 			   (unsigned long)buffer + total_len);
 
+	memset(&c, 0, sizeof(c));
 	c.rw.opcode = read ? nvme_cmd_read : nvme_cmd_write;
-	c.rw.flags = 0;
 	c.rw.nsid = cpu_to_le32(ns->ns_id);
-	c.rw.control = 0;
-	c.rw.dsmgmt = 0;
-	c.rw.reftag = 0;
-	c.rw.apptag = 0;
-	c.rw.appmask = 0;
-	c.rw.metadata = 0;
-
-	while (total_lbas) {
-		if (total_lbas < lbas) {
-			lbas = (u16)total_lbas;
-			total_lbas = 0;
-		} else {
+
+	/*
+	 * Keep up to nslots commands in flight. Each one is tagged with the
+	 * index of the slot holding its PRP list, so completions can come
+	 * back in any order. Since a slot is only reused once its command has
+	 * completed, the submission queue can never overflow.
+	 */
+	while (total_lbas || busy) {
+		bool queued = false;
+
+		for (slot = 0; slot < nslots && total_lbas; slot++) {
+			if (busy & BIT(slot))
+				continue;
+			if (total_lbas < lbas)
+				lbas = (u16)total_lbas;
+
+			if (nvme_setup_prps(dev, slot, &prp2,
+					    lbas << ns->lba_shift, (ulong)buf)) {
+				failed_lba = min(failed_lba, slba);
+				total_lbas = 0;
+				break;
+			}
+			c.rw.command_id = cpu_to_le16(slot);
+			c.rw.slba = cpu_to_le64(slba);
+			c.rw.length = cpu_to_le16(lbas - 1);
+			c.rw.prp1 = cpu_to_le64((ulong)buf);
+			c.rw.prp2 = cpu_to_le64(prp2);
+			nvme_queue_cmd(nvmeq, &c);
+			queued = true;
+
+			busy |= BIT(slot);
+			slot_lba[slot] = slba;
+			slba += lbas;
 			total_lbas -= lbas;
+			buf += lbas << ns->lba_shift;
 		}
+		if (queued)
+			nvme_ring_sq_doorbell(nvmeq);
+		if (!busy)
+			break;
 
-		if (nvme_setup_prps(dev, &prp2,
-				    lbas << ns->lba_shift, (ulong)buffer))
-			return -EIO;
-		c.rw.slba = cpu_to_le64(slba);
-		slba += lbas;
-		c.rw.length = cpu_to_le16(lbas - 1);
-		c.rw.prp1 = cpu_to_le64((ulong)buffer);
-		c.rw.prp2 = cpu_to_le64(prp2);
-		status = nvme_submit_sync_cmd(dev->queues[NVME_IO_Q],
-				&c, NULL, IO_TIMEOUT);
-		if (status)
+		/* Wait for one completion, then pick up any others */
+		for (reaped = 0; busy; reaped++) {
+			ret = nvme_reap_cmd(nvmeq, &cmd_id,
+					    reaped ? 0 : timeout_us);
+			if (ret == -ETIMEDOUT)
+				break;
+			if (cmd_id >= nslots || !(busy & BIT(cmd_id))) {
+				printf("ERROR: unexpected cmd_id %d\n", cmd_id);
+				continue;
+			}
+			busy &= ~BIT(cmd_id);
+			if (ret) {
+				failed_lba = min(failed_lba, slot_lba[cmd_id]);
+				total_lbas = 0;
+			}
+		}
+		if (reaped)
+			nvme_ring_cq_doorbell(nvmeq);
+		else
+			/* Nothing completed in time; give up on the rest */
 			break;
-		temp_len -= (u32)lbas << ns->lba_shift;
-		buffer += lbas << ns->lba_shift;
 	}
 
+	if (busy) {
+		for (slot = 0; slot < nslots; slot++) {
+			if (busy & BIT(slot))
+				failed_lba = min(failed_lba, slot_lba[slot]);
+		}
+		/*
+		 * The commands which timed out still own their slots and may
+		 * complete at any time, so stop the controller before the
+		 * slots and the caller's buffer are used again
+		 */
+		printf("ERROR: %s: I/O timed out, resetting controller\n",
+		       udev->name);
+		ret = nvme_reset_ctrl(dev);
+		if (ret)
+			printf("ERROR: %s: reset failed (err=%d)\n", udev->name,
+			       ret);
+	}
+	failed_lba = min(failed_lba, slba);
+
 	if (read)
 		invalidate_dcache_range((unsigned long)buffer,
 					(unsigned long)buffer + total_len);
 
-	return (total_len - temp_len) >> desc->log2blksz;
+	return failed_lba - blknr;
 }
 
 static ulong nvme_blk_read(struct udevice *udev, lbaint_t blknr,
@@ -841,21 +1002,27 @@ static int nvme_probe(struct udevice *udev)
 	if (ret)
 		goto free_queue;
 
-	/* Allocate after the page size is known */
-	ndev->prp_pool = memalign(ndev->page_size, MAX_PRP_POOL);
-	if (!ndev->prp_pool) {
-		ret = -ENOMEM;
-		printf("Error: %s: Out of memory!\n", udev->name);
-		goto free_nvme;
-	}
-	ndev->prp_entry_num = MAX_PRP_POOL >> 3;
-
 	ret = nvme_setup_io_queues(ndev);
 	if (ret)
 		goto free_queue;
 
 	nvme_get_info_from_identify(ndev);
 
+	/*
+	 * Allocate a PRP list for each I/O queue slot, now that the page size
+	 * and maximum transfer size are known
+	 */
+	ndev->prp_pages = DIV_ROUND_UP((1 << ndev->max_transfer_shift) /
+				       ndev->page_size,
+				       (ndev->page_size >> 3) - 1);
+	ndev->prp_pool = memalign(ndev->page_size, (ndev->q_depth - 1) *
+				  ndev->prp_pages * ndev->page_size);
+	if (!ndev->prp_pool) {
+		ret = -ENOMEM;
+		printf("Error: %s: Out of memory!\n", udev->name);
+		goto free_queue;
+	}
+
 	return 0;
 
 free_queue:
@@ -864,9 +1031,24 @@ free_nvme:
 	return ret;
 }
 
+#ifdef CONFIG_SANDBOX
+/*
+ * Real devices are bound by their PCI class below. The sandbox PCI bus can
+ * only reach an emulator through a device bound from the device tree, so
+ * the emulated device needs a compatible string.
+ */
+static const struct udevice_id nvme_ids[] = {
+	{ .compatible = "sandbox,nvme" },
+	{ }
+};
+#endif
+
 U_BOOT_DRIVER(nvme) = {
 	.name	= "nvme",
 	.id	= UCLASS_NVME,
+#ifdef CONFIG_SANDBOX
+	.of_match = nvme_ids,
+#endif
 	.bind	= nvme_bind,
 	.probe	= nvme_probe,
 	.priv_auto_alloc_size = sizeof(struct nvme_dev),
@@ -624,8 +624,8 @@ struct nvme_dev {
 	u32 stripe_size;
 	u32 page_size;
 	u8 vwc;
-	u64 *prp_pool;
-	u32 prp_entry_num;
+	u64 *prp_pool;		/* one PRP list per I/O queue slot */
+	u32 prp_pages;		/* pages in each PRP list */
 	u32 nn;
 };
 
@@ -0,0 +1,548 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * PCI emulation device for an NVMe controller
+ *
+ * This provides a single namespace held in memory, which is enough for the
+ * NVMe driver to probe and to read and write blocks. Commands are processed
+ * as soon as the submission queue doorbell is written. The completions for a
+ * batch of I/O commands are posted in reverse order, so that the driver has
+ * to match them by command ID.
+ */
+
+#include <common.h>
+#include <dm.h>
+#include <log.h>
+#include <malloc.h>
+#include <pci.h>
+#include <asm/io.h>
+#include <asm/test.h>
+#include "nvme.h"
+
+enum {
+	NVME_EMUL_BAR_SIZE	= 0x2000,
+	/* Offset of the doorbells, with a stride of 4 bytes */
+	NVME_EMUL_DB		= 0x1000,
+	/* Admin queue and one I/O queue */
+	NVME_EMUL_QUEUES	= 2,
+	NVME_EMUL_DEPTH		= 8,
+	NVME_EMUL_PAGE_SIZE	= 4096,
+	/* Largest transfer, as a power of two of the page size */
+	NVME_EMUL_MDTS		= 3,
+	NVME_EMUL_LBA_SHIFT	= 9,
+	NVME_EMUL_BLOCKS	= 2048,
+};
+
+/**
+ * struct nvme_emul_platdata - platform data for this device
+ *
+ * @command:	Current PCI command value
+ * @bar:	Current base address values
+ */
+struct nvme_emul_platdata {
+	u16 command;
+	u32 bar[6];
+};
+
+static struct pci_bar {
+	int type;
+	u32 size;
+} barinfo[] = {
+	{ PCI_BASE_ADDRESS_MEM_TYPE_32, NVME_EMUL_BAR_SIZE },
+	{ 0, 0 },
+	{ 0, 0 },
+	{ 0, 0 },
+	{ 0, 0 },
+	{ 0, 0 },
+};
+
+/**
+ * struct nvme_emul_queue - a submission or completion queue
+ *
+ * @base:	Queue entries in host memory, or NULL if the queue is not set up
+ * @depth:	Number of entries in the queue
+ * @head:	Next entry to process (submission queue only)
+ * @tail:	Next entry to fill (completion queue only)
+ * @phase:	Phase tag for the next entry (completion queue only)
+ */
+struct nvme_emul_queue {
+	void *base;
+	u16 depth;
+	u16 head;
+	u16 tail;
+	u8 phase;
+};
+
+/**
+ * struct nvme_emul_done - result of a command, waiting to be posted
+ *
+ * @command_id:	Command ID from the submission queue entry
+ * @status:	Status code (NVME_SC_...)
+ * @result:	Command-specific result
+ */
+struct nvme_emul_done {
+	u16 command_id;
+	u16 status;
+	u32 result;
+};
+
+/**
+ * struct nvme_emul_priv - private data for this device
+ *
+ * @regs:	Controller registers, mapped through BAR 0
+ * @sq:		Submission queues
+ * @cq:		Completion queues
+ * @disk:	Namespace contents
+ * @fail_lba:	I/O commands touching this block fail, -1ULL for none
+ * @max_batch:	Largest number of I/O commands processed in one go
+ */
+struct nvme_emul_priv {
+	u8 regs[NVME_EMUL_BAR_SIZE] __aligned(8);
+	struct nvme_emul_queue sq[NVME_EMUL_QUEUES];
+	struct nvme_emul_queue cq[NVME_EMUL_QUEUES];
+	u8 *disk;
+	u64 fail_lba;
+	uint max_batch;
+};
+
+static void *nvme_emul_ptr(__le64 addr)
+{
+	return (void *)(ulong)le64_to_cpu(addr);
+}
+
+static int nvme_emul_identify(struct nvme_emul_priv *priv,
+			      struct nvme_identify *c)
+{
+	void *buf = nvme_emul_ptr(c->prp1);
+
+	switch (le32_to_cpu(c->cns)) {
+	case 0: {
+		struct nvme_id_ns *id = buf;
+
+		if (le32_to_cpu(c->nsid) != 1)
+			return NVME_SC_INVALID_NS;
+		memset(id, '\0', sizeof(*id));
+		id->nsze = cpu_to_le64(NVME_EMUL_BLOCKS);
+		id->ncap = id->nsze;
+		id->nuse = id->nsze;
+		id->lbaf[0].ds = NVME_EMUL_LBA_SHIFT;
+		break;
+	}
+	case 1: {
+		struct nvme_id_ctrl *id = buf;
+
+		memset(id, '\0', sizeof(*id));
+		id->vid = cpu_to_le16(SANDBOX_PCI_VENDOR_ID);
+		memcpy(id->sn, "sandbox-nvme", 12);
+		memcpy(id->mn, "Sandbox NVMe emulator", 21);
+		memcpy(id->fr, "1.0", 3);
+		id->mdts = NVME_EMUL_MDTS;
+		id->nn = cpu_to_le32(1);
+		break;
+	}
+	default:
+		return NVME_SC_INVALID_FIELD;
+	}
+
+	return NVME_SC_SUCCESS;
+}
+
+static int nvme_emul_create_queue(struct nvme_emul_queue *q, uint qid,
+				  __le64 prp1, __le16 qsize)
+{
+	uint depth = le16_to_cpu(qsize) + 1;
+
+	if (!qid || qid >= NVME_EMUL_QUEUES)
+		return NVME_SC_QID_INVALID;
+	if (depth > NVME_EMUL_DEPTH)
+		return NVME_SC_QUEUE_SIZE;
+	memset(q, '\0', sizeof(*q));
+	q->base = nvme_emul_ptr(prp1);
+	q->depth = depth;
+	q->phase = 1;
+
+	return NVME_SC_SUCCESS;
+}
+
+static int nvme_emul_admin(struct nvme_emul_priv *priv,
+			   struct nvme_command *c, u32 *resultp)
+{
+	uint qid;
+
+	switch (c->common.opcode) {
+	case nvme_admin_identify:
+		return nvme_emul_identify(priv, &c->identify);
+	case nvme_admin_set_features:
+		if (le32_to_cpu(c->features.fid) != NVME_FEAT_NUM_QUEUES)
+			return NVME_SC_INVALID_FIELD;
+		/* One submission queue and one completion queue, zero-based */
+		*resultp = 0;
+		return NVME_SC_SUCCESS;
+	case nvme_admin_create_cq:
+		qid = le16_to_cpu(c->create_cq.cqid);
+		return nvme_emul_create_queue(&priv->cq[qid % NVME_EMUL_QUEUES],
+					      qid, c->create_cq.prp1,
+					      c->create_cq.qsize);
+	case nvme_admin_create_sq:
+		qid = le16_to_cpu(c->create_sq.sqid);
+		return nvme_emul_create_queue(&priv->sq[qid % NVME_EMUL_QUEUES],
+					      qid, c->create_sq.prp1,
+					      c->create_sq.qsize);
+	case nvme_admin_delete_sq:
+	case nvme_admin_delete_cq:
+		qid = le16_to_cpu(c->delete_queue.qid);
+		if (!qid || qid >= NVME_EMUL_QUEUES)
+			return NVME_SC_QID_INVALID;
+		if (c->common.opcode == nvme_admin_delete_sq)
+			priv->sq[qid].base = NULL;
+		else
+			priv->cq[qid].base = NULL;
+		return NVME_SC_SUCCESS;
+	}
+
+	return NVME_SC_INVALID_OPCODE;
+}
+
+static void nvme_emul_copy(void *ptr, u8 *disk, uint len, bool read)
+{
+	if (read)
+		memcpy(ptr, disk, len);
+	else
+		memcpy(disk, ptr, len);
+}
+
+/**
+ * nvme_emul_xfer() - Move data for an I/O command, following its PRPs
+ *
+ * @c:		Read or write command
+ * @disk:	Place in the namespace to read from or write to
+ * @len:	Number of bytes to transfer
+ * @read:	true to read from the namespace, false to write to it
+ * @return NVME_SC_SUCCESS if OK, NVME_SC_INVALID_FIELD if a PRP entry is not
+ *	page-aligned
+ */
+static int nvme_emul_xfer(struct nvme_rw_command *c, u8 *disk, uint len,
+			  bool read)
+{
+	const uint per_page = NVME_EMUL_PAGE_SIZE / sizeof(u64);
+	u8 *ptr = nvme_emul_ptr(c->prp1);
+	uint offset = (ulong)ptr & (NVME_EMUL_PAGE_SIZE - 1);
+	uint chunk = min(len, NVME_EMUL_PAGE_SIZE - offset);
+	__le64 *list;
+	uint i;
+
+	nvme_emul_copy(ptr, disk, chunk, read);
+	disk += chunk;
+	len -= chunk;
+	if (!len)
+		return NVME_SC_SUCCESS;
+
+	/* PRP2 is either the second page or a list of the remaining pages */
+	ptr = nvme_emul_ptr(c->prp2);
+	if ((ulong)ptr & (NVME_EMUL_PAGE_SIZE - 1))
+		return NVME_SC_INVALID_FIELD;
+	if (len <= NVME_EMUL_PAGE_SIZE) {
+		nvme_emul_copy(ptr, disk, len, read);
+		return NVME_SC_SUCCESS;
+	}
+
+	list = (__le64 *)ptr;
+	for (i = 0; len; i++) {
+		/* The last entry in a full page points to the next page */
+		if (i == per_page - 1 && len > NVME_EMUL_PAGE_SIZE) {
+			list = nvme_emul_ptr(list[i]);
+			i = 0;
+		}
+		ptr = nvme_emul_ptr(list[i]);
+		if ((ulong)ptr & (NVME_EMUL_PAGE_SIZE - 1))
+			return NVME_SC_INVALID_FIELD;
+		chunk = min(len, (uint)NVME_EMUL_PAGE_SIZE);
+		nvme_emul_copy(ptr, disk, chunk, read);
+		disk += chunk;
+		len -= chunk;
+	}
+
+	return NVME_SC_SUCCESS;
+}
+
+static int nvme_emul_io(struct nvme_emul_priv *priv, struct nvme_command *c)
+{
+	struct nvme_rw_command *rw = &c->rw;
+	u64 slba = le64_to_cpu(rw->slba);
+	uint nlb = le16_to_cpu(rw->length) + 1;
+	bool read;
+
+	switch (rw->opcode) {
+	case nvme_cmd_flush:
+		return NVME_SC_SUCCESS;
+	case nvme_cmd_read:
+		read = true;
+		break;
+	case nvme_cmd_write:
+		read = false;
+		break;
+	default:
+		return NVME_SC_INVALID_OPCODE;
+	}
+	if (le32_to_cpu(rw->nsid) != 1)
+		return NVME_SC_INVALID_NS;
+	if (slba >= NVME_EMUL_BLOCKS || nlb > NVME_EMUL_BLOCKS - slba)
+		return NVME_SC_LBA_RANGE;
+	if (nlb << NVME_EMUL_LBA_SHIFT >
+	    NVME_EMUL_PAGE_SIZE << NVME_EMUL_MDTS)
+		return NVME_SC_INVALID_FIELD;
+	if (priv->fail_lba >= slba && priv->fail_lba < slba + nlb)
+		return NVME_SC_DATA_XFER_ERROR;
+
+	return nvme_emul_xfer(rw, priv->disk + (slba << NVME_EMUL_LBA_SHIFT),
+			      nlb << NVME_EMUL_LBA_SHIFT, read);
+}
+
+static void nvme_emul_complete(struct nvme_emul_priv *priv, uint qid,
+			       struct nvme_emul_done *done)
+{
+	struct nvme_emul_queue *cq = &priv->cq[qid];
+	struct nvme_completion *cqe;
+
+	cqe = (struct nvme_completion *)cq->base + cq->tail;
+	cqe->result = cpu_to_le32(done->result);
+	cqe->sq_head = cpu_to_le16(priv->sq[qid].head);
+	cqe->sq_id = cpu_to_le16(qid);
+	cqe->command_id = done->command_id;
+	/* Write the status last, since its phase tag makes the entry valid */
+	cqe->status = cpu_to_le16(done->status << 1 | cq->phase);
+	if (++cq->tail == cq->depth) {
+		cq->tail = 0;
+		cq->phase = !cq->phase;
+	}
+}
+
+/* Process the commands up to a new submission queue tail */
+static void nvme_emul_run_sq(struct nvme_emul_priv *priv, uint qid, uint tail)
+{
+	struct nvme_emul_queue *sq = &priv->sq[qid];
+	struct nvme_emul_done done[NVME_EMUL_DEPTH];
+	struct nvme_command *c;
+	uint count, i;
+
+	if (!sq->base || !priv->cq[qid].base || tail >= sq->depth)
+		return;
+
+	for (count = 0; sq->head != tail; count++) {
+		c = (struct nvme_command *)sq->base + sq->head;
+		if (++sq->head == sq->depth)
+			sq->head = 0;
+		done[count].command_id = c->common.command_id;
+		done[count].result = 0;
+		if (qid)
+			done[count].status = nvme_emul_io(priv, c);
+		else
+			done[count].status = nvme_emul_admin(priv, c,
+							     &done[count].result);
+	}
+
+	if (!qid) {
+		for (i = 0; i < count; i++)
+			nvme_emul_complete(priv, qid, &done[i]);
+		return;
+	}
+	priv->max_batch = max(priv->max_batch, count);
+	for (i = count; i--;)
+		nvme_emul_complete(priv, qid, &done[i]);
+}
+
+/* Enable or disable the controller when the CC register is written */
+static void nvme_emul_set_cc(struct nvme_emul_priv *priv)
+{
+	struct nvme_bar *bar = (struct nvme_bar *)priv->regs;
+	u32 cc = le32_to_cpu(bar->cc);
+	u32 aqa = le32_to_cpu(bar->aqa);
+
+	/* Disabling the controller deletes all the queues */
+	memset(priv->sq, '\0', sizeof(priv->sq));
+	memset(priv->cq, '\0', sizeof(priv->cq));
+	if (!(cc & NVME_CC_ENABLE)) {
+		bar->csts = 0;
+		return;
+	}
+
+	priv->sq[0].base = (void *)(ulong)le64_to_cpu(bar->asq);
+	priv->sq[0].depth = (aqa & 0xfff) + 1;
+	priv->cq[0].base = (void *)(ulong)le64_to_cpu(bar->acq);
+	priv->cq[0].depth = ((aqa >> 16) & 0xfff) + 1;
+	priv->cq[0].phase = 1;
+	bar->csts = cpu_to_le32(NVME_CSTS_RDY);
+}
+
+static void nvme_emul_write(struct udevice *dev, ulong offset, u64 val)
+{
+	struct nvme_emul_priv *priv = dev_get_priv(dev);
+	uint db, qid;
+
+	if (offset == offsetof(struct nvme_bar, cc)) {
+		nvme_emul_set_cc(priv);
+	} else if (offset >= NVME_EMUL_DB) {
+		db = (offset - NVME_EMUL_DB) / sizeof(u32);
+		qid = db / 2;
+		/* Completion queue head doorbells need no action */
+		if (qid < NVME_EMUL_QUEUES && !(db & 1))
+			nvme_emul_run_sq(priv, qid, val);
+	}
+}
+
+static int sandbox_nvme_emul_read_config(const struct udevice *emul,
+					 uint offset, ulong *valuep,
+					 enum pci_size_t size)
+{
+	struct nvme_emul_platdata *plat = dev_get_platdata(emul);
+
+	switch (offset) {
+	case PCI_COMMAND:
+		*valuep = plat->command;
+		break;
+	case PCI_HEADER_TYPE:
+		*valuep = PCI_HEADER_TYPE_NORMAL;
+		break;
+	case PCI_VENDOR_ID:
+		*valuep = SANDBOX_PCI_VENDOR_ID;
+		break;
+	case PCI_DEVICE_ID:
+		*valuep = SANDBOX_PCI_NVME_EMUL_ID;
+		break;
+	case PCI_CLASS_REVISION:
+		*valuep = PCI_CLASS_STORAGE_EXPRESS << 8;
+		break;
+	case PCI_CLASS_DEVICE:
+		*valuep = PCI_CLASS_STORAGE_EXPRESS >> 8;
+		break;
+	case PCI_BASE_ADDRESS_0:
+	case PCI_BASE_ADDRESS_1:
+	case PCI_BASE_ADDRESS_2:
+	case PCI_BASE_ADDRESS_3:
+	case PCI_BASE_ADDRESS_4:
+	case PCI_BASE_ADDRESS_5: {
+		int barnum;
+
+		barnum = pci_offset_to_barnum(offset);
+		*valuep = sandbox_pci_read_bar(plat->bar[barnum],
+					       barinfo[barnum].type,
+					       barinfo[barnum].size);
+		break;
+	}
+	default:
+		*valuep = 0;
+		break;
+	}
+
+	return 0;
+}
+
+static int sandbox_nvme_emul_write_config(struct udevice *emul, uint offset,
+					  ulong value, enum pci_size_t size)
+{
+	struct nvme_emul_platdata *plat = dev_get_platdata(emul);
+
+	switch (offset) {
+	case PCI_COMMAND:
+		plat->command = value;
+		break;
+	case PCI_BASE_ADDRESS_0:
+	case PCI_BASE_ADDRESS_1:
+	case PCI_BASE_ADDRESS_2:
+	case PCI_BASE_ADDRESS_3:
+	case PCI_BASE_ADDRESS_4:
+	case PCI_BASE_ADDRESS_5: {
+		int barnum;
+
+		barnum = pci_offset_to_barnum(offset);
+		plat->bar[barnum] = value;
+		/* space indicator (bit#0) is read-only */
+		plat->bar[barnum] |= barinfo[barnum].type;
+		break;
+	}
+	}
+
+	return 0;
+}
+
+static int sandbox_nvme_emul_map_physmem(struct udevice *dev,
+					 phys_addr_t addr, unsigned long *lenp,
+					 void **ptrp)
+{
+	struct nvme_emul_platdata *plat = dev_get_platdata(dev);
+	struct nvme_emul_priv *priv = dev_get_priv(dev);
+	u32 base = plat->bar[0] & PCI_BASE_ADDRESS_MEM_MASK;
+	uint offset;
+
+	if (addr < base || addr >= base + NVME_EMUL_BAR_SIZE)
+		return -ENOENT;
+	offset = addr - base;
+	*ptrp = priv->regs + offset;
+	*lenp = min(*lenp, (ulong)(NVME_EMUL_BAR_SIZE - offset));
+
+	return 0;
+}
+
+static int sandbox_nvme_emul_probe(struct udevice *dev)
+{
+	struct nvme_emul_priv *priv = dev_get_priv(dev);
+	struct nvme_bar *bar = (struct nvme_bar *)priv->regs;
+
+	priv->disk = calloc(NVME_EMUL_BLOCKS, 1 << NVME_EMUL_LBA_SHIFT);
+	if (!priv->disk)
+		return -ENOMEM;
+	priv->fail_lba = -1ULL;
+
+	/* MQES, contiguous queues required, 500ms timeout, NVM command set */
+	bar->cap = cpu_to_le64((NVME_EMUL_DEPTH - 1) | 1 << 16 | 1 << 24 |
+			       1ULL << 37);
+	bar->vs = cpu_to_le32(0x10300);
+
+	return sandbox_mmio_add(dev, priv->regs, sizeof(priv->regs),
+				nvme_emul_write);
+}
+
+static int sandbox_nvme_emul_remove(struct udevice *dev)
+{
+	struct nvme_emul_priv *priv = dev_get_priv(dev);
+
+	sandbox_mmio_remove(dev);
+	free(priv->disk);
+
+	return 0;
+}
+
+void sandbox_nvme_emul_set_fail_lba(struct udevice *emul, u64 lba)
+{
+	struct nvme_emul_priv *priv = dev_get_priv(emul);
+
+	priv->fail_lba = lba;
+}
+
+uint sandbox_nvme_emul_get_max_batch(struct udevice *emul)
+{
+	struct nvme_emul_priv *priv = dev_get_priv(emul);
+
+	return priv->max_batch;
+}
+
+static struct dm_pci_emul_ops sandbox_nvme_emul_emul_ops = {
+	.read_config = sandbox_nvme_emul_read_config,
+	.write_config = sandbox_nvme_emul_write_config,
+	.map_physmem = sandbox_nvme_emul_map_physmem,
+};
+
+static const struct udevice_id sandbox_nvme_emul_ids[] = {
+	{ .compatible = "sandbox,nvme-emul" },
+	{ }
+};
+
+U_BOOT_DRIVER(sandbox_nvme_emul_emul) = {
+	.name		= "sandbox_nvme_emul_emul",
+	.id		= UCLASS_PCI_EMUL,
+	.of_match	= sandbox_nvme_emul_ids,
+	.ops		= &sandbox_nvme_emul_emul_ops,
+	.probe		= sandbox_nvme_emul_probe,
+	.remove		= sandbox_nvme_emul_remove,
+	.priv_auto_alloc_size = sizeof(struct nvme_emul_priv),
+	.platdata_auto_alloc_size = sizeof(struct nvme_emul_platdata),
+};
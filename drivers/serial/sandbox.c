@@ -19,6 +19,7 @@
 #include <video.h>
 #include <linux/compiler.h>
 #include <asm/state.h>
+#include <asm/test.h>
 
 DECLARE_GLOBAL_DATA_PTR;
 
@@ -37,6 +38,10 @@ static unsigned char serial_buf[16];
 static unsigned int serial_buf_write;
 static unsigned int serial_buf_read;
 
+/* Test controls for output: FIFO space left (-1 for no limit), chars sent */
+static int serial_tx_room = -1;
+static unsigned int serial_tx_count;
+
 struct sandbox_serial_platdata {
 	int colour;	/* Text colour to use for output, -1 for none */
 };
@@ -93,6 +98,12 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	struct sandbox_serial_priv *priv = dev_get_priv(dev);
 	struct sandbox_serial_platdata *plat = dev->platdata;
 
+	if (!serial_tx_room)
+		return -EAGAIN;	/* pretend that the FIFO is full */
+	if (serial_tx_room > 0)
+		serial_tx_room--;
+	serial_tx_count++;
+
 	/* With of-platdata we don't real the colour correctly, so disable it */
 	if (!CONFIG_IS_ENABLED(OF_PLATDATA) && priv->start_of_line &&
 	    plat->colour != -1) {
@@ -107,6 +118,16 @@ static int sandbox_serial_putc(struct udevice *dev, const char ch)
 	return 0;
 }
 
+void sandbox_serial_set_tx_room(int room)
+{
+	serial_tx_room = room;
+}
+
+uint sandbox_serial_get_tx_count(void)
+{
+	return serial_tx_count;
+}
+
 static unsigned int increment_buffer_index(unsigned int index)
 {
 	return (index + 1) % ARRAY_SIZE(serial_buf);
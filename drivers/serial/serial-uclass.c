@@ -271,6 +271,27 @@ void serial_puts(const char *str)
 		_serial_puts(gd->cur_serial_dev, str);
 }
 
+int serial_try_puts(struct udevice *dev, const char *str, int len)
+{
+	struct dm_serial_ops *ops = serial_get_ops(dev);
+	int i, err;
+
+	for (i = 0; i < len; i++) {
+		if (str[i] == '\n') {
+			if (ops->putc(dev, '\r') == -EAGAIN)
+				break;
+			/* The '\r' is out, so the '\n' must follow it */
+			do {
+				err = ops->putc(dev, '\n');
+			} while (err == -EAGAIN);
+		} else if (ops->putc(dev, str[i]) == -EAGAIN) {
+			break;
+		}
+	}
+
+	return i;
+}
+
 int serial_getc(void)
 {
 	if (!gd->cur_serial_dev)
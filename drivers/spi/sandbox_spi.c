@@ -15,6 +15,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <os.h>
 
@@ -134,12 +135,61 @@ static int sandbox_spi_get_mmap(struct udevice *dev, ulong *map_basep,
 	return 0;
 }
 
+static int sandbox_spi_dirmap_create(struct spi_mem_dirmap_desc *desc)
+{
+	/* The emulator can stream any amount of data from one read op */
+	return 0;
+}
+
+/*
+ * Model a controller with a memory-mapped read window: the whole request is
+ * served by a single operation, with no max_read_size splitting
+ */
+static ssize_t sandbox_spi_dirmap_read(struct spi_mem_dirmap_desc *desc,
+				       u64 offs, size_t len, void *buf)
+{
+	const struct spi_mem_op *tmpl = &desc->info.op_tmpl;
+	u64 addr = desc->info.offset + offs;
+	u8 op_buf[1 + 8 + 0xff];
+	uint pos = 0;
+	int ret;
+	int i;
+
+	if (tmpl->dummy.nbytes > sizeof(op_buf) - 1 - tmpl->addr.nbytes)
+		return -EINVAL;
+	/* The bus deals in bits, so keep the length within a uint */
+	len = min_t(size_t, len, UINT_MAX / 8);
+
+	op_buf[pos++] = tmpl->cmd.opcode;
+	for (i = 0; i < tmpl->addr.nbytes; i++)
+		op_buf[pos++] = addr >> (8 * (tmpl->addr.nbytes - i - 1));
+	memset(op_buf + pos, 0xff, tmpl->dummy.nbytes);
+	pos += tmpl->dummy.nbytes;
+
+	ret = sandbox_spi_xfer(desc->slave->dev, pos * 8, op_buf, NULL,
+			       SPI_XFER_BEGIN);
+	if (ret)
+		return ret;
+	ret = sandbox_spi_xfer(desc->slave->dev, len * 8, NULL, buf,
+			       SPI_XFER_END);
+	if (ret)
+		return ret;
+
+	return len;
+}
+
+static const struct spi_controller_mem_ops sandbox_spi_mem_ops = {
+	.dirmap_create	= sandbox_spi_dirmap_create,
+	.dirmap_read	= sandbox_spi_dirmap_read,
+};
+
 static const struct dm_spi_ops sandbox_spi_ops = {
 	.xfer		= sandbox_spi_xfer,
 	.set_speed	= sandbox_spi_set_speed,
 	.set_mode	= sandbox_spi_set_mode,
 	.cs_info	= sandbox_cs_info,
 	.get_mmap	= sandbox_spi_get_mmap,
+	.mem_ops	= &sandbox_spi_mem_ops,
 };
 
 static const struct udevice_id sandbox_spi_ids[] = {
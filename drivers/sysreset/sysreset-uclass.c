@@ -8,6 +8,7 @@
 
 #include <common.h>
 #include <command.h>
+#include <console.h>
 #include <cpu_func.h>
 #include <hang.h>
 #include <log.h>
@@ -94,6 +95,7 @@ void sysreset_walk_halt(enum sysreset_t type)
 {
 	int ret;
 
+	console_flush();
 	ret = sysreset_walk(type);
 
 	/* Wait for the reset to take effect */
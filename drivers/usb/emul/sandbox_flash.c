@@ -44,6 +44,7 @@ enum {
  * @alloc_len:	Allocation length from the last incoming command
  * @transfer_len: Transfer length from CBW header
  * @read_len:	Number of blocks of data left in the current read command
+ * @max_read_len: Largest number of blocks requested by a read command
  * @tag:	Tag value from last command
  * @fd:		File descriptor of backing file
  * @file_size:	Size of file in bytes
@@ -56,6 +57,7 @@ struct sandbox_flash_priv {
 	int alloc_len;
 	int transfer_len;
 	int read_len;
+	int max_read_len;
 	enum cmd_phase phase;
 	u32 tag;
 	int fd;
@@ -65,9 +67,19 @@ struct sandbox_flash_priv {
 	u8 buff[512];
 };
 
+/**
+ * struct sandbox_flash_plat - platform data for this driver
+ *
+ * @pathname:	Path of the backing file
+ * @flash_strings: String descriptors
+ * @device_desc: Device descriptor, which gives the USB version
+ * @desc_list:	Descriptors for this device, starting with @device_desc
+ */
 struct sandbox_flash_plat {
 	const char *pathname;
 	struct usb_string flash_strings[STRINGID_COUNT];
+	struct usb_device_descriptor device_desc;
+	void *desc_list[6];
 };
 
 struct scsi_inquiry_resp {
@@ -231,6 +243,7 @@ static void handle_read(struct sandbox_flash_priv *priv, ulong lba,
 	if (priv->fd != -1) {
 		os_lseek(priv->fd, lba * SANDBOX_FLASH_BLOCK_LEN, OS_SEEK_SET);
 		priv->read_len = transfer_len;
+		priv->max_read_len = max(priv->max_read_len, (int)transfer_len);
 		setup_response(priv, priv->buff,
 			       transfer_len * SANDBOX_FLASH_BLOCK_LEN);
 	} else {
@@ -388,7 +401,14 @@ static int sandbox_flash_bind(struct udevice *dev)
 	fs[2].id = STRINGID_SERIAL;
 	fs[2].s = dev->name;
 
-	return usb_emul_setup_device(dev, plat->flash_strings, flash_desc_list);
+	/* A SuperSpeed stick only differs in the USB version it reports */
+	plat->device_desc = flash_device_desc;
+	if (dev_read_bool(dev, "sandbox,superspeed"))
+		plat->device_desc.bcdUSB = cpu_to_le16(0x0300);
+	memcpy(plat->desc_list, flash_desc_list, sizeof(flash_desc_list));
+	plat->desc_list[0] = &plat->device_desc;
+
+	return usb_emul_setup_device(dev, plat->flash_strings, plat->desc_list);
 }
 
 static int sandbox_flash_probe(struct udevice *dev)
@@ -403,6 +423,13 @@ static int sandbox_flash_probe(struct udevice *dev)
 	return 0;
 }
 
+int sandbox_usb_flash_get_max_read(struct udevice *dev)
+{
+	struct sandbox_flash_priv *priv = dev_get_priv(dev);
+
+	return priv->max_read_len;
+}
+
 static const struct dm_usb_ops sandbox_usb_flash_ops = {
 	.control	= sandbox_flash_control,
 	.bulk		= sandbox_flash_bulk,
@@ -9,7 +9,7 @@
 #include <log.h>
 #include <malloc.h>
 #include <linux/lzo.h>
-#include <linux/zstd.h>
+#include <u-boot/zstd.h>
 #include <linux/compat.h>
 #include <u-boot/zlib.h>
 #include <asm/unaligned.h>
@@ -139,22 +139,12 @@ static u32 decompress_zstd(const u8 *cbuf, u32 clen, u8 *dbuf, u32 dlen)
 	ZSTD_DStream *dstream;
 	ZSTD_inBuffer in_buf;
 	ZSTD_outBuffer out_buf;
-	void *workspace;
-	size_t wsize;
 	u32 res = -1;
 
-	wsize = ZSTD_DStreamWorkspaceBound(ZSTD_BTRFS_MAX_INPUT);
-	workspace = malloc(wsize);
-	if (!workspace) {
-		debug("%s: cannot allocate workspace of size %zu\n", __func__,
-		      wsize);
-		return -1;
-	}
-
-	dstream = ZSTD_initDStream(ZSTD_BTRFS_MAX_INPUT, workspace, wsize);
+	dstream = zstd_get_dstream(ZSTD_BTRFS_MAX_INPUT);
 	if (!dstream) {
-		printf("%s: ZSTD_initDStream failed\n", __func__);
-		goto err_free;
+		printf("%s: cannot get zstd stream\n", __func__);
+		return -1;
 	}
 
 	in_buf.src = cbuf;
@@ -182,7 +172,7 @@ static u32 decompress_zstd(const u8 *cbuf, u32 clen, u8 *dbuf, u32 dlen)
 	res = out_buf.pos;
 
 err_free:
-	free(workspace);
+	zstd_put_dstream(dstream);
 	return res;
 }
 
@@ -19,6 +19,7 @@
  */
 
 #include <common.h>
+#include <arena.h>
 #include <blk.h>
 #include <ext_common.h>
 #include <ext4fs.h>
@@ -712,23 +713,20 @@ static int find_dir_depth(char *dirname)
 	 */
 }
 
-static int parse_path(char **arr, char *dirname)
+/* Split dirname in place, the entries of arr point into it */
+static int parse_path(struct arena *arena, char **arr, char *dirname)
 {
 	char *token = strtok(dirname, "/");
 	int i = 0;
 
 	/* add root */
-	arr[i] = zalloc(strlen("/") + 1);
-	if (!arr[i])
+	arr[i] = arena_strdup(arena, "/");
+	if (!arr[i++])
 		return -ENOMEM;
-	memcpy(arr[i++], "/", strlen("/"));
 
 	/* add each path entry after root */
 	while (token != NULL) {
-		arr[i] = zalloc(strlen(token) + 1);
-		if (!arr[i])
-			return -ENOMEM;
-		memcpy(arr[i++], token, strlen(token));
+		arr[i++] = token;
 		token = strtok(NULL, "/");
 	}
 	arr[i] = NULL;
@@ -764,34 +762,36 @@ int ext4fs_get_parent_inode_num(const char *dirname, char *dname, int flags)
 	struct ext2_inode *parent_inode = NULL;
 	struct ext2_inode *first_inode = NULL;
 	struct ext2_inode temp_inode;
+	struct arena arena;
 
 	if (*dirname != '/') {
 		printf("Please supply Absolute path\n");
 		return -1;
 	}
 
+	/* All temporary buffers are released together at the end */
+	arena_begin(&arena);
+
 	/* TODO: input validation make equivalent to linux */
-	depth_dirname = zalloc(strlen(dirname) + 1);
+	depth_dirname = arena_strdup(&arena, dirname);
 	if (!depth_dirname)
 		return -ENOMEM;
 
-	memcpy(depth_dirname, dirname, strlen(dirname));
 	depth = find_dir_depth(depth_dirname);
-	parse_dirname = zalloc(strlen(dirname) + 1);
+	parse_dirname = arena_strdup(&arena, dirname);
 	if (!parse_dirname)
 		goto fail;
-	memcpy(parse_dirname, dirname, strlen(dirname));
 
 	/* allocate memory for each directory level */
-	ptr = zalloc((depth) * sizeof(char *));
+	ptr = arena_alloc(&arena, depth * sizeof(char *));
 	if (!ptr)
 		goto fail;
-	if (parse_path(ptr, parse_dirname))
+	if (parse_path(&arena, ptr, parse_dirname))
 		goto fail;
-	parent_inode = zalloc(sizeof(struct ext2_inode));
+	parent_inode = arena_alloc(&arena, sizeof(struct ext2_inode));
 	if (!parent_inode)
 		goto fail;
-	first_inode = zalloc(sizeof(struct ext2_inode));
+	first_inode = arena_alloc(&arena, sizeof(struct ext2_inode));
 	if (!first_inode)
 		goto fail;
 	memcpy(parent_inode, ext4fs_root->inode, sizeof(struct ext2_inode));
@@ -849,16 +849,7 @@ end:
 	memcpy(dname, ptr[i], strlen(ptr[i]));
 
 fail:
-	free(depth_dirname);
-	free(parse_dirname);
-	for (i = 0; i < depth; i++) {
-		if (!ptr[i])
-			break;
-		free(ptr[i]);
-	}
-	free(ptr);
-	free(parent_inode);
-	free(first_inode);
+	arena_end(&arena);
 
 	return result_inode_no;
 }
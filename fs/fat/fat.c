@@ -260,7 +260,12 @@ get_cluster(fsdata *mydata, __u32 clustnum, __u8 *buffer, unsigned long size)
 
 	debug("gc - clustnum: %d, startsect: %d\n", clustnum, startsect);
 
-	if ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1)) {
+	/*
+	 * With driver model the block layer deals with misaligned buffers
+	 * itself, so this copy is only needed for legacy block devices.
+	 */
+	if (!CONFIG_IS_ENABLED(BLK) &&
+	    ((unsigned long)buffer & (ARCH_DMA_MINALIGN - 1))) {
 		ALLOC_CACHE_ALIGN_BUFFER(__u8, tmpbuf, mydata->sect_size);
 
 		debug("FAT: Misaligned buffer address (%p)\n", buffer);
@@ -489,6 +489,7 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	int ret;
 	loff_t size;
 	loff_t read_len;
+	phys_addr_t alloc;
 
 	/* get the actual size of the file */
 	ret = info->size(filename, &size);
@@ -507,7 +508,9 @@ static int fs_read_lmb_check(const char *filename, ulong addr, loff_t offset,
 	lmb_init_and_reserve(&lmb, gd->bd, (void *)gd->fdt_blob);
 	lmb_dump_all(&lmb);
 
-	if (lmb_alloc_addr(&lmb, addr, read_len) == addr)
+	alloc = lmb_alloc_addr(&lmb, addr, read_len);
+	lmb_uninit(&lmb);
+	if (alloc == addr)
 		return 0;
 
 	log_err("** Reading file would overwrite reserved memory **\n");
@@ -7,6 +7,7 @@
  * sqfs.c: SquashFS filesystem implementation
  */
 
+#include <arena.h>
 #include <asm/unaligned.h>
 #include <errno.h>
 #include <fs.h>
@@ -234,14 +235,17 @@ static int sqfs_get_tokens_length(char **tokens, int count)
 }
 
 /* Takes a token list and returns a single string with '/' as separator. */
-static char *sqfs_concat_tokens(char **token_list, int token_count)
+static char *sqfs_concat_tokens(struct arena *arena, char **token_list,
+				int token_count)
 {
 	char *result;
 	int i, length = 0, offset = 0;
 
 	length = sqfs_get_tokens_length(token_list, token_count);
 
-	result = malloc(length + 1);
+	result = arena_alloc(arena, length + 1);
+	if (!result)
+		return NULL;
 	result[length] = '\0';
 
 	for (i = 0; i < token_count; i++) {
@@ -273,65 +277,42 @@ static int sqfs_join(char **strings, char *dest, int start, int end,
 }
 
 /*
- * Fills the given token list using its size (count) and a source string (str)
+ * Fills the given token list using its size (count) and a source string (str).
+ * The tokens point into a copy of the string allocated from the arena.
  */
-static int sqfs_tokenize(char **tokens, int count, const char *str)
+static int sqfs_tokenize(struct arena *arena, char **tokens, int count,
+			 const char *str)
 {
-	int i, j, ret = 0;
-	char *aux, *strc;
+	char *strc;
+	int j;
 
-	strc = strdup(str);
+	strc = arena_strdup(arena, str);
 	if (!strc)
 		return -ENOMEM;
 
 	if (!strcmp(strc, "/")) {
-		tokens[0] = strdup(strc);
-		if (!tokens[0]) {
-			ret = -ENOMEM;
-			goto free_strc;
-		}
-	} else {
-		for (j = 0; j < count; j++) {
-			aux = strtok(!j ? strc : NULL, "/");
-			tokens[j] = strdup(aux);
-			if (!tokens[j]) {
-				for (i = 0; i < j; i++)
-					free(tokens[i]);
-				ret = -ENOMEM;
-				goto free_strc;
-			}
-		}
+		tokens[0] = strc;
+		return 0;
 	}
 
-free_strc:
-	free(strc);
-
-	return ret;
-}
-
-/*
- * Remove last 'updir + 1' tokens from the base path tokens list. This leaves us
- * with a token list containing only the tokens needed to form the resolved
- * path, and returns the decremented size of the token list.
- */
-static int sqfs_clean_base_path(char **base, int count, int updir)
-{
-	int i;
-
-	for (i = count - updir - 1; i < count; i++)
-		free(base[i]);
+	for (j = 0; j < count; j++) {
+		tokens[j] = strtok(!j ? strc : NULL, "/");
+		if (!tokens[j])
+			return -EINVAL;
+	}
 
-	return count - updir - 1;
+	return 0;
 }
 
 /*
  * Given the base ("current dir.") path and the relative one, generate the
  * absolute path.
  */
-static char *sqfs_get_abs_path(const char *base, const char *rel)
+static char *sqfs_get_abs_path(struct arena *arena, const char *base,
+			       const char *rel)
 {
-	char **base_tokens, **rel_tokens, *resolved = NULL;
-	int ret, bc, rc, i, updir = 0, resolved_size = 0, offset = 0;
+	char **base_tokens, **rel_tokens, *resolved;
+	int bc, rc, i, updir = 0, resolved_size = 0, offset = 0;
 
 	/* Memory allocation for the token lists */
 	bc = sqfs_count_tokens(base);
@@ -339,22 +320,15 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	if (bc < 1 || rc < 1)
 		return NULL;
 
-	base_tokens = malloc(bc * sizeof(char *));
-	if (!base_tokens)
+	base_tokens = arena_alloc(arena, bc * sizeof(char *));
+	rel_tokens = arena_alloc(arena, rc * sizeof(char *));
+	if (!base_tokens || !rel_tokens)
 		return NULL;
 
-	rel_tokens = malloc(rc * sizeof(char *));
-	if (!rel_tokens)
-		goto free_b_tokens;
-
 	/* Fill token lists */
-	ret = sqfs_tokenize(base_tokens, bc, base);
-	if (ret)
-		goto free_r_tokens;
-
-	sqfs_tokenize(rel_tokens, rc, rel);
-	if (ret)
-		goto free_r_tokens;
+	if (sqfs_tokenize(arena, base_tokens, bc, base) ||
+	    sqfs_tokenize(arena, rel_tokens, rc, rel))
+		return NULL;
 
 	/* count '..' occurrences in target path */
 	for (i = 0; i < rc; i++) {
@@ -363,9 +337,9 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	}
 
 	/* Remove the last token and the '..' occurrences */
-	bc = sqfs_clean_base_path(base_tokens, bc, updir);
+	bc -= updir + 1;
 	if (bc < 0)
-		goto free_r_tokens;
+		return NULL;
 
 	/* Calculate resolved path size */
 	if (!bc)
@@ -374,9 +348,9 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	resolved_size += sqfs_get_tokens_length(base_tokens, bc) +
 		sqfs_get_tokens_length(rel_tokens, rc);
 
-	resolved = malloc(resolved_size + 1);
+	resolved = arena_alloc(arena, resolved_size + 1);
 	if (!resolved)
-		goto free_r_tokens_loop;
+		return NULL;
 
 	/* Set resolved path */
 	memset(resolved, '\0', resolved_size + 1);
@@ -384,27 +358,18 @@ static char *sqfs_get_abs_path(const char *base, const char *rel)
 	resolved[offset++] = '/';
 	offset += sqfs_join(rel_tokens, resolved + offset, updir, rc, '/');
 
-free_r_tokens_loop:
-	for (i = 0; i < rc; i++)
-		free(rel_tokens[i]);
-	for (i = 0; i < bc; i++)
-		free(base_tokens[i]);
-free_r_tokens:
-	free(rel_tokens);
-free_b_tokens:
-	free(base_tokens);
-
 	return resolved;
 }
 
-static char *sqfs_resolve_symlink(struct squashfs_symlink_inode *sym,
+static char *sqfs_resolve_symlink(struct arena *arena,
+				  struct squashfs_symlink_inode *sym,
 				  const char *base_path)
 {
-	char *resolved, *target;
+	char *target;
 	u32 sz;
 
 	sz = get_unaligned_le32(&sym->symlink_size);
-	target = malloc(sz + 1);
+	target = arena_alloc(arena, sz + 1);
 	if (!target)
 		return NULL;
 
@@ -417,11 +382,7 @@ static char *sqfs_resolve_symlink(struct squashfs_symlink_inode *sym,
 	strncpy(target, sym->symlink, sz);
 
 	/* Relative -> absolute path conversion */
-	resolved = sqfs_get_abs_path(base_path, target);
-
-	free(target);
-
-	return resolved;
+	return sqfs_get_abs_path(arena, base_path, target);
 }
 
 /*
@@ -429,7 +390,8 @@ static char *sqfs_resolve_symlink(struct squashfs_symlink_inode *sym,
  * elements of m_list. Those metadata blocks come from the compressed directory
  * table.
  */
-static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
+static int sqfs_search_dir(struct arena *arena,
+			   struct squashfs_dir_stream *dirs, char **token_list,
 			   int token_count, u32 *m_list, int m_count)
 {
 	struct squashfs_super_block *sblk = ctxt.sblk;
@@ -504,15 +466,22 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 		/* Check for symbolic link and inode type sanity */
 		if (get_unaligned_le16(&dir->inode_type) == SQFS_SYMLINK_TYPE) {
 			sym = (struct squashfs_symlink_inode *)table;
+			free(dirs->entry);
 			/* Get first j + 1 tokens */
-			path = sqfs_concat_tokens(token_list, j + 1);
+			path = sqfs_concat_tokens(arena, token_list, j + 1);
+			if (!path)
+				return -ENOMEM;
 			/* Resolve for these tokens */
-			target = sqfs_resolve_symlink(sym, path);
+			target = sqfs_resolve_symlink(arena, sym, path);
 			/* Join remaining tokens */
-			rem = sqfs_concat_tokens(token_list + j + 1, token_count -
-						 j - 1);
+			rem = sqfs_concat_tokens(arena, token_list + j + 1,
+						 token_count - j - 1);
+			if (!target || !rem)
+				return -ENOMEM;
 			/* Concatenate remaining tokens and symlink's target */
-			res = malloc(strlen(rem) + strlen(target) + 1);
+			res = arena_alloc(arena, strlen(rem) + strlen(target) + 2);
+			if (!res)
+				return -ENOMEM;
 			strcpy(res, target);
 			res[strlen(target)] = '/';
 			strcpy(res + strlen(target) + 1, rem);
@@ -521,19 +490,18 @@ static int sqfs_search_dir(struct squashfs_dir_stream *dirs, char **token_list,
 			if (token_count < 0)
 				return -EINVAL;
 
-			sym_tokens = malloc(token_count * sizeof(char *));
+			sym_tokens = arena_alloc(arena,
+						 token_count * sizeof(char *));
 			if (!sym_tokens)
 				return -EINVAL;
 
 			/* Fill tokens list */
-			ret = sqfs_tokenize(sym_tokens, token_count, res);
+			ret = sqfs_tokenize(arena, sym_tokens, token_count, res);
 			if (ret)
 				return -EINVAL;
-			free(dirs->entry);
 
-			ret = sqfs_search_dir(dirs, sym_tokens, token_count,
-					      m_list, m_count);
-			return ret;
+			return sqfs_search_dir(arena, dirs, sym_tokens,
+					       token_count, m_list, m_count);
 		} else if (!sqfs_is_dir(get_unaligned_le16(&dir->inode_type))) {
 			printf("** Cannot find directory. **\n");
 			free(dirs->entry);
@@ -812,10 +780,11 @@ free_dtb:
 int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 {
 	unsigned char *inode_table = NULL, *dir_table = NULL;
-	int j, token_count, ret = 0, metablks_count;
+	int token_count, ret = 0, metablks_count;
 	struct squashfs_dir_stream *dirs;
-	char **token_list, *path;
 	u32 *pos_list = NULL;
+	struct arena arena;
+	char **token_list;
 
 	dirs = malloc(sizeof(*dirs));
 	if (!dirs)
@@ -834,18 +803,15 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	if (token_count < 0)
 		return -EINVAL;
 
-	path = strdup(filename);
-	if (!path)
-		return -ENOMEM;
-
-	token_list = malloc(token_count * sizeof(char *));
+	arena_begin(&arena);
+	token_list = arena_alloc(&arena, token_count * sizeof(char *));
 	if (!token_list) {
 		ret = -EINVAL;
-		goto free_path;
+		goto free_tokens;
 	}
 
 	/* Fill tokens list */
-	ret = sqfs_tokenize(token_list, token_count, path);
+	ret = sqfs_tokenize(&arena, token_list, token_count, filename);
 	if (ret)
 		goto free_tokens;
 	/*
@@ -854,7 +820,7 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	 */
 	dirs->inode_table = inode_table;
 	dirs->dir_table = dir_table;
-	ret = sqfs_search_dir(dirs, token_list, token_count, pos_list,
+	ret = sqfs_search_dir(&arena, dirs, token_list, token_count, pos_list,
 			      metablks_count);
 	if (ret)
 		goto free_tokens;
@@ -876,12 +842,8 @@ int sqfs_opendir(const char *filename, struct fs_dir_stream **dirsp)
 	*dirsp = (struct fs_dir_stream *)dirs;
 
 free_tokens:
-	for (j = 0; j < token_count; j++)
-		free(token_list[j]);
-	free(token_list);
+	arena_end(&arena);
 	free(pos_list);
-free_path:
-	free(path);
 
 	return ret;
 }
@@ -1066,72 +1028,38 @@ static char *sqfs_dirname(char *path)
  * file: file.txt
  * dir: /path/to
  */
-static int sqfs_split_path(char **file, char **dir, const char *path)
+static int sqfs_split_path(struct arena *arena, char **file, char **dir,
+			   const char *path)
 {
-	char *dirc, *basec, *bname, *dname, *tmp_path;
-	int ret = 0;
+	char *dirc, *basec, *dname, *tmp_path;
 
 	/* check for first slash in path*/
+	tmp_path = arena_alloc(arena, strlen(path) + 2);
+	dirc = arena_alloc(arena, strlen(path) + 2);
+	basec = arena_alloc(arena, strlen(path) + 2);
+	if (!tmp_path || !dirc || !basec)
+		return -ENOMEM;
+
 	if (path[0] == '/') {
-		tmp_path = strdup(path);
-		if (!tmp_path)
-			return -ENOMEM;
+		strcpy(tmp_path, path);
 	} else {
-		tmp_path = malloc(strlen(path) + 2);
-		if (!tmp_path)
-			return -ENOMEM;
 		tmp_path[0] = '/';
 		strcpy(tmp_path + 1, path);
 	}
 
 	/* String duplicates */
-	dirc = strdup(tmp_path);
-	if (!dirc) {
-		ret = -ENOMEM;
-		goto free_tmp;
-	}
-
-	basec = strdup(tmp_path);
-	if (!basec) {
-		ret = -ENOMEM;
-		goto free_dirc;
-	}
+	strcpy(dirc, tmp_path);
+	strcpy(basec, tmp_path);
 
 	dname = sqfs_dirname(dirc);
-	bname = sqfs_basename(basec);
+	*file = sqfs_basename(basec);
 
-	*file = strdup(bname);
-
-	if (!*file) {
-		ret = -ENOMEM;
-		goto free_basec;
-	}
-
-	if (*dname == '\0') {
-		*dir = malloc(2);
-		if (!*dir) {
-			ret = -ENOMEM;
-			goto free_basec;
-		}
-
-		(*dir)[0] = '/';
-		(*dir)[1] = '\0';
-	} else {
-		*dir = strdup(dname);
-		if (!*dir) {
-			ret = -ENOMEM;
-			goto free_basec;
-		}
-	}
-
-free_basec:
-	free(basec);
-free_dirc:
-	free(dirc);
-free_tmp:
-	free(tmp_path);
+	if (*dname == '\0')
+		*dir = "/";
+	else
+		*dir = dname;
 
-	return ret;
+	return 0;
 }
 
 static int sqfs_get_regfile_info(struct squashfs_reg_inode *reg,
@@ -1229,6 +1157,7 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	unsigned long dest_len;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
+	struct arena arena;
 
 	*actread = 0;
 
@@ -1236,7 +1165,10 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	 * sqfs_opendir will uncompress inode and directory tables, and will
 	 * return a pointer to the directory that contains the requested file.
 	 */
-	sqfs_split_path(&file, &dir, filename);
+	arena_begin(&arena);
+	ret = sqfs_split_path(&arena, &file, &dir, filename);
+	if (ret)
+		goto free_paths;
 	ret = sqfs_opendir(dir, &dirsp);
 	if (ret) {
 		sqfs_closedir(dirsp);
@@ -1296,9 +1228,12 @@ int sqfs_read(const char *filename, void *buf, loff_t offset, loff_t len,
 	case SQFS_SYMLINK_TYPE:
 	case SQFS_LSYMLINK_TYPE:
 		symlink = (struct squashfs_symlink_inode *)ipos;
-		resolved = sqfs_resolve_symlink(symlink, filename);
+		resolved = sqfs_resolve_symlink(&arena, symlink, filename);
+		if (!resolved) {
+			ret = -ENOMEM;
+			goto free_paths;
+		}
 		ret = sqfs_read(resolved, buf, offset, len, actread);
-		free(resolved);
 		goto free_paths;
 	case SQFS_BLKDEV_TYPE:
 	case SQFS_CHRDEV_TYPE:
@@ -1446,8 +1381,7 @@ free_datablk:
 	if (datablk_count)
 		free(datablock);
 free_paths:
-	free(file);
-	free(dir);
+	arena_end(&arena);
 
 	return ret;
 }
@@ -1464,9 +1398,15 @@ int sqfs_size(const char *filename, loff_t *size)
 	char *dir, *file, *resolved;
 	struct fs_dirent *dent;
 	unsigned char *ipos;
+	struct arena arena;
 	int ret, i_number;
 
-	sqfs_split_path(&file, &dir, filename);
+	arena_begin(&arena);
+	ret = sqfs_split_path(&arena, &file, &dir, filename);
+	if (ret) {
+		arena_end(&arena);
+		return ret;
+	}
 	/*
 	 * sqfs_opendir will uncompress inode and directory tables, and will
 	 * return a pointer to the directory that contains the requested file.
@@ -1512,9 +1452,12 @@ int sqfs_size(const char *filename, loff_t *size)
 	case SQFS_SYMLINK_TYPE:
 	case SQFS_LSYMLINK_TYPE:
 		symlink = (struct squashfs_symlink_inode *)ipos;
-		resolved = sqfs_resolve_symlink(symlink, filename);
+		resolved = sqfs_resolve_symlink(&arena, symlink, filename);
+		if (!resolved) {
+			ret = -ENOMEM;
+			break;
+		}
 		ret = sqfs_size(resolved, size);
-		free(resolved);
 		break;
 	case SQFS_BLKDEV_TYPE:
 	case SQFS_CHRDEV_TYPE:
@@ -1532,8 +1475,7 @@ int sqfs_size(const char *filename, loff_t *size)
 	}
 
 free_strings:
-	free(dir);
-	free(file);
+	arena_end(&arena);
 
 	sqfs_closedir(dirsp);
 
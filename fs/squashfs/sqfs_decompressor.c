@@ -19,7 +19,7 @@
 #endif
 
 #if IS_ENABLED(CONFIG_ZSTD)
-#include <linux/zstd.h>
+#include <u-boot/zstd.h>
 #endif
 
 #include "sqfs_decompressor.h"
@@ -40,9 +40,6 @@ int sqfs_decompressor_init(struct squashfs_ctxt *ctxt)
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
-		ctxt->zstd_workspace = malloc(ZSTD_DCtxWorkspaceBound());
-		if (!ctxt->zstd_workspace)
-			return -ENOMEM;
 		break;
 #endif
 	default:
@@ -68,7 +65,6 @@ void sqfs_decompressor_cleanup(struct squashfs_ctxt *ctxt)
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
 	case SQFS_COMP_ZSTD:
-		free(ctxt->zstd_workspace);
 		break;
 #endif
 	}
@@ -91,22 +87,6 @@ static void zlib_decompression_status(int ret)
 }
 #endif
 
-#if IS_ENABLED(CONFIG_ZSTD)
-static int sqfs_zstd_decompress(struct squashfs_ctxt *ctxt, void *dest,
-				unsigned long dest_len, void *source, u32 src_len)
-{
-	ZSTD_DCtx *ctx;
-	size_t wsize;
-	int ret;
-
-	wsize = ZSTD_DCtxWorkspaceBound();
-	ctx = ZSTD_initDCtx(ctxt->zstd_workspace, wsize);
-	ret = ZSTD_decompressDCtx(ctx, dest, dest_len, source, src_len);
-
-	return ZSTD_isError(ret);
-}
-#endif /* CONFIG_ZSTD */
-
 int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
 		    unsigned long *dest_len, void *source, u32 src_len)
 {
@@ -137,14 +117,18 @@ int sqfs_decompress(struct squashfs_ctxt *ctxt, void *dest,
 		break;
 #endif
 #if IS_ENABLED(CONFIG_ZSTD)
-	case SQFS_COMP_ZSTD:
-		ret = sqfs_zstd_decompress(ctxt, dest, *dest_len, source, src_len);
+	case SQFS_COMP_ZSTD: {
+		size_t zstd_dest_len = *dest_len;
+
+		ret = zstd_decompress(source, src_len, dest, &zstd_dest_len);
 		if (ret) {
-			printf("ZSTD Error code: %d\n", ZSTD_getErrorCode(ret));
+			printf("ZSTD decompression failed. Error code: %d\n", ret);
 			return -EINVAL;
 		}
+		*dest_len = zstd_dest_len;
 
 		break;
+	}
 #endif
 	default:
 		printf("Error: unknown compression type.\n");
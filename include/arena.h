@@ -0,0 +1,71 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * Bump allocator for memory scoped to one operation
+ */
+
+#ifndef __ARENA_H
+#define __ARENA_H
+
+#include <linux/types.h>
+
+/* Default size of the blocks an arena takes from malloc() */
+#define ARENA_BLOCK_SIZE	1024
+
+struct arena_block;
+
+/**
+ * struct arena - memory handed out for a single operation
+ *
+ * Memory is carved from blocks obtained with malloc(). Individual
+ * allocations cannot be freed; arena_end() releases all of them at once.
+ *
+ * @block:	most recently allocated block, linked to the older ones
+ * @ptr:	next free byte in @block
+ * @end:	end of @block
+ */
+struct arena {
+	struct arena_block *block;
+	char *ptr;
+	char *end;
+};
+
+/**
+ * arena_begin() - start using an arena
+ *
+ * No memory is allocated until the first call to arena_alloc().
+ *
+ * @arena:	arena to set up
+ */
+void arena_begin(struct arena *arena);
+
+/**
+ * arena_alloc() - allocate memory from an arena
+ *
+ * The memory is aligned like memory from malloc() and remains valid until
+ * arena_end() is called.
+ *
+ * @arena:	arena to allocate from
+ * @size:	number of bytes to allocate
+ * Return:	pointer to the memory, or NULL if out of memory
+ */
+void *arena_alloc(struct arena *arena, size_t size);
+
+/**
+ * arena_strdup() - copy a string into an arena
+ *
+ * @arena:	arena to allocate from
+ * @str:	string to copy
+ * Return:	pointer to the copy, or NULL if out of memory
+ */
+char *arena_strdup(struct arena *arena, const char *str);
+
+/**
+ * arena_end() - free all memory allocated from an arena
+ *
+ * The arena is left empty and can be used again.
+ *
+ * @arena:	arena to release
+ */
+void arena_end(struct arena *arena);
+
+#endif /* __ARENA_H */
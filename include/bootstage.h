@@ -205,6 +205,10 @@ enum bootstage_id {
 	BOOTSTAGE_ID_ACCUM_FSP_M,
 	BOOTSTAGE_ID_ACCUM_FSP_S,
 	BOOTSTAGE_ID_ACCUM_MMAP_SPI,
+	BOOTSTAGE_ID_ACCUM_SPL_MEDIA,	/* SPL boot-media init */
+	BOOTSTAGE_ID_ACCUM_SPL_READ,	/* SPL image load, incl. media init */
+	BOOTSTAGE_ID_ACCUM_SPL_FIXUP,	/* SPL fixups to the image / FDT */
+	BOOTSTAGE_ID_ACCUM_SPL_JUMP,	/* SPL preparing to jump to image */
 
 	/* a few spare for the user, from here */
 	BOOTSTAGE_ID_USER,
@@ -234,7 +238,19 @@ void show_boot_progress(int val);
 #if CONFIG_IS_ENABLED(BOOTSTAGE)
 #define ENABLE_BOOTSTAGE
 #endif
+#if CONFIG_IS_ENABLED(BOOTSTAGE_TRACE)
+#define ENABLE_BOOTSTAGE_TRACE
 #endif
+#endif
+
+/* Categories of boot timing span, see bootstage_span_start() */
+enum bootstage_span_cat {
+	BOOTSTAGE_SPAN_STAGE,	/* bootstage_start() to bootstage_accum() */
+	BOOTSTAGE_SPAN_PROBE,	/* device_probe() */
+	BOOTSTAGE_SPAN_CMD,	/* running a command */
+
+	BOOTSTAGE_SPAN_CAT_COUNT,
+};
 
 #ifdef ENABLE_BOOTSTAGE
 
@@ -431,6 +447,60 @@ static inline int bootstage_init(bool first)
 
 #endif /* ENABLE_BOOTSTAGE */
 
+#ifdef ENABLE_BOOTSTAGE_TRACE
+/**
+ * bootstage_span_start() - Start a boot timing span
+ *
+ * Spans may nest. Each one must be closed with bootstage_span_end(), passing
+ * the value returned here.
+ *
+ * @name: Name of the span; this is copied (and possibly truncated)
+ * @cat: Category of the span
+ * @return span number, -ENOSPC if the span table is full, or -ENOSYS if
+ *	bootstage is not set up yet
+ */
+int bootstage_span_start(const char *name, enum bootstage_span_cat cat);
+
+/**
+ * bootstage_span_end() - End a boot timing span
+ *
+ * @span: Value returned by bootstage_span_start(); errors are ignored
+ */
+void bootstage_span_end(int span);
+
+/**
+ * bootstage_export() - Write bootstage data as a Chrome trace-event file
+ *
+ * This writes a JSON object with a 'traceEvents' array holding a complete
+ * event for each span and an instant event for each bootstage mark. Spans
+ * which are still open are shown as ending now.
+ *
+ * The output is nul-terminated if there is space. Pass a @size of 0 to find
+ * out how much space is needed.
+ *
+ * @buf: Buffer to write to
+ * @size: Size of buffer in bytes
+ * @return number of bytes in the full output, not including the terminator.
+ *	If this is >= @size then the output was truncated.
+ */
+int bootstage_export(char *buf, int size);
+#else
+static inline int bootstage_span_start(const char *name,
+				       enum bootstage_span_cat cat)
+{
+	return -1;	/* No span */
+}
+
+static inline void bootstage_span_end(int span)
+{
+}
+
+static inline int bootstage_export(char *buf, int size)
+{
+	return 0;
+}
+#endif /* ENABLE_BOOTSTAGE_TRACE */
+
 /* Helper macro for adding a bootstage to a line of code */
 #define BOOTSTAGE_MARKER()	\
 		bootstage_mark_code(__FILE__, __func__, __LINE__)
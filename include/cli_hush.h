@@ -16,6 +16,25 @@ extern int u_boot_hush_start(void);
 extern int parse_string_outer(const char *, int);
 extern int parse_file_outer(void);
 
+/**
+ * parse_cached_string_outer() - Run a script held in an environment variable
+ *
+ * This behaves like run_command(s, CMD_FLAG_ENV) but keeps the parsed script,
+ * so that running the same variable again does not need to parse it.
+ *
+ * @name:	Name of the environment variable holding the script
+ * @s:		Script to run, i.e. the value of the variable
+ * @return 0 on success, 1 on failure
+ */
+int parse_cached_string_outer(const char *name, const char *s);
+
+/**
+ * parse_cache_invalidate() - Drop the parsed script for a variable
+ *
+ * @name:	Name of the environment variable which has changed
+ */
+void parse_cache_invalidate(const char *name);
+
 int set_local_var(const char *s, int flg_export);
 void unset_local_var(const char *name);
 char *get_local_var(const char *s);
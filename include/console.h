@@ -100,6 +100,38 @@ static inline int console_record_avail(void)
 
 #endif /* !CONFIG_CONSOLE_RECORD */
 
+#if CONFIG_IS_ENABLED(CONSOLE_DEFER)
+/**
+ * console_flush() - write out any deferred console output
+ *
+ * This waits until all output queued for stdout has been sent to the
+ * devices. It should be called before anything which stops U-Boot from
+ * writing the rest later, such as a reset or booting an OS.
+ */
+void console_flush(void);
+
+/**
+ * console_defer_suspend() - stop or restart deferring console output
+ *
+ * While deferral is suspended, output is written directly. This is used
+ * while handing over to an OS or application, since output still queued
+ * when it takes over the machine is lost.
+ *
+ * @suspend: true to flush the output and write further output directly,
+ *	false to defer output again
+ */
+void console_defer_suspend(bool suspend);
+#else
+static inline void console_flush(void)
+{
+	/* Output is never deferred */
+}
+
+static inline void console_defer_suspend(bool suspend)
+{
+}
+#endif
+
 /**
  * console_announce_r() - print a U-Boot console on non-serial consoles
  *
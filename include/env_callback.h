@@ -24,6 +24,12 @@
 #define SILENT_CALLBACK
 #endif
 
+#ifdef CONFIG_CONSOLE_DEFER
+#define CONSOLE_DEFER_CALLBACK "consoledefer:consoledefer,"
+#else
+#define CONSOLE_DEFER_CALLBACK
+#endif
+
 #ifdef CONFIG_SPLASHIMAGE_GUARD
 #define SPLASHIMAGE_CALLBACK "splashimage:splashimage,"
 #else
@@ -67,6 +73,7 @@
 	NET_CALLBACKS \
 	"loadaddr:loadaddr," \
 	SILENT_CALLBACK \
+	CONSOLE_DEFER_CALLBACK \
 	SPLASHIMAGE_CALLBACK \
 	"stdin:console,stdout:console,stderr:console," \
 	"serial#:serialno," \
@@ -286,6 +286,7 @@ struct flash_info;
  * @write_proto:	the SPI protocol for write operations
  * @reg_proto		the SPI protocol for read_reg/write_reg/erase operations
  * @cmd_buf:		used by the write_reg
+ * @dirmap.rdesc:	direct mapping descriptor used for reads, if any
  * @prepare:		[OPTIONAL] do some preparations for the
  *			read/write/erase/lock/unlock operations
  * @unprepare:		[OPTIONAL] do some post work after the
@@ -327,6 +328,9 @@ struct spi_nor {
 	bool			sst_write_second;
 	u32			flags;
 	u8			cmd_buf[SPI_NOR_MAX_CMD_SIZE];
+	struct {
+		struct spi_mem_dirmap_desc *rdesc;
+	} dirmap;
 
 	int (*prepare)(struct spi_nor *nor, enum spi_nor_ops ops);
 	void (*unprepare)(struct spi_nor *nor, enum spi_nor_ops ops);
@@ -437,4 +441,19 @@ struct spi_nor_hwcaps {
  */
 int spi_nor_scan(struct spi_nor *nor);
 
+#if CONFIG_IS_ENABLED(SPI_DIRMAP)
+/**
+ * spi_nor_remove() - release the resources allocated by spi_nor_scan()
+ * @nor:	the spi_nor structure
+ *
+ * Return: 0 for success, others for failure.
+ */
+int spi_nor_remove(struct spi_nor *nor);
+#else
+static inline int spi_nor_remove(struct spi_nor *nor)
+{
+	return 0;
+}
+#endif
+
 #endif
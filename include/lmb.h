@@ -12,25 +12,65 @@
  * Copyright (C) 2001 Peter Bergner, IBM Corp.
  */
 
-#define MAX_LMB_REGIONS 8
+/*
+ * Number of regions each list can hold before it has to move to the heap.
+ * This covers most boards, and lets lmb work before malloc() is available.
+ */
+#define LMB_INITIAL_REGIONS 8
 
 struct lmb_property {
 	phys_addr_t base;
 	phys_size_t size;
 };
 
+/**
+ * struct lmb_region - List of regions, sorted by base address
+ *
+ * The regions are held in @initial until there are more than
+ * LMB_INITIAL_REGIONS of them, then in @heap. Use lmb_regions() to get at
+ * them. Since nothing points into the structure itself, a copy of a list
+ * which has not grown is independent of the original.
+ *
+ * @cnt:	Number of regions in use
+ * @max:	Number of regions there is room for
+ * @size:	Unused
+ * @heap:	Regions allocated on the heap, or NULL if @initial is in use
+ * @initial:	Storage used until more regions are needed
+ */
 struct lmb_region {
 	unsigned long cnt;
+	unsigned long max;
 	phys_size_t size;
-	struct lmb_property region[MAX_LMB_REGIONS+1];
+	struct lmb_property *heap;
+	struct lmb_property initial[LMB_INITIAL_REGIONS];
 };
 
+/**
+ * lmb_regions() - Get the array of regions in a list
+ *
+ * @rgn: List of regions
+ * @return the regions, valid until the next change to the list
+ */
+static inline struct lmb_property *lmb_regions(struct lmb_region *rgn)
+{
+	return rgn->heap ? rgn->heap : rgn->initial;
+}
+
 struct lmb {
 	struct lmb_region memory;
 	struct lmb_region reserved;
 };
 
 extern void lmb_init(struct lmb *lmb);
+/**
+ * lmb_uninit() - Release memory allocated for an lmb
+ *
+ * This must be called once an lmb is no longer needed, since lists with
+ * many regions are kept on the heap. It is safe to call on a zeroed lmb.
+ *
+ * @lmb: lmb to release
+ */
+extern void lmb_uninit(struct lmb *lmb);
 extern void lmb_init_and_reserve(struct lmb *lmb, struct bd_info *bd,
 				 void *fdt_blob);
 extern void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
@@ -54,7 +94,7 @@ extern void lmb_dump_all_force(struct lmb *lmb);
 static inline phys_size_t
 lmb_size_bytes(struct lmb_region *type, unsigned long region_nr)
 {
-	return type->region[region_nr].size;
+	return lmb_regions(type)[region_nr].size;
 }
 
 void board_lmb_reserve(struct lmb *lmb);
@@ -284,7 +284,10 @@ void __assert_fail(const char *assertion, const char *file, unsigned int line,
  * @file: Name of file where the log record was generated (not allocated)
  * @line: Line number where the log record was generated
  * @func: Function where the log record was generated (not allocated)
- * @msg: Log message (allocated)
+ * @msg: Log message (allocated). This is only set up for drivers which do not
+ *	have LOGDF_RAW set
+ * @fmt: printf() format string for the message (not allocated)
+ * @args: Arguments for @fmt. Drivers must use va_copy() to read these
  */
 struct log_rec {
 	enum log_category_t cat;
@@ -293,17 +296,29 @@ struct log_rec {
 	int line;
 	const char *func;
 	const char *msg;
+	const char *fmt;
+	va_list *args;
 };
 
 struct log_device;
 
+/** enum log_driver_flags - flags for a log driver */
+enum log_driver_flags {
+	/* Driver uses @fmt and @args, so the message need not be formatted */
+	LOGDF_RAW	= 1 << 0,
+	/* With no filters, accept all records, not just the default level */
+	LOGDF_ALL	= 1 << 1,
+};
+
 /**
  * struct log_driver - a driver which accepts and processes log records
  *
  * @name: Name of driver
+ * @flags: Flags for this driver (enum log_driver_flags)
  */
 struct log_driver {
 	const char *name;
+	unsigned short flags;
 	/**
 	 * emit() - emit a log record
 	 *
@@ -446,6 +461,35 @@ int log_add_filter(const char *drv_name, enum log_category_t cat_list[],
  */
 int log_remove_filter(const char *drv_name, int filter_num);
 
+#if CONFIG_IS_ENABLED(LOG_BINARY)
+/**
+ * log_binary_dump() - Show the records held by the binary log driver
+ *
+ * The records are formatted according to gd->log_fmt, oldest first, each
+ * preceded by its timestamp.
+ *
+ * @count: Number of records to show (the most recent ones), or 0 for all
+ */
+void log_binary_dump(int count);
+#endif
+
+#if CONFIG_IS_ENABLED(LOG_BINARY) && CONFIG_IS_ENABLED(BLOBLIST)
+/**
+ * log_binary_to_bloblist() - Add the formatted binary log to the bloblist
+ *
+ * This formats the records held by the binary log driver into a
+ * BLOBLISTT_LOG record, so that the next stage can read them.
+ *
+ * @return 0 if OK, -ENOSPC if the bloblist has no room
+ */
+int log_binary_to_bloblist(void);
+#else
+static inline int log_binary_to_bloblist(void)
+{
+	return 0;
+}
+#endif
+
 #if CONFIG_IS_ENABLED(LOG)
 /**
  * log_init() - Set up the log system ready for use
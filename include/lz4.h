@@ -6,6 +6,108 @@
 #ifndef __LZ4_H
 #define __LZ4_H
 
+#include <linux/types.h>
+#include <linux/xxhash.h>
+
+/* Magic, flags and block descriptor, which say how large the header is */
+#define LZ4F_HEADER_START	6
+
+/* Largest frame header: magic, flags, block descriptor, content size, check */
+#define LZ4F_MAX_HEADER_SIZE	15
+
+/**
+ * struct lz4f_stream - State for decoding an LZ4 frame supplied in pieces
+ *
+ * Members are private to lib/lz4_wrapper.c, except @content_size which may be
+ * read once lz4f_stream_decode() has seen the frame header.
+ *
+ * @dst:		Place to put the decompressed data
+ * @dst_size:		Size of @dst in bytes
+ * @out:		Number of bytes written to @dst so far
+ * @content_size:	Decompressed size from the frame header, 0 if unknown
+ * @state:		Part of the frame being decoded (enum lz4f_state)
+ * @flags:		Frame flags (FLG byte)
+ * @field:		Frame header, block header or checksum being gathered
+ * @field_len:		Number of bytes in @field so far
+ * @block_max:		Maximum block size from the frame header
+ * @block_size:		Size of the current block in bytes
+ * @block_len:		Number of bytes of the current block received
+ * @block_sum:		xxh32 of the current block, if it has a checksum
+ * @buf:		Holds a compressed block which arrives in pieces, or
+ *			NULL if not needed yet
+ * @buf_size:		Size of @buf in bytes
+ * @xxh:		Hash state for an uncompressed block arriving in pieces
+ */
+struct lz4f_stream {
+	u8 *dst;
+	size_t dst_size;
+	size_t out;
+	u64 content_size;
+	int state;
+	u8 flags;
+	u8 field[LZ4F_MAX_HEADER_SIZE];
+	uint field_len;
+	u32 block_max;
+	u32 block_size;
+	u32 block_len;
+	u32 block_sum;
+	u8 *buf;
+	u32 buf_size;
+	struct xxh32_state xxh;
+};
+
+/**
+ * lz4f_stream_init() - Set up to decode an LZ4 frame in pieces
+ *
+ * @ls:		Stream state to set up
+ * @dst:	Place to put the decompressed data, which must be contiguous
+ *		since later blocks may refer back to earlier ones
+ * @dst_size:	Size of @dst in bytes
+ */
+void lz4f_stream_init(struct lz4f_stream *ls, void *dst, size_t dst_size);
+
+/**
+ * lz4f_stream_decode() - Decode the next piece of an LZ4 frame
+ *
+ * The input may be split anywhere. Blocks which are wholly inside @src are
+ * decompressed straight from it; a compressed block which is split across
+ * calls is gathered in a buffer first, allocated with malloc().
+ *
+ * Block checksums and the content size are checked if the frame has them,
+ * as is the content checksum with CONFIG_LZ4_CONTENT_CHECKSUM. If the content
+ * size is larger than the output buffer, this fails as soon as the frame
+ * header is seen.
+ *
+ * @ls:		Stream state
+ * @src:	Next piece of compressed data
+ * @srcnp:	Size of @src in bytes; updated to the number of bytes used,
+ *		which is less than the size only at the end of the frame
+ * @return 1 if the frame is complete, 0 if more input is needed,
+ *	-EPROTONOSUPPORT if the magic or version number are not recognised,
+ *	-EINVAL if the reserved fields are non-zero or a block is too large,
+ *	-EBADMSG if a checksum or the content size is wrong, -ENOBUFS if the
+ *	output buffer is too small, -ENOMEM if a block buffer cannot be
+ *	allocated, -EPROTO if the decompression algorithm reports an error
+ */
+int lz4f_stream_decode(struct lz4f_stream *ls, const void *src,
+		       size_t *srcnp);
+
+/**
+ * lz4f_block_max() - Get the largest block size used by an LZ4 frame
+ *
+ * @src:	Start of the frame, at least LZ4F_HEADER_START bytes
+ * @return maximum block size in bytes, or -ve on error (see
+ *	lz4f_stream_decode())
+ */
+int lz4f_block_max(const void *src);
+
+/**
+ * lz4f_stream_end() - Free resources used to decode a frame
+ *
+ * @ls:		Stream state
+ */
+void lz4f_stream_end(struct lz4f_stream *ls);
+
 /**
  * ulz4fn() - Decompress LZ4 data
  *
@@ -14,10 +116,10 @@
  * @dst: Destination for uncompressed data
  * @dstn: Returns length of uncompressed data
  * @return 0 if OK, -EPROTONOSUPPORT if the magic number or version number are
- *	not recognised or independent blocks are used, -EINVAL if the reserved
- *	fields are non-zero, or input is overrun, -EENOBUFS if the destination
- *	buffer is overrun, -EEPROTO if the compressed data causes an error in
- *	the decompression algorithm
+ *	not recognised, -EINVAL if the reserved fields are non-zero, or input
+ *	is overrun, -EBADMSG if a checksum is wrong, -EENOBUFS if the
+ *	destination buffer is overrun, -EEPROTO if the compressed data causes
+ *	an error in the decompression algorithm
  */
 int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn);
 
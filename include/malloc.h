@@ -978,6 +978,35 @@ extern ulong mem_malloc_brk;
 
 void mem_malloc_init(ulong start, ulong size);
 
+/**
+ * struct malloc_slab_stats - usage of a slab size class
+ *
+ * @size:	object size of the class in bytes
+ * @pages:	number of slab pages held by the class
+ * @objs:	number of objects the pages can hold
+ * @used:	number of objects currently allocated
+ * @allocs:	number of allocations served since mem_malloc_init()
+ * @page_size:	size of each slab page in bytes
+ */
+struct malloc_slab_stats {
+	ulong size;
+	ulong pages;
+	ulong objs;
+	ulong used;
+	ulong allocs;
+	ulong page_size;
+};
+
+/**
+ * malloc_slab_get_stats() - get the statistics of a slab size class
+ *
+ * @class:	index of the size class, starting at 0
+ * @stats:	returns the statistics
+ * Return:	0 if OK, -ENOENT if there is no such class, -ENOSYS if
+ *		CONFIG_SYS_MALLOC_SLAB is not enabled
+ */
+int malloc_slab_get_stats(int class, struct malloc_slab_stats *stats);
+
 #ifdef __cplusplus
 };  /* end of extern "C" */
 #endif
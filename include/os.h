@@ -355,4 +355,24 @@ int os_read_file(const char *name, void **bufp, int *sizep);
  */
 void *os_find_text_base(void);
 
+/**
+ * os_profile_start() - Start sampling the call stack
+ *
+ * This uses a SIGPROF timer, so time is only counted while the process is
+ * running, not while it is sleeping.
+ *
+ * @hz:		Number of samples per second
+ * @func:	Function to call from the signal handler with each sample. The
+ *		first entry in @pcs is the interrupted program counter and the
+ *		rest are return addresses.
+ * @return 0 if OK, -ve on error
+ */
+int os_profile_start(unsigned int hz,
+		     void (*func)(void *const pcs[], int depth));
+
+/**
+ * os_profile_stop() - Stop sampling the call stack
+ */
+void os_profile_stop(void);
+
 #endif
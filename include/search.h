@@ -47,6 +47,11 @@ struct hsearch_data {
 	struct env_entry_node *table;
 	unsigned int size;
 	unsigned int filled;
+	unsigned int deleted;		/* slots holding a deleted marker */
+	unsigned int min_size;		/* never shrink below this size */
+	unsigned int cb_depth;		/* nesting level of callbacks */
+	struct env_entry_node **sorted;	/* entries in ascending key order */
+	bool unsorted;			/* sorted[] must be rebuilt */
 /*
  * Callback function which will check whether the given change for variable
  * "item" to "newval" may be applied or not, and possibly apply such change.
@@ -98,6 +103,18 @@ int himport_r(struct hsearch_data *htab, const char *env, size_t size,
 int hwalk_r(struct hsearch_data *htab,
 	    int (*callback)(struct env_entry *entry));
 
+/* Statistics about the hash table, as filled in by hstats_r() */
+struct hsearch_stats {
+	unsigned int size;		/* number of slots */
+	unsigned int filled;		/* number of entries */
+	unsigned int deleted;		/* number of deleted markers */
+	unsigned int probe_total;	/* sum of probe lengths of all entries */
+	unsigned int probe_max;		/* longest probe length of any entry */
+};
+
+/* Collect statistics about the table, for "env info" */
+void hstats_r(struct hsearch_data *htab, struct hsearch_stats *stats);
+
 /* Flags for himport_r(), hexport_r(), hdelete_r(), and hsearch_r() */
 #define H_NOCLEAR	(1 << 0) /* do not clear hash table before importing */
 #define H_FORCE		(1 << 1) /* overwrite read-only/write-once variables */
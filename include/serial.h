@@ -318,6 +318,20 @@ int serial_setconfig(struct udevice *dev, uint config);
  */
 int serial_getinfo(struct udevice *dev, struct serial_device_info *info);
 
+/**
+ * serial_try_puts() - Write as much of a string as the uart accepts now
+ *
+ * Characters are written until the driver reports that its transmit FIFO
+ * is full, so this never waits for the line to drain. A '\n' is written as
+ * '\r\n' and is only counted once both characters are sent.
+ *
+ * @dev: Device pointer
+ * @str: Characters to write (need not be nul-terminated)
+ * @len: Number of characters in @str
+ * @return number of characters from @str that were written
+ */
+int serial_try_puts(struct udevice *dev, const char *str, int len);
+
 void atmel_serial_initialize(void);
 void mcf_serial_initialize(void);
 void mpc85xx_serial_initialize(void);
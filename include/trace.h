@@ -23,11 +23,18 @@ enum {
 	 * this value.
 	 */
 	FUNC_SITE_SIZE	= 4,	/* distance between function sites */
+
+	/* Maximum number of stack frames recorded in each profile sample */
+	PROFILE_STACK_DEPTH	= 8,
+
+	/* Offset used for a PC which is outside the U-Boot image */
+	PROFILE_PC_EXTERNAL	= 0xffffffff,
 };
 
 enum trace_chunk_type {
 	TRACE_CHUNK_FUNCS,
 	TRACE_CHUNK_CALLS,
+	TRACE_CHUNK_SAMPLES,
 };
 
 /* A trace record for a function, as written to the profile output file */
@@ -79,6 +86,16 @@ struct trace_call {
 
 int trace_list_calls(void *buff, size_t buff_size, size_t *needed);
 
+/*
+ * A call stack recorded by the sampling profiler. Each entry is a code
+ * offset: pc[0] is where the CPU was executing and the rest are callers, each
+ * adjusted to point inside the call instruction.
+ */
+struct trace_sample {
+	uint32_t depth;				/* Number of valid entries */
+	uint32_t pc[PROFILE_STACK_DEPTH];	/* Innermost first */
+};
+
 /**
  * Turn function tracing on and off
  *
@@ -101,4 +118,66 @@ int trace_early_init(void);
  */
 int trace_init(void *buff, size_t buff_size);
 
+/**
+ * profile_start() - Start the sampling profiler
+ *
+ * This discards any previous samples.
+ *
+ * @hz:		Number of samples to take each second
+ * @return 0 if OK, -ENOMEM if the sample buffer cannot be allocated, -ENOSYS
+ *	if the architecture does not support sampling
+ */
+int profile_start(uint hz);
+
+/**
+ * profile_stop() - Stop the sampling profiler
+ *
+ * The samples are kept until profiling is started again.
+ */
+void profile_stop(void);
+
+/* Print statistics about profile samples */
+void profile_print_stats(void);
+
+/**
+ * profile_record() - Record a sample
+ *
+ * This is called by the architecture, typically from an interrupt or signal
+ * handler, with the interrupted call stack.
+ *
+ * @pcs:	Program counters, starting with the interrupted one and
+ *		followed by return addresses
+ * @depth:	Number of entries in @pcs
+ */
+void profile_record(void *const pcs[], int depth);
+
+/**
+ * profile_list_samples() - Dump the profile samples into a buffer
+ *
+ * This writes a struct trace_output_hdr followed by a struct trace_sample for
+ * each sample.
+ *
+ * @buff:	Buffer in which to place data, or NULL to count size
+ * @buff_size:	Size of buffer
+ * @needed:	Returns number of bytes used / needed
+ * @return 0 if ok, -ENOSPC if the buffer is too small
+ */
+int profile_list_samples(void *buff, size_t buff_size, size_t *needed);
+
+/**
+ * arch_profile_start() - Start taking profile samples
+ *
+ * The architecture should call profile_record() @hz times a second until
+ * arch_profile_stop() is called.
+ *
+ * @hz:		Number of samples to take each second
+ * @return 0 if OK, -ENOSYS if not supported, other -ve on error
+ */
+int arch_profile_start(uint hz);
+
+/**
+ * arch_profile_stop() - Stop taking profile samples
+ */
+void arch_profile_stop(void);
+
 #endif
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * ECDSA signing and verification of FIT images
+ */
+
+#ifndef _ECDSA_H
+#define _ECDSA_H
+
+#include <errno.h>
+#include <image.h>
+#include <linux/kconfig.h>
+
+struct image_sign_info;
+
+#if IMAGE_ENABLE_SIGN
+/**
+ * ecdsa_sign() - calculate and return signature for given input data
+ *
+ * The private key is read from <keydir>/<keyname>.key, in PEM format. The
+ * signature is the values r and s, each as a big-endian number the size of
+ * the curve, one after the other.
+ *
+ * @info:	Specifies key and FIT information
+ * @region:	Pointer to the input data
+ * @region_count:	Number of regions
+ * @sigp:	Set to an allocated buffer holding the signature
+ * @sig_len:	Set to length of the calculated signature
+ *
+ * @return: 0, on success, -ve on error
+ */
+int ecdsa_sign(struct image_sign_info *info,
+	       const struct image_region region[],
+	       int region_count, uint8_t **sigp, uint *sig_len);
+
+/**
+ * ecdsa_add_verify_data() - Add verification information to FDT
+ *
+ * Add the public key from <keydir>/<keyname>.crt to the FDT node, as the
+ * curve name and the coordinates of the public point.
+ *
+ * @info:	Specifies key and FIT information
+ * @keydest:	Destination FDT blob for public key data
+ * @return: 0, on success, -ENOSPC if the keydest FDT blob ran out of space,
+ *	other -ve value on error
+ */
+int ecdsa_add_verify_data(struct image_sign_info *info, void *keydest);
+#else
+static inline int ecdsa_sign(struct image_sign_info *info,
+			     const struct image_region region[],
+			     int region_count, uint8_t **sigp, uint *sig_len)
+{
+	return -ENXIO;
+}
+
+static inline int ecdsa_add_verify_data(struct image_sign_info *info,
+					void *keydest)
+{
+	return -ENXIO;
+}
+#endif
+
+#if IMAGE_ENABLE_SIGN || CONFIG_IS_ENABLED(ECDSA_VERIFY)
+/**
+ * ecdsa_verify_hash() - Verify a signature against a hash
+ *
+ * The public key is found in the /signature node of @info->fdt_blob, as for
+ * RSA.
+ *
+ * @info:	Specifies key and FIT information
+ * @hash:	Hash according to algorithm specified in @info
+ * @sig:	Signature, r followed by s
+ * @sig_len:	Number of bytes in signature
+ * @return 0 if verified, -ve on error
+ */
+int ecdsa_verify_hash(struct image_sign_info *info,
+		      const uint8_t *hash, const uint8_t *sig, uint sig_len);
+
+/**
+ * ecdsa_verify() - Verify a signature against some data
+ *
+ * @info:	Specifies key and FIT information
+ * @region:	Pointer to the input data
+ * @region_count:	Number of regions
+ * @sig:	Signature, r followed by s
+ * @sig_len:	Number of bytes in signature
+ * @return 0 if verified, -ve on error
+ */
+int ecdsa_verify(struct image_sign_info *info,
+		 const struct image_region region[], int region_count,
+		 uint8_t *sig, uint sig_len);
+#else
+static inline int ecdsa_verify_hash(struct image_sign_info *info,
+				    const uint8_t *hash, const uint8_t *sig,
+				    uint sig_len)
+{
+	return -ENXIO;
+}
+
+static inline int ecdsa_verify(struct image_sign_info *info,
+			       const struct image_region region[],
+			       int region_count, uint8_t *sig, uint sig_len)
+{
+	return -ENXIO;
+}
+#endif
+
+#define ECDSA256_BYTES	(256 / 8)
+#define ECDSA384_BYTES	(384 / 8)
+
+/* Names of the curves in the ecdsa,curve property, as used by OpenSSL */
+#define ECDSA_P256_NAME		"prime256v1"
+#define ECDSA_P384_NAME		"secp384r1"
+
+#endif
@@ -0,0 +1,65 @@
+/* SPDX-License-Identifier: GPL-2.0+ */
+/*
+ * U-Boot helpers for zstd decompression
+ */
+
+#ifndef __UBOOT_ZSTD_H
+#define __UBOOT_ZSTD_H
+
+#include <linux/zstd.h>
+
+/**
+ * zstd_get_dctx() - Get a decompression context from the pool
+ *
+ * The context is ready for use with ZSTD_decompressDCtx() or the bufferless
+ * API. Its memory is kept for later users when it is returned with
+ * zstd_put_dctx(), so it is only allocated once.
+ *
+ * @return context, or NULL if out of memory or the pool is exhausted
+ */
+ZSTD_DCtx *zstd_get_dctx(void);
+
+/**
+ * zstd_put_dctx() - Return a decompression context to the pool
+ *
+ * @dctx:	Context from zstd_get_dctx()
+ */
+void zstd_put_dctx(ZSTD_DCtx *dctx);
+
+/**
+ * zstd_get_dstream() - Get a streaming decompression context from the pool
+ *
+ * The stream is ready for ZSTD_decompressStream(), which decodes input
+ * supplied in chunks of any size. A stream from the pool may support a larger
+ * window than requested.
+ *
+ * @max_window:	Largest window size the stream must handle, in bytes
+ * @return stream, or NULL if out of memory or the pool is exhausted
+ */
+ZSTD_DStream *zstd_get_dstream(size_t max_window);
+
+/**
+ * zstd_put_dstream() - Return a streaming decompression context to the pool
+ *
+ * @zds:	Stream from zstd_get_dstream()
+ */
+void zstd_put_dstream(ZSTD_DStream *zds);
+
+/**
+ * zstd_decompress() - Decompress zstd data held in memory
+ *
+ * This decompresses all the frames in @src, straight into @dst, using a
+ * context from the pool.
+ *
+ * @src:	Compressed data
+ * @src_len:	Size of compressed data in bytes
+ * @dst:	Place to put the decompressed data
+ * @dst_lenp:	Size of @dst in bytes; updated to the decompressed size on
+ *		success
+ * @return 0 if OK, -ENOMEM if no context is available, -ENOSPC if @dst is too
+ *	small, -EINVAL if the data is corrupt
+ */
+int zstd_decompress(const void *src, size_t src_len, void *dst,
+		    size_t *dst_lenp);
+
+#endif
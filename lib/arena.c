@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Bump allocator for memory scoped to one operation
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <malloc.h>
+#include <linux/kernel.h>
+#include <linux/string.h>
+
+#define ARENA_ALIGN	(2 * sizeof(size_t))
+
+struct arena_block {
+	struct arena_block *next;
+	char data[] __aligned(ARENA_ALIGN);
+};
+
+void arena_begin(struct arena *arena)
+{
+	arena->block = NULL;
+	arena->ptr = NULL;
+	arena->end = NULL;
+}
+
+void *arena_alloc(struct arena *arena, size_t size)
+{
+	struct arena_block *block;
+	void *ptr;
+
+	size = ALIGN(size, ARENA_ALIGN);
+	if (size > arena->end - arena->ptr) {
+		size_t block_size = max_t(size_t, size, ARENA_BLOCK_SIZE);
+
+		block = malloc(sizeof(*block) + block_size);
+		if (!block)
+			return NULL;
+		block->next = arena->block;
+		arena->block = block;
+		arena->ptr = block->data;
+		arena->end = block->data + block_size;
+	}
+	ptr = arena->ptr;
+	arena->ptr += size;
+
+	return ptr;
+}
+
+char *arena_strdup(struct arena *arena, const char *str)
+{
+	size_t len = strlen(str) + 1;
+	char *copy;
+
+	copy = arena_alloc(arena, len);
+	if (copy)
+		memcpy(copy, str, len);
+
+	return copy;
+}
+
+void arena_end(struct arena *arena)
+{
+	struct arena_block *block, *next;
+
+	for (block = arena->block; block; block = next) {
+		next = block->next;
+		free(block);
+	}
+	arena_begin(arena);
+}
@@ -0,0 +1,348 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * ECDSA signing for FIT images, using OpenSSL
+ */
+
+#include "mkimage.h"
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <image.h>
+#include <u-boot/ecdsa.h>
+#include <u-boot/sha512.h>
+#include <openssl/bn.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+#include <openssl/err.h>
+#include <openssl/evp.h>
+#include <openssl/objects.h>
+#include <openssl/pem.h>
+#include <openssl/x509.h>
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L || \
+	(defined(LIBRESSL_VERSION_NUMBER) && LIBRESSL_VERSION_NUMBER < 0x02070000fL)
+static void ECDSA_SIG_get0(const ECDSA_SIG *sig, const BIGNUM **pr,
+			   const BIGNUM **ps)
+{
+	if (pr)
+		*pr = sig->r;
+	if (ps)
+		*ps = sig->s;
+}
+#endif
+
+static int ecdsa_err(const char *msg)
+{
+	unsigned long sslErr = ERR_get_error();
+
+	fprintf(stderr, "%s", msg);
+	fprintf(stderr, ": %s\n",
+		ERR_error_string(sslErr, 0));
+
+	return -1;
+}
+
+/**
+ * ecdsa_check_curve() - Check that a key is on the curve for the algorithm
+ *
+ * @info:	Specifies key and FIT information
+ * @ec:		Key to check
+ * @return size of the curve in bytes if OK, -ve on error
+ */
+static int ecdsa_check_curve(struct image_sign_info *info, const EC_KEY *ec)
+{
+	int nid, bytes;
+
+	nid = EC_GROUP_get_curve_name(EC_KEY_get0_group(ec));
+	switch (nid) {
+	case NID_X9_62_prime256v1:
+		bytes = ECDSA256_BYTES;
+		break;
+	case NID_secp384r1:
+		bytes = ECDSA384_BYTES;
+		break;
+	default:
+		fprintf(stderr, "Unsupported curve '%s' in key '%s'\n",
+			OBJ_nid2sn(nid), info->keyname);
+		return -EINVAL;
+	}
+	if (bytes != info->crypto->key_len) {
+		fprintf(stderr, "Key '%s' on curve '%s' does not suit %s\n",
+			info->keyname, OBJ_nid2sn(nid), info->crypto->name);
+		return -EINVAL;
+	}
+
+	return bytes;
+}
+
+/**
+ * ecdsa_get_key() - read an EC key from a file
+ *
+ * @info:	Specifies key and FIT information
+ * @priv:	true to read the private key from <name>.key, false to read
+ *		the public key from the certificate <name>.crt
+ * @ecp:	Returns EC_KEY object, or NULL on failure
+ * @return 0 if ok, -ve on error (in which case *ecp will be set to NULL)
+ */
+static int ecdsa_get_key(struct image_sign_info *info, bool priv,
+			 EC_KEY **ecp)
+{
+	char path[1024];
+	EVP_PKEY *key;
+	X509 *cert;
+	EC_KEY *ec;
+	FILE *f;
+	int ret;
+
+	*ecp = NULL;
+	if (info->engine_id) {
+		fprintf(stderr, "Engines are not supported for ECDSA keys\n");
+		return -ENOTSUP;
+	}
+	snprintf(path, sizeof(path), "%s/%s.%s", info->keydir, info->keyname,
+		 priv ? "key" : "crt");
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "Couldn't open ECDSA %s: '%s': %s\n",
+			priv ? "private key" : "certificate", path,
+			strerror(errno));
+		return -EACCES;
+	}
+
+	if (priv) {
+		key = PEM_read_PrivateKey(f, NULL, NULL, path);
+		if (!key) {
+			ecdsa_err("Failure reading private key");
+			ret = -EPROTO;
+			goto err_read;
+		}
+	} else {
+		cert = PEM_read_X509(f, NULL, NULL, NULL);
+		if (!cert) {
+			ecdsa_err("Couldn't read certificate");
+			ret = -EINVAL;
+			goto err_read;
+		}
+		key = X509_get_pubkey(cert);
+		X509_free(cert);
+		if (!key) {
+			ecdsa_err("Couldn't read public key");
+			ret = -EINVAL;
+			goto err_read;
+		}
+	}
+
+	ec = EVP_PKEY_get1_EC_KEY(key);
+	EVP_PKEY_free(key);
+	if (!ec) {
+		fprintf(stderr, "Key '%s' is not an EC key\n", path);
+		ret = -EINVAL;
+		goto err_read;
+	}
+	ret = ecdsa_check_curve(info, ec);
+	if (ret < 0) {
+		EC_KEY_free(ec);
+		goto err_read;
+	}
+	fclose(f);
+	*ecp = ec;
+
+	return 0;
+
+err_read:
+	fclose(f);
+	return ret;
+}
+
+/* Write a number as a big-endian byte array, padded to @size bytes */
+static int ecdsa_bn2bin(const BIGNUM *num, uint8_t *buf, int size)
+{
+	int len = BN_num_bytes(num);
+
+	if (len > size)
+		return -EINVAL;
+	memset(buf, '\0', size - len);
+	BN_bn2bin(num, buf + size - len);
+
+	return 0;
+}
+
+int ecdsa_sign(struct image_sign_info *info,
+	       const struct image_region region[], int region_count,
+	       uint8_t **sigp, uint *sig_len)
+{
+	uint8_t hash[SHA512_SUM_LEN];
+	const BIGNUM *r, *s;
+	ECDSA_SIG *esig;
+	uint8_t *sig;
+	EC_KEY *ec;
+	int bytes;
+	int ret;
+
+	ret = ecdsa_get_key(info, true, &ec);
+	if (ret)
+		return ret;
+	bytes = info->crypto->key_len;
+
+	ret = info->checksum->calculate(info->checksum->name, region,
+					region_count, hash);
+	if (ret) {
+		fprintf(stderr, "Error in checksum calculation\n");
+		ret = -EINVAL;
+		goto err_hash;
+	}
+
+	/* This uses the leftmost bits of the hash if it is too long */
+	esig = ECDSA_do_sign(hash, info->checksum->checksum_len, ec);
+	if (!esig) {
+		ret = ecdsa_err("Could not obtain signature");
+		goto err_hash;
+	}
+
+	sig = malloc(bytes * 2);
+	if (!sig) {
+		fprintf(stderr, "Out of memory for signature (%d bytes)\n",
+			bytes * 2);
+		ret = -ENOMEM;
+		goto err_alloc;
+	}
+	ECDSA_SIG_get0(esig, &r, &s);
+	ret = ecdsa_bn2bin(r, sig, bytes);
+	if (!ret)
+		ret = ecdsa_bn2bin(s, sig + bytes, bytes);
+	if (ret) {
+		fprintf(stderr, "Signature is too large\n");
+		free(sig);
+		goto err_alloc;
+	}
+
+	debug("Got signature: %d bytes\n", bytes * 2);
+	*sigp = sig;
+	*sig_len = bytes * 2;
+
+err_alloc:
+	ECDSA_SIG_free(esig);
+err_hash:
+	EC_KEY_free(ec);
+
+	return ret;
+}
+
+/**
+ * ecdsa_get_point() - Get the coordinates of the public point of a key
+ *
+ * @ec:		Key
+ * @x:		Returns x coordinate, as a big-endian byte array
+ * @y:		Returns y coordinate, as a big-endian byte array
+ * @size:	Size of each coordinate in bytes
+ * @return 0 if OK, -ve on error
+ */
+static int ecdsa_get_point(const EC_KEY *ec, uint8_t *x, uint8_t *y,
+			   int size)
+{
+	BIGNUM *bx, *by;
+	BN_CTX *ctx;
+	int ret;
+
+	ctx = BN_CTX_new();
+	bx = BN_new();
+	by = BN_new();
+	if (!ctx || !bx || !by) {
+		fprintf(stderr, "Out of memory (bignum)\n");
+		ret = -ENOMEM;
+		goto done;
+	}
+	if (!EC_POINT_get_affine_coordinates_GFp(EC_KEY_get0_group(ec),
+						 EC_KEY_get0_public_key(ec),
+						 bx, by, ctx)) {
+		ret = ecdsa_err("Couldn't get public point");
+		goto done;
+	}
+	ret = ecdsa_bn2bin(bx, x, size);
+	if (!ret)
+		ret = ecdsa_bn2bin(by, y, size);
+done:
+	BN_free(by);
+	BN_free(bx);
+	BN_CTX_free(ctx);
+
+	return ret;
+}
+
+int ecdsa_add_verify_data(struct image_sign_info *info, void *keydest)
+{
+	uint8_t x[ECDSA384_BYTES], y[ECDSA384_BYTES];
+	const char *curve;
+	int parent, node;
+	char name[100];
+	EC_KEY *ec;
+	int bytes;
+	int ret;
+
+	debug("%s: Getting verification data\n", __func__);
+	ret = ecdsa_get_key(info, false, &ec);
+	if (ret)
+		return ret;
+	bytes = info->crypto->key_len;
+	curve = bytes == ECDSA256_BYTES ? ECDSA_P256_NAME : ECDSA_P384_NAME;
+	ret = ecdsa_get_point(ec, x, y, bytes);
+	EC_KEY_free(ec);
+	if (ret)
+		return ret;
+
+	parent = fdt_subnode_offset(keydest, 0, FIT_SIG_NODENAME);
+	if (parent == -FDT_ERR_NOTFOUND) {
+		parent = fdt_add_subnode(keydest, 0, FIT_SIG_NODENAME);
+		if (parent < 0) {
+			ret = parent;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Couldn't create signature node: %s\n",
+					fdt_strerror(parent));
+			}
+		}
+	}
+	if (ret)
+		goto done;
+
+	/* Either create or overwrite the named key node */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(keydest, parent, name);
+	if (node == -FDT_ERR_NOTFOUND) {
+		node = fdt_add_subnode(keydest, parent, name);
+		if (node < 0) {
+			ret = node;
+			if (ret != -FDT_ERR_NOSPACE) {
+				fprintf(stderr, "Could not create key subnode: %s\n",
+					fdt_strerror(node));
+			}
+		}
+	} else if (node < 0) {
+		fprintf(stderr, "Cannot select keys parent: %s\n",
+			fdt_strerror(node));
+		ret = node;
+	}
+
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, FIT_KEY_HINT,
+					 info->keyname);
+	}
+	if (!ret)
+		ret = fdt_setprop_string(keydest, node, "ecdsa,curve", curve);
+	if (!ret)
+		ret = fdt_setprop(keydest, node, "ecdsa,x-point", x, bytes);
+	if (!ret)
+		ret = fdt_setprop(keydest, node, "ecdsa,y-point", y, bytes);
+	if (!ret) {
+		ret = fdt_setprop_string(keydest, node, FIT_ALGO_PROP,
+					 info->name);
+	}
+	if (!ret && info->require_keys) {
+		ret = fdt_setprop_string(keydest, node, FIT_KEY_REQUIRED,
+					 info->require_keys);
+	}
+done:
+	if (ret)
+		ret = ret == -FDT_ERR_NOSPACE ? -ENOSPC : -EIO;
+
+	return ret;
+}
@@ -0,0 +1,877 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * ECDSA signature verification on the NIST P-256 and P-384 curves
+ *
+ * Field and scalar arithmetic uses Montgomery multiplication with fixed loop
+ * counts, and selects results with masks rather than branches, so its timing
+ * does not depend on the values. The point arithmetic branches on special
+ * cases such as adding a point to itself, which only depend on the public
+ * key, signature and hash.
+ */
+
+#ifndef USE_HOSTCC
+#include <common.h>
+#include <fdtdec.h>
+#include <log.h>
+#include <linux/errno.h>
+#else
+#include "fdt_host.h"
+#include "mkimage.h"
+#include <fdt_support.h>
+#endif
+#include <linux/kconfig.h>
+#include <u-boot/ecdsa.h>
+#include <u-boot/sha512.h>
+
+/* Limbs are 64-bit where the compiler can multiply them, as for RSA */
+#ifdef __SIZEOF_INT128__
+typedef uint64_t ec_limb;
+typedef unsigned __int128 ec_dlimb;
+#else
+typedef uint32_t ec_limb;
+typedef uint64_t ec_dlimb;
+#endif
+
+#define EC_LIMB_BITS	(sizeof(ec_limb) * 8)
+#define EC_MAX_LIMBS	(ECDSA384_BYTES / sizeof(ec_limb))
+
+/**
+ * struct ecdsa_curve - Parameters of a curve y^2 = x^3 - 3x + b mod p
+ *
+ * Numbers are big-endian byte arrays of @bytes bytes.
+ *
+ * @name:	Curve name, as in the ecdsa,curve property
+ * @bytes:	Size of the field elements and scalars in bytes
+ * @p:		Field prime
+ * @n:		Order of the base point
+ * @b:		Curve coefficient b
+ * @gx:		x coordinate of the base point
+ * @gy:		y coordinate of the base point
+ */
+struct ecdsa_curve {
+	const char *name;
+	uint bytes;
+	const uint8_t *p;
+	const uint8_t *n;
+	const uint8_t *b;
+	const uint8_t *gx;
+	const uint8_t *gy;
+};
+
+/**
+ * struct ec_mod - A modulus set up for Montgomery multiplication
+ *
+ * @m:		Modulus, as little endian limb array
+ * @rr:		R^2 mod m, where R = 2^(len * EC_LIMB_BITS)
+ * @m0inv:	-1 / m[0] mod 2^EC_LIMB_BITS
+ */
+struct ec_mod {
+	ec_limb m[EC_MAX_LIMBS];
+	ec_limb rr[EC_MAX_LIMBS];
+	ec_limb m0inv;
+};
+
+/**
+ * struct ec_point - A point in Jacobian coordinates
+ *
+ * The point is (x / z^2, y / z^3), with each coordinate in Montgomery form.
+ * It is the point at infinity if z is 0.
+ */
+struct ec_point {
+	ec_limb x[EC_MAX_LIMBS];
+	ec_limb y[EC_MAX_LIMBS];
+	ec_limb z[EC_MAX_LIMBS];
+};
+
+/**
+ * struct ec_ctx - Working state for a verification
+ *
+ * @len:	Number of limbs in each number
+ * @p:		Field prime
+ * @n:		Order of the base point
+ * @b:		Curve coefficient b, in Montgomery form
+ * @one:	1 in Montgomery form, i.e. R mod p
+ * @g:		Base point
+ */
+struct ec_ctx {
+	uint len;
+	struct ec_mod p;
+	struct ec_mod n;
+	ec_limb b[EC_MAX_LIMBS];
+	ec_limb one[EC_MAX_LIMBS];
+	struct ec_point g;
+};
+
+static const uint8_t p256_p[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x01,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+static const uint8_t p256_n[] = {
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xbc, 0xe6, 0xfa, 0xad, 0xa7, 0x17, 0x9e, 0x84,
+	0xf3, 0xb9, 0xca, 0xc2, 0xfc, 0x63, 0x25, 0x51
+};
+
+static const uint8_t p256_b[] = {
+	0x5a, 0xc6, 0x35, 0xd8, 0xaa, 0x3a, 0x93, 0xe7,
+	0xb3, 0xeb, 0xbd, 0x55, 0x76, 0x98, 0x86, 0xbc,
+	0x65, 0x1d, 0x06, 0xb0, 0xcc, 0x53, 0xb0, 0xf6,
+	0x3b, 0xce, 0x3c, 0x3e, 0x27, 0xd2, 0x60, 0x4b
+};
+
+static const uint8_t p256_gx[] = {
+	0x6b, 0x17, 0xd1, 0xf2, 0xe1, 0x2c, 0x42, 0x47,
+	0xf8, 0xbc, 0xe6, 0xe5, 0x63, 0xa4, 0x40, 0xf2,
+	0x77, 0x03, 0x7d, 0x81, 0x2d, 0xeb, 0x33, 0xa0,
+	0xf4, 0xa1, 0x39, 0x45, 0xd8, 0x98, 0xc2, 0x96
+};
+
+static const uint8_t p256_gy[] = {
+	0x4f, 0xe3, 0x42, 0xe2, 0xfe, 0x1a, 0x7f, 0x9b,
+	0x8e, 0xe7, 0xeb, 0x4a, 0x7c, 0x0f, 0x9e, 0x16,
+	0x2b, 0xce, 0x33, 0x57, 0x6b, 0x31, 0x5e, 0xce,
+	0xcb, 0xb6, 0x40, 0x68, 0x37, 0xbf, 0x51, 0xf5
+};
+
+static const uint8_t p384_p[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xfe,
+	0xff, 0xff, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff
+};
+
+static const uint8_t p384_n[] = {
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xc7, 0x63, 0x4d, 0x81, 0xf4, 0x37, 0x2d, 0xdf,
+	0x58, 0x1a, 0x0d, 0xb2, 0x48, 0xb0, 0xa7, 0x7a,
+	0xec, 0xec, 0x19, 0x6a, 0xcc, 0xc5, 0x29, 0x73
+};
+
+static const uint8_t p384_b[] = {
+	0xb3, 0x31, 0x2f, 0xa7, 0xe2, 0x3e, 0xe7, 0xe4,
+	0x98, 0x8e, 0x05, 0x6b, 0xe3, 0xf8, 0x2d, 0x19,
+	0x18, 0x1d, 0x9c, 0x6e, 0xfe, 0x81, 0x41, 0x12,
+	0x03, 0x14, 0x08, 0x8f, 0x50, 0x13, 0x87, 0x5a,
+	0xc6, 0x56, 0x39, 0x8d, 0x8a, 0x2e, 0xd1, 0x9d,
+	0x2a, 0x85, 0xc8, 0xed, 0xd3, 0xec, 0x2a, 0xef
+};
+
+static const uint8_t p384_gx[] = {
+	0xaa, 0x87, 0xca, 0x22, 0xbe, 0x8b, 0x05, 0x37,
+	0x8e, 0xb1, 0xc7, 0x1e, 0xf3, 0x20, 0xad, 0x74,
+	0x6e, 0x1d, 0x3b, 0x62, 0x8b, 0xa7, 0x9b, 0x98,
+	0x59, 0xf7, 0x41, 0xe0, 0x82, 0x54, 0x2a, 0x38,
+	0x55, 0x02, 0xf2, 0x5d, 0xbf, 0x55, 0x29, 0x6c,
+	0x3a, 0x54, 0x5e, 0x38, 0x72, 0x76, 0x0a, 0xb7
+};
+
+static const uint8_t p384_gy[] = {
+	0x36, 0x17, 0xde, 0x4a, 0x96, 0x26, 0x2c, 0x6f,
+	0x5d, 0x9e, 0x98, 0xbf, 0x92, 0x92, 0xdc, 0x29,
+	0xf8, 0xf4, 0x1d, 0xbd, 0x28, 0x9a, 0x14, 0x7c,
+	0xe9, 0xda, 0x31, 0x13, 0xb5, 0xf0, 0xb8, 0xc0,
+	0x0a, 0x60, 0xb1, 0xce, 0x1d, 0x7e, 0x81, 0x9d,
+	0x7a, 0x43, 0x1d, 0x7c, 0x90, 0xea, 0x0e, 0x5f
+};
+
+static const struct ecdsa_curve ecdsa_curves[] = {
+	{
+		.name = ECDSA_P256_NAME,
+		.bytes = ECDSA256_BYTES,
+		.p = p256_p,
+		.n = p256_n,
+		.b = p256_b,
+		.gx = p256_gx,
+		.gy = p256_gy,
+	},
+	{
+		.name = ECDSA_P384_NAME,
+		.bytes = ECDSA384_BYTES,
+		.p = p384_p,
+		.n = p384_n,
+		.b = p384_b,
+		.gx = p384_gx,
+		.gy = p384_gy,
+	},
+};
+
+static void ec_from_be(ec_limb *dst, uint len, const uint8_t *src)
+{
+	uint size = len * sizeof(ec_limb);
+	uint i;
+
+	memset(dst, '\0', size);
+	for (i = 0; i < size; i++)
+		dst[i / sizeof(ec_limb)] |= (ec_limb)src[size - 1 - i] <<
+			(i % sizeof(ec_limb) * 8);
+}
+
+static bool ec_is_zero(const ec_limb *a, uint len)
+{
+	ec_limb acc = 0;
+	uint i;
+
+	for (i = 0; i < len; i++)
+		acc |= a[i];
+
+	return !acc;
+}
+
+/* Set r to a if cond is 1, leaving it alone if cond is 0 */
+static void ec_cmov(ec_limb *r, const ec_limb *a, ec_limb cond, uint len)
+{
+	ec_limb mask = -cond;
+	uint i;
+
+	for (i = 0; i < len; i++)
+		r[i] ^= (r[i] ^ a[i]) & mask;
+}
+
+/* r = a + b, returning the carry */
+static ec_limb ec_add(ec_limb *r, const ec_limb *a, const ec_limb *b,
+		      uint len)
+{
+	ec_dlimb acc = 0;
+	uint i;
+
+	for (i = 0; i < len; i++) {
+		acc += (ec_dlimb)a[i] + b[i];
+		r[i] = (ec_limb)acc;
+		acc >>= EC_LIMB_BITS;
+	}
+
+	return (ec_limb)acc;
+}
+
+/* r = a - b, returning the borrow */
+static ec_limb ec_sub(ec_limb *r, const ec_limb *a, const ec_limb *b,
+		      uint len)
+{
+	ec_dlimb acc;
+	ec_limb borrow = 0;
+	uint i;
+
+	for (i = 0; i < len; i++) {
+		acc = (ec_dlimb)a[i] - b[i] - borrow;
+		r[i] = (ec_limb)acc;
+		borrow = (ec_limb)(acc >> EC_LIMB_BITS) & 1;
+	}
+
+	return borrow;
+}
+
+/* r = a + b mod m, where a, b < m */
+static void ec_mod_add(const struct ec_ctx *ctx, const struct ec_mod *m,
+		       ec_limb *r, const ec_limb *a, const ec_limb *b)
+{
+	ec_limb tmp[EC_MAX_LIMBS];
+	ec_limb carry, borrow;
+
+	carry = ec_add(r, a, b, ctx->len);
+	borrow = ec_sub(tmp, r, m->m, ctx->len);
+	ec_cmov(r, tmp, carry | (borrow ^ 1), ctx->len);
+}
+
+/* r = a - b mod m, where a, b < m */
+static void ec_mod_sub(const struct ec_ctx *ctx, const struct ec_mod *m,
+		       ec_limb *r, const ec_limb *a, const ec_limb *b)
+{
+	ec_limb tmp[EC_MAX_LIMBS];
+	ec_limb borrow;
+
+	borrow = ec_sub(r, a, b, ctx->len);
+	ec_add(tmp, r, m->m, ctx->len);
+	ec_cmov(r, tmp, borrow, ctx->len);
+}
+
+/**
+ * ec_mont_mul() - Montgomery multiplication
+ *
+ * Operation: r = a * b / R mod m
+ *
+ * @ctx:	Context
+ * @m:		Modulus
+ * @r:		Place to put the result, which may be the same as @a or @b
+ * @a:		Multiplier, < m
+ * @b:		Multiplicand, < m
+ */
+static void ec_mont_mul(const struct ec_ctx *ctx, const struct ec_mod *m,
+			ec_limb *r, const ec_limb *a, const ec_limb *b)
+{
+	ec_limb t[EC_MAX_LIMBS + 2];
+	uint len = ctx->len;
+	ec_limb u, borrow;
+	ec_dlimb acc;
+	uint i, j;
+
+	memset(t, '\0', sizeof(t));
+	for (i = 0; i < len; i++) {
+		acc = 0;
+		for (j = 0; j < len; j++) {
+			acc = (ec_dlimb)a[i] * b[j] + t[j] +
+				(acc >> EC_LIMB_BITS);
+			t[j] = (ec_limb)acc;
+		}
+		acc = (ec_dlimb)t[len] + (acc >> EC_LIMB_BITS);
+		t[len] = (ec_limb)acc;
+		t[len + 1] = (ec_limb)(acc >> EC_LIMB_BITS);
+
+		/* Add a multiple of m which clears the bottom limb */
+		u = t[0] * m->m0inv;
+		acc = (ec_dlimb)u * m->m[0] + t[0];
+		for (j = 1; j < len; j++) {
+			acc = (ec_dlimb)u * m->m[j] + t[j] +
+				(acc >> EC_LIMB_BITS);
+			t[j - 1] = (ec_limb)acc;
+		}
+		acc = (ec_dlimb)t[len] + (acc >> EC_LIMB_BITS);
+		t[len - 1] = (ec_limb)acc;
+		t[len] = t[len + 1] + (ec_limb)(acc >> EC_LIMB_BITS);
+	}
+
+	/* t < 2m, so subtract m once unless that underflows */
+	borrow = ec_sub(r, t, m->m, len);
+	ec_cmov(r, t, borrow & !t[len], len);
+}
+
+/**
+ * ec_mod_inv() - Modular inverse in Montgomery form
+ *
+ * This works out a^(m - 2), which is the inverse since m is prime. The
+ * exponent is a constant, so the timing does not depend on @a.
+ *
+ * @ctx:	Context
+ * @m:		Modulus, which must be prime with its top bit set
+ * @r:		Place to put the inverse, in Montgomery form
+ * @a:		Value to invert, in Montgomery form
+ */
+static void ec_mod_inv(const struct ec_ctx *ctx, const struct ec_mod *m,
+		       ec_limb *r, const ec_limb *a)
+{
+	ec_limb x[EC_MAX_LIMBS];
+	ec_limb e;
+	int i;
+
+	memcpy(x, a, sizeof(x));
+	for (i = ctx->len * EC_LIMB_BITS - 2; i >= 0; i--) {
+		ec_mont_mul(ctx, m, x, x, x);
+		e = m->m[i / EC_LIMB_BITS];
+		if (i < EC_LIMB_BITS)
+			e -= 2;
+		if ((e >> (i % EC_LIMB_BITS)) & 1)
+			ec_mont_mul(ctx, m, x, x, a);
+	}
+	memcpy(r, x, sizeof(x));
+}
+
+/**
+ * ec_mod_setup() - Set up a modulus for Montgomery multiplication
+ *
+ * @ctx:	Context, with @ctx->len set up
+ * @m:		Modulus to set up
+ * @val:	Modulus, as big-endian byte array
+ */
+static void ec_mod_setup(const struct ec_ctx *ctx, struct ec_mod *m,
+			 const uint8_t *val)
+{
+	ec_limb zero[EC_MAX_LIMBS] = {0};
+	ec_limb inv, m0;
+	uint i;
+
+	ec_from_be(m->m, ctx->len, val);
+
+	/* Each Newton step doubles the number of correct bits */
+	m0 = m->m[0];
+	inv = m0;
+	for (i = 0; i < 5; i++)
+		inv *= 2 - m0 * inv;
+	m->m0inv = -inv;
+
+	/* R mod m is -m, since the top bit of m is set; then double it */
+	ec_sub(m->rr, zero, m->m, ctx->len);
+	for (i = 0; i < ctx->len * EC_LIMB_BITS; i++)
+		ec_mod_add(ctx, m, m->rr, m->rr, m->rr);
+}
+
+/* Convert a big-endian number < p to Montgomery form */
+static void ec_to_mont(const struct ec_ctx *ctx, ec_limb *r,
+		       const uint8_t *val)
+{
+	ec_from_be(r, ctx->len, val);
+	ec_mont_mul(ctx, &ctx->p, r, r, ctx->p.rr);
+}
+
+static void ec_setup(struct ec_ctx *ctx, const struct ecdsa_curve *curve)
+{
+	ctx->len = curve->bytes / sizeof(ec_limb);
+	ec_mod_setup(ctx, &ctx->p, curve->p);
+	ec_mod_setup(ctx, &ctx->n, curve->n);
+	ec_to_mont(ctx, ctx->b, curve->b);
+	ec_to_mont(ctx, ctx->g.x, curve->gx);
+	ec_to_mont(ctx, ctx->g.y, curve->gy);
+
+	/* R mod p is R^2 / R */
+	memset(ctx->one, '\0', sizeof(ctx->one));
+	ctx->one[0] = 1;
+	ec_mont_mul(ctx, &ctx->p, ctx->one, ctx->one, ctx->p.rr);
+	memcpy(ctx->g.z, ctx->one, sizeof(ctx->one));
+}
+
+/* Check that a number, as a little endian limb array, is less than m */
+static bool ec_less_than(const struct ec_ctx *ctx, const struct ec_mod *m,
+			 const ec_limb *a)
+{
+	ec_limb tmp[EC_MAX_LIMBS];
+
+	return ec_sub(tmp, a, m->m, ctx->len);
+}
+
+/**
+ * ec_on_curve() - Check that an affine point is on the curve
+ *
+ * @ctx:	Context
+ * @pt:		Point to check, with coordinates in Montgomery form
+ * @return true if y^2 = x^3 - 3x + b
+ */
+static bool ec_on_curve(const struct ec_ctx *ctx, const struct ec_point *pt)
+{
+	const struct ec_mod *p = &ctx->p;
+	ec_limb lhs[EC_MAX_LIMBS], rhs[EC_MAX_LIMBS], t[EC_MAX_LIMBS];
+
+	ec_mont_mul(ctx, p, lhs, pt->y, pt->y);
+	ec_mont_mul(ctx, p, rhs, pt->x, pt->x);
+	ec_mont_mul(ctx, p, rhs, rhs, pt->x);
+	ec_mod_add(ctx, p, t, pt->x, pt->x);
+	ec_mod_add(ctx, p, t, t, pt->x);
+	ec_mod_sub(ctx, p, rhs, rhs, t);
+	ec_mod_add(ctx, p, rhs, rhs, ctx->b);
+
+	return !memcmp(lhs, rhs, ctx->len * sizeof(ec_limb));
+}
+
+/**
+ * ec_point_double() - Double a point, using a = -3
+ *
+ * This uses the "dbl-2001-b" formulas. The point at infinity doubles to
+ * itself, since z stays 0.
+ *
+ * @ctx:	Context
+ * @r:		Place to put the result, which may be the same as @pt
+ * @pt:		Point to double
+ */
+static void ec_point_double(const struct ec_ctx *ctx, struct ec_point *r,
+			    const struct ec_point *pt)
+{
+	const struct ec_mod *p = &ctx->p;
+	ec_limb delta[EC_MAX_LIMBS], gamma[EC_MAX_LIMBS], beta[EC_MAX_LIMBS];
+	ec_limb alpha[EC_MAX_LIMBS], t[EC_MAX_LIMBS];
+
+	ec_mont_mul(ctx, p, delta, pt->z, pt->z);
+	ec_mont_mul(ctx, p, gamma, pt->y, pt->y);
+	ec_mont_mul(ctx, p, beta, pt->x, gamma);
+
+	/* alpha = 3 * (x - delta) * (x + delta) */
+	ec_mod_sub(ctx, p, t, pt->x, delta);
+	ec_mod_add(ctx, p, alpha, pt->x, delta);
+	ec_mont_mul(ctx, p, alpha, alpha, t);
+	ec_mod_add(ctx, p, t, alpha, alpha);
+	ec_mod_add(ctx, p, alpha, alpha, t);
+
+	/* z3 = (y + z)^2 - gamma - delta */
+	ec_mod_add(ctx, p, r->z, pt->y, pt->z);
+	ec_mont_mul(ctx, p, r->z, r->z, r->z);
+	ec_mod_sub(ctx, p, r->z, r->z, gamma);
+	ec_mod_sub(ctx, p, r->z, r->z, delta);
+
+	/* x3 = alpha^2 - 8 * beta */
+	ec_mod_add(ctx, p, beta, beta, beta);
+	ec_mod_add(ctx, p, beta, beta, beta);
+	ec_mont_mul(ctx, p, r->x, alpha, alpha);
+	ec_mod_sub(ctx, p, r->x, r->x, beta);
+	ec_mod_sub(ctx, p, r->x, r->x, beta);
+
+	/* y3 = alpha * (4 * beta - x3) - 8 * gamma^2 */
+	ec_mod_sub(ctx, p, t, beta, r->x);
+	ec_mont_mul(ctx, p, r->y, alpha, t);
+	ec_mont_mul(ctx, p, gamma, gamma, gamma);
+	ec_mod_add(ctx, p, gamma, gamma, gamma);
+	ec_mod_add(ctx, p, gamma, gamma, gamma);
+	ec_mod_add(ctx, p, gamma, gamma, gamma);
+	ec_mod_sub(ctx, p, r->y, r->y, gamma);
+}
+
+/**
+ * ec_point_add() - Add two points
+ *
+ * This uses the "add-2007-bl" formulas, with checks for the point at infinity
+ * and for adding a point to itself or its inverse.
+ *
+ * @ctx:	Context
+ * @r:		Place to put the result, which may be the same as @a
+ * @a:		First point
+ * @b:		Second point, which must not be the same as @r
+ */
+static void ec_point_add(const struct ec_ctx *ctx, struct ec_point *r,
+			 const struct ec_point *a, const struct ec_point *b)
+{
+	const struct ec_mod *p = &ctx->p;
+	ec_limb z1z1[EC_MAX_LIMBS], z2z2[EC_MAX_LIMBS];
+	ec_limb u1[EC_MAX_LIMBS], h[EC_MAX_LIMBS];
+	ec_limb s1[EC_MAX_LIMBS], s2[EC_MAX_LIMBS];
+	ec_limb i[EC_MAX_LIMBS], j[EC_MAX_LIMBS];
+	uint len = ctx->len;
+
+	if (ec_is_zero(b->z, len)) {
+		if (r != a)
+			*r = *a;
+		return;
+	}
+	if (ec_is_zero(a->z, len)) {
+		*r = *b;
+		return;
+	}
+
+	ec_mont_mul(ctx, p, z1z1, a->z, a->z);
+	ec_mont_mul(ctx, p, z2z2, b->z, b->z);
+	ec_mont_mul(ctx, p, u1, a->x, z2z2);
+	ec_mont_mul(ctx, p, h, b->x, z1z1);
+	ec_mod_sub(ctx, p, h, h, u1);
+	ec_mont_mul(ctx, p, s1, a->y, b->z);
+	ec_mont_mul(ctx, p, s1, s1, z2z2);
+	ec_mont_mul(ctx, p, s2, b->y, a->z);
+	ec_mont_mul(ctx, p, s2, s2, z1z1);
+	ec_mod_sub(ctx, p, s2, s2, s1);
+
+	if (ec_is_zero(h, len)) {
+		if (ec_is_zero(s2, len))
+			ec_point_double(ctx, r, a);
+		else
+			memset(r->z, '\0', sizeof(r->z));
+		return;
+	}
+
+	/* s2 is now r = 2 * (s2 - s1), and i = (2 * h)^2, j = h * i */
+	ec_mod_add(ctx, p, s2, s2, s2);
+	ec_mod_add(ctx, p, i, h, h);
+	ec_mont_mul(ctx, p, i, i, i);
+	ec_mont_mul(ctx, p, j, h, i);
+
+	/* z3 = ((z1 + z2)^2 - z1z1 - z2z2) * h */
+	ec_mod_add(ctx, p, r->z, a->z, b->z);
+	ec_mont_mul(ctx, p, r->z, r->z, r->z);
+	ec_mod_sub(ctx, p, r->z, r->z, z1z1);
+	ec_mod_sub(ctx, p, r->z, r->z, z2z2);
+	ec_mont_mul(ctx, p, r->z, r->z, h);
+
+	/* u1 is now v = u1 * i; x3 = r^2 - j - 2 * v */
+	ec_mont_mul(ctx, p, u1, u1, i);
+	ec_mont_mul(ctx, p, r->x, s2, s2);
+	ec_mod_sub(ctx, p, r->x, r->x, j);
+	ec_mod_sub(ctx, p, r->x, r->x, u1);
+	ec_mod_sub(ctx, p, r->x, r->x, u1);
+
+	/* y3 = r * (v - x3) - 2 * s1 * j */
+	ec_mod_sub(ctx, p, u1, u1, r->x);
+	ec_mont_mul(ctx, p, r->y, s2, u1);
+	ec_mont_mul(ctx, p, s1, s1, j);
+	ec_mod_add(ctx, p, s1, s1, s1);
+	ec_mod_sub(ctx, p, r->y, r->y, s1);
+}
+
+/* Window size for scalar multiplication, in bits */
+#define EC_WINDOW_BITS	4
+
+static uint ec_bit(const ec_limb *a, uint pos)
+{
+	return (a[pos / EC_LIMB_BITS] >> (pos % EC_LIMB_BITS)) & 1;
+}
+
+/**
+ * ec_window_digits() - Split a scalar into sliding windows
+ *
+ * Each run of up to EC_WINDOW_BITS bits ending in a one becomes an odd digit,
+ * placed at the position of its lowest bit. All other positions are zero, so
+ * the scalar is the sum of digits[i] * 2^i.
+ *
+ * @ctx:	Context
+ * @digits:	Returns the digits, one per bit of the scalar
+ * @a:		Scalar, which is public
+ */
+static void ec_window_digits(const struct ec_ctx *ctx, uint8_t *digits,
+			     const ec_limb *a)
+{
+	int i, j, k;
+
+	memset(digits, '\0', ctx->len * EC_LIMB_BITS);
+	for (i = ctx->len * EC_LIMB_BITS - 1; i >= 0; i--) {
+		if (!ec_bit(a, i))
+			continue;
+		for (j = i - EC_WINDOW_BITS + 1 > 0 ? i - EC_WINDOW_BITS + 1 : 0;
+		     !ec_bit(a, j); j++)
+			;
+		for (k = i; k >= j; k--)
+			digits[j] = digits[j] << 1 | ec_bit(a, k);
+		i = j;
+	}
+}
+
+/**
+ * ec_odd_multiples() - Work out the odd multiples of a point
+ *
+ * @ctx:	Context
+ * @table:	Returns pt, 3 * pt, 5 * pt, ... for each odd window digit
+ * @pt:		Point to multiply
+ */
+static void ec_odd_multiples(const struct ec_ctx *ctx, struct ec_point *table,
+			     const struct ec_point *pt)
+{
+	struct ec_point twice;
+	int i;
+
+	table[0] = *pt;
+	ec_point_double(ctx, &twice, pt);
+	for (i = 1; i < 1 << (EC_WINDOW_BITS - 1); i++)
+		ec_point_add(ctx, &table[i], &table[i - 1], &twice);
+}
+
+/**
+ * ec_verify() - Check an ECDSA signature
+ *
+ * This follows SEC 1 section 4.1.4: with w = 1 / s mod n, the signature is
+ * valid if the x coordinate of (e * w) * G + (r * w) * Q is r, mod n.
+ *
+ * @curve:	Curve to use
+ * @qx:		x coordinate of the public key, as big-endian byte array
+ * @qy:		y coordinate of the public key, as big-endian byte array
+ * @hash:	Hash of the data
+ * @hash_len:	Length of @hash in bytes
+ * @sig:	Signature, as r then s, each a big-endian byte array
+ * @return 0 if valid, -EINVAL if the key is not a point on the curve,
+ *	-EBADMSG if the signature does not match
+ */
+static int ec_verify(const struct ecdsa_curve *curve, const uint8_t *qx,
+		     const uint8_t *qy, const uint8_t *hash, uint hash_len,
+		     const uint8_t *sig)
+{
+	ec_limb r[EC_MAX_LIMBS], s[EC_MAX_LIMBS], e[EC_MAX_LIMBS];
+	ec_limb u1[EC_MAX_LIMBS], u2[EC_MAX_LIMBS], t[EC_MAX_LIMBS];
+	struct ec_point gtab[1 << (EC_WINDOW_BITS - 1)];
+	struct ec_point qtab[1 << (EC_WINDOW_BITS - 1)];
+	uint8_t d1[EC_MAX_LIMBS * EC_LIMB_BITS], d2[EC_MAX_LIMBS * EC_LIMB_BITS];
+	uint8_t buf[ECDSA384_BYTES];
+	struct ec_point q, acc;
+	struct ec_ctx ctx;
+	uint len;
+	int i;
+
+	ec_setup(&ctx, curve);
+	len = ctx.len;
+
+	/* The public key must be a point on the curve */
+	ec_from_be(q.x, len, qx);
+	ec_from_be(q.y, len, qy);
+	if (!ec_less_than(&ctx, &ctx.p, q.x) ||
+	    !ec_less_than(&ctx, &ctx.p, q.y)) {
+		debug("%s: Public key is out of range\n", __func__);
+		return -EINVAL;
+	}
+	ec_mont_mul(&ctx, &ctx.p, q.x, q.x, ctx.p.rr);
+	ec_mont_mul(&ctx, &ctx.p, q.y, q.y, ctx.p.rr);
+	memcpy(q.z, ctx.one, sizeof(q.z));
+	if (!ec_on_curve(&ctx, &q)) {
+		debug("%s: Public key is not on the curve\n", __func__);
+		return -EINVAL;
+	}
+
+	/* r and s must be in [1, n - 1] */
+	ec_from_be(r, len, sig);
+	ec_from_be(s, len, sig + curve->bytes);
+	if (ec_is_zero(r, len) || !ec_less_than(&ctx, &ctx.n, r) ||
+	    ec_is_zero(s, len) || !ec_less_than(&ctx, &ctx.n, s))
+		return -EBADMSG;
+
+	/* Use the leftmost bits of the hash, then reduce it mod n */
+	memset(buf, '\0', sizeof(buf));
+	if (hash_len > curve->bytes)
+		hash_len = curve->bytes;
+	memcpy(buf + curve->bytes - hash_len, hash, hash_len);
+	ec_from_be(e, len, buf);
+	ec_sub(t, e, ctx.n.m, len);
+	ec_cmov(e, t, !ec_less_than(&ctx, &ctx.n, e), len);
+
+	/*
+	 * s * R is s in Montgomery form; its inverse is w * R, so Montgomery
+	 * multiplication of e and r by this gives plain u1 and u2
+	 */
+	ec_mont_mul(&ctx, &ctx.n, t, s, ctx.n.rr);
+	ec_mod_inv(&ctx, &ctx.n, t, t);
+	ec_mont_mul(&ctx, &ctx.n, u1, e, t);
+	ec_mont_mul(&ctx, &ctx.n, u2, r, t);
+
+	/* Work out u1 * G + u2 * Q together, sharing the doublings */
+	ec_window_digits(&ctx, d1, u1);
+	ec_window_digits(&ctx, d2, u2);
+	ec_odd_multiples(&ctx, gtab, &ctx.g);
+	ec_odd_multiples(&ctx, qtab, &q);
+	memset(acc.z, '\0', sizeof(acc.z));
+	for (i = len * EC_LIMB_BITS - 1; i >= 0; i--) {
+		ec_point_double(&ctx, &acc, &acc);
+		if (d1[i])
+			ec_point_add(&ctx, &acc, &acc, &gtab[d1[i] >> 1]);
+		if (d2[i])
+			ec_point_add(&ctx, &acc, &acc, &qtab[d2[i] >> 1]);
+	}
+	if (ec_is_zero(acc.z, len))
+		return -EBADMSG;
+
+	/*
+	 * The affine x coordinate is X / Z^2, which is less than p. Rather than
+	 * working out the inverse of Z, check whether X = x * Z^2 for each x
+	 * below p which is r mod n: that is r and perhaps r + n.
+	 */
+	ec_mont_mul(&ctx, &ctx.p, u1, acc.z, acc.z);
+	ec_mont_mul(&ctx, &ctx.p, t, r, ctx.p.rr);
+	ec_mont_mul(&ctx, &ctx.p, t, t, u1);
+	if (!memcmp(t, acc.x, len * sizeof(ec_limb)))
+		return 0;
+	if (ec_add(r, r, ctx.n.m, len) || !ec_less_than(&ctx, &ctx.p, r))
+		return -EBADMSG;
+	ec_mont_mul(&ctx, &ctx.p, t, r, ctx.p.rr);
+	ec_mont_mul(&ctx, &ctx.p, t, t, u1);
+	if (memcmp(t, acc.x, len * sizeof(ec_limb)))
+		return -EBADMSG;
+
+	return 0;
+}
+
+/**
+ * ecdsa_verify_with_keynode() - Verify a signature using a key node
+ *
+ * @info:	Specifies key and FIT information
+ * @hash:	Hash of the data
+ * @sig:	Signature
+ * @sig_len:	Number of bytes in signature
+ * @node:	Node with the ECDSA key properties
+ * @return 0 if verified, -ve on error
+ */
+static int ecdsa_verify_with_keynode(struct image_sign_info *info,
+				     const uint8_t *hash, const uint8_t *sig,
+				     uint sig_len, int node)
+{
+	const void *blob = info->fdt_blob;
+	const struct ecdsa_curve *curve;
+	const uint8_t *qx, *qy;
+	const char *name;
+	int xlen, ylen;
+
+	if (node < 0) {
+		debug("%s: Skipping invalid node", __func__);
+		return -EBADF;
+	}
+
+	name = fdt_getprop(blob, node, "ecdsa,curve", NULL);
+	if (!name) {
+		debug("%s: Missing ECDSA key info", __func__);
+		return -EFAULT;
+	}
+	for (curve = ecdsa_curves;
+	     curve != ecdsa_curves + ARRAY_SIZE(ecdsa_curves); curve++) {
+		if (!strcmp(curve->name, name))
+			break;
+	}
+	if (curve == ecdsa_curves + ARRAY_SIZE(ecdsa_curves) ||
+	    curve->bytes != info->crypto->key_len) {
+		debug("%s: Curve '%s' does not match %s\n", __func__, name,
+		      info->crypto->name);
+		return -EINVAL;
+	}
+
+	qx = fdt_getprop(blob, node, "ecdsa,x-point", &xlen);
+	qy = fdt_getprop(blob, node, "ecdsa,y-point", &ylen);
+	if (!qx || !qy || xlen != curve->bytes || ylen != curve->bytes) {
+		debug("%s: Missing ECDSA key info", __func__);
+		return -EFAULT;
+	}
+
+	if (sig_len != curve->bytes * 2) {
+		debug("Signature is of incorrect length %d\n", sig_len);
+		return -EINVAL;
+	}
+
+	return ec_verify(curve, qx, qy, hash, info->checksum->checksum_len,
+			 sig);
+}
+
+int ecdsa_verify_hash(struct image_sign_info *info,
+		      const uint8_t *hash, const uint8_t *sig, uint sig_len)
+{
+	const void *blob = info->fdt_blob;
+	int ndepth, noffset;
+	int sig_node, node;
+	char name[100];
+	int ret;
+
+	sig_node = fdt_subnode_offset(blob, 0, FIT_SIG_NODENAME);
+	if (sig_node < 0) {
+		debug("%s: No signature node found\n", __func__);
+		return -ENOENT;
+	}
+
+	/* See if we must use a particular key */
+	if (info->required_keynode != -1)
+		return ecdsa_verify_with_keynode(info, hash, sig, sig_len,
+						 info->required_keynode);
+
+	/* Look for a key that matches our hint */
+	snprintf(name, sizeof(name), "key-%s", info->keyname);
+	node = fdt_subnode_offset(blob, sig_node, name);
+	ret = ecdsa_verify_with_keynode(info, hash, sig, sig_len, node);
+	if (!ret)
+		return ret;
+
+	/* No luck, so try each of the keys in turn */
+	for (ndepth = 0, noffset = fdt_next_node(blob, sig_node, &ndepth);
+	     noffset >= 0 && ndepth > 0;
+	     noffset = fdt_next_node(blob, noffset, &ndepth)) {
+		if (ndepth == 1 && noffset != node) {
+			ret = ecdsa_verify_with_keynode(info, hash, sig,
+							sig_len, noffset);
+			if (!ret)
+				break;
+		}
+	}
+
+	return ret;
+}
+
+int ecdsa_verify(struct image_sign_info *info,
+		 const struct image_region region[], int region_count,
+		 uint8_t *sig, uint sig_len)
+{
+	/* Reserve memory for the largest supported checksum */
+	uint8_t hash[SHA512_SUM_LEN];
+	int ret;
+
+	if (info->checksum->checksum_len > sizeof(hash)) {
+		debug("%s: invalid checksum-algorithm %s for %s\n",
+		      __func__, info->checksum->name, info->crypto->name);
+		return -EINVAL;
+	}
+
+	ret = info->checksum->calculate(info->checksum->name,
+					region, region_count, hash);
+	if (ret < 0) {
+		debug("%s: Error in checksum calculation\n", __func__);
+		return -EINVAL;
+	}
+
+	return ecdsa_verify_hash(info, hash, sig, sig_len);
+}
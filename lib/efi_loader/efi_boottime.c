@@ -6,6 +6,7 @@
  */
 
 #include <common.h>
+#include <console.h>
 #include <div64.h>
 #include <efi_loader.h>
 #include <irq_func.h>
@@ -1996,6 +1997,9 @@ static efi_status_t EFIAPI efi_exit_boot_services(efi_handle_t image_handle,
 
 	board_quiesce_devices();
 
+	/* The console is not ours to write to after this */
+	console_flush();
+
 	/* Patch out unsupported runtime function */
 	efi_runtime_detach();
 
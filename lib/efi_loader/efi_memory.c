@@ -12,7 +12,7 @@
 #include <mapmem.h>
 #include <watchdog.h>
 #include <asm/cache.h>
-#include <linux/list_sort.h>
+#include <linux/rbtree_augmented.h>
 #include <linux/sizes.h>
 
 DECLARE_GLOBAL_DATA_PTR;
@@ -22,17 +22,30 @@ DECLARE_GLOBAL_DATA_PTR;
 
 efi_uintn_t efi_memory_map_key;
 
+/**
+ * struct efi_mem_list - memory map entry
+ *
+ * @node:	node in the memory map tree, ordered by physical address
+ * @desc:	memory descriptor
+ * @max_free:	largest number of free pages in a single entry of the
+ *		subtree rooted at this node
+ *
+ * The memory map is kept as a red-black tree of non-overlapping entries.
+ * Each node caches the size of the largest EFI_CONVENTIONAL_MEMORY entry
+ * below it so that a free range can be found without visiting entries
+ * that are too small.
+ */
 struct efi_mem_list {
-	struct list_head link;
+	struct rb_node node;
 	struct efi_mem_desc desc;
+	u64 max_free;
 };
 
-#define EFI_CARVE_NO_OVERLAP		-1
-#define EFI_CARVE_LOOP_AGAIN		-2
-#define EFI_CARVE_OVERLAPS_NONRAM	-3
+/* This tree contains all memory map items */
+static struct rb_root efi_mem = RB_ROOT;
 
-/* This list contains all memory map items */
-LIST_HEAD(efi_mem);
+/* Number of entries in the memory map */
+static efi_uintn_t efi_mem_count;
 
 #ifdef CONFIG_EFI_LOADER_BOUNCE_BUFFER
 void *efi_bounce_buffer;
@@ -77,156 +90,225 @@ static u64 checksum(struct efi_pool_allocation *alloc)
 	return ret;
 }
 
-/*
- * Sorts the memory list from highest address to lowest address
- *
- * When allocating memory we should always start from the highest
- * address chunk, so sort the memory list such that the first list
- * iterator gets the highest address and goes lower from there.
- */
-static int efi_mem_cmp(void *priv, struct list_head *a, struct list_head *b)
+static uint64_t desc_get_end(struct efi_mem_desc *desc)
 {
-	struct efi_mem_list *mema = list_entry(a, struct efi_mem_list, link);
-	struct efi_mem_list *memb = list_entry(b, struct efi_mem_list, link);
-
-	if (mema->desc.physical_start == memb->desc.physical_start)
-		return 0;
-	else if (mema->desc.physical_start < memb->desc.physical_start)
-		return 1;
-	else
-		return -1;
+	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
 }
 
-static uint64_t desc_get_end(struct efi_mem_desc *desc)
+static u64 efi_mem_free_pages(struct efi_mem_list *mem)
 {
-	return desc->physical_start + (desc->num_pages << EFI_PAGE_SHIFT);
+	if (mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+		return 0;
+
+	return mem->desc.num_pages;
 }
 
-static void efi_mem_sort(void)
+static u64 efi_mem_compute_max(struct efi_mem_list *mem)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *prevmem = NULL;
-	bool merge_again = true;
-
-	list_sort(NULL, &efi_mem, efi_mem_cmp);
-
-	/* Now merge entries that can be merged */
-	while (merge_again) {
-		merge_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			struct efi_mem_desc *prev = &prevmem->desc;
-			struct efi_mem_desc *cur;
-			uint64_t pages;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			if (!prevmem) {
-				prevmem = lmem;
-				continue;
-			}
-
-			cur = &lmem->desc;
-
-			if ((desc_get_end(cur) == prev->physical_start) &&
-			    (prev->type == cur->type) &&
-			    (prev->attribute == cur->attribute)) {
-				/* There is an existing map before, reuse it */
-				pages = cur->num_pages;
-				prev->num_pages += pages;
-				prev->physical_start -= pages << EFI_PAGE_SHIFT;
-				prev->virtual_start -= pages << EFI_PAGE_SHIFT;
-				list_del(&lmem->link);
-				free(lmem);
-
-				merge_again = true;
-				break;
-			}
+	u64 max = efi_mem_free_pages(mem);
+	struct efi_mem_list *child;
 
-			prevmem = lmem;
-		}
+	if (mem->node.rb_left) {
+		child = rb_entry(mem->node.rb_left, struct efi_mem_list, node);
+		max = max(max, child->max_free);
+	}
+	if (mem->node.rb_right) {
+		child = rb_entry(mem->node.rb_right, struct efi_mem_list, node);
+		max = max(max, child->max_free);
 	}
+
+	return max;
 }
 
-/** efi_mem_carve_out - unmap memory region
+RB_DECLARE_CALLBACKS(static, efi_mem_augment, struct efi_mem_list, node,
+		     u64, max_free, efi_mem_compute_max)
+
+/**
+ * efi_mem_update() - update an entry after changing its descriptor
  *
- * @map:		memory map
- * @carve_desc:		memory region to unmap
- * @overlap_only_ram:	the carved out region may only overlap RAM
- * Return Value:	the number of overlapping pages which have been
- *			removed from the map,
- *			EFI_CARVE_NO_OVERLAP, if the regions don't overlap,
- *			EFI_CARVE_OVERLAPS_NONRAM, if the carve and map overlap,
- *			and the map contains anything but free ram
- *			(only when overlap_only_ram is true),
- *			EFI_CARVE_LOOP_AGAIN, if the mapping list should be
- *			traversed again, as it has been altered.
+ * @mem:	memory map entry
  *
- * Unmaps all memory occupied by the carve_desc region from the list entry
- * pointed to by map.
+ * The start address may only change within the bounds of the neighbouring
+ * entries, so the tree order is preserved.
+ */
+static void efi_mem_update(struct efi_mem_list *mem)
+{
+	mem->desc.virtual_start = mem->desc.physical_start;
+	efi_mem_augment_propagate(&mem->node, NULL);
+}
+
+static void efi_mem_insert(struct efi_mem_list *mem)
+{
+	struct rb_node **link = &efi_mem.rb_node, *parent = NULL;
+	u64 free = efi_mem_free_pages(mem);
+
+	while (*link) {
+		struct efi_mem_list *cur;
+
+		parent = *link;
+		cur = rb_entry(parent, struct efi_mem_list, node);
+		if (cur->max_free < free)
+			cur->max_free = free;
+		if (mem->desc.physical_start < cur->desc.physical_start)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+
+	mem->max_free = free;
+	rb_link_node(&mem->node, parent, link);
+	rb_insert_augmented(&mem->node, &efi_mem, &efi_mem_augment);
+	++efi_mem_count;
+}
+
+static void efi_mem_remove(struct efi_mem_list *mem)
+{
+	rb_erase_augmented(&mem->node, &efi_mem, &efi_mem_augment);
+	--efi_mem_count;
+	free(mem);
+}
+
+static struct efi_mem_list *efi_mem_next(struct efi_mem_list *mem)
+{
+	struct rb_node *node = rb_next(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+static struct efi_mem_list *efi_mem_prev(struct efi_mem_list *mem)
+{
+	struct rb_node *node = rb_prev(&mem->node);
+
+	return node ? rb_entry(node, struct efi_mem_list, node) : NULL;
+}
+
+/**
+ * efi_mem_lookup() - find the first entry ending above an address
  *
- * In case of EFI_CARVE_OVERLAPS_NONRAM it is the callers responsibility
- * to re-add the already carved out pages to the mapping.
+ * @addr:	physical address
+ * Return:	entry containing @addr, else the first entry above @addr,
+ *		NULL if there is none
  */
-static s64 efi_mem_carve_out(struct efi_mem_list *map,
-			     struct efi_mem_desc *carve_desc,
-			     bool overlap_only_ram)
+static struct efi_mem_list *efi_mem_lookup(u64 addr)
 {
-	struct efi_mem_list *newmap;
-	struct efi_mem_desc *map_desc = &map->desc;
-	uint64_t map_start = map_desc->physical_start;
-	uint64_t map_end = map_start + (map_desc->num_pages << EFI_PAGE_SHIFT);
-	uint64_t carve_start = carve_desc->physical_start;
-	uint64_t carve_end = carve_start +
-			     (carve_desc->num_pages << EFI_PAGE_SHIFT);
-
-	/* check whether we're overlapping */
-	if ((carve_end <= map_start) || (carve_start >= map_end))
-		return EFI_CARVE_NO_OVERLAP;
-
-	/* We're overlapping with non-RAM, warn the caller if desired */
-	if (overlap_only_ram && (map_desc->type != EFI_CONVENTIONAL_MEMORY))
-		return EFI_CARVE_OVERLAPS_NONRAM;
-
-	/* Sanitize carve_start and carve_end to lie within our bounds */
-	carve_start = max(carve_start, map_start);
-	carve_end = min(carve_end, map_end);
-
-	/* Carving at the beginning of our map? Just move it! */
-	if (carve_start == map_start) {
-		if (map_end == carve_end) {
-			/* Full overlap, just remove map */
-			list_del(&map->link);
-			free(map);
+	struct rb_node *node = efi_mem.rb_node;
+	struct efi_mem_list *ret = NULL;
+
+	while (node) {
+		struct efi_mem_list *cur;
+
+		cur = rb_entry(node, struct efi_mem_list, node);
+		if (addr < desc_get_end(&cur->desc)) {
+			ret = cur;
+			if (addr >= cur->desc.physical_start)
+				break;
+			node = node->rb_left;
 		} else {
-			map->desc.physical_start = carve_end;
-			map->desc.virtual_start = carve_end;
-			map->desc.num_pages = (map_end - carve_end)
-					      >> EFI_PAGE_SHIFT;
+			node = node->rb_right;
 		}
+	}
+
+	return ret;
+}
 
-		return (carve_end - carve_start) >> EFI_PAGE_SHIFT;
+static bool efi_mem_can_merge(struct efi_mem_list *low,
+			      struct efi_mem_list *high)
+{
+	return low && high &&
+	       desc_get_end(&low->desc) == high->desc.physical_start &&
+	       low->desc.type == high->desc.type &&
+	       low->desc.attribute == high->desc.attribute;
+}
+
+/**
+ * efi_mem_merge() - merge an entry with adjacent entries of the same kind
+ *
+ * @mem:	memory map entry
+ */
+static void efi_mem_merge(struct efi_mem_list *mem)
+{
+	struct efi_mem_list *prev = efi_mem_prev(mem);
+	struct efi_mem_list *next = efi_mem_next(mem);
+
+	if (efi_mem_can_merge(mem, next)) {
+		mem->desc.num_pages += next->desc.num_pages;
+		efi_mem_remove(next);
+		efi_mem_update(mem);
 	}
+	if (efi_mem_can_merge(prev, mem)) {
+		prev->desc.num_pages += mem->desc.num_pages;
+		efi_mem_remove(mem);
+		efi_mem_update(prev);
+	}
+}
 
-	/*
-	 * Overlapping maps, just split the list map at carve_start,
-	 * it will get moved or removed in the next iteration.
-	 *
-	 * [ map_desc |__carve_start__| newmap ]
-	 */
+/**
+ * efi_mem_is_free() - check that a range is fully covered by free RAM
+ *
+ * @start:	start address, must be a multiple of EFI_PAGE_SIZE
+ * @end:	end address, must be a multiple of EFI_PAGE_SIZE
+ * Return:	true if every page in the range is EFI_CONVENTIONAL_MEMORY
+ */
+static bool efi_mem_is_free(u64 start, u64 end)
+{
+	struct efi_mem_list *mem = efi_mem_lookup(start);
 
-	/* Create a new map from [ carve_start ... map_end ] */
-	newmap = calloc(1, sizeof(*newmap));
-	newmap->desc = map->desc;
-	newmap->desc.physical_start = carve_start;
-	newmap->desc.virtual_start = carve_start;
-	newmap->desc.num_pages = (map_end - carve_start) >> EFI_PAGE_SHIFT;
-	/* Insert before current entry (descending address order) */
-	list_add_tail(&newmap->link, &map->link);
+	for (; mem && start < end; mem = efi_mem_next(mem)) {
+		if (mem->desc.physical_start > start ||
+		    mem->desc.type != EFI_CONVENTIONAL_MEMORY)
+			return false;
+		start = desc_get_end(&mem->desc);
+	}
 
-	/* Shrink the map to [ map_start ... carve_start ] */
-	map_desc->num_pages = (carve_start - map_start) >> EFI_PAGE_SHIFT;
+	return start >= end;
+}
 
-	return EFI_CARVE_LOOP_AGAIN;
+/**
+ * efi_mem_carve_out() - unmap memory region
+ *
+ * @start:	start address, must be a multiple of EFI_PAGE_SIZE
+ * @end:	end address, must be a multiple of EFI_PAGE_SIZE
+ * @spare:	entry to use if an existing entry has to be split, set to
+ *		NULL if it was used
+ *
+ * Removes all memory in [@start, @end) from the memory map, shrinking or
+ * splitting the entries that overlap the range.
+ */
+static void efi_mem_carve_out(u64 start, u64 end, struct efi_mem_list **spare)
+{
+	struct efi_mem_list *mem = efi_mem_lookup(start);
+
+	while (mem && mem->desc.physical_start < end) {
+		struct efi_mem_list *next = efi_mem_next(mem);
+		u64 map_start = mem->desc.physical_start;
+		u64 map_end = desc_get_end(&mem->desc);
+
+		if (map_start < start && map_end > end) {
+			/* [ mem | carve | spare ] */
+			(*spare)->desc = mem->desc;
+			(*spare)->desc.physical_start = end;
+			(*spare)->desc.virtual_start = end;
+			(*spare)->desc.num_pages = (map_end - end) >>
+						   EFI_PAGE_SHIFT;
+			mem->desc.num_pages = (start - map_start) >>
+					      EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+			efi_mem_insert(*spare);
+			*spare = NULL;
+			break;
+		} else if (map_start < start) {
+			mem->desc.num_pages = (start - map_start) >>
+					      EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+		} else if (map_end > end) {
+			mem->desc.physical_start = end;
+			mem->desc.num_pages = (map_end - end) >> EFI_PAGE_SHIFT;
+			efi_mem_update(mem);
+		} else {
+			efi_mem_remove(mem);
+		}
+		mem = next;
+	}
 }
 
 /**
@@ -242,10 +324,8 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 					  int memory_type,
 					  bool overlap_only_ram)
 {
-	struct list_head *lhandle;
-	struct efi_mem_list *newlist;
-	bool carve_again;
-	uint64_t carved_pages = 0;
+	struct efi_mem_list *newlist, *spare;
+	u64 end = start + (pages << EFI_PAGE_SHIFT);
 	struct efi_event *evt;
 
 	EFI_PRINT("%s: 0x%llx 0x%llx %d %s\n", __func__,
@@ -257,8 +337,22 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 	if (!pages)
 		return EFI_SUCCESS;
 
-	++efi_memory_map_key;
+	/*
+	 * The payload wants to have RAM overlaps only. Check this before
+	 * touching the map so that nothing has to be undone.
+	 */
+	if (overlap_only_ram && !efi_mem_is_free(start, end))
+		return EFI_NO_MAPPING;
+
 	newlist = calloc(1, sizeof(*newlist));
+	spare = calloc(1, sizeof(*spare));
+	if (!newlist || !spare) {
+		free(newlist);
+		free(spare);
+		return EFI_OUT_OF_RESOURCES;
+	}
+
+	++efi_memory_map_key;
 	newlist->desc.type = memory_type;
 	newlist->desc.physical_start = start;
 	newlist->desc.virtual_start = start;
@@ -277,60 +371,11 @@ static efi_status_t efi_add_memory_map_pg(u64 start, u64 pages,
 		break;
 	}
 
-	/* Add our new map */
-	do {
-		carve_again = false;
-		list_for_each(lhandle, &efi_mem) {
-			struct efi_mem_list *lmem;
-			s64 r;
-
-			lmem = list_entry(lhandle, struct efi_mem_list, link);
-			r = efi_mem_carve_out(lmem, &newlist->desc,
-					      overlap_only_ram);
-			switch (r) {
-			case EFI_CARVE_OVERLAPS_NONRAM:
-				/*
-				 * The user requested to only have RAM overlaps,
-				 * but we hit a non-RAM region. Error out.
-				 */
-				return EFI_NO_MAPPING;
-			case EFI_CARVE_NO_OVERLAP:
-				/* Just ignore this list entry */
-				break;
-			case EFI_CARVE_LOOP_AGAIN:
-				/*
-				 * We split an entry, but need to loop through
-				 * the list again to actually carve it.
-				 */
-				carve_again = true;
-				break;
-			default:
-				/* We carved a number of pages */
-				carved_pages += r;
-				carve_again = true;
-				break;
-			}
-
-			if (carve_again) {
-				/* The list changed, we need to start over */
-				break;
-			}
-		}
-	} while (carve_again);
-
-	if (overlap_only_ram && (carved_pages != pages)) {
-		/*
-		 * The payload wanted to have RAM overlaps, but we overlapped
-		 * with an unallocated region. Error out.
-		 */
-		return EFI_NO_MAPPING;
-	}
-
-	/* Add our new map */
-        list_add_tail(&newlist->link, &efi_mem);
-
-	/* And make sure memory is listed in descending order */
-	efi_mem_sort();
+	/* Remove what we overlap, then add our new map */
+	efi_mem_carve_out(start, end, &spare);
+	free(spare);
+	efi_mem_insert(newlist);
+	efi_mem_merge(newlist);
 
 	/* Notify that the memory map was changed */
 	list_for_each_entry(evt, &efi_events, link) {
@@ -384,64 +429,67 @@ efi_status_t efi_add_memory_map(u64 start, u64 size, int memory_type)
  */
 static efi_status_t efi_check_allocated(u64 addr, bool must_be_allocated)
 {
-	struct efi_mem_list *item;
-
-	list_for_each_entry(item, &efi_mem, link) {
-		u64 start = item->desc.physical_start;
-		u64 end = start + (item->desc.num_pages << EFI_PAGE_SHIFT);
-
-		if (addr >= start && addr < end) {
-			if (must_be_allocated ^
-			    (item->desc.type == EFI_CONVENTIONAL_MEMORY))
-				return EFI_SUCCESS;
-			else
-				return EFI_NOT_FOUND;
+	struct efi_mem_list *item = efi_mem_lookup(addr);
+
+	if (!item || addr < item->desc.physical_start)
+		return EFI_NOT_FOUND;
+
+	if (must_be_allocated ^ (item->desc.type == EFI_CONVENTIONAL_MEMORY))
+		return EFI_SUCCESS;
+	else
+		return EFI_NOT_FOUND;
+}
+
+/**
+ * efi_find_free_node() - find the highest free range below a limit
+ *
+ * @node:	subtree to search
+ * @pages:	number of pages needed
+ * @max_addr:	page aligned limit for the end of the range
+ * Return:	start address of the range, 0 if there is none
+ *
+ * Subtrees without a large enough free entry are skipped, as are the right
+ * subtrees of entries starting at or above @max_addr.
+ */
+static u64 efi_find_free_node(struct rb_node *node, u64 pages, u64 max_addr)
+{
+	while (node) {
+		struct efi_mem_list *mem;
+		u64 end, ret;
+
+		mem = rb_entry(node, struct efi_mem_list, node);
+		if (mem->max_free < pages)
+			return 0;
+
+		if (mem->desc.physical_start < max_addr) {
+			/* Higher addresses first */
+			ret = efi_find_free_node(node->rb_right, pages,
+						 max_addr);
+			if (ret)
+				return ret;
+
+			end = min(max_addr, desc_get_end(&mem->desc));
+			if (efi_mem_free_pages(mem) >= pages &&
+			    end - mem->desc.physical_start >=
+			    pages << EFI_PAGE_SHIFT)
+				return end - (pages << EFI_PAGE_SHIFT);
 		}
+		node = node->rb_left;
 	}
 
-	return EFI_NOT_FOUND;
+	return 0;
 }
 
 static uint64_t efi_find_free_memory(uint64_t len, uint64_t max_addr)
 {
-	struct list_head *lhandle;
-
 	/*
 	 * Prealign input max address, so we simplify our matching
 	 * logic below and can just reuse it as return pointer.
 	 */
 	max_addr &= ~EFI_PAGE_MASK;
 
-	list_for_each(lhandle, &efi_mem) {
-		struct efi_mem_list *lmem = list_entry(lhandle,
-			struct efi_mem_list, link);
-		struct efi_mem_desc *desc = &lmem->desc;
-		uint64_t desc_len = desc->num_pages << EFI_PAGE_SHIFT;
-		uint64_t desc_end = desc->physical_start + desc_len;
-		uint64_t curmax = min(max_addr, desc_end);
-		uint64_t ret = curmax - len;
-
-		/* We only take memory from free RAM */
-		if (desc->type != EFI_CONVENTIONAL_MEMORY)
-			continue;
-
-		/* Out of bounds for max_addr */
-		if ((ret + len) > max_addr)
-			continue;
-
-		/* Out of bounds for upper map limit */
-		if ((ret + len) > desc_end)
-			continue;
-
-		/* Out of bounds for lower map limit */
-		if (ret < desc->physical_start)
-			continue;
-
-		/* Return the highest address in this map within bounds */
-		return ret;
-	}
-
-	return 0;
+	return efi_find_free_node(efi_mem.rb_node, len >> EFI_PAGE_SHIFT,
+				  max_addr);
 }
 
 /*
@@ -541,8 +589,6 @@ efi_status_t efi_free_pages(uint64_t memory, efi_uintn_t pages)
 
 	ret = efi_add_memory_map_pg(memory, pages, EFI_CONVENTIONAL_MEMORY,
 				    false);
-	/* Merging of adjacent free regions is missing */
-
 	if (ret != EFI_SUCCESS)
 		return EFI_NOT_FOUND;
 
@@ -637,8 +683,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 				uint32_t *descriptor_version)
 {
 	efi_uintn_t map_size = 0;
-	int map_entries = 0;
-	struct list_head *lhandle;
+	struct rb_node *node;
 	efi_uintn_t provided_map_size;
 
 	if (!memory_map_size)
@@ -646,10 +691,7 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 
 	provided_map_size = *memory_map_size;
 
-	list_for_each(lhandle, &efi_mem)
-		map_entries++;
-
-	map_size = map_entries * sizeof(struct efi_mem_desc);
+	map_size = efi_mem_count * sizeof(struct efi_mem_desc);
 
 	*memory_map_size = map_size;
 
@@ -665,15 +707,12 @@ efi_status_t efi_get_memory_map(efi_uintn_t *memory_map_size,
 	if (!memory_map)
 		return EFI_INVALID_PARAMETER;
 
-	/* Copy list into array */
-	/* Return the list in ascending order */
-	memory_map = &memory_map[map_entries - 1];
-	list_for_each(lhandle, &efi_mem) {
+	/* Copy the tree into the array, highest address first */
+	for (node = rb_last(&efi_mem); node; node = rb_prev(node)) {
 		struct efi_mem_list *lmem;
 
-		lmem = list_entry(lhandle, struct efi_mem_list, link);
-		*memory_map = lmem->desc;
-		memory_map--;
+		lmem = rb_entry(node, struct efi_mem_list, node);
+		*memory_map++ = lmem->desc;
 	}
 
 	if (map_key)
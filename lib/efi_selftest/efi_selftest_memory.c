@@ -13,6 +13,7 @@
 #include <efi_selftest.h>
 
 #define EFI_ST_NUM_PAGES 8
+#define EFI_ST_NUM_ALLOCATIONS 512
 
 static const efi_guid_t fdt_guid = EFI_FDT_GUID;
 static struct efi_boot_services *boottime;
@@ -93,6 +94,88 @@ static int find_in_memory_map(efi_uintn_t map_size,
 	return EFI_ST_SUCCESS;
 }
 
+/**
+ * get_map_size() - get the size of the memory map
+ *
+ * @map_size:	size of the memory map in bytes
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int get_map_size(efi_uintn_t *map_size)
+{
+	efi_uintn_t map_key;
+	efi_uintn_t desc_size;
+	u32 desc_version;
+	efi_status_t ret;
+
+	*map_size = 0;
+	ret = boottime->get_memory_map(map_size, NULL, &map_key, &desc_size,
+				       &desc_version);
+	if (ret != EFI_BUFFER_TOO_SMALL) {
+		efi_st_error
+			("GetMemoryMap did not return EFI_BUFFER_TOO_SMALL\n");
+		return EFI_ST_FAILURE;
+	}
+	return EFI_ST_SUCCESS;
+}
+
+/**
+ * many_allocations() - allocate and free many single pages
+ *
+ * Pages of alternating memory type cannot be merged, so each allocation
+ * adds an entry to the memory map. After freeing all pages in a different
+ * order the map must have returned to its original size.
+ *
+ * Return:	EFI_ST_SUCCESS for success
+ */
+static int many_allocations(void)
+{
+	u64 pages[EFI_ST_NUM_ALLOCATIONS];
+	efi_uintn_t map_size_before;
+	efi_uintn_t map_size;
+	efi_status_t ret;
+	size_t i;
+
+	if (get_map_size(&map_size_before) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
+	for (i = 0; i < EFI_ST_NUM_ALLOCATIONS; ++i) {
+		ret = boottime->allocate_pages(EFI_ALLOCATE_ANY_PAGES,
+					       i & 1 ? EFI_LOADER_DATA :
+					       EFI_BOOT_SERVICES_DATA,
+					       1, &pages[i]);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error
+				("AllocatePages did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	if (get_map_size(&map_size) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (map_size <= map_size_before) {
+		efi_st_error("Memory map did not grow\n");
+		return EFI_ST_FAILURE;
+	}
+
+	/* Free the even pages first to split the map further */
+	for (i = 0; i < 2 * EFI_ST_NUM_ALLOCATIONS; i += 2) {
+		ret = boottime->free_pages(pages[i % EFI_ST_NUM_ALLOCATIONS +
+					   i / EFI_ST_NUM_ALLOCATIONS], 1);
+		if (ret != EFI_SUCCESS) {
+			efi_st_error("FreePages did not return EFI_SUCCESS\n");
+			return EFI_ST_FAILURE;
+		}
+	}
+
+	if (get_map_size(&map_size) != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+	if (map_size != map_size_before) {
+		efi_st_error("Memory map not restored after FreePages\n");
+		return EFI_ST_FAILURE;
+	}
+	return EFI_ST_SUCCESS;
+}
+
 /*
  * execute() - execute unit test
  *
@@ -181,6 +264,10 @@ static int execute(void)
 			("Device tree not marked as ACPI reclaim memory\n");
 		return EFI_ST_FAILURE;
 	}
+
+	if (many_allocations() != EFI_ST_SUCCESS)
+		return EFI_ST_FAILURE;
+
 	return EFI_ST_SUCCESS;
 }
 
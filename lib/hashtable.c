@@ -92,6 +92,112 @@ static int isprime(unsigned int number)
 	return number % div != 0;
 }
 
+/* Round nel up to the next prime number */
+static unsigned int next_prime(unsigned int nel)
+{
+	nel |= 1;		/* make odd */
+	while (!isprime(nel))
+		nel += 2;
+
+	return nel;
+}
+
+/*
+ * FNV-1a hash of the key. The shift-and-add hash used before only took
+ * the first eight characters into account, so families of variables like
+ * "boot_a_left" / "boot_a_tries" all ended up on the same probe chain.
+ */
+static unsigned int hash_key(const char *key)
+{
+	unsigned int hash = 2166136261U;
+
+	while (*key) {
+		hash ^= (unsigned char)*key++;
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+/* First hash function: simply take the modulus but prevent zero */
+static unsigned int hash_first(unsigned int hash, unsigned int size)
+{
+	unsigned int idx = hash % size;
+
+	return idx ? idx : 1;
+}
+
+/* Second hash function: as suggested in [Knuth] */
+static unsigned int hash_step(unsigned int hash, unsigned int size)
+{
+	return 1 + hash % (size - 2);
+}
+
+/*
+ * Move to the next slot of a probe chain. Because the size is prime this
+ * guarantees to step through all available indices.
+ */
+static unsigned int hash_next(unsigned int idx, unsigned int step,
+			      unsigned int size)
+{
+	if (idx <= step)
+		return size + idx - step;
+
+	return idx - step;
+}
+
+/*
+ * The table keeps an index of its entries sorted by key, so that exporting
+ * the environment does not need to gather and sort all entries each time.
+ * Single insertions and deletions update the index in place. Bulk imports
+ * just mark it as unsorted, and it is then rebuilt once, on the next export.
+ */
+
+/* Find the position of key in the first n entries of the sorted index */
+static unsigned int hsorted_pos(struct hsearch_data *htab, unsigned int n,
+				const char *key)
+{
+	unsigned int lo = 0, hi = n;
+
+	while (lo < hi) {
+		unsigned int mid = lo + (hi - lo) / 2;
+
+		if (strcmp(htab->sorted[mid]->entry.key, key) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+/* Add a new entry to the index; htab->filled does not yet include it */
+static void hsorted_add(struct hsearch_data *htab, struct env_entry_node *node)
+{
+	unsigned int pos;
+
+	if (htab->unsorted)
+		return;
+
+	pos = hsorted_pos(htab, htab->filled, node->entry.key);
+	memmove(&htab->sorted[pos + 1], &htab->sorted[pos],
+		(htab->filled - pos) * sizeof(htab->sorted[0]));
+	htab->sorted[pos] = node;
+}
+
+/* Drop an entry from the index; htab->filled still includes it */
+static void hsorted_del(struct hsearch_data *htab, struct env_entry_node *node)
+{
+	unsigned int pos;
+
+	if (htab->unsorted)
+		return;
+
+	pos = hsorted_pos(htab, htab->filled, node->entry.key);
+	memmove(&htab->sorted[pos], &htab->sorted[pos + 1],
+		(htab->filled - pos - 1) * sizeof(htab->sorted[0]));
+}
+
 /*
  * Before using the hash table we must allocate memory for it.
  * Test for an existing table are done. We allocate one element
@@ -116,17 +222,22 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	}
 
 	/* Change nel to the first prime number not smaller as nel. */
-	nel |= 1;		/* make odd */
-	while (!isprime(nel))
-		nel += 2;
-
-	htab->size = nel;
+	htab->size = next_prime(nel);
+	htab->min_size = htab->size;
 	htab->filled = 0;
+	htab->deleted = 0;
+	htab->cb_depth = 0;
 
 	/* allocate memory and zero out */
 	htab->table = (struct env_entry_node *)calloc(htab->size + 1,
 						sizeof(struct env_entry_node));
-	if (htab->table == NULL) {
+	htab->sorted = malloc(htab->size * sizeof(htab->sorted[0]));
+	htab->unsorted = false;
+	if (htab->table == NULL || htab->sorted == NULL) {
+		free(htab->table);
+		free(htab->sorted);
+		htab->table = NULL;
+		htab->sorted = NULL;
 		__set_errno(ENOMEM);
 		return 0;
 	}
@@ -135,6 +246,59 @@ int hcreate_r(size_t nel, struct hsearch_data *htab)
 	return 1;
 }
 
+/*
+ * Move all entries into a new table with room for at least nel entries.
+ * This also drops the deleted markers, which would otherwise lengthen the
+ * probe chains. On allocation failure the old table is kept as it is.
+ */
+static int hresize_r(struct hsearch_data *htab, unsigned int nel)
+{
+	struct env_entry_node *table, **sorted;
+	unsigned int size, i, n;
+
+	size = next_prime(nel);
+	table = calloc(size + 1, sizeof(struct env_entry_node));
+	sorted = malloc(size * sizeof(sorted[0]));
+	if (!table || !sorted) {
+		free(table);
+		free(sorted);
+		return 0;
+	}
+
+	/* Walk the entries in key order, if known, to carry the index over */
+	for (i = 1, n = 0; i <= htab->size; ++i) {
+		struct env_entry_node *node = &htab->table[i];
+		unsigned int hash, hval, step, idx;
+
+		if (!htab->unsorted)
+			node = n < htab->filled ? htab->sorted[n] : NULL;
+		else if (node->used <= 0)
+			continue;
+		if (!node)
+			break;
+
+		hash = hash_key(node->entry.key);
+		hval = hash_first(hash, size);
+		step = hash_step(hash, size);
+		for (idx = hval; table[idx].used; idx = hash_next(idx, step, size))
+			;
+		table[idx] = *node;
+		table[idx].used = hval;
+		sorted[n++] = &table[idx];
+	}
+
+	debug("hresize: %u -> %u slots for %u entries\n", htab->size, size,
+	      htab->filled);
+	free(htab->table);
+	free(htab->sorted);
+	htab->table = table;
+	htab->sorted = sorted;
+	htab->size = size;
+	htab->deleted = 0;
+
+	return 1;
+}
+
 
 /*
  * hdestroy()
@@ -165,6 +329,8 @@ void hdestroy_r(struct hsearch_data *htab)
 		}
 	}
 	free(htab->table);
+	free(htab->sorted);
+	htab->sorted = NULL;
 
 	/* the sign for an existing table is an value != NULL in htable */
 	htab->table = NULL;
@@ -227,13 +393,25 @@ int hmatch_r(const char *match, int last_idx, struct env_entry **retval,
 	return 0;
 }
 
+/*
+ * Run the callback of an entry. The callback may in turn change other
+ * variables, so the table must not be resized while it runs: the caller
+ * still holds an index into it.
+ */
 static int
-do_callback(const struct env_entry *e, const char *name, const char *value,
-	    enum env_op op, int flags)
+do_callback(struct hsearch_data *htab, const struct env_entry *e,
+	    const char *name, const char *value, enum env_op op, int flags)
 {
 #ifndef CONFIG_SPL_BUILD
-	if (e->callback)
-		return e->callback(name, value, op, flags);
+	int ret;
+
+	if (e->callback) {
+		htab->cb_depth++;
+		ret = e->callback(name, value, op, flags);
+		htab->cb_depth--;
+
+		return ret;
+	}
 #endif
 	return 0;
 }
@@ -263,7 +441,7 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 			}
 
 			/* If there is a callback, call it */
-			if (do_callback(&htab->table[idx].entry, item.key,
+			if (do_callback(htab, &htab->table[idx].entry, item.key,
 					item.data, env_op_overwrite, flag)) {
 				debug("callback() rejected setting variable "
 					"%s, skipping it!\n", item.key);
@@ -291,28 +469,13 @@ static inline int _compare_and_overwrite_entry(struct env_entry item,
 int hsearch_r(struct env_entry item, enum env_action action,
 	      struct env_entry **retval, struct hsearch_data *htab, int flag)
 {
+	unsigned int hash = hash_key(item.key);
 	unsigned int hval;
-	unsigned int count;
-	unsigned int len = strlen(item.key);
 	unsigned int idx;
 	unsigned int first_deleted = 0;
 	int ret;
 
-	/* Compute an value for the given string. Perhaps use a better method. */
-	hval = len;
-	count = len;
-	while (count-- > 0) {
-		hval <<= 4;
-		hval += item.key[count];
-	}
-
-	/*
-	 * First hash function:
-	 * simply take the modul but prevent zero.
-	 */
-	hval %= htab->size;
-	if (hval == 0)
-		++hval;
+	hval = hash_first(hash, htab->size);
 
 	/* The first index tried. */
 	idx = hval;
@@ -333,21 +496,10 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		if (ret != -1)
 			return ret;
 
-		/*
-		 * Second hash function:
-		 * as suggested in [Knuth]
-		 */
-		hval2 = 1 + hval % (htab->size - 2);
+		hval2 = hash_step(hash, htab->size);
 
 		do {
-			/*
-			 * Because SIZE is prime this guarantees to
-			 * step through all available indices.
-			 */
-			if (idx <= hval2)
-				idx = htab->size + idx - hval2;
-			else
-				idx -= hval2;
+			idx = hash_next(idx, hval2, htab->size);
 
 			/*
 			 * If we visited all entries leave the loop
@@ -371,6 +523,29 @@ int hsearch_r(struct env_entry item, enum env_action action,
 
 	/* An empty bucket has been found. */
 	if (action == ENV_ENTER) {
+		/*
+		 * Keep the table (including deleted markers) below 3/4 full so
+		 * that probe chains stay short: grow it when the entries take
+		 * up more than half of it, otherwise just rehash it in place
+		 * to get rid of the deleted markers.
+		 */
+		if (!htab->cb_depth &&
+		    (htab->filled + htab->deleted + 1) * 4 > htab->size * 3) {
+			unsigned int nel = htab->size;
+
+			if ((htab->filled + 1) * 2 > htab->size)
+				nel *= 2;
+			if (hresize_r(htab, nel)) {
+				unsigned int step = hash_step(hash, htab->size);
+
+				hval = hash_first(hash, htab->size);
+				for (idx = hval; htab->table[idx].used;
+				     idx = hash_next(idx, step, htab->size))
+					;
+				first_deleted = 0;
+			}
+		}
+
 		/*
 		 * If table is full and another entry should be
 		 * entered return with error.
@@ -385,8 +560,10 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		 * Create new entry;
 		 * create copies of item.key and item.data
 		 */
-		if (first_deleted)
+		if (first_deleted) {
 			idx = first_deleted;
+			--htab->deleted;
+		}
 
 		htab->table[idx].used = hval;
 		htab->table[idx].entry.key = strdup(item.key);
@@ -398,6 +575,7 @@ int hsearch_r(struct env_entry item, enum env_action action,
 			return 0;
 		}
 
+		hsorted_add(htab, &htab->table[idx]);
 		++htab->filled;
 
 		/* This is a new entry, so look up a possible callback */
@@ -417,8 +595,8 @@ int hsearch_r(struct env_entry item, enum env_action action,
 		}
 
 		/* If there is a callback, call it */
-		if (do_callback(&htab->table[idx].entry, item.key, item.data,
-				env_op_create, flag)) {
+		if (do_callback(htab, &htab->table[idx].entry, item.key,
+				item.data, env_op_create, flag)) {
 			debug("callback() rejected setting variable "
 				"%s, skipping it!\n", item.key);
 			_hdelete(item.key, htab, &htab->table[idx].entry, idx);
@@ -453,12 +631,14 @@ static void _hdelete(const char *key, struct hsearch_data *htab,
 {
 	/* free used entry */
 	debug("hdelete: DELETING key \"%s\"\n", key);
+	hsorted_del(htab, &htab->table[idx]);
 	free((void *)ep->key);
 	free(ep->data);
 	ep->flags = 0;
 	htab->table[idx].used = USED_DELETED;
 
 	--htab->filled;
+	++htab->deleted;
 }
 
 int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
@@ -486,7 +666,7 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 	}
 
 	/* If there is a callback, call it */
-	if (do_callback(&htab->table[idx].entry, key, NULL,
+	if (do_callback(htab, &htab->table[idx].entry, key, NULL,
 			env_op_delete, flag)) {
 		debug("callback() rejected deleting variable "
 			"%s, skipping it!\n", key);
@@ -496,6 +676,16 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 
 	_hdelete(key, htab, ep, idx);
 
+	/* Give memory back once the table is mostly empty */
+	if (!htab->cb_depth && htab->size > htab->min_size &&
+	    htab->filled * 8 < htab->size) {
+		unsigned int nel = htab->size / 2;
+
+		if (nel < htab->min_size)
+			nel = htab->min_size;
+		hresize_r(htab, nel);
+	}
+
 	return 1;
 }
 
@@ -544,10 +734,23 @@ int hdelete_r(const char *key, struct hsearch_data *htab, int flag)
 
 static int cmpkey(const void *p1, const void *p2)
 {
-	struct env_entry *e1 = *(struct env_entry **)p1;
-	struct env_entry *e2 = *(struct env_entry **)p2;
+	struct env_entry_node *n1 = *(struct env_entry_node **)p1;
+	struct env_entry_node *n2 = *(struct env_entry_node **)p2;
 
-	return (strcmp(e1->key, e2->key));
+	return (strcmp(n1->entry.key, n2->entry.key));
+}
+
+/* Rebuild the sorted index after a bulk import */
+static void hsorted_rebuild(struct hsearch_data *htab)
+{
+	unsigned int i, n;
+
+	for (i = 1, n = 0; i <= htab->size; ++i) {
+		if (htab->table[i].used > 0)
+			htab->sorted[n++] = &htab->table[i];
+	}
+	qsort(htab->sorted, n, sizeof(htab->sorted[0]), cmpkey);
+	htab->unsorted = false;
 }
 
 static int match_string(int flag, const char *str, const char *pat, void *priv)
@@ -608,11 +811,24 @@ static int match_entry(struct env_entry *ep, int flag, int argc,
 	return 0;
 }
 
+/* Check whether an entry is to be included in the export */
+static int export_entry(struct env_entry *ep, int flag, int argc,
+			char *const argv[])
+{
+	if (argc > 0 && !match_entry(ep, flag, argc, argv))
+		return 0;
+
+	if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
+		return 0;
+
+	return 1;
+}
+
 ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		 char **resp, size_t size,
 		 int argc, char *const argv[])
 {
-	struct env_entry *list[htab->size];
+	struct env_entry **list;
 	char *res, *p;
 	size_t totlen;
 	int i, n;
@@ -625,61 +841,53 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 
 	debug("EXPORT  table = %p, htab.size = %d, htab.filled = %d, size = %lu\n",
 	      htab, htab->size, htab->filled, (ulong)size);
-	/*
-	 * Pass 1:
-	 * search used entries,
-	 * save addresses and compute total length
-	 */
-	for (i = 1, n = 0, totlen = 0; i <= htab->size; ++i) {
 
-		if (htab->table[i].used > 0) {
-			struct env_entry *ep = &htab->table[i].entry;
-			int found = match_entry(ep, flag, argc, argv);
+	if (htab->unsorted)
+		hsorted_rebuild(htab);
 
-			if ((argc > 0) && (found == 0))
-				continue;
+	/* Matching may compile a regex per entry, so only do it once */
+	list = malloc((htab->filled + 1) * sizeof(*list));
+	if (!list) {
+		__set_errno(ENOMEM);
+		return (-1);
+	}
 
-			if ((flag & H_HIDE_DOT) && ep->key[0] == '.')
-				continue;
+	/*
+	 * Pass 1:
+	 * walk the sorted index, pick the entries to export and compute the
+	 * total length
+	 */
+	for (i = 0, n = 0, totlen = 0; i < htab->filled; ++i) {
+		struct env_entry *ep = &htab->sorted[i]->entry;
 
-			list[n++] = ep;
+		if (!export_entry(ep, flag, argc, argv))
+			continue;
+		list[n++] = ep;
 
-			totlen += strlen(ep->key);
+		totlen += strlen(ep->key);
 
-			if (sep == '\0') {
-				totlen += strlen(ep->data);
-			} else {	/* check if escapes are needed */
-				char *s = ep->data;
+		if (sep == '\0') {
+			totlen += strlen(ep->data);
+		} else {	/* check if escapes are needed */
+			char *s = ep->data;
 
-				while (*s) {
+			while (*s) {
+				++totlen;
+				/* add room for needed escape chars */
+				if ((*s == sep) || (*s == '\\'))
 					++totlen;
-					/* add room for needed escape chars */
-					if ((*s == sep) || (*s == '\\'))
-						++totlen;
-					++s;
-				}
+				++s;
 			}
-			totlen += 2;	/* for '=' and 'sep' char */
 		}
+		totlen += 2;	/* for '=' and 'sep' char */
 	}
 
-#ifdef DEBUG
-	/* Pass 1a: print unsorted list */
-	printf("Unsorted: n=%d\n", n);
-	for (i = 0; i < n; ++i) {
-		printf("\t%3d: %p ==> %-10s => %s\n",
-		       i, list[i], list[i]->key, list[i]->data);
-	}
-#endif
-
-	/* Sort list by keys */
-	qsort(list, n, sizeof(struct env_entry *), cmpkey);
-
 	/* Check if the user supplied buffer size is sufficient */
 	if (size) {
 		if (size < totlen + 1) {	/* provided buffer too small */
 			printf("Env export buffer too small: %lu, but need %lu\n",
 			       (ulong)size, (ulong)totlen + 1);
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
@@ -696,23 +904,25 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		/* no, allocate and clear one */
 		*resp = res = calloc(1, size);
 		if (res == NULL) {
+			free(list);
 			__set_errno(ENOMEM);
 			return (-1);
 		}
 	}
 	/*
 	 * Pass 2:
-	 * export sorted list of result data
+	 * export the entries picked in pass 1, in sorted order
 	 */
 	for (i = 0, p = res; i < n; ++i) {
+		struct env_entry *ep = list[i];
 		const char *s;
 
-		s = list[i]->key;
+		s = ep->key;
 		while (*s)
 			*p++ = *s++;
 		*p++ = '=';
 
-		s = list[i]->data;
+		s = ep->data;
 
 		while (*s) {
 			if ((*s == sep) || (*s == '\\'))
@@ -722,6 +932,7 @@ ssize_t hexport_r(struct hsearch_data *htab, const char sep, int flag,
 		*p++ = sep;
 	}
 	*p = '\0';		/* terminate result */
+	free(list);
 
 	return size;
 }
@@ -760,6 +971,25 @@ static int drop_var_from_set(const char *name, int nvars, char * vars[])
 	return res;
 }
 
+/*
+ * Count the "name=value" pairs in linearized data. This is only a hint for
+ * sizing a new table, so escaped separators are not taken into account.
+ */
+static int himport_count(const char *data, size_t size, const char sep)
+{
+	const char *dp = data;
+	int n = 0;
+
+	while (dp < data + size && *dp) {
+		++n;
+		while (dp < data + size && *dp && *dp != sep)
+			++dp;
+		++dp;
+	}
+
+	return n;
+}
+
 /*
  * Import linearized data into hash table.
  *
@@ -858,16 +1088,31 @@ int himport_r(struct hsearch_data *htab,
 
 	if (!htab->table) {
 		int nent = CONFIG_ENV_MIN_ENTRIES + size / 8;
+		int count = himport_count(data, size, sep);
 
 		if (nent > CONFIG_ENV_MAX_ENTRIES)
 			nent = CONFIG_ENV_MAX_ENTRIES;
 
+		/*
+		 * The table grows as needed, but make room for all of the
+		 * imported entries up front so that a large environment does
+		 * not get rehashed several times on the way in.
+		 */
+		if (nent < count * 2)
+			nent = count * 2;
+
 		debug("Create Hash Table: N=%d\n", nent);
 
 		if (hcreate_r(nent, htab) == 0) {
 			free(data);
 			return 0;
 		}
+
+		/*
+		 * Filling a new table, so sort the index once on the next
+		 * export instead of inserting into it entry by entry
+		 */
+		htab->unsorted = true;
 	}
 
 	if (!size) {
@@ -1014,3 +1259,37 @@ int hwalk_r(struct hsearch_data *htab, int (*callback)(struct env_entry *entry))
 
 	return 0;
 }
+
+/*
+ * Collect load and probe length statistics. The probe length of an entry
+ * is the number of slots a lookup of its key visits, so 1 means a direct
+ * hit.
+ */
+void hstats_r(struct hsearch_data *htab, struct hsearch_stats *stats)
+{
+	unsigned int i;
+
+	memset(stats, '\0', sizeof(*stats));
+	if (!htab->table)
+		return;
+
+	stats->size = htab->size;
+	stats->filled = htab->filled;
+	stats->deleted = htab->deleted;
+	for (i = 1; i <= htab->size; ++i) {
+		unsigned int hash, step, idx, len;
+
+		if (htab->table[i].used <= 0)
+			continue;
+
+		hash = hash_key(htab->table[i].entry.key);
+		step = hash_step(hash, htab->size);
+		idx = hash_first(hash, htab->size);
+		for (len = 1; idx != i; len++)
+			idx = hash_next(idx, step, htab->size);
+
+		stats->probe_total += len;
+		if (len > stats->probe_max)
+			stats->probe_max = len;
+	}
+}
@@ -16,6 +16,8 @@
 
 void lmb_dump_all_force(struct lmb *lmb)
 {
+	struct lmb_property *mem = lmb_regions(&lmb->memory);
+	struct lmb_property *res = lmb_regions(&lmb->reserved);
 	unsigned long i;
 
 	printf("lmb_dump_all:\n");
@@ -24,9 +26,9 @@ void lmb_dump_all_force(struct lmb *lmb)
 	       (unsigned long long)lmb->memory.size);
 	for (i = 0; i < lmb->memory.cnt; i++) {
 		printf("    memory.reg[0x%lx].base   = 0x%llx\n", i,
-		       (unsigned long long)lmb->memory.region[i].base);
+		       (unsigned long long)mem[i].base);
 		printf("		   .size   = 0x%llx\n",
-		       (unsigned long long)lmb->memory.region[i].size);
+		       (unsigned long long)mem[i].size);
 	}
 
 	printf("\n    reserved.cnt	   = 0x%lx\n", lmb->reserved.cnt);
@@ -34,9 +36,9 @@ void lmb_dump_all_force(struct lmb *lmb)
 	       (unsigned long long)lmb->reserved.size);
 	for (i = 0; i < lmb->reserved.cnt; i++) {
 		printf("    reserved.reg[0x%lx].base = 0x%llx\n", i,
-		       (unsigned long long)lmb->reserved.region[i].base);
+		       (unsigned long long)res[i].base);
 		printf("		     .size = 0x%llx\n",
-		       (unsigned long long)lmb->reserved.region[i].size);
+		       (unsigned long long)res[i].size);
 	}
 }
 
@@ -67,42 +69,87 @@ static long lmb_addrs_adjacent(phys_addr_t base1, phys_size_t size1,
 	return 0;
 }
 
-static long lmb_regions_adjacent(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+/*
+ * Find the first region whose base is above base. The region before it, if
+ * any, is then the only one which can contain base.
+ */
+static unsigned long lmb_search(struct lmb_region *rgn, phys_addr_t base)
 {
-	phys_addr_t base1 = rgn->region[r1].base;
-	phys_size_t size1 = rgn->region[r1].size;
-	phys_addr_t base2 = rgn->region[r2].base;
-	phys_size_t size2 = rgn->region[r2].size;
+	struct lmb_property *region = lmb_regions(rgn);
+	unsigned long lo = 0, hi = rgn->cnt;
+
+	while (lo < hi) {
+		unsigned long mid = lo + (hi - lo) / 2;
+
+		if (region[mid].base <= base)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
 
-	return lmb_addrs_adjacent(base1, size1, base2, size2);
+	return lo;
 }
 
-static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+/* Make room for one more region, moving the list to the heap if needed */
+static int lmb_grow_region(struct lmb_region *rgn)
 {
-	unsigned long i;
+	struct lmb_property *region;
+	unsigned long max;
+
+	if (rgn->cnt < rgn->max)
+		return 0;
 
-	for (i = r; i < rgn->cnt - 1; i++) {
-		rgn->region[i].base = rgn->region[i + 1].base;
-		rgn->region[i].size = rgn->region[i + 1].size;
+	max = rgn->max * 2;
+	if (!rgn->heap) {
+		region = malloc(max * sizeof(*region));
+		if (region)
+			memcpy(region, rgn->initial,
+			       rgn->cnt * sizeof(*region));
+	} else {
+		region = realloc(rgn->heap, max * sizeof(*region));
 	}
+	if (!region)
+		return -ENOMEM;
+
+	rgn->heap = region;
+	rgn->max = max;
+
+	return 0;
+}
+
+static void lmb_remove_region(struct lmb_region *rgn, unsigned long r)
+{
+	struct lmb_property *region = lmb_regions(rgn);
+
+	memmove(&region[r], &region[r + 1],
+		(rgn->cnt - r - 1) * sizeof(region[0]));
 	rgn->cnt--;
 }
 
-/* Assumption: base addr of region 1 < base addr of region 2 */
-static void lmb_coalesce_regions(struct lmb_region *rgn, unsigned long r1,
-				 unsigned long r2)
+static void lmb_init_region(struct lmb_region *rgn)
+{
+	rgn->cnt = 0;
+	rgn->max = LMB_INITIAL_REGIONS;
+	rgn->size = 0;
+	rgn->heap = NULL;
+}
+
+static void lmb_uninit_region(struct lmb_region *rgn)
 {
-	rgn->region[r1].size += rgn->region[r2].size;
-	lmb_remove_region(rgn, r2);
+	free(rgn->heap);
+	lmb_init_region(rgn);
 }
 
 void lmb_init(struct lmb *lmb)
 {
-	lmb->memory.cnt = 0;
-	lmb->memory.size = 0;
-	lmb->reserved.cnt = 0;
-	lmb->reserved.size = 0;
+	lmb_init_region(&lmb->memory);
+	lmb_init_region(&lmb->reserved);
+}
+
+void lmb_uninit(struct lmb *lmb)
+{
+	lmb_uninit_region(&lmb->memory);
+	lmb_uninit_region(&lmb->reserved);
 }
 
 static void lmb_reserve_common(struct lmb *lmb, void *fdt_blob)
@@ -148,68 +195,56 @@ void lmb_init_and_reserve_range(struct lmb *lmb, phys_addr_t base,
 /* This routine called with relocation disabled. */
 static long lmb_add_region(struct lmb_region *rgn, phys_addr_t base, phys_size_t size)
 {
-	unsigned long coalesced = 0;
-	long adjacent, i;
+	struct lmb_property *region = lmb_regions(rgn);
+	struct lmb_property *prev = NULL, *next = NULL;
+	unsigned long i;
 
-	if (rgn->cnt == 0) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
-		rgn->cnt = 1;
+	/*
+	 * Since the regions are sorted and do not overlap, only the two
+	 * regions around base can overlap with or be adjacent to the new one.
+	 */
+	i = lmb_search(rgn, base);
+	if (i > 0)
+		prev = &region[i - 1];
+	if (i < rgn->cnt)
+		next = &region[i];
+
+	if (prev && prev->base == base && prev->size == size)
+		/* Already have this region, so we're done */
 		return 0;
-	}
-
-	/* First try and coalesce this LMB with another. */
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-
-		if ((rgnbase == base) && (rgnsize == size))
-			/* Already have this region, so we're done */
-			return 0;
-
-		adjacent = lmb_addrs_adjacent(base, size, rgnbase, rgnsize);
-		if (adjacent > 0) {
-			rgn->region[i].base -= size;
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (adjacent < 0) {
-			rgn->region[i].size += size;
-			coalesced++;
-			break;
-		} else if (lmb_addrs_overlap(base, size, rgnbase, rgnsize)) {
-			/* regions overlap */
-			return -1;
-		}
-	}
-
-	if ((i < rgn->cnt - 1) && lmb_regions_adjacent(rgn, i, i + 1)) {
-		lmb_coalesce_regions(rgn, i, i + 1);
-		coalesced++;
-	}
 
-	if (coalesced)
-		return coalesced;
-	if (rgn->cnt >= MAX_LMB_REGIONS)
+	if ((prev && lmb_addrs_overlap(base, size, prev->base, prev->size)) ||
+	    (next && lmb_addrs_overlap(base, size, next->base, next->size)))
+		/* regions overlap */
 		return -1;
 
-	/* Couldn't coalesce the LMB, so add it to the sorted table. */
-	for (i = rgn->cnt-1; i >= 0; i--) {
-		if (base < rgn->region[i].base) {
-			rgn->region[i + 1].base = rgn->region[i].base;
-			rgn->region[i + 1].size = rgn->region[i].size;
-		} else {
-			rgn->region[i + 1].base = base;
-			rgn->region[i + 1].size = size;
-			break;
+	/* Try to coalesce this LMB with the regions on either side */
+	if (prev && lmb_addrs_adjacent(base, size, prev->base,
+				       prev->size) < 0) {
+		prev->size += size;
+		if (next && lmb_addrs_adjacent(prev->base, prev->size,
+					       next->base, next->size) > 0) {
+			prev->size += next->size;
+			lmb_remove_region(rgn, i);
+			return 2;
 		}
+		return 1;
 	}
-
-	if (base < rgn->region[0].base) {
-		rgn->region[0].base = base;
-		rgn->region[0].size = size;
+	if (next && lmb_addrs_adjacent(base, size, next->base,
+				       next->size) > 0) {
+		next->base = base;
+		next->size += size;
+		return 1;
 	}
 
+	/* Couldn't coalesce the LMB, so add it to the sorted table. */
+	if (lmb_grow_region(rgn))
+		return -1;
+	region = lmb_regions(rgn);
+	memmove(&region[i + 1], &region[i],
+		(rgn->cnt - i) * sizeof(region[0]));
+	region[i].base = base;
+	region[i].size = size;
 	rgn->cnt++;
 
 	return 0;
@@ -226,23 +261,21 @@ long lmb_add(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
 	struct lmb_region *rgn = &(lmb->reserved);
+	struct lmb_property *region = lmb_regions(rgn);
 	phys_addr_t rgnbegin, rgnend;
 	phys_addr_t end = base + size - 1;
-	int i;
-
-	rgnbegin = rgnend = 0; /* supress gcc warnings */
+	unsigned long i;
 
 	/* Find the region where (base, size) belongs to */
-	for (i = 0; i < rgn->cnt; i++) {
-		rgnbegin = rgn->region[i].base;
-		rgnend = rgnbegin + rgn->region[i].size - 1;
-
-		if ((rgnbegin <= base) && (end <= rgnend))
-			break;
-	}
+	i = lmb_search(rgn, base);
+	if (i == 0)
+		return -1;
+	i--;
+	rgnbegin = region[i].base;
+	rgnend = rgnbegin + region[i].size - 1;
 
 	/* Didn't find the region */
-	if (i == rgn->cnt)
+	if (end > rgnend)
 		return -1;
 
 	/* Check to see if we are removing entire region */
@@ -253,14 +286,14 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 
 	/* Check to see if region is matching at the front */
 	if (rgnbegin == base) {
-		rgn->region[i].base = end + 1;
-		rgn->region[i].size -= size;
+		region[i].base = end + 1;
+		region[i].size -= size;
 		return 0;
 	}
 
 	/* Check to see if the region is matching at the end */
 	if (rgnend == end) {
-		rgn->region[i].size -= size;
+		region[i].size -= size;
 		return 0;
 	}
 
@@ -268,7 +301,7 @@ long lmb_free(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 	 * We need to split the entry -  adjust the current one to the
 	 * beginging of the hole and add the region after hole.
 	 */
-	rgn->region[i].size = base - rgn->region[i].base;
+	region[i].size = base - region[i].base;
 	return lmb_add_region(rgn, end + 1, rgnend - end);
 }
 
@@ -282,16 +315,18 @@ long lmb_reserve(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 static long lmb_overlaps_region(struct lmb_region *rgn, phys_addr_t base,
 				phys_size_t size)
 {
-	unsigned long i;
-
-	for (i = 0; i < rgn->cnt; i++) {
-		phys_addr_t rgnbase = rgn->region[i].base;
-		phys_size_t rgnsize = rgn->region[i].size;
-		if (lmb_addrs_overlap(base, size, rgnbase, rgnsize))
-			break;
-	}
-
-	return (i < rgn->cnt) ? i : -1;
+	struct lmb_property *region = lmb_regions(rgn);
+	unsigned long i = lmb_search(rgn, base);
+
+	/* Only the regions either side of base can overlap */
+	if (i > 0 && lmb_addrs_overlap(base, size, region[i - 1].base,
+				       region[i - 1].size))
+		return i - 1;
+	if (i < rgn->cnt && lmb_addrs_overlap(base, size, region[i].base,
+					      region[i].size))
+		return i;
+
+	return -1;
 }
 
 phys_addr_t lmb_alloc(struct lmb *lmb, phys_size_t size, ulong align)
@@ -319,13 +354,14 @@ static phys_addr_t lmb_align_down(phys_addr_t addr, phys_size_t size)
 
 phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phys_addr_t max_addr)
 {
+	struct lmb_property *mem = lmb_regions(&lmb->memory);
 	long i, rgn;
 	phys_addr_t base = 0;
 	phys_addr_t res_base;
 
 	for (i = lmb->memory.cnt - 1; i >= 0; i--) {
-		phys_addr_t lmbbase = lmb->memory.region[i].base;
-		phys_size_t lmbsize = lmb->memory.region[i].size;
+		phys_addr_t lmbbase = mem[i].base;
+		phys_size_t lmbsize = mem[i].size;
 
 		if (lmbsize < size)
 			continue;
@@ -349,7 +385,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
 					return 0;
 				return base;
 			}
-			res_base = lmb->reserved.region[rgn].base;
+			res_base = lmb_regions(&lmb->reserved)[rgn].base;
 			if (res_base < size)
 				break;
 			base = lmb_align_down(res_base - size, align);
@@ -364,6 +400,7 @@ phys_addr_t __lmb_alloc_base(struct lmb *lmb, phys_size_t size, ulong align, phy
  */
 phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 {
+	struct lmb_property *mem = lmb_regions(&lmb->memory);
 	long rgn;
 
 	/* Check if the requested address is in one of the memory regions */
@@ -373,8 +410,7 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 		 * Check if the requested end address is in the same memory
 		 * region we found.
 		 */
-		if (lmb_addrs_overlap(lmb->memory.region[rgn].base,
-				      lmb->memory.region[rgn].size,
+		if (lmb_addrs_overlap(mem[rgn].base, mem[rgn].size,
 				      base + size - 1, 1)) {
 			/* ok, reserve the memory */
 			if (lmb_reserve(lmb, base, size) >= 0)
@@ -387,41 +423,33 @@ phys_addr_t lmb_alloc_addr(struct lmb *lmb, phys_addr_t base, phys_size_t size)
 /* Return number of bytes from a given address that are free */
 phys_size_t lmb_get_free_size(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
+	struct lmb_property *mem = lmb_regions(&lmb->memory);
+	struct lmb_property *res = lmb_regions(&lmb->reserved);
+	unsigned long i;
 	long rgn;
 
 	/* check if the requested address is in the memory regions */
 	rgn = lmb_overlaps_region(&lmb->memory, addr, 1);
 	if (rgn >= 0) {
-		for (i = 0; i < lmb->reserved.cnt; i++) {
-			if (addr < lmb->reserved.region[i].base) {
-				/* first reserved range > requested address */
-				return lmb->reserved.region[i].base - addr;
-			}
-			if (lmb->reserved.region[i].base +
-			    lmb->reserved.region[i].size > addr) {
-				/* requested addr is in this reserved range */
-				return 0;
-			}
+		i = lmb_search(&lmb->reserved, addr);
+		if (i > 0 && res[i - 1].base + res[i - 1].size > addr) {
+			/* requested addr is in this reserved range */
+			return 0;
+		}
+		if (i < lmb->reserved.cnt) {
+			/* first reserved range > requested address */
+			return res[i].base - addr;
 		}
 		/* if we come here: no reserved ranges above requested addr */
-		return lmb->memory.region[lmb->memory.cnt - 1].base +
-		       lmb->memory.region[lmb->memory.cnt - 1].size - addr;
+		return mem[lmb->memory.cnt - 1].base +
+		       mem[lmb->memory.cnt - 1].size - addr;
 	}
 	return 0;
 }
 
 int lmb_is_reserved(struct lmb *lmb, phys_addr_t addr)
 {
-	int i;
-
-	for (i = 0; i < lmb->reserved.cnt; i++) {
-		phys_addr_t upper = lmb->reserved.region[i].base +
-			lmb->reserved.region[i].size - 1;
-		if ((addr >= lmb->reserved.region[i].base) && (addr <= upper))
-			return 1;
-	}
-	return 0;
+	return lmb_overlaps_region(&lmb->reserved, addr, 1) >= 0;
 }
 
 __weak void board_lmb_reserve(struct lmb *lmb)
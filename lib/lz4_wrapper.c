@@ -7,6 +7,8 @@
 #include <compiler.h>
 #include <image.h>
 #include <lz4.h>
+#include <malloc.h>
+#include <linux/bitops.h>
 #include <linux/kernel.h>
 #include <linux/types.h>
 #include <asm/unaligned.h>
@@ -28,94 +30,303 @@ typedef uint64_t U64;
 
 #define LZ4F_BLOCKUNCOMPRESSED_FLAG 0x80000000U
 
-int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+/* Frame flags (FLG byte) */
+#define LZ4F_FLG_VERSION_SHIFT		6
+#define LZ4F_FLG_INDEPENDENT_BLOCKS	BIT(5)
+#define LZ4F_FLG_BLOCK_CHECKSUM		BIT(4)
+#define LZ4F_FLG_CONTENT_SIZE		BIT(3)
+#define LZ4F_FLG_CONTENT_CHECKSUM	BIT(2)
+
+enum lz4f_state {
+	LZ4F_HEADER,		/* gathering the frame header */
+	LZ4F_BLOCK_HEADER,	/* gathering a block header */
+	LZ4F_BLOCK_RAW,		/* copying an uncompressed block */
+	LZ4F_BLOCK,		/* gathering a compressed block */
+	LZ4F_BLOCK_CHECKSUM,	/* gathering the checksum after a block */
+	LZ4F_CONTENT_CHECKSUM,	/* gathering the checksum at the end */
+	LZ4F_DONE,
+};
+
+void lz4f_stream_init(struct lz4f_stream *ls, void *dst, size_t dst_size)
+{
+	memset(ls, '\0', sizeof(*ls));
+	ls->dst = dst;
+	ls->dst_size = dst_size;
+	ls->state = LZ4F_HEADER;
+}
+
+void lz4f_stream_end(struct lz4f_stream *ls)
+{
+	free(ls->buf);
+	ls->buf = NULL;
+	ls->buf_size = 0;
+}
+
+/**
+ * lz4f_gather() - Collect a small field which may be split across pieces
+ *
+ * @ls:		Stream state; its field_len must be zeroed once the field
+ *		is used
+ * @inp:	Input pointer, updated
+ * @leftp:	Bytes left in the input, updated
+ * @size:	Size of the field
+ * @return true if the field is complete, false if more input is needed
+ */
+static bool lz4f_gather(struct lz4f_stream *ls, const u8 **inp, size_t *leftp,
+			uint size)
+{
+	uint n;
+
+	if (ls->field_len >= size)
+		return true;
+	n = min_t(size_t, size - ls->field_len, *leftp);
+	memcpy(ls->field + ls->field_len, *inp, n);
+	ls->field_len += n;
+	*inp += n;
+	*leftp -= n;
+
+	return ls->field_len == size;
+}
+
+/**
+ * lz4f_header_size() - Check the start of the frame header
+ *
+ * @ls:		Stream state, with the first LZ4F_HEADER_START bytes of the
+ *		header in ls->field
+ * @return size of the whole header in bytes, or -ve on error (see
+ *	lz4f_stream_decode())
+ */
+static int lz4f_header_size(struct lz4f_stream *ls)
+{
+	u8 flags = ls->field[4];
+	u8 block_desc = ls->field[5];
+	int size;
+
+	/* We assume there's always only a single, standard frame. */
+	if (get_unaligned_le32(ls->field) != LZ4F_MAGIC ||
+	    flags >> LZ4F_FLG_VERSION_SHIFT != 1)
+		return -EPROTONOSUPPORT;	/* unknown format */
+	if ((flags & 0x03) || (block_desc & 0x8f) || block_desc >> 4 < 4)
+		return -EINVAL;	/* reserved bits must be zero */
+	ls->block_max = 1 << (8 + 2 * (block_desc >> 4));
+
+	/* Header checksum byte, after the optional size */
+	size = LZ4F_HEADER_START + 1;
+	if (flags & LZ4F_FLG_CONTENT_SIZE)
+		size += sizeof(u64);
+
+	return size;
+}
+
+int lz4f_block_max(const void *src)
 {
-	const void *end = dst + *dstn;
-	const void *in = src;
-	void *out = dst;
-	int has_block_checksum;
+	struct lz4f_stream ls;
 	int ret;
-	*dstn = 0;
-
-	{ /* With in-place decompression the header may become invalid later. */
-		u32 magic;
-		u8 flags, version, independent_blocks, has_content_size;
-		u8 block_desc;
-
-		if (srcn < sizeof(u32) + 3*sizeof(u8))
-			return -EINVAL;	/* input overrun */
-
-		magic = get_unaligned_le32(in);
-		in += sizeof(u32);
-		flags = *(u8 *)in;
-		in += sizeof(u8);
-		block_desc = *(u8 *)in;
-		in += sizeof(u8);
-
-		version = (flags >> 6) & 0x3;
-		independent_blocks = (flags >> 5) & 0x1;
-		has_block_checksum = (flags >> 4) & 0x1;
-		has_content_size = (flags >> 3) & 0x1;
-
-		/* We assume there's always only a single, standard frame. */
-		if (magic != LZ4F_MAGIC || version != 1)
-			return -EPROTONOSUPPORT;	/* unknown format */
-		if ((flags & 0x03) || (block_desc & 0x8f))
-			return -EINVAL;	/* reserved bits must be zero */
-		if (!independent_blocks)
-			return -EPROTONOSUPPORT; /* we can't support this yet */
-
-		if (has_content_size) {
-			if (srcn < sizeof(u32) + 3*sizeof(u8) + sizeof(u64))
-				return -EINVAL;	/* input overrun */
-			in += sizeof(u64);
-		}
-		/* Header checksum byte */
-		in += sizeof(u8);
+
+	lz4f_stream_init(&ls, NULL, 0);
+	memcpy(ls.field, src, LZ4F_HEADER_START);
+	ret = lz4f_header_size(&ls);
+	if (ret < 0)
+		return ret;
+
+	return ls.block_max;
+}
+
+/**
+ * lz4f_parse_header() - Check the frame header and set up for the first block
+ *
+ * @ls:		Stream state, with the header in ls->field
+ * @size:	Size of the header in bytes
+ * @return 0 if OK, -ve on error (see lz4f_stream_decode())
+ */
+static int lz4f_parse_header(struct lz4f_stream *ls, uint size)
+{
+	u8 flags = ls->field[4];
+
+	if ((ls->field[size - 1]) !=
+	    ((xxh32(ls->field + 4, size - 5, 0) >> 8) & 0xff))
+		return -EBADMSG;
+	if (flags & LZ4F_FLG_CONTENT_SIZE) {
+		ls->content_size = get_unaligned_le64(ls->field +
+						      LZ4F_HEADER_START);
+		if (ls->content_size > ls->dst_size)
+			return -ENOBUFS;	/* output overrun */
 	}
+	ls->flags = flags;
 
-	while (1) {
-		u32 block_header, block_size;
+	return 0;
+}
 
-		block_header = get_unaligned_le32(in);
-		in += sizeof(u32);
-		block_size = block_header & ~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+int lz4f_stream_decode(struct lz4f_stream *ls, const void *src,
+		       size_t *srcnp)
+{
+	const u8 *in = src, *block, *prefix;
+	size_t left = *srcnp, n;
+	u32 block_header;
+	uint size;
+	int ret = 0;
 
-		if (in - src + block_size > srcn) {
-			ret = -EINVAL;		/* input overrun */
+	while (ls->state != LZ4F_DONE) {
+		switch (ls->state) {
+		case LZ4F_HEADER:
+			if (!lz4f_gather(ls, &in, &left, LZ4F_HEADER_START))
+				goto out;
+			ret = lz4f_header_size(ls);
+			if (ret < 0)
+				goto out;
+			size = ret;
+			ret = 0;
+			if (!lz4f_gather(ls, &in, &left, size))
+				goto out;
+			ls->field_len = 0;
+			ret = lz4f_parse_header(ls, size);
+			if (ret)
+				goto out;
+			ls->state = LZ4F_BLOCK_HEADER;
 			break;
-		}
-
-		if (!block_size) {
-			ret = 0;	/* decompression successful */
+		case LZ4F_BLOCK_HEADER:
+			if (!lz4f_gather(ls, &in, &left, sizeof(u32)))
+				goto out;
+			ls->field_len = 0;
+			block_header = get_unaligned_le32(ls->field);
+			if (!block_header) {
+				ls->state = LZ4F_DONE;
+				if (ls->flags & LZ4F_FLG_CONTENT_CHECKSUM)
+					ls->state = LZ4F_CONTENT_CHECKSUM;
+				break;
+			}
+			ls->block_size = block_header &
+				~LZ4F_BLOCKUNCOMPRESSED_FLAG;
+			if (ls->block_size > ls->block_max) {
+				ret = -EINVAL;
+				goto out;
+			}
+			ls->block_len = 0;
+			if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
+				xxh32_reset(&ls->xxh, 0);
+				ls->state = LZ4F_BLOCK_RAW;
+			} else {
+				ls->state = LZ4F_BLOCK;
+			}
 			break;
-		}
-
-		if (block_header & LZ4F_BLOCKUNCOMPRESSED_FLAG) {
-			size_t size = min((ptrdiff_t)block_size, end - out);
-			memcpy(out, in, size);
-			out += size;
-			if (size < block_size) {
+		case LZ4F_BLOCK_RAW:
+			n = min_t(size_t, ls->block_size - ls->block_len, left);
+			if (n > ls->dst_size - ls->out) {
 				ret = -ENOBUFS;	/* output overrun */
-				break;
+				goto out;
 			}
-		} else {
+			memcpy(ls->dst + ls->out, in, n);
+			if (ls->flags & LZ4F_FLG_BLOCK_CHECKSUM)
+				xxh32_update(&ls->xxh, in, n);
+			in += n;
+			left -= n;
+			ls->out += n;
+			ls->block_len += n;
+			if (ls->block_len < ls->block_size)
+				goto out;
+			ls->block_sum = xxh32_digest(&ls->xxh);
+			ls->state = ls->flags & LZ4F_FLG_BLOCK_CHECKSUM ?
+				LZ4F_BLOCK_CHECKSUM : LZ4F_BLOCK_HEADER;
+			break;
+		case LZ4F_BLOCK:
+			if (!ls->block_len && left >= ls->block_size) {
+				/* The whole block is here, so use it there */
+				block = in;
+				in += ls->block_size;
+				left -= ls->block_size;
+			} else {
+				if (ls->buf_size < ls->block_size) {
+					free(ls->buf);
+					ls->buf_size = 0;
+					ls->buf = malloc(ls->block_size);
+					if (!ls->buf) {
+						ret = -ENOMEM;
+						goto out;
+					}
+					ls->buf_size = ls->block_size;
+				}
+				n = min_t(size_t,
+					  ls->block_size - ls->block_len, left);
+				memcpy(ls->buf + ls->block_len, in, n);
+				in += n;
+				left -= n;
+				ls->block_len += n;
+				if (ls->block_len < ls->block_size)
+					goto out;
+				block = ls->buf;
+			}
+			if (ls->flags & LZ4F_FLG_BLOCK_CHECKSUM)
+				ls->block_sum = xxh32(block, ls->block_size, 0);
+
+			/* Linked blocks may refer back to any earlier output */
+			prefix = ls->dst;
+			if (ls->flags & LZ4F_FLG_INDEPENDENT_BLOCKS)
+				prefix += ls->out;
+
 			/* constant folding essential, do not touch params! */
-			ret = LZ4_decompress_generic(in, out, block_size,
-					end - out, endOnInputSize,
-					full, 0, noDict, out, NULL, 0);
+			ret = LZ4_decompress_generic((const char *)block,
+					(char *)ls->dst + ls->out,
+					ls->block_size,
+					min_t(size_t, ls->dst_size - ls->out,
+					      INT_MAX),
+					endOnInputSize, full, 0, noDict,
+					prefix, NULL, 0);
 			if (ret < 0) {
 				ret = -EPROTO;	/* decompression error */
-				break;
+				goto out;
+			}
+			ls->out += ret;
+			ret = 0;
+			ls->state = ls->flags & LZ4F_FLG_BLOCK_CHECKSUM ?
+				LZ4F_BLOCK_CHECKSUM : LZ4F_BLOCK_HEADER;
+			break;
+		case LZ4F_BLOCK_CHECKSUM:
+			if (!lz4f_gather(ls, &in, &left, sizeof(u32)))
+				goto out;
+			ls->field_len = 0;
+			if (get_unaligned_le32(ls->field) != ls->block_sum) {
+				ret = -EBADMSG;
+				goto out;
 			}
-			out += ret;
+			ls->state = LZ4F_BLOCK_HEADER;
+			break;
+		case LZ4F_CONTENT_CHECKSUM:
+			if (!lz4f_gather(ls, &in, &left, sizeof(u32)))
+				goto out;
+			ls->field_len = 0;
+			if (IS_ENABLED(CONFIG_LZ4_CONTENT_CHECKSUM) &&
+			    get_unaligned_le32(ls->field) !=
+			    xxh32(ls->dst, ls->out, 0)) {
+				ret = -EBADMSG;
+				goto out;
+			}
+			ls->state = LZ4F_DONE;
+			break;
 		}
-
-		in += block_size;
-		if (has_block_checksum)
-			in += sizeof(u32);
 	}
+	if ((ls->flags & LZ4F_FLG_CONTENT_SIZE) &&
+	    ls->out != ls->content_size)
+		ret = -EBADMSG;
+	else
+		ret = 1;
+out:
+	*srcnp = in - (const u8 *)src;
 
-	*dstn = out - dst;
 	return ret;
 }
+
+int ulz4fn(const void *src, size_t srcn, void *dst, size_t *dstn)
+{
+	struct lz4f_stream ls;
+	int ret;
+
+	/* With in-place decompression the header may become invalid later. */
+	lz4f_stream_init(&ls, dst, *dstn);
+	ret = lz4f_stream_decode(&ls, src, &srcn);
+	lz4f_stream_end(&ls);
+	*dstn = ls.out;
+	if (!ret)
+		return -EINVAL;		/* input overrun */
+
+	return ret < 0 ? ret : 0;
+}
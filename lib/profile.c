@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Sampling profiler
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <trace.h>
+#include <asm/sections.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/* Information about the samples collected so far */
+struct profile_info {
+	struct trace_sample *sample;	/* Sample buffer */
+	ulong size;		/* Number of samples we have space for */
+	ulong count;		/* Number of samples recorded */
+	ulong dropped;		/* Number of samples dropped as buffer full */
+	uint hz;		/* Sample rate */
+	bool running;		/* true if samples are being recorded */
+};
+
+static struct profile_info prof;
+
+static uint32_t pc_to_offset(void *pc, bool caller)
+{
+	uintptr_t offset = (uintptr_t)pc;
+
+#ifdef CONFIG_SANDBOX
+	offset -= (uintptr_t)&_init;
+#else
+	if (gd->flags & GD_FLG_RELOC)
+		offset -= gd->relocaddr;
+	else
+		offset -= CONFIG_SYS_TEXT_BASE;
+#endif
+	/* A return address may be the start of the next function */
+	if (caller)
+		offset--;
+
+	/* Host library code on sandbox, or code outside U-Boot */
+	if (offset >= PROFILE_PC_EXTERNAL)
+		return PROFILE_PC_EXTERNAL;
+
+	return offset;
+}
+
+void profile_record(void *const pcs[], int depth)
+{
+	struct trace_sample *sample;
+	int i;
+
+	if (!prof.running)
+		return;
+	if (prof.count == prof.size) {
+		prof.dropped++;
+		return;
+	}
+	sample = &prof.sample[prof.count];
+	depth = min(depth, PROFILE_STACK_DEPTH);
+	for (i = 0; i < depth; i++)
+		sample->pc[i] = pc_to_offset(pcs[i], i);
+	sample->depth = depth;
+	prof.count++;
+}
+
+__weak int arch_profile_start(uint hz)
+{
+	return -ENOSYS;
+}
+
+__weak void arch_profile_stop(void)
+{
+}
+
+int profile_start(uint hz)
+{
+	int ret;
+
+	if (prof.running)
+		profile_stop();
+	if (!prof.sample) {
+		prof.sample = malloc(CONFIG_PROFILE_BUFFER_SIZE);
+		if (!prof.sample)
+			return -ENOMEM;
+		prof.size = CONFIG_PROFILE_BUFFER_SIZE / sizeof(*prof.sample);
+	}
+	prof.count = 0;
+	prof.dropped = 0;
+	prof.hz = hz;
+	prof.running = true;
+	ret = arch_profile_start(hz);
+	if (ret) {
+		prof.running = false;
+		return ret;
+	}
+
+	return 0;
+}
+
+void profile_stop(void)
+{
+	if (!prof.running)
+		return;
+	arch_profile_stop();
+	prof.running = false;
+}
+
+void profile_print_stats(void)
+{
+	printf("Profiling is %s\n", prof.running ? "running" : "stopped");
+	printf("%15lu samples at %u Hz\n", prof.count, prof.hz);
+	printf("%15lu samples dropped (buffer holds %lu)\n", prof.dropped,
+	       prof.size);
+}
+
+int profile_list_samples(void *buff, size_t buff_size, size_t *needed)
+{
+	struct trace_output_hdr *output_hdr = NULL;
+	void *end, *ptr = buff;
+	ulong rec, count;
+
+	end = buff ? buff + buff_size : NULL;
+
+	/* Place some header information */
+	if (ptr + sizeof(struct trace_output_hdr) <= end)
+		output_hdr = ptr;
+	ptr += sizeof(struct trace_output_hdr);
+
+	/* Copy out the samples that fit, so that the count is consistent */
+	count = prof.count;
+	for (rec = 0; rec < count && ptr + sizeof(*prof.sample) <= end;
+	     rec++) {
+		memcpy(ptr, &prof.sample[rec], sizeof(*prof.sample));
+		ptr += sizeof(*prof.sample);
+	}
+	if (output_hdr) {
+		output_hdr->rec_count = rec;
+		output_hdr->type = TRACE_CHUNK_SAMPLES;
+	}
+	ptr += (count - rec) * sizeof(*prof.sample);
+
+	/* Work out how much of the buffer we used */
+	*needed = ptr - buff;
+	if (ptr > end)
+		return -ENOSPC;
+
+	return 0;
+}
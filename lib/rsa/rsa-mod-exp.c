@@ -20,29 +20,58 @@
 #include <u-boot/rsa.h>
 #include <u-boot/rsa-mod-exp.h>
 
-#define UINT64_MULT32(v, multby)  (((uint64_t)(v)) * ((uint32_t)(multby)))
-
-#define get_unaligned_be32(a) fdt32_to_cpu(*(uint32_t *)a)
-#define put_unaligned_be32(a, b) (*(uint32_t *)(b) = cpu_to_fdt32(a))
-
 /* Default public exponent for backward compatibility */
 #define RSA_DEFAULT_PUBEXP	65537
 
+/*
+ * Numbers are held as little-endian arrays of limbs. Where the compiler has a
+ * 128-bit type, 64-bit limbs are used: these need a quarter of the multiplies
+ * of 32-bit ones.
+ */
+#ifdef __SIZEOF_INT128__
+typedef uint64_t rsa_limb;
+typedef unsigned __int128 rsa_dlimb;
+#else
+typedef uint32_t rsa_limb;
+typedef uint64_t rsa_dlimb;
+#endif
+
+#define RSA_LIMB_BITS	(sizeof(rsa_limb) * 8)
+
+/**
+ * struct rsa_mont - RSA public key set up for Montgomery multiplication
+ *
+ * @len:	Length of the modulus in limbs
+ * @n0inv:	-1 / modulus[0] mod 2^RSA_LIMB_BITS
+ * @modulus:	Modulus, as little endian limb array
+ * @rr:		R^2 mod modulus, where R = 2^(len * RSA_LIMB_BITS), as little
+ *		endian limb array
+ * @exponent:	Public exponent
+ */
+struct rsa_mont {
+	uint len;
+	rsa_limb n0inv;
+	rsa_limb *modulus;
+	rsa_limb *rr;
+	uint64_t exponent;
+};
+
 /**
  * subtract_modulus() - subtract modulus from the given value
  *
  * @key:	Key containing modulus to subtract
- * @num:	Number to subtract modulus from, as little endian word array
+ * @num:	Number to subtract modulus from, as little endian limb array
  */
-static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
+static void subtract_modulus(const struct rsa_mont *key, rsa_limb num[])
 {
-	int64_t acc = 0;
+	rsa_dlimb acc;
+	rsa_limb borrow = 0;
 	uint i;
 
 	for (i = 0; i < key->len; i++) {
-		acc += (uint64_t)num[i] - key->modulus[i];
-		num[i] = (uint32_t)acc;
-		acc >>= 32;
+		acc = (rsa_dlimb)num[i] - key->modulus[i] - borrow;
+		num[i] = (rsa_limb)acc;
+		borrow = (rsa_limb)(acc >> RSA_LIMB_BITS) & 1;
 	}
 }
 
@@ -50,11 +79,10 @@ static void subtract_modulus(const struct rsa_public_key *key, uint32_t num[])
  * greater_equal_modulus() - check if a value is >= modulus
  *
  * @key:	Key containing modulus to check
- * @num:	Number to check against modulus, as little endian word array
+ * @num:	Number to check against modulus, as little endian limb array
  * @return 0 if num < modulus, 1 if num >= modulus
  */
-static int greater_equal_modulus(const struct rsa_public_key *key,
-				 uint32_t num[])
+static int greater_equal_modulus(const struct rsa_mont *key, rsa_limb num[])
 {
 	int i;
 
@@ -74,32 +102,34 @@ static int greater_equal_modulus(const struct rsa_public_key *key,
  * Operation: montgomery result[] += a * b[] / n0inv % modulus
  *
  * @key:	RSA key
- * @result:	Place to put result, as little endian word array
+ * @result:	Place to put result, as little endian limb array
  * @a:		Multiplier
- * @b:		Multiplicand, as little endian word array
+ * @b:		Multiplicand, as little endian limb array
  */
-static void montgomery_mul_add_step(const struct rsa_public_key *key,
-		uint32_t result[], const uint32_t a, const uint32_t b[])
+static void montgomery_mul_add_step(const struct rsa_mont *key,
+		rsa_limb result[], const rsa_limb a, const rsa_limb b[])
 {
-	uint64_t acc_a, acc_b;
-	uint32_t d0;
+	rsa_dlimb acc_a, acc_b;
+	rsa_limb d0;
 	uint i;
 
-	acc_a = (uint64_t)a * b[0] + result[0];
-	d0 = (uint32_t)acc_a * key->n0inv;
-	acc_b = (uint64_t)d0 * key->modulus[0] + (uint32_t)acc_a;
+	acc_a = (rsa_dlimb)a * b[0] + result[0];
+	d0 = (rsa_limb)acc_a * key->n0inv;
+	acc_b = (rsa_dlimb)d0 * key->modulus[0] + (rsa_limb)acc_a;
 	for (i = 1; i < key->len; i++) {
-		acc_a = (acc_a >> 32) + (uint64_t)a * b[i] + result[i];
-		acc_b = (acc_b >> 32) + (uint64_t)d0 * key->modulus[i] +
-				(uint32_t)acc_a;
-		result[i - 1] = (uint32_t)acc_b;
+		acc_a = (acc_a >> RSA_LIMB_BITS) + (rsa_dlimb)a * b[i] +
+				result[i];
+		acc_b = (acc_b >> RSA_LIMB_BITS) +
+				(rsa_dlimb)d0 * key->modulus[i] +
+				(rsa_limb)acc_a;
+		result[i - 1] = (rsa_limb)acc_b;
 	}
 
-	acc_a = (acc_a >> 32) + (acc_b >> 32);
+	acc_a = (acc_a >> RSA_LIMB_BITS) + (acc_b >> RSA_LIMB_BITS);
 
-	result[i - 1] = (uint32_t)acc_a;
+	result[i - 1] = (rsa_limb)acc_a;
 
-	if (acc_a >> 32)
+	if (acc_a >> RSA_LIMB_BITS)
 		subtract_modulus(key, result);
 }
 
@@ -109,12 +139,13 @@ static void montgomery_mul_add_step(const struct rsa_public_key *key,
  * Operation: montgomery result[] = a[] * b[] / n0inv % modulus
  *
  * @key:	RSA key
- * @result:	Place to put result, as little endian word array
- * @a:		Multiplier, as little endian word array
- * @b:		Multiplicand, as little endian word array
+ * @result:	Place to put result, as little endian limb array, which must
+ *		not overlap @a or @b
+ * @a:		Multiplier, as little endian limb array
+ * @b:		Multiplicand, as little endian limb array
  */
-static void montgomery_mul(const struct rsa_public_key *key,
-		uint32_t result[], uint32_t a[], const uint32_t b[])
+static void montgomery_mul(const struct rsa_mont *key,
+		rsa_limb result[], const rsa_limb a[], const rsa_limb b[])
 {
 	uint i;
 
@@ -124,13 +155,94 @@ static void montgomery_mul(const struct rsa_public_key *key,
 		montgomery_mul_add_step(key, result, a[i], b);
 }
 
+/**
+ * rsa_n0inv() - Calculate -1 / n0 mod 2^RSA_LIMB_BITS
+ *
+ * @n0:		Lowest limb of the modulus, which must be odd
+ * @return the inverse
+ */
+static rsa_limb rsa_n0inv(rsa_limb n0)
+{
+	rsa_limb inv = n0;	/* n0 * n0 = 1 mod 8, so 3 bits are right */
+	int i;
+
+	/* Each Newton step doubles the number of correct bits */
+	for (i = 0; i < 5; i++)
+		inv *= 2 - n0 * inv;
+
+	return -inv;
+}
+
+/**
+ * rsa_limbs_from_be() - Convert a big-endian byte array to limbs
+ *
+ * @dst:	Place to put the little endian limb array
+ * @len:	Number of limbs in @dst
+ * @src:	Big-endian byte array, no larger than @dst
+ * @size:	Size of @src in bytes
+ */
+static void rsa_limbs_from_be(rsa_limb *dst, uint len, const uint8_t *src,
+			      uint size)
+{
+	uint i;
+
+	memset(dst, '\0', len * sizeof(rsa_limb));
+	for (i = 0; i < size; i++)
+		dst[i / sizeof(rsa_limb)] |= (rsa_limb)src[size - 1 - i] <<
+			(i % sizeof(rsa_limb) * 8);
+}
+
+/**
+ * rsa_limbs_to_be() - Convert limbs to a big-endian byte array
+ *
+ * @dst:	Place to put the big-endian byte array
+ * @size:	Size of @dst in bytes
+ * @src:	Little endian limb array, holding at least @size bytes
+ */
+static void rsa_limbs_to_be(uint8_t *dst, uint size, const rsa_limb *src)
+{
+	uint i;
+
+	for (i = 0; i < size; i++)
+		dst[size - 1 - i] = src[i / sizeof(rsa_limb)] >>
+			(i % sizeof(rsa_limb) * 8);
+}
+
+/**
+ * rsa_scale_rr() - Adjust R^2 mod N for a larger R
+ *
+ * R^2 mod N in the key is based on R = 2^num_bits. If this is not a whole
+ * number of limbs, R is larger here, so R^2 must be multiplied by
+ * 2^(2 * extra bits). This is done by doubling it modulo N.
+ *
+ * @key:	RSA key, with @key->rr to adjust
+ * @bits:	Number of bits R has grown by
+ */
+static void rsa_scale_rr(const struct rsa_mont *key, uint bits)
+{
+	rsa_limb carry;
+	uint i, j;
+
+	for (i = 0; i < bits * 2; i++) {
+		carry = 0;
+		for (j = 0; j < key->len; j++) {
+			rsa_limb top = key->rr[j] >> (RSA_LIMB_BITS - 1);
+
+			key->rr[j] = key->rr[j] << 1 | carry;
+			carry = top;
+		}
+		if (carry || greater_equal_modulus(key, key->rr))
+			subtract_modulus(key, key->rr);
+	}
+}
+
 /**
  * num_pub_exponent_bits() - Number of bits in the public exponent
  *
  * @key:	RSA key
  * @num_bits:	Storage for the number of public exponent bits
  */
-static int num_public_exponent_bits(const struct rsa_public_key *key,
+static int num_public_exponent_bits(const struct rsa_mont *key,
 		int *num_bits)
 {
 	uint64_t exponent;
@@ -160,39 +272,58 @@ static int num_public_exponent_bits(const struct rsa_public_key *key,
  * @key:	RSA key
  * @pos:	The bit position to check
  */
-static int is_public_exponent_bit_set(const struct rsa_public_key *key,
+static int is_public_exponent_bit_set(const struct rsa_mont *key,
 		int pos)
 {
-	return key->exponent & (1ULL << pos);
+	return !!(key->exponent & (1ULL << pos));
 }
 
 /**
- * pow_mod() - in-place public exponentiation
+ * exponent_window_bits() - Choose the window size for an exponent
  *
- * @key:	RSA key
- * @inout:	Big-endian word array containing value and result
+ * A window of w bits needs 2^(w-1) odd powers to be worked out first, so it
+ * only pays off for longer exponents. The thresholds are the ones OpenSSL
+ * uses; a 64-bit exponent does not reach the next one.
+ *
+ * @bits:	Number of bits in the exponent
+ * @return window size in bits
  */
-static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
+static int exponent_window_bits(int bits)
 {
-	uint32_t *result, *ptr;
-	uint i;
-	int j, k;
+	if (bits > 23)
+		return 3;
 
-	/* Sanity check for stack size - key->len is in 32-bit words */
-	if (key->len > RSA_MAX_KEY_BITS / 32) {
-		debug("RSA key words %u exceeds maximum %d\n", key->len,
-		      RSA_MAX_KEY_BITS / 32);
+	return 1;
+}
+
+/**
+ * pow_mod() - public exponentiation
+ *
+ * This uses a sliding window: each run of up to w exponent bits which ends
+ * in a one is handled with a single multiply by a precomputed odd power of
+ * the value. With the common exponent 65537 the window is one bit, which is
+ * plain square-and-multiply.
+ *
+ * @key:	RSA key
+ * @in:		Value, as big-endian byte array
+ * @out:	Place to put the result, as big-endian byte array
+ * @size:	Size of @in and @out in bytes
+ */
+static int pow_mod(const struct rsa_mont *key, const uint8_t *in,
+		   uint8_t *out, uint size)
+{
+	rsa_limb *acc, *tmp, *swap;
+	bool first, scaled;
+	int i, j, b, k, w;
+	uint val;
+
+	/* Sanity check for stack size - key->len is in limbs */
+	if (key->len > RSA_MAX_KEY_BITS / RSA_LIMB_BITS) {
+		debug("RSA key limbs %u exceeds maximum %zu\n", key->len,
+		      RSA_MAX_KEY_BITS / RSA_LIMB_BITS);
 		return -EINVAL;
 	}
 
-	uint32_t val[key->len], acc[key->len], tmp[key->len];
-	uint32_t a_scaled[key->len];
-	result = tmp;  /* Re-use location. */
-
-	/* Convert from big endian byte array to little endian word array. */
-	for (i = 0, ptr = inout + key->len - 1; i < key->len; i++, ptr--)
-		val[i] = get_unaligned_be32(ptr);
-
 	if (0 != num_public_exponent_bits(key, &k))
 		return -EINVAL;
 
@@ -206,36 +337,74 @@ static int pow_mod(const struct rsa_public_key *key, uint32_t *inout)
 		debug("LSB of RSA public exponent must be set.\n");
 		return -EINVAL;
 	}
+	w = exponent_window_bits(k);
+
+	rsa_limb val_buf[key->len], buf1[key->len], buf2[key->len];
+	rsa_limb table[1 << (w - 1)][key->len];
+
+	rsa_limbs_from_be(val_buf, key->len, in, size);
+
+	/* table[i] = a^(2i + 1) * R mod n */
+	montgomery_mul(key, table[0], val_buf, key->rr);
+	if (w > 1) {
+		montgomery_mul(key, buf1, table[0], table[0]);
+		for (i = 1; i < 1 << (w - 1); i++)
+			montgomery_mul(key, table[i], table[i - 1], buf1);
+	}
 
-	/* the bit at e[k-1] is 1 by definition, so start with: C := M */
-	montgomery_mul(key, acc, val, key->rr); /* acc = a * RR / R mod n */
-	/* retain scaled version for intermediate use */
-	memcpy(a_scaled, acc, key->len * sizeof(a_scaled[0]));
+	acc = buf1;
+	tmp = buf2;
+	first = true;
+	scaled = true;
+	for (i = k - 1; i >= 0; i = j - 1) {
+		if (!is_public_exponent_bit_set(key, i)) {
+			montgomery_mul(key, tmp, acc, acc);
+			swap = acc, acc = tmp, tmp = swap;
+			j = i;
+			continue;
+		}
 
-	for (j = k - 2; j > 0; --j) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
+		/* Find the longest window, up to w bits, ending in a one */
+		for (j = i - w + 1 > 0 ? i - w + 1 : 0;
+		     !is_public_exponent_bit_set(key, j); j++)
+			;
+		val = (key->exponent >> j) & ((1U << (i - j + 1)) - 1);
+		if (first) {
+			/* the top bit is 1 by definition, so start with a^val */
+			memcpy(acc, table[val >> 1], key->len * sizeof(acc[0]));
+			first = false;
+			continue;
+		}
+		for (b = i; b >= j; b--) {
+			montgomery_mul(key, tmp, acc, acc);
+			swap = acc, acc = tmp, tmp = swap;
+		}
 
-		if (is_public_exponent_bit_set(key, j)) {
-			/* acc = tmp * val / R mod n */
-			montgomery_mul(key, acc, tmp, a_scaled);
+		/*
+		 * Multiplying by the plain value for a final 1 bit leaves the
+		 * Montgomery form, which saves a multiply at the end
+		 */
+		if (!j && val == 1) {
+			montgomery_mul(key, tmp, acc, val_buf);
+			scaled = false;
 		} else {
-			/* e[j] == 0, copy tmp back to acc for next operation */
-			memcpy(acc, tmp, key->len * sizeof(acc[0]));
+			montgomery_mul(key, tmp, acc, table[val >> 1]);
 		}
+		swap = acc, acc = tmp, tmp = swap;
+	}
+	if (scaled) {
+		memset(val_buf, '\0', key->len * sizeof(val_buf[0]));
+		val_buf[0] = 1;
+		montgomery_mul(key, tmp, acc, val_buf);
+		swap = acc, acc = tmp, tmp = swap;
 	}
-
-	/* the bit at e[0] is always 1 */
-	montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod n */
-	montgomery_mul(key, acc, tmp, val); /* acc = tmp * a / R mod M */
-	memcpy(result, acc, key->len * sizeof(result[0]));
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
-	if (greater_equal_modulus(key, result))
-		subtract_modulus(key, result);
+	if (greater_equal_modulus(key, acc))
+		subtract_modulus(key, acc);
+
+	rsa_limbs_to_be(out, size, acc);
 
-	/* Convert to bigendian byte array */
-	for (i = key->len - 1, ptr = inout; (int)i >= 0; i--, ptr++)
-		put_unaligned_be32(result[i], ptr);
 	return 0;
 }
 
@@ -250,15 +419,13 @@ static void rsa_convert_big_endian(uint32_t *dst, const uint32_t *src, int len)
 int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		struct key_prop *prop, uint8_t *out)
 {
-	struct rsa_public_key key;
-	int ret;
+	struct rsa_mont key;
+	uint size;
 
 	if (!prop) {
 		debug("%s: Skipping invalid prop", __func__);
 		return -EBADF;
 	}
-	key.n0inv = prop->n0inv;
-	key.len = prop->num_bits;
 
 	if (!prop->public_exponent)
 		key.exponent = RSA_DEFAULT_PUBEXP;
@@ -266,40 +433,40 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
 		rsa_convert_big_endian((uint32_t *)&key.exponent,
 				       prop->public_exponent, 2);
 
-	if (!key.len || !prop->modulus || !prop->rr) {
+	if (!prop->num_bits || !prop->modulus || !prop->rr) {
 		debug("%s: Missing RSA key info", __func__);
 		return -EFAULT;
 	}
 
 	/* Sanity check for stack size */
-	if (key.len > RSA_MAX_KEY_BITS || key.len < RSA_MIN_KEY_BITS) {
+	if (prop->num_bits > RSA_MAX_KEY_BITS ||
+	    prop->num_bits < RSA_MIN_KEY_BITS) {
 		debug("RSA key bits %u outside allowed range %d..%d\n",
-		      key.len, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
+		      prop->num_bits, RSA_MIN_KEY_BITS, RSA_MAX_KEY_BITS);
 		return -EFAULT;
 	}
-	key.len /= sizeof(uint32_t) * 8;
-	uint32_t key1[key.len], key2[key.len];
+	size = prop->num_bits / 8;
+	key.len = (prop->num_bits + RSA_LIMB_BITS - 1) / RSA_LIMB_BITS;
+	if (sig_len > key.len * sizeof(rsa_limb)) {
+		debug("%s: Signature is larger than the key", __func__);
+		return -EINVAL;
+	}
+	rsa_limb key1[key.len], key2[key.len];
 
 	key.modulus = key1;
 	key.rr = key2;
-	rsa_convert_big_endian(key.modulus, (uint32_t *)prop->modulus, key.len);
-	rsa_convert_big_endian(key.rr, (uint32_t *)prop->rr, key.len);
-	if (!key.modulus || !key.rr) {
-		debug("%s: Out of memory", __func__);
-		return -ENOMEM;
+	rsa_limbs_from_be(key.modulus, key.len, prop->modulus, size);
+	rsa_limbs_from_be(key.rr, key.len, prop->rr, size);
+	if (!(key.modulus[0] & 1)) {
+		debug("%s: RSA modulus must be odd", __func__);
+		return -EINVAL;
 	}
+	key.n0inv = rsa_n0inv(key.modulus[0]);
+	if (prop->num_bits % RSA_LIMB_BITS)
+		rsa_scale_rr(&key, RSA_LIMB_BITS - prop->num_bits %
+			     RSA_LIMB_BITS);
 
-	uint32_t buf[sig_len / sizeof(uint32_t)];
-
-	memcpy(buf, sig, sig_len);
-
-	ret = pow_mod(&key, buf);
-	if (ret)
-		return ret;
-
-	memcpy(out, buf, sig_len);
-
-	return 0;
+	return pow_mod(&key, sig, out, sig_len);
 }
 
 #if defined(CONFIG_CMD_ZYNQ_RSA)
@@ -316,38 +483,55 @@ int rsa_mod_exp_sw(const uint8_t *sig, uint32_t sig_len,
  */
 int zynq_pow_mod(u32 *keyptr, u32 *inout)
 {
-	u32 *result, *ptr;
+	struct rsa_public_key *pkey;
+	struct rsa_mont key;
+	rsa_limb *result;
 	uint i;
-	struct rsa_public_key *key;
-	u32 val[RSA2048_BYTES], acc[RSA2048_BYTES], tmp[RSA2048_BYTES];
 
-	key = (struct rsa_public_key *)keyptr;
+	pkey = (struct rsa_public_key *)keyptr;
 
-	/* Sanity check for stack size - key->len is in 32-bit words */
-	if (key->len > RSA_MAX_KEY_BITS / 32) {
-		debug("RSA key words %u exceeds maximum %d\n", key->len,
+	/* Sanity check for stack size - pkey->len is in 32-bit words */
+	if (pkey->len > RSA_MAX_KEY_BITS / 32 ||
+	    pkey->len * 32 % RSA_LIMB_BITS) {
+		debug("RSA key words %u unsupported, maximum %d\n", pkey->len,
 		      RSA_MAX_KEY_BITS / 32);
 		return -EINVAL;
 	}
+	key.len = pkey->len * 32 / RSA_LIMB_BITS;
 
-	result = tmp;  /* Re-use location. */
+	rsa_limb modulus[key.len], rr[key.len];
+	rsa_limb val[key.len], acc[key.len], tmp[key.len];
 
-	for (i = 0, ptr = inout; i < key->len; i++, ptr++)
-		val[i] = *(ptr);
+	memset(modulus, '\0', sizeof(modulus));
+	memset(rr, '\0', sizeof(rr));
+	memset(val, '\0', sizeof(val));
+	for (i = 0; i < pkey->len; i++) {
+		uint shift = i * 32 % RSA_LIMB_BITS;
 
-	montgomery_mul(key, acc, val, key->rr);  /* axx = a * RR / R mod M */
+		modulus[i * 32 / RSA_LIMB_BITS] |=
+			(rsa_limb)pkey->modulus[i] << shift;
+		rr[i * 32 / RSA_LIMB_BITS] |= (rsa_limb)pkey->rr[i] << shift;
+		val[i * 32 / RSA_LIMB_BITS] |= (rsa_limb)inout[i] << shift;
+	}
+	key.modulus = modulus;
+	key.rr = rr;
+	key.n0inv = rsa_n0inv(modulus[0]);
+	result = tmp;  /* Re-use location. */
+
+	montgomery_mul(&key, acc, val, key.rr);  /* axx = a * RR / R mod M */
 	for (i = 0; i < 16; i += 2) {
-		montgomery_mul(key, tmp, acc, acc); /* tmp = acc^2 / R mod M */
-		montgomery_mul(key, acc, tmp, tmp); /* acc = tmp^2 / R mod M */
+		montgomery_mul(&key, tmp, acc, acc); /* tmp = acc^2 / R mod M */
+		montgomery_mul(&key, acc, tmp, tmp); /* acc = tmp^2 / R mod M */
 	}
-	montgomery_mul(key, result, acc, val);  /* result = XX * a / R mod M */
+	montgomery_mul(&key, result, acc, val);  /* result = XX * a / R mod M */
 
 	/* Make sure result < mod; result is at most 1x mod too large. */
-	if (greater_equal_modulus(key, result))
-		subtract_modulus(key, result);
+	if (greater_equal_modulus(&key, result))
+		subtract_modulus(&key, result);
 
-	for (i = 0, ptr = inout; i < key->len; i++, ptr++)
-		*ptr = result[i];
+	for (i = 0; i < pkey->len; i++)
+		inout[i] = result[i * 32 / RSA_LIMB_BITS] >>
+			(i * 32 % RSA_LIMB_BITS);
 
 	return 0;
 }
@@ -373,6 +373,80 @@ static int rsa_verify_key(struct image_sign_info *info,
 #endif
 
 #if CONFIG_IS_ENABLED(RSA_VERIFY_WITH_PKEY)
+/* Number of keys whose properties are kept for later verifications */
+#define RSA_PKEY_CACHE_SIZE	4
+
+/**
+ * struct rsa_pkey_cache - Properties generated for a public key
+ *
+ * @key:	Copy of the key data in DER format, NULL if this slot is empty
+ * @keylen:	Length of @key in bytes
+ * @prop:	Properties generated from @key
+ */
+struct rsa_pkey_cache {
+	void *key;
+	uint keylen;
+	struct key_prop *prop;
+};
+
+static struct rsa_pkey_cache rsa_pkey_cache[RSA_PKEY_CACHE_SIZE];
+static int rsa_pkey_cache_next;
+
+/**
+ * rsa_pkey_cache_get() - Get the properties of a public key
+ *
+ * Generating the properties involves working out R^2 mod N, which is slow, so
+ * the properties of recently used keys are kept. Where a key is verified
+ * against several signatures, e.g. for an EFI image and its certificates,
+ * this is only done once.
+ *
+ * @key:	Key data in DER format
+ * @keylen:	Length of @key in bytes
+ * @propp:	Returns the key properties
+ * @return true if @propp is held in the cache, false if the caller must free
+ *	it with rsa_free_key_prop(), -ve on error
+ */
+static int rsa_pkey_cache_get(const void *key, uint keylen,
+			      struct key_prop **propp)
+{
+	struct rsa_pkey_cache *entry;
+	struct key_prop *prop;
+	void *copy;
+	int ret;
+
+	for (entry = rsa_pkey_cache;
+	     entry != rsa_pkey_cache + RSA_PKEY_CACHE_SIZE; entry++) {
+		if (entry->key && entry->keylen == keylen &&
+		    !memcmp(entry->key, key, keylen)) {
+			*propp = entry->prop;
+			return true;
+		}
+	}
+
+	/* Public key is self-described to fill key_prop */
+	ret = rsa_gen_key_prop(key, keylen, &prop);
+	if (ret)
+		return ret;
+	*propp = prop;
+
+	copy = malloc(keylen);
+	if (!copy)
+		return false;
+	memcpy(copy, key, keylen);
+
+	entry = &rsa_pkey_cache[rsa_pkey_cache_next];
+	rsa_pkey_cache_next = (rsa_pkey_cache_next + 1) % RSA_PKEY_CACHE_SIZE;
+	if (entry->key) {
+		free(entry->key);
+		rsa_free_key_prop(entry->prop);
+	}
+	entry->key = copy;
+	entry->keylen = keylen;
+	entry->prop = prop;
+
+	return true;
+}
+
 /**
  * rsa_verify_with_pkey() - Verify a signature against some data using
  * only modulus and exponent as RSA key properties.
@@ -391,19 +465,20 @@ int rsa_verify_with_pkey(struct image_sign_info *info,
 			 const void *hash, uint8_t *sig, uint sig_len)
 {
 	struct key_prop *prop;
+	int cached;
 	int ret;
 
-	/* Public key is self-described to fill key_prop */
-	ret = rsa_gen_key_prop(info->key, info->keylen, &prop);
-	if (ret) {
+	cached = rsa_pkey_cache_get(info->key, info->keylen, &prop);
+	if (cached < 0) {
 		debug("Generating necessary parameter for decoding failed\n");
-		return ret;
+		return cached;
 	}
 
 	ret = rsa_verify_key(info, prop, sig, sig_len, hash,
 			     info->crypto->key_len);
 
-	rsa_free_key_prop(prop);
+	if (!cached)
+		rsa_free_key_prop(prop);
 
 	return ret;
 }
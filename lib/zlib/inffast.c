@@ -31,6 +31,29 @@
 #  define PUP(a) *++(a)
 #endif
 
+#ifdef INFLATE_FAST_WIDE
+/*
+   Load or copy eight bytes. Going through memcpy() lets the compiler use a
+   single unaligned access where the CPU allows it, and smaller accesses where
+   it does not (e.g. when building with -mstrict-align).
+ */
+local inline unsigned long load64le(const unsigned char FAR *p)
+{
+    u64 val;
+
+    __builtin_memcpy(&val, p, sizeof(val));
+    return le64_to_cpu(val);
+}
+
+local inline void copy64(unsigned char FAR *dst, const unsigned char FAR *src)
+{
+    u64 val;
+
+    __builtin_memcpy(&val, src, sizeof(val));
+    __builtin_memcpy(dst, &val, sizeof(val));
+}
+#endif
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -65,6 +88,12 @@
       bytes, which is the maximum length that can be coded.  inflate_fast()
       requires strm->avail_out >= 258 for each loop to avoid checking for
       output space.
+
+    - With INFLATE_FAST_WIDE, the bit buffer is refilled once per loop from
+      an eight-byte load, which leaves at least 56 bits: enough for a whole
+      length/distance pair. Matches are copied eight bytes at a time and may
+      write up to seven bytes beyond the match, so INFLATE_FAST_MIN_HAVE and
+      INFLATE_FAST_MIN_LEFT are larger.
  */
 void inflate_fast(z_streamp strm, unsigned start)
 /* start: inflate()'s starting value for strm->avail_out */
@@ -98,18 +127,18 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* copy state to local variables */
     state = (struct inflate_state FAR *)strm->state;
     in = strm->next_in - OFF;
-    last = in + (strm->avail_in - 5);
-    if (in > last && strm->avail_in > 5) {
+    last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
+    if (in > last && strm->avail_in > INFLATE_FAST_MIN_HAVE - 1) {
         /*
          * overflow detected, limit strm->avail_in to the
          * max. possible size and recalculate last
          */
 	strm->avail_in = 0xffffffff - (uintptr_t)in;
-        last = in + (strm->avail_in - 5);
+        last = in + (strm->avail_in - (INFLATE_FAST_MIN_HAVE - 1));
     }
     out = strm->next_out - OFF;
     beg = out - (start - strm->avail_out);
-    end = out + (strm->avail_out - 257);
+    end = out + (strm->avail_out - (INFLATE_FAST_MIN_LEFT - 1));
 #ifdef INFLATE_STRICT
     dmax = state->dmax;
 #endif
@@ -127,12 +156,20 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* decode literals and length/distances until end-of-block or not enough
        input data or output space */
     do {
+#ifdef INFLATE_FAST_WIDE
+        /* bytes loaded but not counted in bits are the next input bytes, so
+           the next refill ORs the same values into hold */
+        hold |= load64le(in + OFF) << bits;
+        in += (63 - bits) >> 3;
+        bits |= 56;
+#else
         if (bits < 15) {
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
             hold += (unsigned long)(PUP(in)) << bits;
             bits += 8;
         }
+#endif
         this = lcode[hold & lmask];
       dolen:
         op = (unsigned)(this.bits);
@@ -144,26 +181,39 @@ void inflate_fast(z_streamp strm, unsigned start)
                     "inflate:         literal '%c'\n" :
                     "inflate:         literal 0x%02x\n", this.val));
             PUP(out) = (unsigned char)(this.val);
+#ifdef INFLATE_FAST_WIDE
+            /* a literal leaves enough bits to decode a second one */
+            this = lcode[hold & lmask];
+            if (this.op == 0) {
+                hold >>= this.bits;
+                bits -= this.bits;
+                PUP(out) = (unsigned char)(this.val);
+            }
+#endif
         }
         else if (op & 16) {                     /* length base */
             len = (unsigned)(this.val);
             op &= 15;                           /* number of extra bits */
             if (op) {
+#ifndef INFLATE_FAST_WIDE
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
                 }
+#endif
                 len += (unsigned)hold & ((1U << op) - 1);
                 hold >>= op;
                 bits -= op;
             }
             Tracevv((stderr, "inflate:         length %u\n", len));
+#ifndef INFLATE_FAST_WIDE
             if (bits < 15) {
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
                 hold += (unsigned long)(PUP(in)) << bits;
                 bits += 8;
             }
+#endif
             this = dcode[hold & dmask];
           dodist:
             op = (unsigned)(this.bits);
@@ -173,6 +223,7 @@ void inflate_fast(z_streamp strm, unsigned start)
             if (op & 16) {                      /* distance base */
                 dist = (unsigned)(this.val);
                 op &= 15;                       /* number of extra bits */
+#ifndef INFLATE_FAST_WIDE
                 if (bits < op) {
                     hold += (unsigned long)(PUP(in)) << bits;
                     bits += 8;
@@ -181,6 +232,7 @@ void inflate_fast(z_streamp strm, unsigned start)
                         bits += 8;
                     }
                 }
+#endif
                 dist += (unsigned)hold & ((1U << op) - 1);
 #ifdef INFLATE_STRICT
                 if (dist > dmax) {
@@ -252,6 +304,30 @@ void inflate_fast(z_streamp strm, unsigned start)
                             PUP(out) = PUP(from);
                     }
                 }
+#ifdef INFLATE_FAST_WIDE
+                else {
+                    from = out - dist;          /* copy direct from output */
+                    if (dist >= 8) {            /* words do not overlap */
+                        unsigned char FAR *stop = out + len;
+
+                        do {
+                            copy64(out + OFF, from + OFF);
+                            out += 8;
+                            from += 8;
+                        } while (out < stop);
+                        out = stop;
+                    }
+                    else if (dist == 1) {       /* run of one byte */
+                        memset(out + OFF, out[OFF - 1], len);
+                        out += len;
+                    }
+                    else {
+                        do {
+                            PUP(out) = PUP(from);
+                        } while (--len);
+                    }
+                }
+#else
                 else {
 		    unsigned short *sout;
 		    unsigned long loops;
@@ -295,6 +371,7 @@ void inflate_fast(z_streamp strm, unsigned start)
 		    if (len & 1)
 			PUP(out) = PUP(from);
                 }
+#endif
             }
             else if ((op & 64) == 0) {          /* 2nd level distance code */
                 this = dcode[this.val + (hold & ((1U << op) - 1))];
@@ -331,9 +408,12 @@ void inflate_fast(z_streamp strm, unsigned start)
     /* update state and return */
     strm->next_in = in + OFF;
     strm->next_out = out + OFF;
-    strm->avail_in = (unsigned)(in < last ? 5 + (last - in) : 5 - (in - last));
+    strm->avail_in = (unsigned)(in < last ?
+                                (INFLATE_FAST_MIN_HAVE - 1) + (last - in) :
+                                (INFLATE_FAST_MIN_HAVE - 1) - (in - last));
     strm->avail_out = (unsigned)(out < end ?
-                                 257 + (end - out) : 257 - (out - end));
+                                 (INFLATE_FAST_MIN_LEFT - 1) + (end - out) :
+                                 (INFLATE_FAST_MIN_LEFT - 1) - (out - end));
     state->hold = hold;
     state->bits = bits;
     return;
@@ -8,4 +8,18 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/*
+   With CONFIG_ZLIB_INFLATE_WIDE on a 64-bit machine, inflate_fast() refills
+   its bit buffer and copies matches eight bytes at a time, so it needs a
+   little more input and output to be available than the classic version.
+ */
+#if IS_ENABLED(CONFIG_ZLIB_INFLATE_WIDE) && __SIZEOF_LONG__ == 8
+#  define INFLATE_FAST_WIDE
+#  define INFLATE_FAST_MIN_HAVE 8
+#  define INFLATE_FAST_MIN_LEFT (258 + 7)
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
 void inflate_fast OF((z_streamp strm, unsigned start));
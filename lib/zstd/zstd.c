@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Pool of zstd decompression contexts
+ *
+ * A zstd context needs a large workspace (a few hundred KB for a stream). To
+ * avoid allocating one for every image or filesystem block, workspaces are
+ * kept here once allocated and handed out again.
+ */
+
+#include <common.h>
+#include <log.h>
+#include <malloc.h>
+#include <u-boot/zstd.h>
+
+/* Number of workspaces which can be in use at once */
+#define ZSTD_POOL_SIZE	4
+
+/**
+ * struct zstd_ws - a workspace in the pool
+ *
+ * @buf:	Workspace memory, NULL if this slot is empty
+ * @size:	Size of @buf in bytes
+ * @window:	Window size supported, for a stream; 0 for a context
+ * @ctx:	Context or stream set up in @buf
+ * @busy:	true if handed out
+ */
+struct zstd_ws {
+	void *buf;
+	size_t size;
+	size_t window;
+	void *ctx;
+	bool busy;
+};
+
+static struct zstd_ws zstd_pool[ZSTD_POOL_SIZE];
+
+/**
+ * zstd_pool_get() - Find a free workspace, allocating it if needed
+ *
+ * @window:	Window size needed for a stream, or 0 for a context
+ * @return workspace, marked busy, or NULL if none
+ */
+static struct zstd_ws *zstd_pool_get(size_t window)
+{
+	struct zstd_ws *ws, *spare = NULL;
+
+	for (ws = zstd_pool; ws != zstd_pool + ZSTD_POOL_SIZE; ws++) {
+		if (ws->busy)
+			continue;
+		if (ws->buf && (window ? ws->window >= window : !ws->window))
+			goto found;
+		/* Prefer an empty slot to throwing a workspace away */
+		if (!spare || (spare->buf && !ws->buf))
+			spare = ws;
+	}
+	if (!spare) {
+		log_debug("All %d workspaces are in use\n", ZSTD_POOL_SIZE);
+		return NULL;
+	}
+
+	ws = spare;
+	free(ws->buf);
+	ws->size = window ? ZSTD_DStreamWorkspaceBound(window) :
+		ZSTD_DCtxWorkspaceBound();
+	ws->window = window;
+	ws->ctx = NULL;
+	ws->buf = malloc(ws->size);
+	if (!ws->buf) {
+		log_debug("Cannot allocate workspace of size %zx\n", ws->size);
+		return NULL;
+	}
+found:
+	ws->busy = true;
+
+	return ws;
+}
+
+static void zstd_pool_put(void *ctx)
+{
+	struct zstd_ws *ws;
+
+	for (ws = zstd_pool; ws != zstd_pool + ZSTD_POOL_SIZE; ws++) {
+		if (ws->busy && ws->ctx == ctx) {
+			ws->busy = false;
+			return;
+		}
+	}
+	log_debug("Context %p is not from the pool\n", ctx);
+}
+
+ZSTD_DCtx *zstd_get_dctx(void)
+{
+	struct zstd_ws *ws;
+
+	ws = zstd_pool_get(0);
+	if (!ws)
+		return NULL;
+
+	/* This just sets up the context in the workspace, so is cheap */
+	ws->ctx = ZSTD_initDCtx(ws->buf, ws->size);
+	if (!ws->ctx)
+		ws->busy = false;
+
+	return ws->ctx;
+}
+
+void zstd_put_dctx(ZSTD_DCtx *dctx)
+{
+	zstd_pool_put(dctx);
+}
+
+ZSTD_DStream *zstd_get_dstream(size_t max_window)
+{
+	struct zstd_ws *ws;
+
+	ws = zstd_pool_get(max_window);
+	if (!ws)
+		return NULL;
+
+	if (ws->ctx)
+		ZSTD_resetDStream(ws->ctx);
+	else
+		ws->ctx = ZSTD_initDStream(ws->window, ws->buf, ws->size);
+	if (!ws->ctx)
+		ws->busy = false;
+
+	return ws->ctx;
+}
+
+void zstd_put_dstream(ZSTD_DStream *zds)
+{
+	zstd_pool_put(zds);
+}
+
+int zstd_decompress(const void *src, size_t src_len, void *dst,
+		    size_t *dst_lenp)
+{
+	ZSTD_DCtx *dctx;
+	size_t ret;
+
+	dctx = zstd_get_dctx();
+	if (!dctx)
+		return -ENOMEM;
+	ret = ZSTD_decompressDCtx(dctx, dst, *dst_lenp, src, src_len);
+	zstd_put_dctx(dctx);
+	if (ZSTD_isError(ret)) {
+		log_debug("zstd error %d\n", ZSTD_getErrorCode(ret));
+		if (ZSTD_getErrorCode(ret) == ZSTD_error_dstSize_tooSmall)
+			return -ENOSPC;
+		return -EINVAL;
+	}
+	*dst_lenp = ret;
+
+	return 0;
+}
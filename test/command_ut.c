@@ -14,6 +14,33 @@ static const char test_cmd[] = "setenv list 1\n setenv list ${list}2; "
 		"setenv list ${list}3\0"
 		"setenv list ${list}4";
 
+/* Check that find_cmd() agrees with a walk of the table for all commands */
+static void check_find_cmd(void)
+{
+	struct cmd_tbl *start = ll_entry_start(struct cmd_tbl, cmd);
+	const int count = ll_entry_count(struct cmd_tbl, cmd);
+	struct cmd_tbl *cmdtp;
+	char name[40];
+	int len;
+
+	for (cmdtp = start; cmdtp != start + count; cmdtp++) {
+		/* The full name, every abbreviation and a size suffix */
+		strlcpy(name, cmdtp->name, sizeof(name));
+		for (len = strlen(name); len >= 0; len--) {
+			name[len] = '\0';
+			assert(find_cmd(name) == find_cmd_tbl(name, start, count));
+		}
+		snprintf(name, sizeof(name), "%s.b", cmdtp->name);
+		assert(find_cmd(name) == find_cmd_tbl(name, start, count));
+		snprintf(name, sizeof(name), "%sz", cmdtp->name);
+		assert(find_cmd(name) == find_cmd_tbl(name, start, count));
+	}
+	assert(find_cmd("setexpr") && !strcmp(find_cmd("setexpr")->name,
+					      "setexpr"));
+	assert(!find_cmd("no-such-command"));
+	assert(!find_cmd(NULL));
+}
+
 static int do_ut_cmd(struct cmd_tbl *cmdtp, int flag, int argc,
 		     char *const argv[])
 {
@@ -60,6 +87,8 @@ static int do_ut_cmd(struct cmd_tbl *cmdtp, int flag, int argc,
 
 	assert(run_command("'", 0) == 1);
 
+	check_find_cmd();
+
 	printf("%s: Everything went swimmingly\n", __func__);
 	return 0;
 }
@@ -22,6 +22,8 @@
 #include <lzma/LzmaTools.h>
 
 #include <linux/lzo.h>
+#include <linux/sizes.h>
+#include <u-boot/zstd.h>
 #include <test/compression.h>
 #include <test/suites.h>
 #include <test/ut.h>
@@ -121,6 +123,70 @@ static const char lz4_compressed[] =
 	"\x9d\x12\x8c\x9d";
 static const unsigned long lz4_compressed_size = 276;
 
+/*
+ * for i in $(seq 200); do cat /tmp/plain.txt; done |
+ *	lz4 -BD -BX --content-size -B4 > /tmp/plain200.lz4
+ *
+ * This has two linked blocks, each with a checksum, and the content size.
+ */
+static const char lz4_linked_compressed[] =
+	"\x04\x22\x4d\x18\x5c\x40\x70\x11\x01\x00\x00\x00\x00\x00\xe3\x11"
+	"\x02\x00\x00\xff\x19\x49\x20\x61\x6d\x20\x61\x20\x68\x69\x67\x68"
+	"\x6c\x79\x20\x63\x6f\x6d\x70\x72\x65\x73\x73\x61\x62\x6c\x65\x20"
+	"\x62\x69\x74\x20\x6f\x66\x20\x74\x65\x78\x74\x2e\x0a\x28\x00\x3d"
+	"\xf1\x25\x54\x68\x65\x72\x65\x20\x61\x72\x65\x20\x6d\x61\x6e\x79"
+	"\x20\x6c\x69\x6b\x65\x20\x6d\x65\x2c\x20\x62\x75\x74\x20\x74\x68"
+	"\x69\x73\x20\x6f\x6e\x65\x20\x69\x73\x20\x6d\x69\x6e\x65\x2e\x0a"
+	"\x49\x66\x20\x49\x20\x77\x32\x00\xd1\x6e\x79\x20\x73\x68\x6f\x72"
+	"\x74\x65\x72\x2c\x20\x74\x45\x00\xf4\x0b\x77\x6f\x75\x6c\x64\x6e"
+	"\x27\x74\x20\x62\x65\x20\x6d\x75\x63\x68\x20\x73\x65\x6e\x73\x65"
+	"\x20\x69\x6e\x0a\xcf\x00\xf5\x45\x69\x6e\x67\x20\x6d\x65\x20\x69"
+	"\x6e\x20\x74\x68\x65\x20\x66\x69\x72\x73\x74\x20\x70\x6c\x61\x63"
+	"\x65\x2e\x20\x41\x74\x20\x6c\x65\x61\x73\x74\x20\x77\x69\x74\x68"
+	"\x20\x6c\x7a\x6f\x2c\x20\x61\x6e\x79\x77\x61\x79\x2c\x0a\x77\x68"
+	"\x69\x63\x68\x20\x61\x70\x70\x65\x61\x72\x73\x20\x74\x6f\x20\x62"
+	"\x65\x68\x61\x76\x65\x20\x70\x6f\x6f\x72\x6c\x79\x4e\x00\x62\x61"
+	"\x63\x65\x20\x6f\x66\x95\x00\x01\x2d\x01\x9f\x0a\x6d\x65\x73\x73"
+	"\x61\x67\x65\x73\x36\x01\x3f\x0f\x86\x01\x15\x0f\x5e\x01\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\x11\x50\x20"
+	"\x61\x6d\x20\x61\x92\x11\x38\xba\x1f\x00\x00\x00\x0f\xfa\xff\x0f"
+	"\x0f\x4c\xfe\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"
+	"\xff\xff\xff\xff\x47\x50\x67\x65\x73\x2e\x0a\xe0\x59\x07\x6a\x00"
+	"\x00\x00\x00\x8a\x80\xc2\x98";
+static const unsigned long lz4_linked_compressed_size = 599;
+
+/* zstd -19 -c /tmp/plain.txt > /tmp/plain.zst */
+static const char zstd_compressed[] =
+	"\x28\xb5\x2f\xfd\x64\x5e\x00\xad\x05\x00\x42\x4e\x26\x17\x90\x3b"
+	"\x07\x04\x5a\x13\x8b\xa7\x65\x34\x12\x21\x6d\xb0\x39\xbb\xae\xe8"
+	"\xba\xc9\xcd\x5e\x02\x49\xd0\x2b\xa9\xfa\x96\x92\xe7\x1f\x19\x19"
+	"\x7c\x8f\xf1\x9d\x54\x37\xfc\xd6\x0a\xf3\x0c\x93\x56\xc7\x52\x4f"
+	"\x0a\x62\x3e\xd1\xa5\x83\x17\x31\xab\x5d\x8f\x57\xf3\xcc\x3b\x58"
+	"\xf8\x91\x8c\xf1\x2a\x5c\x89\xdd\xf2\x9b\x15\xb7\x92\x5b\xbe\xba"
+	"\xab\xd5\xd1\x34\xdf\xf0\x02\x0e\x61\xcd\x7b\xd6\x01\xfc\xc2\xa7"
+	"\xd4\xd1\x3d\x26\x9c\x10\x49\xb8\x5b\xcd\xba\x7c\xf7\xac\x4b\xad"
+	"\xb7\x31\x1c\xbc\xf9\xcb\x62\x8e\x2e\x9b\x0f\xd3\x87\x57\x45\x12"
+	"\x16\xfa\x3a\x79\xde\x65\xf8\xcc\x48\xd5\x43\xa6\xbd\xc3\x91\x29"
+	"\x65\x29\xa7\x5b\x9a\x08\x08\x00\x60\x13\x00\x63\xa3\x8e\x28\x94"
+	"\x79\x41\x2a\x78\xc2\x91\x70\x9f\xaa\x6a\x21\x7a\xa1\xaa\x0c\xe4"
+	"\xf4\x6e\xfa";
+static const unsigned long zstd_compressed_size = 195;
+
 
 #define TEST_BUFFER_SIZE	512
 
@@ -296,6 +362,40 @@ static int uncompress_using_lz4(struct unit_test_state *uts,
 	return (ret != 0);
 }
 
+static int compress_using_zstd(struct unit_test_state *uts,
+			       void *in, unsigned long in_size,
+			       void *out, unsigned long out_max,
+			       unsigned long *out_size)
+{
+	/* There is no zstd compression in u-boot, so fake it. */
+	ut_asserteq(in_size, strlen(plain));
+	ut_asserteq_mem(plain, in, in_size);
+
+	if (zstd_compressed_size > out_max)
+		return -1;
+
+	memcpy(out, zstd_compressed, zstd_compressed_size);
+	if (out_size)
+		*out_size = zstd_compressed_size;
+
+	return 0;
+}
+
+static int uncompress_using_zstd(struct unit_test_state *uts,
+				 void *in, unsigned long in_size,
+				 void *out, unsigned long out_max,
+				 unsigned long *out_size)
+{
+	size_t output_size = out_max;
+	int ret;
+
+	ret = zstd_decompress(in, in_size, out, &output_size);
+	if (out_size)
+		*out_size = output_size;
+
+	return (ret != 0);
+}
+
 #define errcheck(statement) if (!(statement)) { \
 	fprintf(stderr, "\tFailed: %s\n", #statement); \
 	ret = 1; \
@@ -440,6 +540,190 @@ static int compression_test_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_lz4, 0);
 
+/* Number of copies of the plain text in lz4_linked_compressed */
+#define LZ4_LINKED_COPIES	200
+
+/**
+ * lz4_stream_pieces() - Decode an LZ4 frame supplied in pieces
+ *
+ * @src:	Compressed data
+ * @src_len:	Size of compressed data in bytes
+ * @dst:	Place to put the decompressed data
+ * @dst_len:	Size of @dst in bytes
+ * @piece:	Number of bytes to supply at a time
+ * @lsp:	Returns the stream state
+ * @return 0 if OK, -ve error code from lz4f_stream_decode() on error,
+ *	-EINVAL if the frame is truncated
+ */
+static int lz4_stream_pieces(const char *src, ulong src_len, void *dst,
+			     ulong dst_len, ulong piece,
+			     struct lz4f_stream *lsp)
+{
+	ulong pos = 0;
+	size_t len;
+	int ret;
+
+	lz4f_stream_init(lsp, dst, dst_len);
+	do {
+		len = min(piece, src_len - pos);
+		ret = lz4f_stream_decode(lsp, src + pos, &len);
+		pos += len;
+		if (!ret && pos == src_len)
+			ret = -EINVAL;
+	} while (!ret);
+	lz4f_stream_end(lsp);
+
+	return ret < 0 ? ret : 0;
+}
+
+static int compression_test_lz4_stream(struct unit_test_state *uts)
+{
+	static const ulong pieces[] = { 1, 3, 64, 1000, ULONG_MAX };
+	ulong plain_len = strlen(plain);
+	ulong size = plain_len * LZ4_LINKED_COPIES;
+	struct lz4f_stream ls;
+	size_t out_size;
+	char *buf, *comp;
+	int i, j;
+
+	buf = malloc(size);
+	ut_assertnonnull(buf);
+	for (i = 0; i < ARRAY_SIZE(pieces); i++) {
+		memset(buf, '\0', size);
+		ut_assertok(lz4_stream_pieces(lz4_linked_compressed,
+					      lz4_linked_compressed_size, buf,
+					      size, pieces[i], &ls));
+		ut_asserteq(size, ls.content_size);
+		ut_asserteq(size, ls.out);
+		for (j = 0; j < LZ4_LINKED_COPIES; j++)
+			ut_asserteq_mem(plain, buf + j * plain_len, plain_len);
+	}
+
+	/* SPL only streams frames with small blocks, like this one */
+	ut_asserteq(SZ_64K, lz4f_block_max(lz4_linked_compressed));
+	ut_asserteq(SZ_4M, lz4f_block_max(lz4_compressed));
+	ut_asserteq(-EPROTONOSUPPORT, lz4f_block_max(plain));
+
+	/* The plain ulz4fn() copes with linked blocks too */
+	out_size = size;
+	ut_assertok(ulz4fn(lz4_linked_compressed, lz4_linked_compressed_size,
+			   buf, &out_size));
+	ut_asserteq(size, out_size);
+
+	/* The content size shows up a small buffer before any output */
+	memset(buf, '\0', size);
+	out_size = size - 1;
+	ut_asserteq(-ENOBUFS, ulz4fn(lz4_linked_compressed,
+				     lz4_linked_compressed_size, buf,
+				     &out_size));
+	ut_asserteq(0, out_size);
+
+	/* A corrupt literal is caught by the block checksum */
+	comp = malloc(lz4_linked_compressed_size);
+	ut_assertnonnull(comp);
+	memcpy(comp, lz4_linked_compressed, lz4_linked_compressed_size);
+	comp[0x20] ^= 0x20;
+	ut_asserteq(-EBADMSG, lz4_stream_pieces(comp,
+						lz4_linked_compressed_size, buf,
+						size, 64, &ls));
+
+	/* ...or by the content checksum, if there are no block checksums */
+	if (IS_ENABLED(CONFIG_LZ4_CONTENT_CHECKSUM)) {
+		memcpy(comp, lz4_compressed, lz4_compressed_size);
+		comp[0x20] ^= 0x20;
+		out_size = size;
+		ut_asserteq(-EBADMSG, ulz4fn(comp, lz4_compressed_size, buf,
+					     &out_size));
+	}
+	free(comp);
+	free(buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_lz4_stream, 0);
+
+static int compression_test_zstd(struct unit_test_state *uts)
+{
+	return run_test(uts, "zstd", compress_using_zstd,
+			uncompress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_zstd, 0);
+
+/* Size of the data used to exercise the inflate fast loop */
+#define GZIP_LARGE_SIZE		(1 << 20)
+
+/**
+ * fill_large_data() - Fill a buffer with data to compress
+ *
+ * This mixes pieces of the plain text, runs of one byte and pseudo-random
+ * bytes, so the compressed data holds literals as well as matches of many
+ * lengths and distances, as a kernel image does.
+ *
+ * @buf:	Buffer to fill
+ * @size:	Size of @buf in bytes
+ */
+static void fill_large_data(u8 *buf, ulong size)
+{
+	ulong plain_len = strlen(plain);
+	ulong pos, len, i;
+	u32 seed = 1;
+
+	for (pos = 0; pos < size; pos += len) {
+		seed = seed * 1103515245 + 12345;
+		len = min((ulong)(seed >> 16) % 64 + 1, size - pos);
+		switch (seed >> 30) {
+		case 0:
+			memset(buf + pos, seed >> 8, len);
+			break;
+		case 1:
+			for (i = 0; i < len; i++) {
+				seed = seed * 1103515245 + 12345;
+				buf[pos + i] = seed >> 16;
+			}
+			break;
+		default:
+			memcpy(buf + pos, plain + (seed >> 8) % (plain_len - len),
+			       len);
+			break;
+		}
+	}
+}
+
+/* Check gunzip on a block large enough to exercise the inflate fast loop */
+static int compression_test_gzip_large(struct unit_test_state *uts)
+{
+	ulong comp_size, out_size;
+	u8 *in_buf, *comp_buf, *out_buf;
+
+	in_buf = malloc(GZIP_LARGE_SIZE);
+	ut_assertnonnull(in_buf);
+	comp_buf = malloc(GZIP_LARGE_SIZE);
+	ut_assertnonnull(comp_buf);
+	out_buf = malloc(GZIP_LARGE_SIZE);
+	ut_assertnonnull(out_buf);
+	fill_large_data(in_buf, GZIP_LARGE_SIZE);
+	comp_size = GZIP_LARGE_SIZE;
+	ut_assertok(gzip(comp_buf, &comp_size, in_buf, GZIP_LARGE_SIZE));
+
+	out_size = comp_size;
+	ut_assertok(gunzip(out_buf, GZIP_LARGE_SIZE, comp_buf, &out_size));
+	ut_asserteq(GZIP_LARGE_SIZE, out_size);
+	ut_asserteq_mem(in_buf, out_buf, GZIP_LARGE_SIZE);
+
+	/* Running out of space must not write past the end of the buffer */
+	out_buf[GZIP_LARGE_SIZE - 1] = 'A';
+	out_size = comp_size;
+	ut_assert(gunzip(out_buf, GZIP_LARGE_SIZE - 1, comp_buf, &out_size));
+	ut_asserteq('A', out_buf[GZIP_LARGE_SIZE - 1]);
+
+	free(out_buf);
+	free(comp_buf);
+	free(in_buf);
+
+	return 0;
+}
+COMPRESSION_TEST(compression_test_gzip_large, 0);
+
 static int compress_using_none(struct unit_test_state *uts,
 			       void *in, unsigned long in_size,
 			       void *out, unsigned long out_max,
@@ -530,6 +814,12 @@ static int compression_test_bootm_lz4(struct unit_test_state *uts)
 }
 COMPRESSION_TEST(compression_test_bootm_lz4, 0);
 
+static int compression_test_bootm_zstd(struct unit_test_state *uts)
+{
+	return run_bootm_test(uts, IH_COMP_ZSTD, compress_using_zstd);
+}
+COMPRESSION_TEST(compression_test_bootm_zstd, 0);
+
 static int compression_test_bootm_none(struct unit_test_state *uts)
 {
 	return run_bootm_test(uts, IH_COMP_NONE, compress_using_none);
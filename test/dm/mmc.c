@@ -7,6 +7,7 @@
 #include <dm.h>
 #include <mmc.h>
 #include <part.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -43,3 +44,39 @@ static int dm_test_mmc_blk(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_mmc_blk, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+static int dm_test_mmc_cmd23(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	uint sbc_count, stop_count;
+	struct udevice *dev;
+	struct mmc *mmc;
+	char cmp[2048];
+
+	ut_assertok(uclass_get_device(UCLASS_MMC, 0, &dev));
+	ut_assertok(blk_get_device_by_str("mmc", "0", &dev_desc));
+	mmc = mmc_get_mmc_dev(dev);
+
+	/* The card and host support CMD23, so no CMD12 is needed */
+	ut_asserteq(4, blk_dread(dev_desc, 0x40, 4, cmp));
+	sandbox_mmc_get_stop_stats(dev, &sbc_count, &stop_count);
+	ut_asserteq(1, sbc_count);
+	ut_asserteq(0, stop_count);
+
+	/* Single-block reads need neither */
+	ut_asserteq(1, blk_dread(dev_desc, 0x48, 1, cmp));
+	sandbox_mmc_get_stop_stats(dev, &sbc_count, &stop_count);
+	ut_asserteq(1, sbc_count);
+	ut_asserteq(0, stop_count);
+
+	/* Without host support we are back to open-ended reads */
+	mmc->host_caps &= ~MMC_CAP_CMD23;
+	ut_asserteq(4, blk_dread(dev_desc, 0x50, 4, cmp));
+	sandbox_mmc_get_stop_stats(dev, &sbc_count, &stop_count);
+	ut_asserteq(1, sbc_count);
+	ut_asserteq(1, stop_count);
+	mmc->host_caps |= MMC_CAP_CMD23;
+
+	return 0;
+}
+DM_TEST(dm_test_mmc_cmd23, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the NVMe driver, using the sandbox NVMe emulator
+ */
+
+#include <common.h>
+#include <blk.h>
+#include <dm.h>
+#include <malloc.h>
+#include <pci.h>
+#include <asm/test.h>
+#include <dm/device-internal.h>
+#include <dm/test.h>
+#include <test/ut.h>
+
+#define NVME_TEST_BLOCKS	2048
+
+/* Write the whole namespace and read it back, then check error handling */
+static int dm_test_nvme_rw(struct unit_test_state *uts)
+{
+	struct udevice *nvme, *blk, *container, *emul;
+	struct blk_desc *desc;
+	u8 *wbuf, *rbuf;
+	uint i;
+
+	sandbox_set_enable_memio(true);
+	sandbox_set_enable_pci_map(true);
+	ut_assertok(uclass_first_device_err(UCLASS_NVME, &nvme));
+	ut_assertok(device_find_first_child(nvme, &blk));
+	ut_assertnonnull(blk);
+	ut_assertok(device_probe(blk));
+	desc = dev_get_uclass_platdata(blk);
+	ut_asserteq(NVME_TEST_BLOCKS, desc->lba);
+	ut_asserteq(512, desc->blksz);
+
+	ut_assertok(sandbox_pci_get_emul(dev_get_parent(nvme),
+					 dm_pci_get_bdf(nvme), &container,
+					 &emul));
+
+	wbuf = malloc(NVME_TEST_BLOCKS * 512);
+	rbuf = malloc(NVME_TEST_BLOCKS * 512);
+	ut_assertnonnull(wbuf);
+	ut_assertnonnull(rbuf);
+	for (i = 0; i < NVME_TEST_BLOCKS * 512; i++)
+		wbuf[i] = i * 7 + (i >> 9);
+
+	/*
+	 * This needs many commands, several in flight at once, and the
+	 * emulator completes each batch in reverse order
+	 */
+	ut_asserteq(NVME_TEST_BLOCKS,
+		    blk_dwrite(desc, 0, NVME_TEST_BLOCKS, wbuf));
+	ut_assert(sandbox_nvme_emul_get_max_batch(emul) > 1);
+	memset(rbuf, '\0', NVME_TEST_BLOCKS * 512);
+	ut_asserteq(NVME_TEST_BLOCKS,
+		    blk_dread(desc, 0, NVME_TEST_BLOCKS, rbuf));
+	ut_asserteq_mem(wbuf, rbuf, NVME_TEST_BLOCKS * 512);
+
+	/* Unaligned start and a length which is not a multiple of a command */
+	memset(rbuf, '\0', NVME_TEST_BLOCKS * 512);
+	ut_asserteq(201, blk_dread(desc, 37, 201, rbuf));
+	ut_asserteq_mem(wbuf + 37 * 512, rbuf, 201 * 512);
+
+	/* The blocks before the failing command are still reported as read */
+	sandbox_nvme_emul_set_fail_lba(emul, 300);
+	ut_asserteq(256, blk_dread(desc, 0, NVME_TEST_BLOCKS, rbuf));
+	sandbox_nvme_emul_set_fail_lba(emul, -1ULL);
+	ut_asserteq(NVME_TEST_BLOCKS,
+		    blk_dread(desc, 0, NVME_TEST_BLOCKS, rbuf));
+	ut_asserteq_mem(wbuf, rbuf, NVME_TEST_BLOCKS * 512);
+
+	free(rbuf);
+	free(wbuf);
+	sandbox_set_enable_pci_map(false);
+	sandbox_set_enable_memio(false);
+
+	return 0;
+}
+DM_TEST(dm_test_nvme_rw, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
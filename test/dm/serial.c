@@ -4,9 +4,12 @@
  */
 
 #include <common.h>
+#include <console.h>
+#include <env.h>
 #include <log.h>
 #include <serial.h>
 #include <dm.h>
+#include <asm/test.h>
 #include <dm/test.h>
 #include <test/test.h>
 #include <test/ut.h>
@@ -70,3 +73,61 @@ static int dm_test_serial(struct unit_test_state *uts)
 }
 
 DM_TEST(dm_test_serial, UT_TESTF_SCAN_FDT);
+
+static int dm_test_serial_try_puts(struct unit_test_state *uts)
+{
+	struct udevice *dev;
+
+	ut_assertok(uclass_get_device_by_name(UCLASS_SERIAL, "serial", &dev));
+
+	/* The sandbox uart never has a full FIFO, so all of it goes out */
+	ut_asserteq(0, serial_try_puts(dev, "", 0));
+	ut_asserteq(5, serial_try_puts(dev, "try\n\n", 5));
+	ut_asserteq(3, serial_try_puts(dev, "ok\nignored", 3));
+
+	return 0;
+}
+
+DM_TEST(dm_test_serial_try_puts, UT_TESTF_SCAN_FDT);
+
+#if CONFIG_IS_ENABLED(CONSOLE_DEFER)
+static int dm_test_serial_defer(struct unit_test_state *uts)
+{
+	uint start, queued, drained, flushed, direct, left;
+
+	/* Start with nothing queued and a full FIFO */
+	console_flush();
+	start = sandbox_serial_get_tx_count();
+	sandbox_serial_set_tx_room(0);
+	puts("deferred\n");
+	queued = sandbox_serial_get_tx_count();
+
+	/* Polling for input sends what the FIFO accepts, then the rest */
+	sandbox_serial_set_tx_room(4);
+	tstc();
+	drained = sandbox_serial_get_tx_count();
+	sandbox_serial_set_tx_room(-1);
+	console_flush();
+	flushed = sandbox_serial_get_tx_count();
+
+	/* With deferral turned off, output goes straight to the uart */
+	ut_assertok(env_set("consoledefer", "n"));
+	sandbox_serial_set_tx_room(4);
+	puts("okay");
+	direct = sandbox_serial_get_tx_count();
+	tstc();
+	left = sandbox_serial_get_tx_count();
+	sandbox_serial_set_tx_room(-1);
+	ut_assertok(env_set("consoledefer", NULL));
+
+	ut_asserteq(start, queued);
+	ut_asserteq(start + 4, drained);
+	ut_asserteq(start + 10, flushed);	/* the '\n' is sent as '\r\n' */
+	ut_asserteq(flushed + 4, direct);
+	ut_asserteq(direct, left);
+
+	return 0;
+}
+
+DM_TEST(dm_test_serial_defer, UT_TESTF_SCAN_FDT);
+#endif
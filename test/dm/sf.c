@@ -10,11 +10,14 @@
 #include <mapmem.h>
 #include <os.h>
 #include <spi.h>
+#include <spi-mem.h>
 #include <spi_flash.h>
 #include <asm/state.h>
 #include <asm/test.h>
 #include <dm/test.h>
 #include <dm/util.h>
+#include <linux/err.h>
+#include <linux/mtd/spi-nor.h>
 #include <test/test.h>
 #include <test/ut.h>
 
@@ -94,3 +97,99 @@ static int dm_test_spi_flash_func(struct unit_test_state *uts)
 	return 0;
 }
 DM_TEST(dm_test_spi_flash_func, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+#define SF_DIRMAP_READ_OP(_opcode, _addr_len, _addr_width, _dummy, _width) \
+	SPI_MEM_OP(SPI_MEM_OP_CMD(_opcode, 1),				\
+		   SPI_MEM_OP_ADDR(_addr_len, 0, _addr_width),		\
+		   SPI_MEM_OP_DUMMY(_dummy, _addr_width),		\
+		   SPI_MEM_OP_DATA_IN(0, NULL, _width))
+
+/* Test reading SPI flash through a direct mapping, with each read opcode */
+static int dm_test_spi_flash_dirmap(struct unit_test_state *uts)
+{
+	static const struct spi_mem_op read_ops[] = {
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ, 3, 1, 0, 1),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_FAST, 3, 1, 1, 1),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_1_2, 3, 1, 1, 2),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_2_2, 3, 2, 2, 2),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_1_4, 3, 1, 1, 4),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_4_4, 3, 4, 4, 4),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_8_8, 3, 8, 8, 8),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_4B, 4, 1, 0, 1),
+		SF_DIRMAP_READ_OP(SPINOR_OP_READ_1_4_4_4B, 4, 4, 4, 4),
+	};
+	struct spi_mem_dirmap_info info;
+	struct spi_mem_dirmap_desc *desc;
+	struct spi_flash *flash;
+	struct spi_slave *slave;
+	struct udevice *dev;
+	int full_size = 0x200000;
+	int size = 0x10000;
+	int offset = 0x1230;
+	u8 *src, *dst;
+	uint mode;
+	int i;
+
+	src = map_sysmem(0x20000, full_size);
+	for (i = 0; i < full_size; i++)
+		src[i] = i ^ (i >> 8);
+	ut_assertok(os_write_file("spi.bin", src, full_size));
+	ut_assertok(uclass_first_device_err(UCLASS_SPI_FLASH, &dev));
+	dst = map_sysmem(0x20000 + full_size, full_size);
+
+	/* The flash core reads through a mapping served by the controller */
+	flash = dev_get_uclass_priv(dev);
+	ut_assertnonnull(flash->dirmap.rdesc);
+	ut_asserteq(0, flash->dirmap.rdesc->nodirmap);
+	ut_assertok(spi_flash_read_dm(dev, offset, size, dst));
+	ut_asserteq_mem(src + offset, dst, size);
+
+	/* Each read protocol the emulator knows about */
+	slave = flash->spi;
+	mode = slave->mode;
+	slave->mode |= SPI_RX_DUAL | SPI_RX_QUAD | SPI_RX_OCTAL |
+		       SPI_TX_DUAL | SPI_TX_QUAD | SPI_TX_OCTAL;
+	for (i = 0; i < ARRAY_SIZE(read_ops); i++) {
+		info.op_tmpl = read_ops[i];
+		info.offset = offset;
+		info.length = size;
+		desc = spi_mem_dirmap_create(slave, &info);
+		ut_assertok_ptr(desc);
+
+		memset(dst, '\0', size);
+		ut_asserteq(size - 0x10,
+			    spi_mem_dirmap_read(desc, 0x10, size - 0x10, dst));
+		ut_asserteq_mem(src + offset + 0x10, dst, size - 0x10);
+
+		/* Reads are clipped to the end of the mapping */
+		ut_asserteq(0x10, spi_mem_dirmap_read(desc, size - 0x10,
+						      0x100, dst));
+		ut_asserteq(-EINVAL, spi_mem_dirmap_read(desc, size, 1, dst));
+		spi_mem_dirmap_destroy(desc);
+	}
+	slave->mode = mode;
+
+	/* Without controller support, reads are split by max_read_size */
+	info.op_tmpl = read_ops[1];
+	desc = spi_mem_dirmap_create(slave, &info);
+	ut_assertok_ptr(desc);
+	desc->nodirmap = true;
+	slave->max_read_size = 0x100;
+	ut_asserteq(0x100, spi_mem_dirmap_read(desc, 0, size, dst));
+	ut_asserteq_mem(src + offset, dst, 0x100);
+	slave->max_read_size = 0;
+	spi_mem_dirmap_destroy(desc);
+
+	/* Write-only mappings are not supported */
+	info.op_tmpl.data.dir = SPI_MEM_DATA_OUT;
+	ut_asserteq_ptr(ERR_PTR(-EINVAL), spi_mem_dirmap_create(slave, &info));
+
+	/*
+	 * Since we are about to destroy all devices, we must tell sandbox
+	 * to forget the emulation device
+	 */
+	sandbox_sf_unbind_emul(state_get_current(), 0, 0);
+
+	return 0;
+}
+DM_TEST(dm_test_spi_flash_dirmap, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
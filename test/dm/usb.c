@@ -6,6 +6,7 @@
 #include <common.h>
 #include <console.h>
 #include <dm.h>
+#include <malloc.h>
 #include <part.h>
 #include <usb.h>
 #include <asm/io.h>
@@ -63,6 +64,42 @@ static int dm_test_usb_flash(struct unit_test_state *uts)
 }
 DM_TEST(dm_test_usb_flash, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
 
+/* Test the largest transfer used for high-speed and SuperSpeed sticks */
+static int dm_test_usb_flash_max_xfer(struct unit_test_state *uts)
+{
+	struct blk_desc *dev_desc;
+	struct udevice *emul;
+	char *buf;
+
+	state_set_skip_delays(true);
+	ut_assertok(usb_init());
+	buf = malloc(4096 * 512);
+	ut_assertnonnull(buf);
+
+	/* A high-speed stick is limited to 240 blocks per command */
+	ut_assertok(blk_get_device_by_str("usb", "0", &dev_desc));
+	ut_asserteq(4096, blk_dread(dev_desc, 0, 4096, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	ut_assertok(uclass_get_device_by_name(UCLASS_USB_EMUL, "flash-stick@0",
+					      &emul));
+	ut_asserteq(240, sandbox_usb_flash_get_max_read(emul));
+
+	/* A SuperSpeed stick gets 2048 blocks (1 MiB) per command */
+	memset(buf, '\0', 4096 * 512);
+	ut_assertok(blk_get_device_by_str("usb", "3", &dev_desc));
+	ut_asserteq(4096, blk_dread(dev_desc, 0, 4096, buf));
+	ut_assertok(strcmp(buf, "this is a test"));
+	ut_assertok(uclass_get_device_by_name(UCLASS_USB_EMUL,
+					      "superspeed-stick@4", &emul));
+	ut_asserteq(2048, sandbox_usb_flash_get_max_read(emul));
+
+	free(buf);
+	ut_assertok(usb_stop());
+
+	return 0;
+}
+DM_TEST(dm_test_usb_flash_max_xfer, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
 /* test that we can handle multiple storage devices */
 static int dm_test_usb_multi(struct unit_test_state *uts)
 {
@@ -137,7 +174,7 @@ static int dm_test_usb_stop(struct unit_test_state *uts)
 	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 0, &dev));
 	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 1, &dev));
 	ut_assertok(uclass_get_device(UCLASS_MASS_STORAGE, 2, &dev));
-	ut_asserteq(6, count_usb_devices());
+	ut_asserteq(7, count_usb_devices());
 	ut_assertok(usb_stop());
 	ut_asserteq(0, count_usb_devices());
 
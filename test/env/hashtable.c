@@ -124,3 +124,75 @@ static int env_test_htab_deletes(struct unit_test_state *uts)
 }
 
 ENV_TEST(env_test_htab_deletes, 0);
+
+/* Grow the table well beyond its initial size, then shrink it again */
+static int env_test_htab_resize(struct unit_test_state *uts)
+{
+	struct hsearch_stats stats;
+	struct hsearch_data htab;
+	unsigned int min_size;
+	char key[20];
+	int i;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, hcreate_r(SIZE, &htab));
+	min_size = htab.size;
+
+	ut_assertok(htab_fill(uts, &htab, SIZE * 16));
+	ut_assertok(htab_check_fill(uts, &htab, SIZE * 16));
+	ut_asserteq(SIZE * 16, htab.filled);
+	ut_assert(htab.size > SIZE * 16);
+
+	/* The load factor stays below 3/4, so probe chains are short */
+	hstats_r(&htab, &stats);
+	ut_asserteq(SIZE * 16, stats.filled);
+	ut_assert(stats.filled * 4 <= stats.size * 3);
+	ut_assert(stats.probe_total < stats.filled * 2);
+
+	for (i = SIZE / 2; i < SIZE * 16; i++) {
+		sprintf(key, "%d", i);
+		ut_asserteq(1, hdelete_r(key, &htab, 0));
+	}
+	ut_assertok(htab_check_fill(uts, &htab, SIZE / 2));
+	ut_asserteq(SIZE / 2, htab.filled);
+	ut_assert(htab.size >= min_size && htab.size < SIZE * 4);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_resize, 0);
+
+/* Check that exports come out sorted, after imports and single changes */
+static int env_test_htab_export(struct unit_test_state *uts)
+{
+	static const char env[] = "c=3\0a=1\0d=4\0b=2\0";
+	struct hsearch_data htab;
+	struct env_entry item, *ritem;
+	char *res = NULL;
+
+	memset(&htab, 0, sizeof(htab));
+	ut_asserteq(1, himport_r(&htab, env, sizeof(env), '\0', 0, 0, 0,
+				 NULL));
+	ut_asserteq(4, htab.filled);
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=1\nb=2\nc=3\nd=4\n", res);
+	free(res);
+
+	item.callback = NULL;
+	item.flags = 0;
+	item.key = "bb";
+	item.data = "5";
+	ut_asserteq(1, hsearch_r(item, ENV_ENTER, &ritem, &htab, 0));
+	ut_asserteq(1, hdelete_r("c", &htab, 0));
+
+	res = NULL;
+	ut_assert(hexport_r(&htab, '\n', 0, &res, 0, 0, NULL) > 0);
+	ut_asserteq_str("a=1\nb=2\nbb=5\nd=4\n", res);
+	free(res);
+
+	hdestroy_r(&htab);
+	return 0;
+}
+
+ENV_TEST(env_test_htab_export, 0);
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the arena allocator
+ */
+
+#include <common.h>
+#include <arena.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+static int lib_test_arena(struct unit_test_state *uts)
+{
+	ulong start_mem = ut_check_free();
+	struct arena arena;
+	char *str, *big;
+	void *prev = NULL;
+	int i;
+
+	arena_begin(&arena);
+
+	/* Small allocations come from one block, aligned like malloc() */
+	for (i = 0; i < 16; i++) {
+		void *ptr = arena_alloc(&arena, i + 1);
+
+		ut_assertnonnull(ptr);
+		ut_asserteq(0, (ulong)ptr & (2 * sizeof(size_t) - 1));
+		if (prev)
+			ut_assert(ptr > prev);
+		memset(ptr, i, i + 1);
+		prev = ptr;
+	}
+
+	str = arena_strdup(&arena, "/path/to/file");
+	ut_assertnonnull(str);
+	ut_asserteq_str("/path/to/file", str);
+
+	/* A request larger than a block gets a block of its own */
+	big = arena_alloc(&arena, ARENA_BLOCK_SIZE * 4);
+	ut_assertnonnull(big);
+	memset(big, 0xaa, ARENA_BLOCK_SIZE * 4);
+	ut_asserteq_str("/path/to/file", str);
+
+	/* Everything is released at once */
+	arena_end(&arena);
+	ut_asserteq(0, ut_check_delta(start_mem));
+
+	/* The arena can be used again */
+	ut_assertnonnull(arena_alloc(&arena, 8));
+	arena_end(&arena);
+	ut_asserteq(0, ut_check_delta(start_mem));
+
+	return 0;
+}
+LIB_TEST(lib_test_arena, 0);
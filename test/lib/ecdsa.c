@@ -0,0 +1,217 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Unit test for ecdsa_verify() function
+ */
+
+#include <common.h>
+#include <command.h>
+#include <image.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+#include <u-boot/ecdsa.h>
+#include <linux/libfdt.h>
+
+/*
+ * dd if=/dev/urandom of=data.raw bs=128 count=1
+ *
+ * openssl ecparam -name prime256v1 -genkey -noout -out p256.pem
+ * openssl dgst -sha256 -sign p256.pem data.raw
+ *
+ * openssl ecparam -name secp384r1 -genkey -noout -out p384.pem
+ * openssl dgst -sha384 -sign p384.pem data.raw
+ *
+ * The public point is the last part of 'openssl ec -pubout -outform der' and
+ * the signature is r followed by s, taken from the DER output of openssl dgst.
+ */
+
+static unsigned char data_raw[] = {
+	0xc0, 0x1f, 0x35, 0x6b, 0xa8, 0x6a, 0x42, 0xbf, 0xbf, 0x3b, 0xce, 0xf7,
+	0x06, 0x72, 0x39, 0x1a, 0x25, 0xa5, 0x66, 0xc1, 0xef, 0x89, 0x0a, 0xc6,
+	0x0a, 0x47, 0x58, 0x9e, 0x33, 0xa8, 0x7a, 0xb0, 0x31, 0x1c, 0xd1, 0x6f,
+	0xb9, 0x15, 0xdd, 0x0e, 0x74, 0xc3, 0xad, 0x81, 0xd0, 0xda, 0x02, 0x17,
+	0xf5, 0x77, 0xfe, 0x8a, 0xe1, 0x3d, 0xa4, 0xcd, 0x96, 0xdc, 0xb6, 0x0d,
+	0xb5, 0x58, 0xa2, 0x68, 0x12, 0x40, 0x50, 0x97, 0xfb, 0x4b, 0x55, 0x09,
+	0x72, 0x58, 0x0d, 0x90, 0x8b, 0x11, 0x69, 0x78, 0x41, 0xfe, 0x0a, 0x6f,
+	0xc4, 0x8f, 0x04, 0x30, 0x6a, 0x70, 0x5b, 0xc8, 0x09, 0xb6, 0x88, 0xd1,
+	0x50, 0xd9, 0xb3, 0xc1, 0xe8, 0x97, 0xfd, 0x73, 0xb3, 0x9f, 0x95, 0xd9,
+	0xe1, 0xdf, 0x8d, 0x5d, 0xae, 0x81, 0x71, 0x75, 0x3a, 0x0b, 0x36, 0x58,
+	0x38, 0x0b, 0xa6, 0x4e, 0xd2, 0xf0, 0xed, 0x88
+};
+
+static unsigned char p256_x[] = {
+	0x52, 0xbc, 0x65, 0xab, 0x40, 0xc5, 0x9f, 0xe9, 0xa2, 0x10, 0x79, 0xf4,
+	0xfa, 0x9c, 0xaf, 0xc2, 0x2c, 0xdb, 0x3c, 0x73, 0x79, 0x90, 0x93, 0x02,
+	0x6d, 0xbd, 0x20, 0x02, 0xcc, 0x1d, 0xc5, 0x1a
+};
+
+static unsigned char p256_y[] = {
+	0x1b, 0x35, 0xc5, 0xf1, 0x9a, 0x47, 0xbe, 0x16, 0xe8, 0xfe, 0xa5, 0x33,
+	0xed, 0xf4, 0xa0, 0x43, 0x05, 0x36, 0xe9, 0x5b, 0x2f, 0xb8, 0x52, 0xa3,
+	0xba, 0x4b, 0xb0, 0xb2, 0x9b, 0xb3, 0x90, 0x26
+};
+
+static unsigned char p256_sig[] = {
+	0x1b, 0xd6, 0xc4, 0x0a, 0x0b, 0xe6, 0xb6, 0x1b, 0xe4, 0x76, 0x35, 0x25,
+	0xea, 0x75, 0x18, 0x16, 0x56, 0x03, 0x93, 0xa7, 0x53, 0xd3, 0xdd, 0x02,
+	0x91, 0x1c, 0xbf, 0xf5, 0xa0, 0x78, 0x6f, 0xe2, 0x76, 0x64, 0x60, 0xbd,
+	0xa1, 0x29, 0xce, 0xcc, 0x1a, 0x5d, 0x22, 0x3d, 0xff, 0x3e, 0x32, 0x98,
+	0xf4, 0x48, 0xba, 0x5f, 0x47, 0x38, 0xdb, 0x44, 0x79, 0x7d, 0xdb, 0x00,
+	0xef, 0xeb, 0x62, 0xe6
+};
+
+static unsigned char p384_x[] = {
+	0x68, 0x72, 0x52, 0xc2, 0x9c, 0x20, 0xc3, 0xc3, 0x2c, 0x82, 0x1e, 0xca,
+	0xb4, 0x35, 0x83, 0xc7, 0xd7, 0x5d, 0x96, 0x89, 0x00, 0x36, 0x61, 0xe9,
+	0x32, 0x55, 0xe6, 0x92, 0x8b, 0x53, 0xad, 0x9d, 0x27, 0xa0, 0xa1, 0x71,
+	0x15, 0x98, 0x05, 0x51, 0x39, 0xe9, 0x01, 0x03, 0xb0, 0xcf, 0xd9, 0xe5
+};
+
+static unsigned char p384_y[] = {
+	0xea, 0x13, 0x0f, 0x08, 0x6d, 0x60, 0xee, 0xee, 0x83, 0x28, 0x7c, 0x8b,
+	0x5f, 0x9e, 0x48, 0x29, 0x07, 0x81, 0xa7, 0xdb, 0x6d, 0xed, 0xb8, 0x18,
+	0xa5, 0x1e, 0xfe, 0x81, 0xc8, 0xc1, 0xeb, 0xfc, 0x51, 0x8e, 0x4c, 0x88,
+	0x0e, 0x85, 0x68, 0x39, 0xf3, 0x55, 0x54, 0x74, 0x42, 0xa0, 0x36, 0x2f
+};
+
+static unsigned char p384_sig[] = {
+	0x24, 0x45, 0x9f, 0x2c, 0x87, 0xa7, 0xb9, 0xd6, 0xc3, 0xde, 0x6e, 0xd3,
+	0x36, 0x88, 0xe4, 0x9c, 0xe2, 0x76, 0x7f, 0x2a, 0x3d, 0x3b, 0xda, 0xf3,
+	0x59, 0xf2, 0x7c, 0xd8, 0x59, 0xb5, 0x2d, 0x71, 0xae, 0x19, 0x7d, 0x6c,
+	0x99, 0x4f, 0x6d, 0x33, 0x6f, 0x87, 0x65, 0x68, 0x05, 0x36, 0x4b, 0x96,
+	0xf5, 0x0c, 0xac, 0x91, 0xb0, 0x5a, 0x22, 0xcc, 0xe2, 0xcd, 0x2c, 0x6d,
+	0x55, 0xdb, 0x3b, 0x9c, 0x91, 0xcd, 0x41, 0x84, 0xe9, 0x7a, 0x4b, 0x5a,
+	0xf6, 0x9d, 0x7f, 0x58, 0x7b, 0xef, 0x03, 0x9d, 0x82, 0x1e, 0x42, 0x3c,
+	0xe2, 0xf4, 0xf6, 0x02, 0xff, 0x07, 0xb0, 0x10, 0x85, 0xe5, 0x5c, 0x7b
+};
+
+/* Size of the device tree holding the public key */
+#define ECDSA_FDT_SIZE		1024
+
+/**
+ * ecdsa_setup() - Set up a device tree with a public key, ready to verify
+ *
+ * This adds the key as /signature/key-dev, as mkimage would.
+ *
+ * @uts:	unit test state
+ * @info:	Returns information for verification
+ * @fdt:	Buffer for the device tree, ECDSA_FDT_SIZE bytes
+ * @name:	Signature algorithm name, e.g. "sha256,ecdsa256"
+ * @curve:	Curve name for the ecdsa,curve property
+ * @x:		X coordinate of the public point
+ * @y:		Y coordinate of the public point
+ * @size:	Size of each coordinate in bytes
+ * Return:	0 = success, 1 = failure
+ */
+static int ecdsa_setup(struct unit_test_state *uts,
+		       struct image_sign_info *info, void *fdt,
+		       const char *name, const char *curve, const uint8_t *x,
+		       const uint8_t *y, int size)
+{
+	int node;
+
+	ut_assertok(fdt_create_empty_tree(fdt, ECDSA_FDT_SIZE));
+	node = fdt_add_subnode(fdt, 0, FIT_SIG_NODENAME);
+	ut_assert(node >= 0);
+	node = fdt_add_subnode(fdt, node, "key-dev");
+	ut_assert(node >= 0);
+	ut_assertok(fdt_setprop_string(fdt, node, FIT_KEY_HINT, "dev"));
+	ut_assertok(fdt_setprop_string(fdt, node, "ecdsa,curve", curve));
+	ut_assertok(fdt_setprop(fdt, node, "ecdsa,x-point", x, size));
+	ut_assertok(fdt_setprop(fdt, node, "ecdsa,y-point", y, size));
+	ut_assertok(fdt_setprop_string(fdt, node, FIT_ALGO_PROP, name));
+
+	memset(info, '\0', sizeof(*info));
+	info->name = name;
+	info->keyname = "dev";
+	info->checksum = image_get_checksum_algo(name);
+	info->crypto = image_get_crypto_algo(name);
+	info->fdt_blob = fdt;
+	info->required_keynode = -1;
+	ut_assertnonnull(info->checksum);
+	ut_assertnonnull(info->crypto);
+
+	return 0;
+}
+
+/**
+ * lib_ecdsa_verify_valid() - unit test for ecdsa_verify()
+ *
+ * Test ecdsa_verify() with valid signatures on both curves
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_ecdsa_verify_valid(struct unit_test_state *uts)
+{
+	struct image_sign_info info;
+	struct image_region reg;
+	char fdt[ECDSA_FDT_SIZE];
+
+	reg.data = data_raw;
+	reg.size = sizeof(data_raw);
+
+	ut_assertok(ecdsa_setup(uts, &info, fdt, "sha256,ecdsa256",
+				ECDSA_P256_NAME, p256_x, p256_y,
+				ECDSA256_BYTES));
+	ut_assertok(info.crypto->verify(&info, &reg, 1, p256_sig,
+					sizeof(p256_sig)));
+
+	ut_assertok(ecdsa_setup(uts, &info, fdt, "sha384,ecdsa384",
+				ECDSA_P384_NAME, p384_x, p384_y,
+				ECDSA384_BYTES));
+	ut_assertok(info.crypto->verify(&info, &reg, 1, p384_sig,
+					sizeof(p384_sig)));
+
+	return CMD_RET_SUCCESS;
+}
+
+LIB_TEST(lib_ecdsa_verify_valid, 0);
+
+/**
+ * lib_ecdsa_verify_invalid() - unit test for ecdsa_verify()
+ *
+ * Test ecdsa_verify() with a corrupted signature, changed data and a key which
+ * does not suit the algorithm
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_ecdsa_verify_invalid(struct unit_test_state *uts)
+{
+	struct image_sign_info info;
+	struct image_region reg;
+	char fdt[ECDSA_FDT_SIZE];
+	unsigned char ctmp;
+	int ret;
+
+	reg.data = data_raw;
+	reg.size = sizeof(data_raw);
+	ut_assertok(ecdsa_setup(uts, &info, fdt, "sha256,ecdsa256",
+				ECDSA_P256_NAME, p256_x, p256_y,
+				ECDSA256_BYTES));
+
+	/* corrupt s, then the data */
+	ctmp = p256_sig[ECDSA256_BYTES + 10];
+	p256_sig[ECDSA256_BYTES + 10] ^= 0x40;
+	ret = info.crypto->verify(&info, &reg, 1, p256_sig, sizeof(p256_sig));
+	p256_sig[ECDSA256_BYTES + 10] = ctmp;
+	ut_assertf(ret != 0, "verification unexpectedly succeeded\n");
+
+	ctmp = data_raw[5];
+	data_raw[5] ^= 0x01;
+	ret = info.crypto->verify(&info, &reg, 1, p256_sig, sizeof(p256_sig));
+	data_raw[5] = ctmp;
+	ut_assertf(ret != 0, "verification unexpectedly succeeded\n");
+
+	/* a P-384 key cannot check an ecdsa256 signature */
+	ut_assertok(ecdsa_setup(uts, &info, fdt, "sha256,ecdsa256",
+				ECDSA_P384_NAME, p384_x, p384_y,
+				ECDSA384_BYTES));
+	ret = info.crypto->verify(&info, &reg, 1, p256_sig, sizeof(p256_sig));
+	ut_assertf(ret != 0, "verification unexpectedly succeeded\n");
+
+	return CMD_RET_SUCCESS;
+}
+
+LIB_TEST(lib_ecdsa_verify_invalid, 0);
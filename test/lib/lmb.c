@@ -21,22 +21,22 @@ static int check_lmb(struct unit_test_state *uts, struct lmb *lmb,
 {
 	if (ram_size) {
 		ut_asserteq(lmb->memory.cnt, 1);
-		ut_asserteq(lmb->memory.region[0].base, ram_base);
-		ut_asserteq(lmb->memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb->memory)[0].base, ram_base);
+		ut_asserteq(lmb_regions(&lmb->memory)[0].size, ram_size);
 	}
 
 	ut_asserteq(lmb->reserved.cnt, num_reserved);
 	if (num_reserved > 0) {
-		ut_asserteq(lmb->reserved.region[0].base, base1);
-		ut_asserteq(lmb->reserved.region[0].size, size1);
+		ut_asserteq(lmb_regions(&lmb->reserved)[0].base, base1);
+		ut_asserteq(lmb_regions(&lmb->reserved)[0].size, size1);
 	}
 	if (num_reserved > 1) {
-		ut_asserteq(lmb->reserved.region[1].base, base2);
-		ut_asserteq(lmb->reserved.region[1].size, size2);
+		ut_asserteq(lmb_regions(&lmb->reserved)[1].base, base2);
+		ut_asserteq(lmb_regions(&lmb->reserved)[1].size, size2);
 	}
 	if (num_reserved > 2) {
-		ut_asserteq(lmb->reserved.region[2].base, base3);
-		ut_asserteq(lmb->reserved.region[2].size, size3);
+		ut_asserteq(lmb_regions(&lmb->reserved)[2].base, base3);
+		ut_asserteq(lmb_regions(&lmb->reserved)[2].size, size3);
 	}
 	return 0;
 }
@@ -82,14 +82,14 @@ static int test_multi_alloc(struct unit_test_state *uts, const phys_addr_t ram,
 
 	if (ram0_size) {
 		ut_asserteq(lmb.memory.cnt, 2);
-		ut_asserteq(lmb.memory.region[0].base, ram0);
-		ut_asserteq(lmb.memory.region[0].size, ram0_size);
-		ut_asserteq(lmb.memory.region[1].base, ram);
-		ut_asserteq(lmb.memory.region[1].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram0);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram0_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].size, ram_size);
 	} else {
 		ut_asserteq(lmb.memory.cnt, 1);
-		ut_asserteq(lmb.memory.region[0].base, ram);
-		ut_asserteq(lmb.memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram_size);
 	}
 
 	/* reserve 64KiB somewhere */
@@ -160,14 +160,14 @@ static int test_multi_alloc(struct unit_test_state *uts, const phys_addr_t ram,
 
 	if (ram0_size) {
 		ut_asserteq(lmb.memory.cnt, 2);
-		ut_asserteq(lmb.memory.region[0].base, ram0);
-		ut_asserteq(lmb.memory.region[0].size, ram0_size);
-		ut_asserteq(lmb.memory.region[1].base, ram);
-		ut_asserteq(lmb.memory.region[1].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram0);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram0_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[1].size, ram_size);
 	} else {
 		ut_asserteq(lmb.memory.cnt, 1);
-		ut_asserteq(lmb.memory.region[0].base, ram);
-		ut_asserteq(lmb.memory.region[0].size, ram_size);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].base, ram);
+		ut_asserteq(lmb_regions(&lmb.memory)[0].size, ram_size);
 	}
 
 	return 0;
@@ -659,3 +659,74 @@ static int lib_test_lmb_get_free_size(struct unit_test_state *uts)
 
 DM_TEST(lib_test_lmb_get_free_size,
 	UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
+
+/* Check that a large number of reservations grows the region table */
+static int lib_test_lmb_many_regions(struct unit_test_state *uts)
+{
+	const phys_addr_t ram = 0x40000000;
+	const phys_size_t ram_size = 0x20000000;
+	const int count = 4096;
+	struct lmb lmb, copy;
+	phys_addr_t a;
+	long ret;
+	int i;
+
+	lmb_init(&lmb);
+	ret = lmb_add(&lmb, ram, ram_size);
+	ut_asserteq(ret, 0);
+
+	/* a copy of a list which has not grown is independent */
+	copy = lmb;
+	ut_asserteq(lmb_reserve(&copy, ram, 0x1000), 0);
+	ut_asserteq(copy.reserved.cnt, 1);
+	ut_asserteq(lmb.reserved.cnt, 0);
+	ut_asserteq_ptr(lmb_regions(&copy.reserved), copy.reserved.initial);
+	ut_asserteq(lmb_regions(&copy.memory)[0].base, ram);
+	lmb_uninit(&copy);
+
+	/* reserve every other 4 KiB page, in an order that is not sorted */
+	for (i = 0; i < count; i++) {
+		int n = (i * 7) % count;
+
+		ret = lmb_reserve(&lmb, ram + n * 0x2000, 0x1000);
+		ut_asserteq(ret, 0);
+	}
+	ut_asserteq(lmb.reserved.cnt, count);
+	ut_assert(lmb.reserved.max > LMB_INITIAL_REGIONS);
+
+	for (i = 1; i < count; i++)
+		ut_assert(lmb_regions(&lmb.reserved)[i - 1].base <
+			  lmb_regions(&lmb.reserved)[i].base);
+
+	ut_assert(lmb_is_reserved(&lmb, ram + 0x1000 * 2 * 100));
+	ut_assert(!lmb_is_reserved(&lmb, ram + 0x1000 * (2 * 100 + 1)));
+	ut_asserteq(lmb_get_free_size(&lmb, ram + 0x1000), 0x1000);
+
+	/* a page-sized allocation fits into a gap, a bigger one only above */
+	a = lmb_alloc_base(&lmb, 0x1000, 0x1000, ram + count * 0x2000);
+	ut_asserteq(a, ram + (count - 1) * 0x2000 + 0x1000);
+	ut_asserteq(lmb.reserved.cnt, count);
+	ut_asserteq(lmb_free(&lmb, a, 0x1000), 0);
+	ut_asserteq(lmb.reserved.cnt, count);
+
+	a = lmb_alloc_base(&lmb, 0x2000, 0x1000, ram + count * 0x2000);
+	ut_asserteq(a, 0);
+
+	/* filling a gap merges its neighbours */
+	ret = lmb_reserve(&lmb, ram + 0x1000, 0x1000);
+	ut_assert(ret > 0);
+	ut_asserteq(lmb.reserved.cnt, count - 1);
+	ut_asserteq(lmb_free(&lmb, ram + 0x1000, 0x1000), 0);
+	ut_asserteq(lmb.reserved.cnt, count);
+
+	for (i = 0; i < count; i++)
+		ut_asserteq(lmb_free(&lmb, ram + i * 0x2000, 0x1000), 0);
+	ut_asserteq(lmb.reserved.cnt, 0);
+
+	lmb_uninit(&lmb);
+	ut_asserteq(lmb.reserved.max, LMB_INITIAL_REGIONS);
+
+	return 0;
+}
+
+DM_TEST(lib_test_lmb_many_regions, UT_TESTF_SCAN_PDATA | UT_TESTF_SCAN_FDT);
@@ -0,0 +1,58 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Tests for the slab front end of malloc()
+ */
+
+#include <common.h>
+#include <malloc.h>
+#include <test/lib.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+/* Index of the 48-byte size class */
+#define SLAB_CLASS_48	2
+
+static int lib_test_malloc_slab(struct unit_test_state *uts)
+{
+	struct malloc_slab_stats before, after;
+	char *p, *q;
+	int i;
+
+	ut_assertok(malloc_slab_get_stats(SLAB_CLASS_48, &before));
+	ut_asserteq(48, before.size);
+
+	p = malloc(40);
+	ut_assertnonnull(p);
+	ut_assertok(malloc_slab_get_stats(SLAB_CLASS_48, &after));
+	ut_asserteq(before.used + 1, after.used);
+	ut_asserteq(before.allocs + 1, after.allocs);
+	ut_asserteq(48, malloc_usable_size(p));
+
+	/* Shrinking stays in place, growing past the class moves it */
+	strcpy(p, "slab");
+	ut_asserteq_ptr(p, realloc(p, 48));
+	q = realloc(p, 1000);
+	ut_assertnonnull(q);
+	ut_asserteq_str("slab", q);
+	ut_assertok(malloc_slab_get_stats(SLAB_CLASS_48, &after));
+	ut_asserteq(before.used, after.used);
+	free(q);
+
+	/* calloc() must clear recycled slab objects */
+	p = malloc(40);
+	ut_assertnonnull(p);
+	memset(p, 0xaa, 40);
+	free(p);
+	p = calloc(1, 40);
+	ut_assertnonnull(p);
+	for (i = 0; i < 40; i++)
+		ut_asserteq(0, p[i]);
+	free(p);
+
+	ut_assertok(malloc_slab_get_stats(SLAB_CLASS_48, &after));
+	ut_asserteq(before.used, after.used);
+	ut_asserteq(-ENOENT, malloc_slab_get_stats(100, &after));
+
+	return 0;
+}
+LIB_TEST(lib_test_malloc_slab, 0);
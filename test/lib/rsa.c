@@ -129,6 +129,111 @@ unsigned char data_enc[] = {
 
 static unsigned int data_enc_len = 256;
 
+/*
+ * As above, with a 4096-bit key:
+ * openssl genrsa -out private_4096.pem 4096
+ * openssl rsa -in private_4096.pem -pubout -outform der -out public_4096.der
+ * dd if=public_4096.der of=public_4096.raw bs=24 skip=1
+ */
+static unsigned char public_key_4096[] = {
+	0x30, 0x82, 0x02, 0x0a, 0x02, 0x82, 0x02, 0x01, 0x00, 0xc0, 0xeb, 0xc1,
+	0x98, 0x53, 0xfa, 0x81, 0xe2, 0xa0, 0x60, 0xf0, 0x4b, 0xc8, 0x90, 0xae,
+	0xaa, 0xaa, 0xe3, 0x94, 0xae, 0x77, 0x81, 0xe3, 0x64, 0xaa, 0x90, 0x56,
+	0xb5, 0x59, 0x74, 0xae, 0xdd, 0xf9, 0xa7, 0xe5, 0x1a, 0xa7, 0x10, 0x48,
+	0x93, 0xc1, 0x8f, 0x0a, 0x9c, 0x29, 0x6a, 0x61, 0xfb, 0x54, 0x0b, 0xcb,
+	0x2d, 0xbb, 0x92, 0x94, 0x1e, 0xd3, 0x61, 0xcc, 0x04, 0x62, 0x4e, 0x86,
+	0xa3, 0xd3, 0x9d, 0x82, 0xd0, 0x9b, 0x3f, 0x0c, 0x8c, 0xde, 0x3c, 0x4d,
+	0x78, 0xf5, 0xfb, 0x11, 0x83, 0x60, 0xc4, 0x92, 0xe3, 0x10, 0x8f, 0xf5,
+	0x0d, 0xe1, 0x1e, 0x52, 0x6b, 0x01, 0x6b, 0x34, 0x45, 0xd0, 0x0d, 0x21,
+	0x31, 0xbb, 0x03, 0xea, 0x03, 0xf1, 0xcd, 0xf7, 0xac, 0x45, 0xc4, 0xa8,
+	0xcf, 0xdb, 0xd2, 0xfa, 0x35, 0x22, 0x24, 0xfd, 0x1f, 0xff, 0x8a, 0x3a,
+	0x6c, 0x1c, 0xed, 0xfc, 0x10, 0xb6, 0x3f, 0x65, 0x79, 0x8b, 0xef, 0xaa,
+	0x83, 0xee, 0x56, 0x28, 0x73, 0x78, 0x4f, 0xbd, 0x8b, 0xef, 0xf2, 0x01,
+	0xb8, 0xd2, 0x85, 0xbe, 0x65, 0x91, 0x9c, 0x20, 0x7d, 0xf8, 0x77, 0x0f,
+	0x55, 0xf1, 0xa7, 0xb9, 0xff, 0x12, 0x84, 0x05, 0x28, 0x0b, 0x8d, 0x53,
+	0x80, 0xc1, 0xe6, 0x98, 0x81, 0xaf, 0xe3, 0x8d, 0xb2, 0x0c, 0xa9, 0xe3,
+	0x9c, 0x39, 0x24, 0xa2, 0x9c, 0x73, 0xb8, 0x91, 0x8d, 0xc2, 0xb0, 0xfe,
+	0x18, 0x43, 0x46, 0xdc, 0x2a, 0xc2, 0xa3, 0x73, 0xe5, 0xcb, 0x2f, 0xd0,
+	0xfa, 0xe3, 0xa6, 0xdf, 0x6a, 0xe9, 0xda, 0xe2, 0x24, 0x63, 0xe9, 0x6d,
+	0xfa, 0x6c, 0xbf, 0x3a, 0x70, 0x94, 0x51, 0x68, 0x0b, 0xa8, 0x76, 0x28,
+	0xb4, 0x33, 0x2c, 0xf0, 0x46, 0x22, 0x7e, 0x8e, 0x9f, 0xe4, 0x55, 0x30,
+	0xfa, 0xcd, 0xc7, 0x64, 0xbb, 0x86, 0x9d, 0x15, 0xb1, 0x6b, 0x6d, 0xf8,
+	0x5c, 0xc0, 0xde, 0xb8, 0x3b, 0x9a, 0xc1, 0x44, 0xca, 0xa9, 0xed, 0xe5,
+	0xe4, 0x1a, 0x47, 0x46, 0xeb, 0x2e, 0xe5, 0xe6, 0x9a, 0x10, 0xd4, 0x00,
+	0x7d, 0xa4, 0x84, 0x49, 0x6d, 0x41, 0x18, 0x4d, 0x86, 0x29, 0xc0, 0x3a,
+	0x4c, 0x4b, 0x35, 0xb3, 0xd4, 0x5f, 0x1c, 0x61, 0xe4, 0x9c, 0xa4, 0x58,
+	0x6b, 0xca, 0x22, 0x3a, 0xd2, 0xa2, 0xce, 0x0a, 0xf1, 0xa5, 0x4b, 0x0c,
+	0x7f, 0xd0, 0xd2, 0x1d, 0xca, 0x83, 0x08, 0x79, 0xc6, 0x0a, 0xe9, 0x5c,
+	0x0f, 0x0c, 0x58, 0x55, 0xd0, 0x74, 0x9a, 0x6d, 0x9f, 0xe1, 0x75, 0xea,
+	0x67, 0xa7, 0xf6, 0x93, 0x18, 0x5f, 0x9f, 0x92, 0xf7, 0xfa, 0x31, 0x4e,
+	0x91, 0x09, 0x0f, 0x62, 0xae, 0xeb, 0x19, 0x31, 0xa3, 0x44, 0x8d, 0x68,
+	0xa1, 0xe2, 0x2e, 0x34, 0x1e, 0xa4, 0x11, 0x77, 0x9e, 0x63, 0x26, 0x86,
+	0x50, 0x95, 0x94, 0xb0, 0x6d, 0xa6, 0x8b, 0x89, 0x28, 0xcb, 0x1a, 0x72,
+	0xb7, 0x13, 0x39, 0xa8, 0xb4, 0x65, 0xcc, 0x5d, 0x9f, 0x78, 0x4a, 0x6a,
+	0x23, 0x3c, 0x81, 0x43, 0x21, 0x95, 0x77, 0xd8, 0x8c, 0xa0, 0x4b, 0x37,
+	0x3d, 0xfc, 0x49, 0x1d, 0xf8, 0xf6, 0xb0, 0x50, 0x75, 0x8a, 0x67, 0x03,
+	0xf9, 0x92, 0x57, 0x7c, 0x3f, 0xed, 0x84, 0x3e, 0xa5, 0x25, 0x11, 0x96,
+	0xf2, 0x6d, 0x14, 0x83, 0x15, 0xeb, 0xfe, 0x99, 0xd8, 0x02, 0x20, 0x57,
+	0x64, 0xea, 0xed, 0x74, 0x07, 0x13, 0x90, 0x3c, 0xc3, 0xff, 0x96, 0xa0,
+	0xc8, 0x0c, 0xfd, 0x62, 0x8d, 0x2a, 0xa4, 0x8b, 0xaf, 0xea, 0xa3, 0x1d,
+	0xa7, 0x0b, 0x93, 0xea, 0x9a, 0x46, 0x2f, 0x96, 0x57, 0x24, 0x79, 0x52,
+	0x49, 0x31, 0xfb, 0xf6, 0x29, 0xd7, 0x0c, 0x48, 0xf9, 0xb7, 0xb7, 0xca,
+	0x37, 0x06, 0x9d, 0x72, 0x69, 0x95, 0x31, 0x3d, 0x4c, 0x89, 0x2a, 0x33,
+	0xf6, 0x88, 0xbc, 0x6f, 0x81, 0x02, 0x03, 0x01, 0x00, 0x01
+};
+static unsigned int public_key_4096_len = 526;
+
+/*
+ * openssl dgst -sha256 -sign private_4096.pem -out data_4096.enc data.raw
+ */
+static unsigned char data_enc_4096[] = {
+	0x32, 0x39, 0x35, 0x86, 0xcf, 0xb7, 0x03, 0xb5, 0x42, 0x6c, 0x8d, 0x3f,
+	0x5a, 0x83, 0x29, 0x53, 0xe8, 0x46, 0x82, 0x9d, 0xcf, 0xe2, 0x9c, 0x60,
+	0x91, 0x41, 0x62, 0x0c, 0x8c, 0xb7, 0xdb, 0xc3, 0x06, 0x53, 0xa0, 0x4b,
+	0x60, 0xad, 0x6a, 0x59, 0xa8, 0x9b, 0x79, 0xaa, 0xb7, 0x5f, 0xa7, 0x44,
+	0x20, 0x0d, 0x82, 0x92, 0x12, 0x35, 0xa9, 0xf0, 0x67, 0xdb, 0xa2, 0xba,
+	0x79, 0x77, 0x93, 0x1f, 0x1e, 0x4a, 0x62, 0xb1, 0x23, 0x13, 0x91, 0xcb,
+	0xa1, 0xed, 0xe0, 0x32, 0xc6, 0x19, 0x91, 0x9b, 0x96, 0xd1, 0xf2, 0x92,
+	0x76, 0xe4, 0x95, 0x3b, 0x48, 0x70, 0x9c, 0x53, 0xad, 0x07, 0x81, 0x1c,
+	0x1b, 0xd8, 0x4c, 0xaa, 0x31, 0xfc, 0x24, 0x0c, 0x35, 0x78, 0x24, 0x53,
+	0x81, 0xef, 0xdb, 0xf3, 0x40, 0xd2, 0xbf, 0x31, 0xe9, 0xa4, 0xf2, 0x77,
+	0x2a, 0x9e, 0xef, 0xf4, 0x9f, 0x01, 0x94, 0x95, 0xe9, 0x82, 0xf7, 0xed,
+	0xba, 0x8a, 0x30, 0x55, 0x29, 0x6d, 0x7a, 0x36, 0xa9, 0x80, 0xd9, 0x96,
+	0x07, 0x46, 0x62, 0xd8, 0x50, 0x11, 0x00, 0xaa, 0x0f, 0x35, 0xcb, 0xe2,
+	0xd2, 0x98, 0xb9, 0x21, 0xd4, 0x53, 0x5b, 0xc5, 0x05, 0xce, 0x73, 0x89,
+	0x3c, 0xb2, 0x59, 0xef, 0x7d, 0x2e, 0xf3, 0x20, 0x00, 0xa6, 0x69, 0xdf,
+	0x4b, 0x52, 0x58, 0x66, 0x0a, 0xb8, 0xda, 0xba, 0x5c, 0x66, 0xce, 0x05,
+	0xf1, 0x81, 0x5d, 0x44, 0x52, 0x96, 0x11, 0x14, 0x1d, 0x71, 0xbd, 0x41,
+	0x3b, 0xb5, 0x77, 0x41, 0x03, 0xa8, 0xd1, 0x0a, 0x49, 0xe7, 0x88, 0x91,
+	0x28, 0xae, 0x5c, 0x80, 0xf8, 0xf0, 0xdc, 0x47, 0xee, 0xdc, 0x5e, 0xd1,
+	0xe5, 0x74, 0x9e, 0xb9, 0xcc, 0x60, 0x40, 0x2e, 0x41, 0xd8, 0xba, 0x61,
+	0xd0, 0x5b, 0xe6, 0xc6, 0xb3, 0x4f, 0x9e, 0xbc, 0x30, 0x4d, 0xb2, 0x4c,
+	0x3e, 0x97, 0x62, 0x3e, 0x80, 0x07, 0xbd, 0x4c, 0xd4, 0xca, 0x1e, 0x97,
+	0xb5, 0xe1, 0x95, 0x5d, 0xd3, 0x93, 0xf1, 0x11, 0xfd, 0xd6, 0x02, 0x42,
+	0x7e, 0x81, 0xa1, 0x8e, 0xb7, 0x5e, 0x6e, 0x24, 0x81, 0x91, 0x66, 0x9e,
+	0xa8, 0xa4, 0xaf, 0x69, 0xee, 0x60, 0x92, 0xa3, 0x5f, 0x73, 0x02, 0x6a,
+	0x6e, 0xb3, 0xe9, 0xee, 0xd8, 0x24, 0x2f, 0x69, 0xdd, 0x94, 0x71, 0x43,
+	0x87, 0x96, 0x46, 0x0f, 0xaf, 0x95, 0xa1, 0xea, 0x18, 0x7c, 0x49, 0xce,
+	0x62, 0xce, 0x79, 0x0a, 0x35, 0xf2, 0x30, 0x70, 0xc9, 0xc0, 0xb3, 0x86,
+	0xd0, 0x1a, 0x53, 0x4f, 0xd5, 0xdc, 0xf4, 0x62, 0xdf, 0x7a, 0x5d, 0x72,
+	0x6e, 0x0b, 0xfa, 0xf4, 0x53, 0xe0, 0xb1, 0x08, 0x54, 0x9a, 0x0a, 0xae,
+	0xca, 0x9e, 0xe3, 0x15, 0xf9, 0x84, 0xc8, 0x2e, 0x19, 0x7a, 0xa5, 0xcf,
+	0x9a, 0xa4, 0x32, 0xec, 0xac, 0x51, 0x78, 0xc1, 0x50, 0x84, 0x72, 0xc8,
+	0x4d, 0x59, 0x6f, 0xcc, 0xc2, 0x46, 0x29, 0x5f, 0xf1, 0xf3, 0xdb, 0xe7,
+	0x88, 0xb5, 0x01, 0x43, 0xa4, 0x28, 0xa6, 0xf9, 0xee, 0x27, 0x7a, 0xaa,
+	0xf7, 0xbb, 0x9e, 0x2e, 0xf6, 0x3b, 0xc3, 0xa0, 0x9a, 0xf2, 0xe7, 0x79,
+	0x99, 0x61, 0x62, 0x56, 0x45, 0x7f, 0xb8, 0xad, 0x10, 0x80, 0x72, 0xa4,
+	0xca, 0xea, 0x73, 0x24, 0x06, 0x0d, 0xb9, 0x4a, 0x0e, 0xd0, 0x9a, 0x4a,
+	0xb4, 0x72, 0x46, 0x5a, 0x3d, 0xe6, 0x3e, 0x00, 0xee, 0x2d, 0xb6, 0x32,
+	0xd0, 0x86, 0x07, 0x53, 0xcf, 0xcc, 0xe4, 0x9f, 0x07, 0x1e, 0xa0, 0x8c,
+	0xa5, 0xfc, 0xd0, 0xe1, 0x7e, 0x2f, 0x5b, 0xa9, 0x63, 0x50, 0xf0, 0xd8,
+	0xd9, 0xe5, 0xd2, 0x2c, 0x60, 0x7d, 0x78, 0xb0, 0xef, 0x7e, 0xea, 0xf2,
+	0x27, 0xc7, 0x7c, 0x88, 0x5a, 0x0a, 0x4e, 0xe6, 0xba, 0x75, 0xb0, 0x6b,
+	0xc6, 0x48, 0xa7, 0x95, 0x76, 0x79, 0xee, 0x21
+};
+
+static unsigned int data_enc_4096_len = 512;
+
 /**
  * lib_rsa_verify_valid() - unit test for rsa_verify()
  *
@@ -203,4 +308,37 @@ static int lib_rsa_verify_invalid(struct unit_test_state *uts)
 }
 
 LIB_TEST(lib_rsa_verify_invalid, 0);
+
+/**
+ * lib_rsa_verify_valid_4096() - unit test for rsa_verify()
+ *
+ * Test rsa_verify() with valid hash and a 4096-bit key
+ *
+ * @uts:	unit test state
+ * Return:	0 = success, 1 = failure
+ */
+static int lib_rsa_verify_valid_4096(struct unit_test_state *uts)
+{
+	struct image_sign_info info;
+	struct image_region reg;
+	int ret;
+
+	memset(&info, '\0', sizeof(info));
+	info.name = "sha256,rsa4096";
+	info.padding = image_get_padding_algo("pkcs-1.5");
+	info.checksum = image_get_checksum_algo("sha256,rsa4096");
+	info.crypto = image_get_crypto_algo(info.name);
+
+	info.key = public_key_4096;
+	info.keylen = public_key_4096_len;
+
+	reg.data = data_raw;
+	reg.size = data_raw_len;
+	ret = rsa_verify(&info, &reg, 1, data_enc_4096, data_enc_4096_len);
+	ut_assertf(ret == 0, "verification unexpectedly failed (%d)\n", ret);
+
+	return CMD_RET_SUCCESS;
+}
+
+LIB_TEST(lib_rsa_verify_valid_4096, 0);
 #endif /* RSA_VERIFY_WITH_PKEY */
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Logging function tests for CONFIG_LOG_BINARY=y.
+ */
+
+/* Override CONFIG_LOG_MAX_LEVEL */
+#define LOG_DEBUG
+
+#include <common.h>
+#include <console.h>
+#include <log.h>
+#include <test/log.h>
+#include <test/test.h>
+#include <test/ut.h>
+
+DECLARE_GLOBAL_DATA_PTR;
+
+/**
+ * check_dump_line() - check the next record written by log_binary_dump()
+ *
+ * @uts:	unit test state
+ * @expect:	expected message, which follows the timestamp
+ * Return:	0 = success
+ */
+static int check_dump_line(struct unit_test_state *uts, const char *expect)
+{
+	char *msg;
+
+	ut_assert(console_record_readline(uts->actual_str,
+					  sizeof(uts->actual_str)) > 0);
+	ut_asserteq('[', uts->actual_str[0]);
+	msg = strstr(uts->actual_str, "] ");
+	ut_assertnonnull(msg);
+	ut_asserteq_str(expect, msg + 2);
+
+	return 0;
+}
+
+static int log_test_binary(struct unit_test_state *uts)
+{
+	int old_log_level = gd->default_log_level;
+	u8 mac[] = { 0x00, 0x11, 0x22, 0x33, 0x44, 0x55 };
+	/* Hide the NULL from the compiler, which warns about it for %s */
+	const char *volatile null_str = NULL;
+
+	gd->log_fmt = BIT(LOGF_MSG);
+	gd->default_log_level = LOGL_INFO;
+	log_info("binlog %d %s %5lx %-3c|%.*s|\n", -12, "str", 0xabcUL, 'z', 2,
+		 "xyz");
+	log_info("100%% %llu %s\n", 1ULL << 40, null_str);
+	/* This cannot be stored as arguments, so is formatted straight away */
+	log_info("mac %pM\n", mac);
+	/* Below the default level, so only the binary driver sees this */
+	log_debug("debug %u\n", 7U);
+	gd->default_log_level = old_log_level;
+
+	console_record_reset_enable();
+	log_binary_dump(4);
+	gd->flags &= ~GD_FLG_RECORD;
+	gd->log_fmt = log_get_default_format();
+
+	ut_assertok(check_dump_line(uts, "binlog -12 str   abc z  |xy|"));
+	ut_assertok(check_dump_line(uts, "100% 1099511627776 <NULL>"));
+	ut_assertok(check_dump_line(uts, "mac 00:11:22:33:44:55"));
+	ut_assertok(check_dump_line(uts, "debug 7"));
+	ut_assertok(ut_check_console_end(uts));
+
+	return 0;
+}
+LOG_TEST(log_test_binary);
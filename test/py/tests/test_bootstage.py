@@ -0,0 +1,73 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test the bootstage command, including exporting boot timing spans as a Chrome
+trace-event file.
+"""
+
+import json
+import os
+import pytest
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_bootstage_report(u_boot_console):
+    """Test that 'bootstage report' shows the timing summary."""
+    output = u_boot_console.run_command('bootstage report')
+    assert 'Timer summary in microseconds' in output
+    assert 'reset' in output
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_trace')
+def test_bootstage_span_report(u_boot_console):
+    """Test that 'bootstage report' includes the span histogram."""
+    output = u_boot_console.run_command('bootstage report')
+    assert 'Spans (' in output
+    lines = output.splitlines()
+    for cat in ('stage', 'probe', 'cmd'):
+        assert any(line.startswith(cat + ' ') for line in lines)
+
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_trace')
+def test_bootstage_export_mem(u_boot_console):
+    """Test writing the trace to memory."""
+    cons = u_boot_console
+    cons.run_command('setenv filesize')
+    output = cons.run_command('bootstage export 1000 && echo ok')
+    assert output.endswith('ok')
+    output = cons.run_command('printenv filesize')
+    assert int(output.split('=')[1], 16) > 0
+
+    # Starts with '{"display'
+    output = cons.run_command('md.b 1000 a')
+    assert '7b 22 64 69 73 70 6c 61 79' in output
+
+    output = cons.run_command('bootstage export 1000 10')
+    assert 'Trace needs' in output
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+@pytest.mark.buildconfigspec('bootstage_trace')
+def test_bootstage_export_host(u_boot_console):
+    """Test writing the trace to a host file and check that it is valid."""
+    cons = u_boot_console
+    fname = os.path.join(cons.config.result_dir, 'bootstage.json')
+    if os.path.exists(fname):
+        os.remove(fname)
+    cons.run_command('bootstage export -f %s' % fname)
+    with open(fname) as inf:
+        trace = json.load(inf)
+
+    events = trace['traceEvents']
+    marks = [ev for ev in events if ev['ph'] == 'i']
+    spans = [ev for ev in events if ev['ph'] == 'X']
+    assert any(ev['name'] == 'reset' and ev['ts'] == 0 for ev in marks)
+    assert any(ev['cat'] == 'probe' for ev in spans)
+
+    for ev in spans:
+        assert ev['dur'] >= 0
+
+    # The export command itself is running, so its span is still open. It is
+    # only recorded if the span table has not filled up already.
+    if not trace['otherData']['spans_dropped']:
+        cmds = [ev for ev in spans if ev['cat'] == 'cmd']
+        assert cmds[-1]['name'] == 'bootstage'
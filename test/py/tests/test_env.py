@@ -358,9 +358,13 @@ def test_env_info(state_test_env):
             assert '= true' in l or '= false' in l
             nb_line += 1
         else:
-            assert true
+            assert True
     assert nb_line == 3
 
+    response = c.run_command('env info -s')
+    assert 'env_entries = ' in response
+    assert 'env_table_size = ' in response
+
     response = c.run_command('env info -p -d')
     assert 'Default environment is used' in response or "Environment was loaded from persistent storage" in response
     assert 'Environment can be persisted' in response or "Environment cannot be persisted" in response
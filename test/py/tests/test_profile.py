@@ -0,0 +1,39 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Test the sampling profiler, which uses SIGPROF on sandbox.
+"""
+
+import pytest
+import re
+
+@pytest.mark.boardspec('sandbox')
+@pytest.mark.buildconfigspec('cmd_profile')
+def test_profile(u_boot_console):
+    """Test that samples are collected and can be dumped to memory."""
+    cons = u_boot_console
+    cons.run_command('profile start 5000')
+
+    # Burn some CPU time so that there is something to sample
+    for _ in range(5):
+        cons.run_command('crc32 0 2000000')
+    cons.run_command('profile stop')
+
+    output = cons.run_command('profile stats')
+    assert 'Profiling is stopped' in output
+    samples = int(re.search(r'(\d+) samples at 5000 Hz', output).group(1))
+    assert samples > 0
+
+    # The header is followed by a 36-byte record for each sample
+    output = cons.run_command('profile samples 1000 100000')
+    assert 'Profile samples dumped to 00001000' in output
+    size = int(re.search(r'size (0x[0-9a-f]+)', output).group(1), 16)
+    assert size > samples * 36
+    output = cons.run_command('printenv profoffset')
+    assert output == 'profoffset=%x' % size
+
+    # Starting again discards the old samples
+    cons.run_command('profile start')
+    cons.run_command('profile stop')
+    output = cons.run_command('profile stats')
+    assert ' samples at 1000 Hz' in output
@@ -43,3 +43,30 @@ def test_shell_run(u_boot_console):
     u_boot_console.run_command('setenv foo')
     u_boot_console.run_command('setenv monty')
     u_boot_console.run_command('setenv python')
+
+@pytest.mark.buildconfigspec('hush_parser')
+def test_shell_run_again(u_boot_console):
+    """Test running the same variable several times, changing it in between.
+
+    With CONFIG_HUSH_PARSE_CACHE the script is only parsed the first time,
+    so check that it is parsed again when changed and that leaving a loop
+    early does not upset the next run."""
+
+    cons = u_boot_console
+    cons.run_command('setenv foo \'for i in a b c; do echo ${pre}$i; ' +
+                     'if test $i = ${stop}; then exit; fi; done\'')
+    cons.run_command('setenv pre x; setenv stop none')
+    for _ in range(2):
+        response = cons.run_command('run foo')
+        assert response.split() == ['xa', 'xb', 'xc']
+    cons.run_command('setenv pre y; setenv stop b')
+    response = cons.run_command('run foo')
+    assert response.split() == ['ya', 'yb']
+    response = cons.run_command('run foo')
+    assert response.split() == ['ya', 'yb']
+    cons.run_command('setenv foo echo changed')
+    response = cons.run_command('run foo')
+    assert response.strip() == 'changed'
+    cons.run_command('setenv foo')
+    cons.run_command('setenv pre')
+    cons.run_command('setenv stop')
@@ -0,0 +1,85 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Boot from SPL straight to an OS payload (falcon mode) and check how long each
+phase takes, using the bootstage records which SPL stashes for the payload.
+
+On sandbox the payload is U-Boot itself, wrapped in a legacy image which is
+marked as Linux, so it picks up the stash and can run 'bootstage report'.
+"""
+
+import os
+import pytest
+import re
+import u_boot_utils as util
+
+# Address to load the OS payload to, in sandbox RAM
+LOAD_ADDR = 0x1000000
+
+# Default upper limits for each phase, in microseconds. These are generous,
+# since the test runs on a shared host. A board can set env__spl_falcon_limits
+# to a dict with some or all of these keys to tighten them.
+DEFAULT_LIMITS = {
+    'spl_media': 100000,
+    'spl_read': 1000000,
+    'spl_fixup': 100000,
+    'spl_jump': 100000,
+}
+
+def get_accum_times(output):
+    """Get the accumulated times from a bootstage report
+
+    Args:
+        output: Output from 'bootstage report'
+
+    Returns:
+        dict: key: record name, value: time in microseconds
+    """
+    times = {}
+    accum = False
+    for line in output.splitlines():
+        if line.startswith('Accumulated time:'):
+            accum = True
+        elif accum:
+            m = re.match(r'^\s+([\d,]+)\s+(\S+)$', line)
+            if not m:
+                break
+            times[m.group(2)] = int(m.group(1).replace(',', ''))
+    return times
+
+@pytest.mark.boardspec('sandbox_spl')
+@pytest.mark.buildconfigspec('spl_os_boot')
+@pytest.mark.buildconfigspec('spl_legacy_image_support')
+@pytest.mark.buildconfigspec('spl_bootstage')
+@pytest.mark.buildconfigspec('bootstage_stash')
+@pytest.mark.buildconfigspec('cmd_bootstage')
+def test_spl_falcon(u_boot_console):
+    """Test booting an OS from SPL and check the time for each phase"""
+    cons = u_boot_console
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+    payload = os.path.join(cons.config.build_dir, 'u-boot')
+    fname = os.path.join(cons.config.result_dir, 'falcon-os.img')
+    util.run_and_log(cons, [mkimage, '-A', 'sandbox', '-O', 'linux',
+                            '-T', 'kernel', '-C', 'none',
+                            '-a', '%x' % LOAD_ADDR, '-e', '%x' % LOAD_ADDR,
+                            '-n', 'falcon', '-d', payload, fname])
+
+    limits = dict(DEFAULT_LIMITS)
+    limits.update(cons.config.env.get('env__spl_falcon_limits', {}))
+    try:
+        cons.restart_uboot_with_flags(['--spl_os', fname])
+        output = cons.run_command('bootstage report')
+    finally:
+        # Go back to booting U-Boot normally
+        cons.restart_uboot()
+
+    times = get_accum_times(output)
+    for phase, limit in sorted(limits.items()):
+        assert phase in times, "No time recorded for '%s'" % phase
+        cons.log.info('%s: %d us (limit %d us)' % (phase, times[phase], limit))
+    for phase, limit in limits.items():
+        assert times[phase] <= limit, "'%s' took %d us, limit is %d us" % (
+            phase, times[phase], limit)
+
+    # The media init is part of reading the image
+    assert times['spl_media'] <= times['spl_read']
@@ -0,0 +1,205 @@
+# SPDX-License-Identifier: GPL-2.0+
+
+"""
+Load a FIT with external data from SPL and check where each image ends up.
+
+Sandbox SPL reads the FIT given with --spl_fit as if it were on a block
+device. It prints the address, size and CRC32 of each image it loads, then
+starts U-Boot as usual.
+
+The FIT covers:
+  - two uncompressed loadables which are next to each other, both in the FIT
+    and in memory, so SPL can read them together
+  - an LZ4 loadable with 64KB blocks, which SPL decompresses as it reads it
+  - an LZ4 loadable with 4MB blocks, which SPL reads in full and then
+    decompresses; 'lz4' only uses these for inputs larger than 1MB
+  - a zstd loadable, which SPL decompresses as it reads it
+"""
+
+import os
+import pytest
+import random
+import re
+import zlib
+import u_boot_utils as util
+
+ITS = '''
+/dts-v1/;
+
+/ {
+	description = "SPL loading test";
+	#address-cells = <1>;
+
+	images {
+		u-boot {
+			data = /incbin/("%(firmware)s");
+			type = "firmware";
+			arch = "sandbox";
+			os = "u-boot";
+			compression = "none";
+			load = <0x2000000>;
+		};
+		fdt-1 {
+			data = /incbin/("%(fdt)s");
+			type = "flat_dt";
+			arch = "sandbox";
+			compression = "none";
+		};
+		data-1 {
+			data = /incbin/("%(data1)s");
+			type = "firmware";
+			arch = "sandbox";
+			compression = "none";
+			load = <0x2100000>;
+		};
+		data-2 {
+			data = /incbin/("%(data2)s");
+			type = "firmware";
+			arch = "sandbox";
+			compression = "none";
+			load = <0x%(data2_load)x>;
+		};
+		lz4-small-blocks {
+			data = /incbin/("%(lz4_small)s");
+			type = "firmware";
+			arch = "sandbox";
+			compression = "lz4";
+			load = <0x2200000>;
+		};
+		lz4-large-blocks {
+			data = /incbin/("%(lz4_large)s");
+			type = "firmware";
+			arch = "sandbox";
+			compression = "lz4";
+			load = <0x2300000>;
+		};
+		zstd {
+			data = /incbin/("%(zstd)s");
+			type = "firmware";
+			arch = "sandbox";
+			compression = "zstd";
+			load = <0x2500000>;
+		};
+	};
+
+	configurations {
+		default = "conf-1";
+		conf-1 {
+			firmware = "u-boot";
+			fdt = "fdt-1";
+			loadables = "data-1", "data-2", "lz4-small-blocks",
+				"lz4-large-blocks", "zstd";
+		};
+	};
+};
+'''
+
+FDT = '''
+/dts-v1/;
+
+/ {
+	#address-cells = <1>;
+	#size-cells = <0>;
+	model = "SPL loading test";
+};
+'''
+
+WORDS = [b'sandbox', b'loads', b'a', b'FIT', b'from', b'SPL', b'with',
+         b'external', b'data', b'and', b'checks', b'each', b'image']
+
+# This compresses well, so the staged copy of it is small
+LARGE_TEXT = b'Read this in full before decompressing it.\n'
+
+def make_text(size, seed):
+    """Make some compressible data
+
+    Args:
+        size: Number of bytes to make
+        seed: Seed for the random choice of words
+
+    Returns:
+        bytes: The data
+    """
+    rand = random.Random(seed)
+    out = bytearray()
+    while len(out) < size:
+        out += rand.choice(WORDS) + b' '
+    return bytes(out[:size])
+
+@pytest.mark.boardspec('sandbox_spl')
+@pytest.mark.buildconfigspec('spl_load_fit')
+@pytest.mark.buildconfigspec('spl_lz4')
+@pytest.mark.buildconfigspec('spl_zstd')
+@pytest.mark.requiredtool('dtc')
+@pytest.mark.requiredtool('lz4')
+@pytest.mark.requiredtool('zstd')
+def test_spl_fit(u_boot_console):
+    """Test loading images from a FIT in SPL"""
+    cons = u_boot_console
+    mkimage = os.path.join(cons.config.build_dir, 'tools', 'mkimage')
+
+    def make_fname(leaf):
+        return os.path.join(cons.config.result_dir, 'spl-fit-' + leaf)
+
+    def write_file(leaf, data):
+        fname = make_fname(leaf)
+        with open(fname, 'wb') as fd:
+            fd.write(data)
+        return fname
+
+    # Each image's name, load address and data once decompressed
+    rand = random.Random(0)
+    expect = {
+        'firmware': (0x2000000, bytes(rand.getrandbits(8)
+                                      for i in range(0x10000))),
+        'data-1': (0x2100000, make_text(0x10000, 1)),
+        'data-2': (0x2110000, make_text(0x8000, 2)),
+        'lz4-small-blocks': (0x2200000, make_text(0x80000, 3)),
+        'lz4-large-blocks': (0x2300000, LARGE_TEXT * 0x8000),
+        'zstd': (0x2500000, make_text(0x80000, 4)),
+    }
+
+    params = {
+        'firmware': write_file('firmware.bin', expect['firmware'][1]),
+        'data1': write_file('data-1.bin', expect['data-1'][1]),
+        'data2': write_file('data-2.bin', expect['data-2'][1]),
+        'data2_load': expect['data-2'][0],
+    }
+    src = write_file('lz4-small.bin', expect['lz4-small-blocks'][1])
+    params['lz4_small'] = src + '.lz4'
+    util.run_and_log(cons, ['lz4', '-f', '-q', '-B4', src, src + '.lz4'])
+    src = write_file('lz4-large.bin', expect['lz4-large-blocks'][1])
+    params['lz4_large'] = src + '.lz4'
+    util.run_and_log(cons, ['lz4', '-f', '-q', '-B7', src, src + '.lz4'])
+    src = write_file('zstd.bin', expect['zstd'][1])
+    params['zstd'] = src + '.zst'
+    util.run_and_log(cons, ['zstd', '-f', '-q', src, '-o', src + '.zst'])
+
+    dts = make_fname('fdt.dts')
+    with open(dts, 'w') as fd:
+        fd.write(FDT)
+    params['fdt'] = make_fname('fdt.dtb')
+    util.run_and_log(cons, ['dtc', dts, '-O', 'dtb', '-o', params['fdt']])
+
+    its = make_fname('test.its')
+    with open(its, 'w') as fd:
+        fd.write(ITS % params)
+    fit = make_fname('test.fit')
+    util.run_and_log(cons, [mkimage, '-E', '-f', its, fit])
+
+    try:
+        cons.restart_uboot_with_flags(['--spl_fit', fit])
+        output = cons.get_spawn_output().replace('\r', '')
+    finally:
+        cons.restart_uboot()
+
+    found = {}
+    for line in output.splitlines():
+        m = re.match(r'^FIT image (\S+): addr (\w+) size (\w+) crc32 (\w+)$',
+                     line)
+        if m:
+            found[m.group(1)] = (int(m.group(2), 16), int(m.group(3), 16),
+                                 int(m.group(4), 16))
+    for name, (addr, data) in expect.items():
+        assert name in found, "Image '%s' was not loaded" % name
+        assert found[name] == (addr, len(data), zlib.crc32(data)), name
@@ -55,6 +55,8 @@ struct func_info *func_list;
 int func_count;
 struct trace_call *call_list;
 int call_count;
+struct trace_sample *sample_list;
+int sample_count;
 int verbose;	/* Verbosity level 0=none, 1=warn, 2=notice, 3=info, 4=debug */
 unsigned long text_offset;		/* text address of first function */
 
@@ -85,6 +87,7 @@ static void usage(void)
 		"\n"
 		"Commands\n"
 		"   dump-ftrace\t\tDump out textual data in ftrace format\n"
+		"   dump-collapsed\tDump profile samples as collapsed stacks\n"
 		"\n"
 		"Options:\n"
 		"   -m <map>\tSpecify Systen.map file\n"
@@ -226,6 +229,32 @@ static int read_calls(FILE *fin, size_t count)
 	return 0;
 }
 
+static int read_samples(FILE *fin, size_t count)
+{
+	struct trace_sample *sample;
+	int i;
+
+	notice("sample count: %zu\n", count);
+	sample_list = calloc(count, sizeof(*sample));
+	if (!sample_list) {
+		error("Cannot allocate sample_list\n");
+		return -1;
+	}
+	sample_count = count;
+
+	sample = sample_list;
+	for (i = 0; i < count; i++, sample++) {
+		if (read_data(fin, sample, sizeof(*sample)))
+			return 1;
+		if (sample->depth > PROFILE_STACK_DEPTH) {
+			error("Invalid stack depth %u in sample %d\n",
+			      sample->depth, i);
+			return 1;
+		}
+	}
+	return 0;
+}
+
 static int read_profile(FILE *fin, int *not_found)
 {
 	struct trace_output_hdr hdr;
@@ -249,6 +278,11 @@ static int read_profile(FILE *fin, int *not_found)
 			if (read_calls(fin, hdr.rec_count))
 				return 1;
 			break;
+
+		case TRACE_CHUNK_SAMPLES:
+			if (read_samples(fin, hdr.rec_count))
+				return 1;
+			break;
 		}
 	}
 	return 0;
@@ -532,6 +566,74 @@ static int make_ftrace(void)
 	return 0;
 }
 
+static int h_cmp_str(const void *v1, const void *v2)
+{
+	const char *const *s1 = v1, *const *s2 = v2;
+
+	return strcmp(*s1, *s2);
+}
+
+/*
+ * Output one line for each distinct call stack, outermost function first,
+ * followed by the number of samples, e.g.:
+ *
+ * board_init_r;run_main_loop;cli_loop;parse_file_outer;memcpy 12
+ *
+ * This is the format used by flamegraph.pl and speedscope.
+ */
+static int make_collapsed(void)
+{
+	char buf[PROFILE_STACK_DEPTH * (MAX_LINE_LEN + 2)];
+	struct trace_sample *sample;
+	char **stacks;
+	int i, j, count;
+
+	stacks = calloc(sample_count, sizeof(*stacks));
+	if (!stacks) {
+		error("Cannot allocate stack list\n");
+		return -1;
+	}
+	for (i = 0, sample = sample_list; i < sample_count; i++, sample++) {
+		char *ptr = buf;
+
+		*ptr = '\0';
+		for (j = sample->depth - 1; j >= 0; j--) {
+			uint32_t offset = sample->pc[j];
+			struct func_info *func = NULL;
+
+			if (offset != PROFILE_PC_EXTERNAL && func_count)
+				func = find_caller_by_offset(offset);
+			if (ptr != buf)
+				*ptr++ = ';';
+			if (func)
+				ptr += sprintf(ptr, "%s", func->name);
+			else if (offset == PROFILE_PC_EXTERNAL)
+				ptr += sprintf(ptr, "[external]");
+			else
+				ptr += sprintf(ptr, "%x", offset);
+		}
+		stacks[i] = strdup(buf);
+		if (!stacks[i]) {
+			error("Cannot allocate stack\n");
+			return -1;
+		}
+	}
+
+	qsort(stacks, sample_count, sizeof(*stacks), h_cmp_str);
+	for (i = 0; i < sample_count; i += count) {
+		for (count = 1; i + count < sample_count &&
+		     !strcmp(stacks[i], stacks[i + count]); count++)
+			;
+		printf("%s %d\n", stacks[i], count);
+	}
+	for (i = 0; i < sample_count; i++)
+		free(stacks[i]);
+	free(stacks);
+	info("collapsed: %d samples\n", sample_count);
+
+	return 0;
+}
+
 static int prof_tool(int argc, char *const argv[],
 		     const char *prof_fname, const char *map_fname,
 		     const char *trace_config_fname)
@@ -552,6 +654,8 @@ static int prof_tool(int argc, char *const argv[],
 
 		if (0 == strcmp(cmd, "dump-ftrace"))
 			err = make_ftrace();
+		else if (0 == strcmp(cmd, "dump-collapsed"))
+			err = make_collapsed();
 		else
 			warn("Unknown command '%s'\n", cmd);
 	}